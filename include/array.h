@@ -12,13 +12,17 @@
 #include <stdio.h>   // For standard I/O operations
 #include <stdlib.h>  // For memory allocation, NULL
 #include <string.h>  // For memcpy, memset, memcmp
+#include <stdint.h>  // For uint64_t
 #include "utils.h"   // For log_error
 
 // Enum representing the supported data types for elements in the array.
 typedef enum {
     TYPE_INT,    // Integer type
     TYPE_FLOAT,  // Floating-point type
-    TYPE_DOUBLE   // Double precision floating-point type
+    TYPE_DOUBLE,  // Double precision floating-point type
+    TYPE_BOOL,    // Boolean mask type, stored as one byte per element (0 or 1)
+    TYPE_COMPLEX_FLOAT,   // Complex type, stored as interleaved (real, imaginary) floats
+    TYPE_COMPLEX_DOUBLE   // Complex type, stored as interleaved (real, imaginary) doubles
 } DataType;
 
 // Structure representing an n-dimensional array.
@@ -28,8 +32,16 @@ typedef struct {
     size_t size;        // Total number of elements in the array (product of shape).
     DataType dtype;     // Data type of the elements (e.g., int, float, double).
     void* data;         // Pointer to the data storage, containing the array elements.
+    size_t* ref_count;  // Number of arrays sharing data (updated atomically); data is copied before the first write while shared.
 } Array;
 
+// Inner loop used by the broadcasting engine.
+// out: Pointer to the first output element of the row (the output is always contiguous).
+// in: Pointers to the first element of the row for every input.
+// in_strides: Byte stride of every input along the row (0 for broadcast inputs).
+// n: Number of elements in the row.
+typedef void (*StridedLoopFunc)(char* out, char** in, const size_t* in_strides, size_t n);
+
 
 // Function prototypes
 
@@ -49,6 +61,10 @@ size_t* allocate_shape_memory(size_t ndim);
 // Returns a pointer to the allocated memory, or NULL if the allocation fails.
 void* allocate_data_memory(size_t data_size);
 
+// Allocates the shared reference count of a data block, initialized to 1.
+// Returns a pointer to the allocated count, or NULL if the allocation fails.
+size_t* allocate_ref_count();
+
 
 // Array creation and destruction functions
 
@@ -62,9 +78,45 @@ void* allocate_data_memory(size_t data_size);
 Array* create_array(DataType dtype, size_t ndim, size_t* shape, void* data);
 
 // Frees the memory allocated for an Array structure.
+// The data block is only freed when no other clone still references it.
 // arr: Pointer to the Array structure to free.
 void free_array(Array* arr);
 
+// Creates an Array structure that shares the data block of arr (copy-on-write).
+// Takes O(1) time and memory for the data; the block is copied on the first write to either array.
+// arr: Pointer to the Array structure to clone.
+// Returns a pointer to the new Array structure, or NULL if memory allocation fails.
+Array* clone_array(Array* arr);
+
+// Gives arr its own copy of its data block if the block is shared with a clone.
+// Called by every function that writes into an existing array; call it before writing to arr->data directly.
+// arr: Pointer to the Array structure.
+// Returns 1 on success, 0 if memory allocation fails.
+int make_array_writable(Array* arr);
+
+
+// Random array creation
+//
+// Values come from the counter-based Philox4x32-10 generator: every element depends only on the seed and
+// its index, so results are reproducible for any number of threads. Filling runs in parallel.
+
+// Creates an array of uniformly distributed random values in [low, high).
+// dtype: TYPE_FLOAT or TYPE_DOUBLE.
+// ndim: The number of dimensions of the array.
+// shape: Pointer to an array containing the size of each dimension.
+// seed: Seed of the generator.
+// Returns a pointer to the created Array structure, or NULL on error.
+Array* random_uniform(DataType dtype, size_t ndim, size_t* shape, double low, double high, uint64_t seed);
+
+// Creates an array of normally distributed random values (Box-Muller transform).
+// dtype: TYPE_FLOAT or TYPE_DOUBLE.
+// Returns a pointer to the created Array structure, or NULL on error.
+Array* random_normal(DataType dtype, size_t ndim, size_t* shape, double mean, double stddev, uint64_t seed);
+
+// Creates a TYPE_INT array of uniformly distributed random integers in [low, high).
+// Returns a pointer to the created Array structure, or NULL on error.
+Array* random_integers(size_t ndim, size_t* shape, int low, int high, uint64_t seed);
+
 
 // Shape and index management functions
 
@@ -134,6 +186,28 @@ int set_element(Array* arr, size_t* indices, void* value);
 // Returns a pointer to the result Array structure, or NULL if the arrays cannot be broadcasted or memory allocation fails.
 Array* broadcast_arrays(Array* arr_a, Array* arr_b, char operation_symbol);
 
+// Computes the byte strides of an array viewed with a broadcasted shape.
+// Dimensions that are broadcast (size 1 in the original array, or missing) get a stride of 0.
+// arr: Pointer to the Array structure.
+// result_shape: Pointer to the broadcasted shape.
+// result_ndim: Number of dimensions of the broadcasted shape.
+// Returns a pointer to the strides (one per broadcasted dimension), or NULL if the shapes are incompatible.
+size_t* broadcast_strides(Array* arr, size_t* result_shape, size_t result_ndim);
+
+// Rank up to which loops over arrays run as fixed-depth loop nests; lower ranks are padded on the
+// left with unit dimensions, and higher ranks take a generic path.
+#define FIXED_LOOP_RANK 4
+
+// Runs a strided inner loop over every row of a result array, broadcasting the inputs to its shape.
+// This is the engine shared by broadcast_arrays, the comparison operations and where.
+// result: Pointer to the preallocated result Array structure.
+// inputs: Pointers to the input arrays (at most MAX_BROADCAST_INPUTS).
+// n_inputs: Number of input arrays.
+// loop: Inner loop applied to each row of the result.
+// Returns 1 on success; returns 0 if the inputs cannot be broadcast to the result shape.
+#define MAX_BROADCAST_INPUTS 3
+int broadcast_apply(Array* result, Array** inputs, size_t n_inputs, StridedLoopFunc loop);
+
 // Flattens the input array into a one-dimensional array.
 // arr: Pointer to the Array structure to flatten.
 // Returns a pointer to the new flattened Array structure, or NULL if memory allocation fails.
@@ -171,10 +245,22 @@ int are_shapes_equal(size_t* shapeA, size_t ndimA, size_t* shapeB, size_t ndimB)
 void print_shape(size_t* shape, size_t ndim);
 
 
-// Prints the elements of the given array to standard output.
+// Prints the elements of the given array to standard output, one row of the last dimension per line.
+// Elements are formatted with format_element.
 // arr: Pointer to the Array structure to print.
 void print_array(Array* arr);
 
+// Longest text produced by format_element.
+#define FORMAT_VALUE_MAX 64
+
+// Formats one element as text: integers and booleans as decimal integers, floating point values with the
+// fewest digits that read back to the same value, complex values as "re+imj".
+// buf: Output buffer with room for FORMAT_VALUE_MAX bytes; the text is not null-terminated.
+// dtype: The data type of the element.
+// element: Pointer to the element.
+// Returns the number of bytes written.
+size_t format_element(char* buf, DataType dtype, const void* element);
+
 // Retrieves the size of a specific dimension based on an index, returning 1 if the index is out of bounds.
 // shape: Pointer to an array containing the shape of the array.
 // ndim: Number of dimensions of the array.
@@ -190,6 +276,12 @@ void get_dim_value(size_t* shape, size_t ndim, size_t index, size_t* dim_value);
 // dtype: The data type of the elements being operated on.
 void apply_operation(char operation_symbol, void* result, void* a, void* b, DataType dtype);
 
+// Returns the strided inner loop that applies the specified operation to a row of elements.
+// operation_symbol: Character representing the operation to be performed ('+', '-', '*', '/').
+// dtype: The data type of the elements being operated on.
+// Returns the loop function, or NULL if the operation or data type is not supported.
+StridedLoopFunc get_operation_loop(char operation_symbol, DataType dtype);
+
 // Calculate the strides for each dimension based on the shape of the array.
 // shape: Pointer to an array containing the shape of the array.
 // ndim: Number of dimensions of the array.
@@ -222,4 +314,428 @@ Array* transpose(Array* arr, size_t* permutation);
 // Returns a pointer to the new Array structure containing the summed elements, or NULL if memory allocation fails.
 Array* sum_along_axis(Array* arr, size_t axis);
 
+// Computes the cumulative sum of the elements along the specified axis.
+// arr: Pointer to the Array structure to scan (TYPE_BOOL arrays are summed as TYPE_INT).
+// axis: The axis along which to accumulate.
+// Returns a pointer to a new Array structure of the same shape, or NULL on error.
+Array* cumsum(Array* arr, size_t axis);
+
+// Computes the cumulative product of the elements along the specified axis.
+// arr: Pointer to the Array structure to scan (TYPE_BOOL arrays are multiplied as TYPE_INT).
+// axis: The axis along which to accumulate.
+// Returns a pointer to a new Array structure of the same shape, or NULL on error.
+Array* cumprod(Array* arr, size_t axis);
+
+// Computes the sum of each window of `window` elements along an axis, in O(n) with running sums.
+// NaN and infinities only affect the windows that contain them.
+// arr: Pointer to the Array structure (TYPE_INT, TYPE_FLOAT or TYPE_DOUBLE).
+// axis: The axis along which the window slides.
+// window: The number of elements in each window (1 to the length of the axis).
+// step: The distance between the starts of consecutive windows (at least 1).
+// Returns a pointer to a new Array whose axis has (n - window) / step + 1 elements, or NULL on error.
+Array* rolling_sum(Array* arr, size_t axis, size_t window, size_t step);
+
+// Computes the mean of each window along an axis; TYPE_INT arrays give TYPE_DOUBLE means.
+// Parameters and result as for rolling_sum.
+Array* rolling_mean(Array* arr, size_t axis, size_t window, size_t step);
+
+// Computes the minimum of each window along an axis, in O(n) with a monotonic deque.
+// Parameters and result as for rolling_sum.
+Array* rolling_min(Array* arr, size_t axis, size_t window, size_t step);
+
+// Computes the maximum of each window along an axis, in O(n) with a monotonic deque.
+// Parameters and result as for rolling_sum.
+Array* rolling_max(Array* arr, size_t axis, size_t window, size_t step);
+
+// Computes C += alpha * op(A) * op(B) on row-major matrices with a cache-blocked kernel.
+// dtype: TYPE_INT, TYPE_FLOAT or TYPE_DOUBLE.
+// m, n, k: op(A) is m x k, op(B) is k x n and C is m x n.
+// a, b, c: Pointers to the matrices, with leading dimensions lda, ldb and ldc.
+// trans_a, trans_b: Use the transpose of A or B when set.
+// threaded: Whether large products may be split across threads.
+// Returns 1 on success, 0 on error.
+int gemm(DataType dtype, size_t m, size_t n, size_t k, double alpha,
+         const void* a, size_t lda, int trans_a, const void* b, size_t ldb, int trans_b,
+         void* c, size_t ldc, int threaded);
+
+// Multiplies two stacks of matrices.
+// arr_a: Pointer to an Array structure of shape (..., m, k).
+// arr_b: Pointer to an Array structure of shape (..., k, n); either operand may be a single two-dimensional matrix.
+// Returns a pointer to a new Array structure of shape (..., m, n), or NULL on error.
+Array* matmul(Array* arr_a, Array* arr_b);
+
+
+// Linear algebra solvers (float and double, on stacks of matrices of shape (..., m, n))
+
+// Computes the LU factorization with partial pivoting of square matrices.
+// arr: Pointer to the Array structure of shape (..., n, n).
+// lu: Receives a new Array structure holding L (unit diagonal, not stored) and U.
+// pivots: Receives a new TYPE_INT Array structure of shape (..., n); row i was interchanged with row pivots[i], in order.
+// Returns 1 on success, 0 on error.
+int lu_factor(Array* arr, Array** lu, Array** pivots);
+
+// Computes the Cholesky factor L of symmetric positive definite matrices (A = L L^T).
+// arr: Pointer to the Array structure of shape (..., n, n); only the lower triangle is read.
+// Returns a pointer to a new Array structure holding L, or NULL on error.
+Array* cholesky(Array* arr);
+
+// Computes the reduced QR factorization of matrices with Householder reflections.
+// arr: Pointer to the Array structure of shape (..., m, n).
+// q: Receives a new Array structure of shape (..., m, min(m, n)) with orthonormal columns.
+// r: Receives a new upper triangular Array structure of shape (..., min(m, n), n).
+// Returns 1 on success, 0 on error.
+int qr(Array* arr, Array** q, Array** r);
+
+// Solves A X = B for triangular matrices A.
+// arr_a: Pointer to the Array structure of shape (..., n, n).
+// arr_b: Pointer to the right-hand sides, of shape (..., n) or (..., n, k).
+// lower: 1 if A is lower triangular, 0 if upper triangular.
+// Returns a pointer to a new Array structure holding X, or NULL on error.
+Array* triangular_solve(Array* arr_a, Array* arr_b, int lower);
+
+// Solves the linear systems A X = B.
+// arr_a: Pointer to the Array structure of shape (..., n, n).
+// arr_b: Pointer to the right-hand sides, of shape (..., n) or (..., n, k).
+// Returns a pointer to a new Array structure holding X, or NULL on error (including singular matrices).
+Array* solve(Array* arr_a, Array* arr_b);
+
+
+// Small matrices (fixed-size kernels for 2x2, 3x3, 4x4 and 8x8 matrices)
+
+// Multiplies stacks of 2x2, 3x3, 4x4 or 8x8 float or double matrices with fully unrolled kernels.
+// Called by matmul, which checks the shapes and allocates the result.
+// Returns 1 if the product was computed, 0 if the size or data type has no fixed-size kernel.
+int small_matmul(Array* arr_a, Array* arr_b, Array* result);
+
+// Inverts a stack of square float or double matrices.
+// arr: Pointer to the Array structure of shape (..., n, n).
+// Returns a pointer to a new Array structure holding the inverses, or NULL on error (including singular matrices).
+Array* inverse(Array* arr);
+
+// Computes the determinants of a stack of square float or double matrices.
+// arr: Pointer to the Array structure of shape (..., n, n).
+// Returns a pointer to a new Array structure of shape (...) (shape (1) for a single matrix), or NULL on error.
+Array* determinant(Array* arr);
+
+// Transposes every matrix of a stack by swapping the last two axes.
+// arr: Pointer to the Array structure of shape (..., m, n).
+// Returns a pointer to a new Array structure of shape (..., n, m), or NULL on error.
+Array* matrix_transpose(Array* arr);
+
+// Evaluates an Einstein summation, e.g. "ij,jk->ik" (matrix product), "bij,bjk->bik", "ii->" (trace).
+// Without "->", the output holds every label that appears once, in alphabetical order.
+// Operands are contracted pairwise in the cheapest order (searched exhaustively for up to 6 operands,
+// greedily beyond); each contraction runs as a GEMM, a fused dot product or a broadcast product.
+// subscripts: One label string per operand, separated by commas; labels are letters.
+// operands: Pointers to the int, float or double operands, all of the same dtype.
+// n_operands: Number of operands.
+// Returns a pointer to the new Array structure (shape (1,) for an output without labels), or NULL on error.
+Array* einsum(const char* subscripts, Array** operands, size_t n_operands);
+
+
+// Convolution and correlation
+
+// Output size of a convolution.
+typedef enum {
+    CONV_VALID,  // Only positions where the kernel fits inside the input
+    CONV_SAME,   // Same size as the input (before striding), centered
+    CONV_FULL    // Every position where the kernel overlaps the input
+} ConvMode;
+
+// Convolves the last axis of an int, float or double array with a kernel.
+// Small filters use a direct kernel; multi-channel filters with many taps use im2col and a packed GEMM.
+// input: Pointer to the Array structure of shape (..., length), or (..., c_in, length) for a channel kernel.
+// kernel: Pointer to the kernel of shape (k), or (c_out, c_in, k) to map c_in input channels to c_out outputs.
+// mode: CONV_VALID, CONV_SAME or CONV_FULL.
+// stride: Step between output positions (1 for every position).
+// dilation: Spacing between kernel taps (1 for a dense kernel).
+// Returns a pointer to a new Array structure of shape (..., [c_out,] out_length), or NULL on error.
+Array* convolve1d(Array* input, Array* kernel, ConvMode mode, size_t stride, size_t dilation);
+
+// Convolves the last two axes of an int, float or double array with a kernel.
+// input: Pointer to the Array structure of shape (..., h, w), or (..., c_in, h, w) for a channel kernel.
+// kernel: Pointer to the kernel of shape (k_h, k_w), or (c_out, c_in, k_h, k_w).
+// stride, dilation: Applied along both axes.
+// Returns a pointer to a new Array structure of shape (..., [c_out,] out_h, out_w), or NULL on error.
+Array* convolve2d(Array* input, Array* kernel, ConvMode mode, size_t stride, size_t dilation);
+
+// Same as convolve1d, without flipping the kernel (cross-correlation).
+Array* correlate1d(Array* input, Array* kernel, ConvMode mode, size_t stride, size_t dilation);
+
+// Same as convolve2d, without flipping the kernel (cross-correlation).
+Array* correlate2d(Array* input, Array* kernel, ConvMode mode, size_t stride, size_t dilation);
+
+
+// Fourier transforms
+
+// Computes the discrete Fourier transform along an axis.
+// Lengths with factors 2, 3 and 5 use mixed-radix passes; other lengths use Bluestein's algorithm.
+// Independent transforms run in parallel; plans for each length are cached.
+// arr: Pointer to an int, float, double or complex Array structure.
+// axis: The axis to transform.
+// Returns a pointer to a new TYPE_COMPLEX_FLOAT (for float input) or TYPE_COMPLEX_DOUBLE Array structure, or NULL on error.
+Array* fft(Array* arr, size_t axis);
+
+// Computes the inverse discrete Fourier transform along an axis, scaled by 1 / n.
+// Returns a pointer to a new complex Array structure, or NULL on error.
+Array* ifft(Array* arr, size_t axis);
+
+// Computes the discrete Fourier transform of real input along an axis.
+// Only the n / 2 + 1 non-negative frequencies are returned; the others are their complex conjugates.
+// arr: Pointer to an int, float or double Array structure.
+// Returns a pointer to a new complex Array structure with n / 2 + 1 elements along axis, or NULL on error.
+Array* rfft(Array* arr, size_t axis);
+
+// Frees the cached FFT plans. Must not be called while a transform is running.
+void fft_free_plans();
+
+
+// Sorting operations
+
+// Sorts an array along the specified axis.
+// arr: Pointer to the Array structure to sort.
+// axis: The axis along which to sort.
+// Returns a pointer to a new sorted Array structure, or NULL on error.
+Array* sort(Array* arr, size_t axis);
+
+// Computes the indices that would sort an array along the specified axis (stable).
+// arr: Pointer to the Array structure to sort.
+// axis: The axis along which to sort.
+// Returns a pointer to a new TYPE_INT Array structure of positions along the axis, or NULL on error.
+Array* argsort(Array* arr, size_t axis);
+
+// Partially sorts an array so the element at position kth of every line is in its sorted position,
+// with smaller elements before it and larger elements after it.
+// arr: Pointer to the Array structure to partition.
+// kth: The position to place.
+// axis: The axis along which to partition.
+// Returns a pointer to a new Array structure, or NULL on error.
+Array* partition(Array* arr, size_t kth, size_t axis);
+
+// Finds the k largest elements of every line along the specified axis.
+// arr: Pointer to the Array structure to search.
+// k: Number of elements to keep per line.
+// axis: The axis along which to search.
+// values: Receives a new Array structure with the k largest values per line, in descending order.
+// indices: Receives a new TYPE_INT Array structure with their positions along the axis.
+// Returns 1 on success; returns 0 otherwise.
+int topk(Array* arr, size_t k, size_t axis, Array** values, Array** indices);
+
+
+// Counting operations
+
+// Counts the occurrences of every non-negative integer value.
+// arr: Pointer to a TYPE_INT Array structure of non-negative values, of any shape.
+// weights: Optional pointer to an Array structure of the same size; when given, each bin sums the weights.
+// minlength: Minimum number of bins.
+// Returns a pointer to a one-dimensional TYPE_INT Array structure (TYPE_DOUBLE when weighted), or NULL on error.
+Array* bincount(Array* arr, Array* weights, size_t minlength);
+
+// Counts the elements of an array in equal-width bins over [min, max]; the last bin includes max.
+// arr: Pointer to the Array structure, of any shape.
+// n_bins: Number of bins.
+// min, max: Range of the bins; when min >= max the range of the data is used.
+// bin_edges: Optional pointer receiving a new TYPE_DOUBLE Array structure with the n_bins + 1 edges.
+// Returns a pointer to a one-dimensional TYPE_INT Array structure of counts, or NULL on error.
+Array* histogram(Array* arr, size_t n_bins, double min, double max, Array** bin_edges);
+
+// Counts the elements of an array in bins given by explicit edges; the last bin includes its right edge.
+// arr: Pointer to the Array structure, of any shape.
+// edges: Pointer to a one-dimensional TYPE_DOUBLE Array structure of increasing edges.
+// Returns a pointer to a one-dimensional TYPE_INT Array structure of counts, or NULL on error.
+Array* histogram_edges(Array* arr, Array* edges);
+
+// Finds the sorted distinct values of an array.
+// arr: Pointer to the Array structure, of any shape.
+// values: Receives a new one-dimensional Array structure of the sorted distinct values.
+// counts: Optional pointer receiving a new TYPE_INT Array structure with the occurrences of each value.
+// inverse: Optional pointer receiving a new TYPE_INT Array structure of arr's shape with each element's position in values.
+// Returns 1 on success; returns 0 otherwise.
+int unique(Array* arr, Array** values, Array** counts, Array** inverse);
+
+
+// Comparison and mask operations
+
+// Compares two arrays element-wise with broadcasting.
+// arr_a: Pointer to the first Array structure.
+// arr_b: Pointer to the second Array structure.
+// comparison: String representing the comparison ("<", "<=", "==", "!=", ">", ">=").
+// Returns a pointer to a TYPE_BOOL result Array structure, or NULL on error.
+Array* compare_arrays(Array* arr_a, Array* arr_b, const char* comparison);
+
+// Combines two boolean masks element-wise with broadcasting.
+// mask_a: Pointer to the first TYPE_BOOL Array structure.
+// mask_b: Pointer to the second TYPE_BOOL Array structure.
+// operation_symbol: Character representing the logical operation ('&', '|', '^').
+// Returns a pointer to a TYPE_BOOL result Array structure, or NULL on error.
+Array* logical_arrays(Array* mask_a, Array* mask_b, char operation_symbol);
+
+// Negates a boolean mask element-wise.
+// mask: Pointer to the TYPE_BOOL Array structure.
+// Returns a pointer to a TYPE_BOOL result Array structure, or NULL on error.
+Array* logical_not(Array* mask);
+
+// Selects elements from two arrays based on a mask, broadcasting all three inputs.
+// mask: Pointer to the TYPE_BOOL Array structure.
+// arr_a: Pointer to the Array structure whose elements are taken where the mask is true.
+// arr_b: Pointer to the Array structure whose elements are taken where the mask is false.
+// Returns a pointer to the result Array structure, or NULL on error.
+Array* where(Array* mask, Array* arr_a, Array* arr_b);
+
+// Counts the true elements of a boolean mask.
+// mask: Pointer to the TYPE_BOOL Array structure.
+// Returns the number of nonzero elements in the mask.
+size_t count_nonzero(Array* mask);
+
+// Gathers the elements of an array where the mask is true into a one-dimensional array (arr[mask]).
+// arr: Pointer to the Array structure to select from.
+// mask: Pointer to a TYPE_BOOL Array structure with the same shape as arr.
+// Returns a pointer to the one-dimensional result Array structure, or NULL on error or if nothing is selected.
+Array* masked_select(Array* arr, Array* mask);
+
+// Checks whether two arrays are element-wise equal within a tolerance, broadcasting them.
+// Elements x of arr_a and y of arr_b are close when |x - y| <= atol + rtol * |y|; NaN is never close.
+// rtol: Relative tolerance.
+// atol: Absolute tolerance.
+// mismatch_index: If not NULL, receives the row-major index (in the broadcast shape) of the first element
+// that is not close, the broadcast size if all are, or (size_t)-1 on error.
+// Returns 1 if every element is close; returns 0 otherwise or on error.
+int arrays_allclose(Array* arr_a, Array* arr_b, double rtol, double atol, size_t* mismatch_index);
+
+// Checks whether two arrays are element-wise within max_ulps units in the last place, broadcasting them.
+// Integer elements are compared by their absolute difference and complex elements component-wise.
+// mismatch_index: As for arrays_allclose.
+// Returns 1 if every element is close; returns 0 otherwise or on error.
+int arrays_allclose_ulp(Array* arr_a, Array* arr_b, size_t max_ulps, size_t* mismatch_index);
+
+
+// Joining operations
+
+// Concatenates arrays along an existing axis.
+// arrays: Pointers to the arrays to join; all must share dtype and shape except along axis.
+// n_arrays: Number of arrays.
+// axis: The axis along which to concatenate.
+// Returns a pointer to the new Array structure, or NULL on error.
+Array* concatenate(Array** arrays, size_t n_arrays, size_t axis);
+
+// Concatenates arrays along an existing axis into a preallocated output array.
+// Along axis 0, arrays whose data already sits at its destination inside out are not copied.
+// out: Pointer to the output Array structure with the concatenated shape.
+// arrays: Pointers to the arrays to join.
+// n_arrays: Number of arrays.
+// axis: The axis along which to concatenate.
+// Returns 1 on success; returns 0 otherwise.
+int concatenate_into(Array* out, Array** arrays, size_t n_arrays, size_t axis);
+
+// Joins arrays of identical shape along a new axis.
+// arrays: Pointers to the arrays to join.
+// n_arrays: Number of arrays.
+// axis: Position of the new axis in the result, from 0 to ndim.
+// Returns a pointer to the new Array structure, or NULL on error.
+Array* stack(Array** arrays, size_t n_arrays, size_t axis);
+
+// Constructs an array by repeating arr the number of times given by reps along each dimension.
+// arr: Pointer to the Array structure to tile.
+// reps: Pointer to the number of repetitions per dimension (aligned to the right of the shape).
+// n_reps: Number of entries in reps.
+// Returns a pointer to the new Array structure, or NULL on error.
+Array* tile(Array* arr, size_t* reps, size_t n_reps);
+
+// Repeats each element of an array along an axis.
+// arr: Pointer to the Array structure to repeat.
+// repeats: Number of times each element is repeated.
+// axis: The axis along which to repeat.
+// Returns a pointer to the new Array structure, or NULL on error.
+Array* repeat(Array* arr, size_t repeats, size_t axis);
+
+
+// Indexing operations
+
+// Takes slices of an array along an axis at the positions given by an index array.
+// arr: Pointer to the Array structure to gather from.
+// indices: Pointer to a TYPE_INT Array structure with positions along axis.
+// axis: The axis to index.
+// Returns a pointer to a new Array structure of shape arr.shape[:axis] + indices.shape + arr.shape[axis+1:], or NULL on error.
+Array* gather(Array* arr, Array* indices, size_t axis);
+
+// Writes slices into an array along an axis at the positions given by an index array.
+// arr: Pointer to the Array structure to write into.
+// indices: Pointer to a TYPE_INT Array structure with positions along axis.
+// values: Pointer to an Array structure of shape arr.shape[:axis] + indices.shape + arr.shape[axis+1:].
+// axis: The axis to index.
+// operation_symbol: '=' to assign, '+' to accumulate (duplicate indices add up).
+// Returns 1 on success; returns 0 otherwise (the array is left unchanged if an index is out of bounds).
+int scatter(Array* arr, Array* indices, Array* values, size_t axis, char operation_symbol);
+
+// Reads a batch of elements from an array.
+// arr: Pointer to the Array structure.
+// indices: Pointer to n rows of arr->ndim indices, stored row-major.
+// n: Number of elements to read.
+// out: Pointer to a buffer of n elements receiving the values.
+// Returns 1 on success; returns 0 if any index is out of bounds.
+int get_elements(Array* arr, size_t* indices, size_t n, void* out);
+
+// Writes a batch of elements into an array.
+// arr: Pointer to the Array structure.
+// indices: Pointer to n rows of arr->ndim indices, stored row-major.
+// n: Number of elements to write.
+// values: Pointer to a buffer of n elements to store.
+// Returns 1 on success; returns 0 if any index is out of bounds (nothing is written).
+int set_elements(Array* arr, size_t* indices, size_t n, void* values);
+
+
+// Text input and output
+
+// Loads a two-dimensional array from a CSV file, parsing pieces of the file on multiple threads.
+// Fields are separated by commas and may be surrounded by blanks; blank lines are skipped.
+// path: Path of the file.
+// dtype: TYPE_INT, TYPE_FLOAT, TYPE_DOUBLE or TYPE_BOOL ("0", "1", "true" or "false").
+// Returns a pointer to a new (rows, columns) Array structure, or NULL on error (the message names the line).
+Array* array_from_csv(const char* path, DataType dtype);
+
+// Writes an array to a CSV file, one row of the last dimension per line, formatting on multiple threads.
+// arr: Pointer to the Array structure to write.
+// path: Path of the file, created or truncated.
+// Returns 1 on success, 0 on error.
+int array_to_csv(Array* arr, const char* path);
+
+
+// Parallel execution
+
+// Minimum amount of work, in bytes, worth handing to a separate thread.
+#define PARALLEL_GRAIN_BYTES (1 << 18)
+
+// Processes the half-open range of iterations [begin, end).
+typedef void (*ParallelFunc)(size_t begin, size_t end, void* ctx);
+
+// Returns the number of threads used by parallel operations (defaults to the number of online cores).
+size_t get_num_threads();
+
+// Sets the number of threads used by parallel operations; 0 restores the default.
+void set_num_threads(size_t n);
+
+// Sets the number of threads used by parallel operations started on the calling thread; 0 restores the
+// process-wide setting. Useful when many threads call the library concurrently.
+void set_thread_num_threads(size_t n);
+
+// Splits the range [0, n) into contiguous chunks of at least grain iterations and runs them in parallel.
+// n: Number of iterations.
+// grain: Minimum number of iterations per thread.
+// body: Function processing a range of iterations.
+// ctx: User data passed to body.
+void parallel_for(size_t n, size_t grain, ParallelFunc body, void* ctx);
+
+// Copies n_bytes from src to dst, splitting large copies across threads.
+void parallel_memcpy(void* dst, const void* src, size_t n_bytes);
+
+// Sets n_bytes of dst to value, splitting large blocks across threads.
+void parallel_memset(void* dst, int value, size_t n_bytes);
+
+// Returns the number of NUMA nodes with CPUs (1 on machines without NUMA).
+size_t get_numa_nodes();
+
+// Restricts the calling thread to the CPUs of a NUMA node (no effect without NUMA).
+// Returns 1 on success, 0 on error.
+int bind_thread_to_node(size_t node);
+
 #endif // ARRAY_H
@@ -0,0 +1,79 @@
+#ifndef ARRAY_ASYNC_H
+#define ARRAY_ASYNC_H
+
+#include "array.h"
+
+// Handle to the result of an asynchronous operation.
+// A future owns its result array; clone_array keeps a result alive after future_free.
+typedef struct ArrayFuture ArrayFuture;
+
+// Body of an asynchronous task.
+// inputs: The results of the task's dependencies, in the order they were given.
+// ctx: The user data passed to submit_async.
+// Returns the result array of the task (may be NULL for tasks run for their side effects).
+// The task fails if it raises an error (see get_last_error).
+typedef Array* (*AsyncFunc)(Array** inputs, void* ctx);
+
+// Called once a future has completed, on the thread that completed it.
+typedef void (*FutureCallback)(ArrayFuture* future, void* user_data);
+
+
+// Submission
+//
+// Tasks run on a pool of get_num_threads() worker threads, started on the first
+// submission. A task is queued once all its dependencies have completed, so
+// submitted tasks form a dependency graph; independent tasks run concurrently,
+// and idle workers steal queued tasks from busy ones, preferring workers on
+// their own NUMA node. Operations inside a task run on its worker thread only.
+// If a dependency fails, its dependents fail with the same error without running.
+
+// Submits a task that runs once every dependency has completed.
+// func: The task body, called with the results of deps.
+// ctx: User data passed to func; it must stay valid until the task has run.
+// deps: The futures the task depends on (may be NULL if n_deps is 0).
+// n_deps: Number of dependencies.
+// Returns a new future for the result of the task, or NULL on error.
+ArrayFuture* submit_async(AsyncFunc func, void* ctx, ArrayFuture** deps, size_t n_deps);
+
+// Wraps an existing array in a completed future, to use it as an operand of asynchronous operations.
+// The future does not take ownership of arr, which must outlive every operation that uses it.
+// Returns a new future, or NULL on error.
+ArrayFuture* future_from_array(Array* arr);
+
+// Asynchronous versions of array operations; operands are futures and become dependencies.
+ArrayFuture* broadcast_arrays_async(ArrayFuture* arr_a, ArrayFuture* arr_b, char operation_symbol);
+ArrayFuture* sum_along_axis_async(ArrayFuture* arr, size_t axis);
+ArrayFuture* matmul_async(ArrayFuture* arr_a, ArrayFuture* arr_b);
+ArrayFuture* solve_async(ArrayFuture* arr_a, ArrayFuture* arr_b);
+ArrayFuture* fft_async(ArrayFuture* arr, size_t axis);
+
+
+// Completion
+
+// Blocks until a future has completed. Called from inside a task, it runs other queued tasks while waiting.
+// Returns the result (still owned by the future), or NULL if the task failed; the task's error is then
+// recorded on the calling thread.
+Array* future_wait(ArrayFuture* future);
+
+// Waits for every future of a list.
+// Returns 1 if every task succeeded, 0 otherwise.
+int future_wait_all(ArrayFuture** futures, size_t n);
+
+// Returns 1 if a future has completed, 0 otherwise (does not block).
+int future_is_done(ArrayFuture* future);
+
+// Returns the error of a completed future, or ARRAY_OK.
+ArrayError future_error(ArrayFuture* future);
+
+// Registers a callback run when a future completes (immediately, on the calling thread, if it already has).
+// Returns 1 on success, 0 on error.
+int future_on_complete(ArrayFuture* future, FutureCallback callback, void* user_data);
+
+// Releases a future and its result. Pending tasks still run, and dependents keep their inputs alive.
+void future_free(ArrayFuture* future);
+
+// Waits for every submitted task and stops the worker threads; the pool restarts on the next submission.
+// Must not be called concurrently with submissions.
+void async_shutdown();
+
+#endif // ARRAY_ASYNC_H
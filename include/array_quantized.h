@@ -0,0 +1,76 @@
+#ifndef ARRAY_QUANTIZED_H
+#define ARRAY_QUANTIZED_H
+
+#include "array.h"
+
+// Storage types for quantized values.
+typedef enum {
+    QUANT_INT8,   // Signed 8-bit values in [-128, 127]
+    QUANT_UINT8   // Unsigned 8-bit values in [0, 255]
+} QuantType;
+
+// Axis value of an array quantized with a single scale and zero point.
+#define QUANT_PER_TENSOR ((size_t)-1)
+
+// Structure representing an n-dimensional array of 8-bit quantized values.
+// Element q stands for the real value scale * (q - zero_point), where the scale and
+// zero point are shared by the whole array or indexed along one axis.
+typedef struct {
+    QuantType qtype;        // Storage type of the values.
+    size_t* shape;          // Size of each dimension.
+    size_t ndim;            // Number of dimensions.
+    size_t size;            // Total number of elements.
+    void* data;             // int8_t or uint8_t values in row-major order.
+    size_t axis;            // Axis the parameters are indexed along, or QUANT_PER_TENSOR.
+    size_t n_params;        // Number of scales and zero points (1, or shape[axis]).
+    float* scales;          // Positive scale of each parameter index.
+    int32_t* zero_points;   // Zero point of each parameter index, within the range of qtype.
+} QuantizedArray;
+
+
+// Conversion and destruction
+
+// Quantizes a TYPE_FLOAT or TYPE_DOUBLE array, choosing the parameters from the range of the values.
+// QUANT_INT8 is symmetric (zero point 0, scale max|x| / 127); QUANT_UINT8 maps [min(x, 0), max(x, 0)]
+// onto [0, 255]. Values are rounded to nearest and saturated.
+// arr: Pointer to the Array structure to quantize.
+// qtype: The storage type of the result.
+// axis: The axis with one scale and zero point per index, or QUANT_PER_TENSOR.
+// Returns a pointer to the new QuantizedArray structure, or NULL on error.
+QuantizedArray* quantize(Array* arr, QuantType qtype, size_t axis);
+
+// Converts a quantized array back to real values.
+// dtype: TYPE_FLOAT or TYPE_DOUBLE.
+// Returns a pointer to the new Array structure, or NULL on error.
+Array* dequantize(QuantizedArray* q, DataType dtype);
+
+// Frees the memory allocated for a QuantizedArray structure.
+void free_quantized_array(QuantizedArray* q);
+
+
+// Operations
+//
+// The kernels work on the stored integers and accumulate in 32 or 64-bit integers;
+// real values are only formed when a result is rescaled or dequantized.
+
+// Adds, subtracts or multiplies two per-tensor quantized arrays of the same shape element-wise
+// and requantizes the result with a fixed-point multiplier.
+// operation_symbol: '+', '-' or '*'.
+// out_scale, out_zero_point: Parameters of the result, which has the storage type of q_a.
+// Returns a pointer to the new QuantizedArray structure, or NULL on error.
+QuantizedArray* quantized_elementwise(QuantizedArray* q_a, QuantizedArray* q_b, char operation_symbol,
+                                      float out_scale, int32_t out_zero_point);
+
+// Sums the real values of a quantized array along an axis.
+// dtype: TYPE_FLOAT or TYPE_DOUBLE, the type of the result.
+// Returns a pointer to the new Array structure without that axis, or NULL on error.
+Array* quantized_sum_along_axis(QuantizedArray* q, size_t axis, DataType dtype);
+
+// Multiplies an (m, k) by a (k, n) quantized matrix with 8-bit products accumulated in integers.
+// q_a: Per-tensor quantized left operand.
+// q_b: Right operand, quantized per tensor or per column (axis 1).
+// dtype: TYPE_FLOAT or TYPE_DOUBLE, the type of the (m, n) result.
+// Returns a pointer to the new Array structure, or NULL on error.
+Array* quantized_matmul(QuantizedArray* q_a, QuantizedArray* q_b, DataType dtype);
+
+#endif // ARRAY_QUANTIZED_H
@@ -0,0 +1,83 @@
+#ifndef ARRAY_SPARSE_H
+#define ARRAY_SPARSE_H
+
+#include "array.h"
+
+// Storage formats for sparse matrices.
+typedef enum {
+    SPARSE_COO,  // Coordinate format: one (row, column, value) triple per nonzero
+    SPARSE_CSR   // Compressed sparse row format: nonzeros grouped by row
+} SparseFormat;
+
+// Structure representing a two-dimensional sparse matrix.
+// Memory scales with the number of stored nonzeros, not with the dense size.
+typedef struct {
+    SparseFormat format;  // Storage format of the matrix.
+    DataType dtype;       // Data type of the stored values (TYPE_INT, TYPE_FLOAT or TYPE_DOUBLE).
+    size_t shape[2];      // Number of rows and columns.
+    size_t nnz;           // Number of stored nonzeros.
+    size_t* row_ptr;      // CSR: shape[0] + 1 offsets into cols/values where each row starts. NULL for COO.
+    size_t* rows;         // COO: row index of each nonzero. NULL for CSR.
+    size_t* cols;         // Column index of each nonzero.
+    void* values;         // Value of each nonzero.
+} SparseArray;
+
+
+// Creation, conversion and destruction
+
+// Creates a COO sparse matrix from coordinate triples (the inputs are copied).
+// dtype: The data type of the values.
+// n_rows, n_cols: Shape of the matrix.
+// nnz: Number of triples.
+// rows, cols: Pointers to the row and column index of each triple.
+// values: Pointer to the value of each triple.
+// Returns a pointer to the new SparseArray structure, or NULL on error.
+SparseArray* create_sparse_coo(DataType dtype, size_t n_rows, size_t n_cols, size_t nnz,
+                               size_t* rows, size_t* cols, void* values);
+
+// Frees the memory allocated for a SparseArray structure.
+void free_sparse_array(SparseArray* sp);
+
+// Converts a dense two-dimensional array to a sparse matrix, storing only its nonzero elements.
+// arr: Pointer to the two-dimensional Array structure.
+// format: The storage format of the result.
+// Returns a pointer to the new SparseArray structure, or NULL on error.
+SparseArray* dense_to_sparse(Array* arr, SparseFormat format);
+
+// Converts a sparse matrix to a dense array (duplicate entries are summed).
+// Returns a pointer to the new two-dimensional Array structure, or NULL on error.
+Array* sparse_to_dense(SparseArray* sp);
+
+// Converts a sparse matrix to another storage format.
+// Converting COO to CSR keeps the column order of the triples within each row.
+// Returns a pointer to the new SparseArray structure, or NULL on error.
+SparseArray* sparse_convert(SparseArray* sp, SparseFormat format);
+
+
+// Operations
+
+// Sums the elements of a sparse matrix along an axis.
+// axis: 0 to sum over the rows (one value per column), 1 to sum over the columns (one value per row).
+// Returns a pointer to a new one-dimensional Array structure, or NULL on error.
+Array* sparse_sum_along_axis(SparseArray* sp, size_t axis);
+
+// Multiplies the nonzeros of a sparse matrix by a dense array broadcast to the matrix shape.
+// The result keeps the sparsity pattern of sp.
+// Returns a pointer to the new CSR SparseArray structure, or NULL on error.
+SparseArray* sparse_multiply_dense(SparseArray* sp, Array* dense);
+
+// Adds a sparse matrix to a dense array broadcast to the matrix shape.
+// Returns a pointer to the new dense two-dimensional Array structure, or NULL on error.
+Array* sparse_add_dense(SparseArray* sp, Array* dense);
+
+// Computes the sparse matrix-vector product sp * x.
+// x: Pointer to a one-dimensional Array structure with shape[1] elements.
+// Returns a pointer to a new one-dimensional Array structure with shape[0] elements, or NULL on error.
+Array* sparse_matvec(SparseArray* sp, Array* x);
+
+// Computes the sparse matrix-dense matrix product sp * dense.
+// dense: Pointer to a two-dimensional Array structure of shape (shape[1], k).
+// Returns a pointer to a new Array structure of shape (shape[0], k), or NULL on error.
+Array* sparse_matmul(SparseArray* sp, Array* dense);
+
+#endif // ARRAY_SPARSE_H
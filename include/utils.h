@@ -4,5 +4,56 @@
 #include "array.h"
 
 
-void log_error(const char* message);
-#endif // UTILS_H
\ No newline at end of file
+// Error reporting
+//
+// Thread safety: every function may be called concurrently from any number of
+// threads, as long as no array is written by one thread while another thread
+// reads or writes it (clones made with clone_array are separate arrays).
+// Errors are recorded per thread, so a failing call only affects the error
+// state of the thread that made it. set_num_threads, set_error_callback and
+// fft_free_plans change process-wide settings and are meant to be called
+// during initialization.
+
+// Category of the last error reported on a thread.
+typedef enum {
+    ARRAY_OK,              // No error since the last clear_last_error
+    ARRAY_ERROR_NULL,      // A required pointer argument was NULL
+    ARRAY_ERROR_MEMORY,    // A memory allocation failed
+    ARRAY_ERROR_DTYPE,     // An unsupported or mismatched data type
+    ARRAY_ERROR_SHAPE,     // Incompatible shapes or numbers of dimensions
+    ARRAY_ERROR_AXIS,      // An axis out of range
+    ARRAY_ERROR_INDEX,     // An index or position out of range
+    ARRAY_ERROR_VALUE      // An invalid argument value or a numerical failure (e.g. a singular matrix)
+} ArrayError;
+
+// Called for every error, on the thread that raised it (which may be a worker thread of parallel_for).
+// code: The category of the error.
+// message: A description of the error, valid until the thread's next error.
+// user_data: The pointer passed to set_error_callback.
+typedef void (*ErrorCallback)(ArrayError code, const char* message, void* user_data);
+
+// Records an error for the calling thread and reports it to the error callback.
+// Without a callback, the message is printed to stderr when LOG_DEBUG is enabled.
+// code: The category of the error.
+// message: A string describing the error, valid until the thread's next error.
+void log_error(ArrayError code, const char* message);
+
+// Returns the category of the last error raised on the calling thread, or ARRAY_OK.
+ArrayError get_last_error();
+
+// Returns the message of the last error raised on the calling thread, or an empty string.
+const char* get_last_error_message();
+
+// Resets the error state of the calling thread to ARRAY_OK.
+void clear_last_error();
+
+// Installs a process-wide error callback; NULL restores printing to stderr.
+// The callback may be called concurrently from several threads.
+void set_error_callback(ErrorCallback callback, void* user_data);
+
+// Records an error for the calling thread without reporting it again.
+// Used by parallel_for to hand errors raised on worker threads to the caller.
+// The message is copied, so it may belong to a thread that has exited since.
+void restore_last_error(ArrayError code, const char* message);
+
+#endif // UTILS_H
@@ -15,7 +15,7 @@ Array* create_array(DataType dtype, size_t ndim, size_t *shape, void *data) {
     } else {
         free(arr->shape);
         free(arr);
-        log_error("Shape is NULL");
+        log_error(ARRAY_ERROR_NULL, "Shape is NULL");
         return NULL;
     }
 
@@ -34,9 +34,97 @@ Array* create_array(DataType dtype, size_t ndim, size_t *shape, void *data) {
         return NULL;
     }
 
-    data ? memcpy(arr->data, data, data_size) : memset(arr->data, 0, data_size);
+    arr->ref_count = allocate_ref_count();
+    if (!arr->ref_count) {
+        free(arr->data);
+        free(arr->shape);
+        free(arr);
+        return NULL;
+    }
+
+    // allocate_data_memory returns zeroed memory; large copies follow its NUMA placement
+    if (data) {
+        parallel_memcpy(arr->data, data, data_size);
+    }
 
     arr->dtype = dtype;
 
     return arr;
-}
\ No newline at end of file
+}
+
+/**
+ * Create an array that shares the data block of another one.
+ *
+ * Only the shape is copied; the shared block is copied lazily by
+ * make_array_writable when either array is first written.
+ *
+ * @param arr The array to clone.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* clone_array(Array* arr) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    Array* clone = allocate_array_memory();
+    if (!clone) return NULL;
+
+    clone->shape = allocate_shape_memory(arr->ndim);
+    if (!clone->shape) {
+        free(clone);
+        return NULL;
+    }
+    memcpy(clone->shape, arr->shape, arr->ndim * sizeof(size_t));
+
+    clone->ndim = arr->ndim;
+    clone->size = arr->size;
+    clone->dtype = arr->dtype;
+    clone->data = arr->data;
+    clone->ref_count = arr->ref_count;
+    __atomic_add_fetch(clone->ref_count, 1, __ATOMIC_RELAXED);
+    return clone;
+}
+
+/**
+ * Detach an array from the clones sharing its data block before a write.
+ *
+ * An array whose count is 1 owns its block and is left untouched. Otherwise
+ * the block is copied and the old count released; if every other owner
+ * detached concurrently, the last one to release frees the old block.
+ *
+ * @param arr The array about to be written.
+ * @return 1 on success, 0 if memory allocation fails.
+ */
+int make_array_writable(Array* arr) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return 0;
+        }
+    #endif
+
+    if (__atomic_load_n(arr->ref_count, __ATOMIC_ACQUIRE) == 1) {
+        return 1;
+    }
+
+    size_t data_size = arr->size * get_dtype_size(arr->dtype);
+    void* data = allocate_data_memory(data_size);
+    size_t* ref_count = allocate_ref_count();
+    if (!data || !ref_count) {
+        free(data);
+        free(ref_count);
+        return 0;
+    }
+    parallel_memcpy(data, arr->data, data_size);
+
+    if (__atomic_sub_fetch(arr->ref_count, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(arr->data);
+        free(arr->ref_count);
+    }
+    arr->data = data;
+    arr->ref_count = ref_count;
+    return 1;
+}
@@ -3,10 +3,13 @@
 #include <stdio.h>
 #include <string.h>
 
+// Blocks at least this large are placed across NUMA nodes by first touch
+#define NUMA_FIRST_TOUCH_BYTES (1 << 22)
+
 Array* allocate_array_memory() {
     Array* arr = malloc(sizeof(Array));
     if (!arr) {
-        log_error("Failed to allocate array memory");
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate array memory");
         return NULL;
     }
     return arr;
@@ -15,13 +18,13 @@ Array* allocate_array_memory() {
 size_t* allocate_shape_memory(size_t ndim) {
 
     if (ndim == 0) {
-        log_error("Number of dimensions is 0");
+        log_error(ARRAY_ERROR_SHAPE, "Number of dimensions is 0");
         return NULL;
     }
 
     size_t *shape = calloc(ndim, sizeof(size_t));
     if (!shape) {
-        log_error("Failed to allocate shape memory");
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate shape memory");
         return NULL;
     }
     return shape;
@@ -29,22 +32,48 @@ size_t* allocate_shape_memory(size_t ndim) {
 
 void* allocate_data_memory(size_t data_size) {
     if (data_size == 0) {
-        log_error("Data size is 0");
+        log_error(ARRAY_ERROR_VALUE, "Data size is 0");
         return NULL;
     }
 
+    // On NUMA machines large blocks are zeroed by parallel_for, so each page is
+    // first touched, and therefore placed, on the node whose threads process it
+    if (data_size >= NUMA_FIRST_TOUCH_BYTES && get_numa_nodes() > 1) {
+        void* data = malloc(data_size);
+        if (!data) {
+            log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for data");
+            return NULL;
+        }
+        parallel_memset(data, 0, data_size);
+        return data;
+    }
+
     void *data = calloc(data_size, 1);
     if (!data) {
-        log_error("Failed to allocate memory for data");
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for data");
         return NULL;
     }
     return data;
 }
 
+size_t* allocate_ref_count() {
+    size_t* ref_count = malloc(sizeof(size_t));
+    if (!ref_count) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate reference count");
+        return NULL;
+    }
+    *ref_count = 1;
+    return ref_count;
+}
+
 void free_array(Array* arr) {
     if (arr) {
         free(arr->shape);
-        free(arr->data);
+        // The last array referencing the block frees it
+        if (__atomic_sub_fetch(arr->ref_count, 1, __ATOMIC_ACQ_REL) == 0) {
+            free(arr->data);
+            free(arr->ref_count);
+        }
         free(arr);
     }
 }
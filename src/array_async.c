@@ -0,0 +1,679 @@
+#include "array_async.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+// Initial capacity of a worker's task deque
+#define DEQUE_INITIAL_CAPACITY 64
+
+// Tasks a waiting worker may run inside one another on one stack
+#define MAX_NESTED_TASKS 32
+
+// Longest error message kept by a future, including the terminator
+#define FUTURE_MESSAGE_MAX 128
+
+typedef struct CallbackNode {
+    FutureCallback callback;
+    void* user_data;
+    struct CallbackNode* next;
+} CallbackNode;
+
+struct ArrayFuture {
+    pthread_mutex_t lock;
+    pthread_cond_t done_cond;
+    int done;                      // Set under lock once result and error are final
+    Array* result;
+    int owns_result;               // 0 for futures wrapping a caller's array
+    ArrayError error;
+    char message[FUTURE_MESSAGE_MAX];  // Copied: the worker's message may not outlive it
+
+    AsyncFunc func;
+    void* ctx;
+    ArrayFuture** deps;            // Referenced until the task has run
+    size_t n_deps;
+    size_t pending;                // Unfinished dependencies, plus one until submission completes
+
+    ArrayFuture** dependents;      // Tasks waiting for this one (under lock)
+    size_t n_dependents;
+    size_t dependents_capacity;
+    CallbackNode* callbacks;       // Under lock
+
+    size_t refs;                   // The caller, the scheduler until the task has run, and each dependent
+};
+
+// Double-ended queue of ready tasks: its owner pushes and pops at the
+// bottom (most recent first, for locality), thieves take from the top.
+typedef struct {
+    pthread_mutex_t lock;
+    ArrayFuture** tasks;
+    size_t capacity;
+    size_t top, bottom;            // Ring buffer indices; bottom - top tasks are queued
+    pthread_t thread;
+    int running;                   // The thread was created
+    size_t node;                   // NUMA node the worker is bound to
+    uint32_t seed;                 // Victim selection for stealing
+} Worker;
+
+typedef struct {
+    Worker* workers;
+    size_t n_workers;
+    size_t queued;                 // Tasks in all deques (atomic)
+    size_t active;                 // Submitted tasks that have not completed (atomic)
+    size_t next_worker;            // Round-robin target for submissions from other threads (atomic)
+    size_t sleepers;               // Workers waiting for tasks (atomic)
+    int started;                   // Atomic
+    int shutdown;
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake_cond;      // Signaled when a task is queued or at shutdown
+    pthread_cond_t idle_cond;      // Signaled when no task is active
+    pthread_mutex_t start_lock;
+} TaskPool;
+
+static TaskPool pool = {
+    .sleep_lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake_cond = PTHREAD_COND_INITIALIZER,
+    .idle_cond = PTHREAD_COND_INITIALIZER,
+    .start_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// Worker run by the current thread, NULL outside the pool
+static _Thread_local Worker* current_worker = NULL;
+
+// Tasks the current worker is running inside future_wait
+static _Thread_local size_t nested_tasks = 0;
+
+static void release_future(ArrayFuture* f) {
+    if (__atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+    if (f->owns_result) {
+        free_array(f->result);
+    }
+    for (CallbackNode* node = f->callbacks; node;) {
+        CallbackNode* next = node->next;
+        free(node);
+        node = next;
+    }
+    free(f->deps);
+    free(f->dependents);
+    pthread_mutex_destroy(&f->lock);
+    pthread_cond_destroy(&f->done_cond);
+    free(f);
+}
+
+static ArrayFuture* create_future() {
+    ArrayFuture* f = calloc(1, sizeof(ArrayFuture));
+    if (!f) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for future");
+        return NULL;
+    }
+    pthread_mutex_init(&f->lock, NULL);
+    pthread_cond_init(&f->done_cond, NULL);
+    f->owns_result = 1;
+    f->error = ARRAY_OK;
+    f->refs = 1;
+    return f;
+}
+
+static int deque_push(Worker* w, ArrayFuture* f) {
+    pthread_mutex_lock(&w->lock);
+    if (w->bottom - w->top == w->capacity) {
+        size_t capacity = w->capacity ? 2 * w->capacity : DEQUE_INITIAL_CAPACITY;
+        ArrayFuture** tasks = malloc(capacity * sizeof(ArrayFuture*));
+        if (!tasks) {
+            pthread_mutex_unlock(&w->lock);
+            return 0;
+        }
+        for (size_t i = w->top; i < w->bottom; i++) {
+            tasks[i - w->top] = w->tasks[i % w->capacity];
+        }
+        free(w->tasks);
+        w->tasks = tasks;
+        w->bottom -= w->top;
+        w->top = 0;
+        w->capacity = capacity;
+    }
+    w->tasks[w->bottom++ % w->capacity] = f;
+    pthread_mutex_unlock(&w->lock);
+    return 1;
+}
+
+static ArrayFuture* deque_pop(Worker* w) {
+    ArrayFuture* f = NULL;
+    pthread_mutex_lock(&w->lock);
+    if (w->bottom != w->top) {
+        f = w->tasks[--w->bottom % w->capacity];
+    }
+    pthread_mutex_unlock(&w->lock);
+    return f;
+}
+
+static ArrayFuture* deque_steal(Worker* w) {
+    ArrayFuture* f = NULL;
+    pthread_mutex_lock(&w->lock);
+    if (w->bottom != w->top) {
+        f = w->tasks[w->top++ % w->capacity];
+    }
+    pthread_mutex_unlock(&w->lock);
+    return f;
+}
+
+// Takes a task from the worker's own deque, or steals one from another
+// worker, trying the workers on the same NUMA node first
+static ArrayFuture* find_task(Worker* self) {
+    if (__atomic_load_n(&pool.queued, __ATOMIC_SEQ_CST) == 0) {
+        return NULL;
+    }
+    ArrayFuture* f = self ? deque_pop(self) : NULL;
+    if (!f) {
+        uint32_t seed = self ? self->seed : 1;
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        if (self) {
+            self->seed = seed;
+        }
+        for (int remote = 0; remote < 2 && !f; remote++) {
+            for (size_t i = 0; i < pool.n_workers && !f; i++) {
+                Worker* victim = &pool.workers[(seed + i) % pool.n_workers];
+                int local = !self || victim->node == self->node;
+                if (victim != self && local != remote) {
+                    f = deque_steal(victim);
+                }
+            }
+        }
+    }
+    if (f) {
+        __atomic_sub_fetch(&pool.queued, 1, __ATOMIC_SEQ_CST);
+    }
+    return f;
+}
+
+// Queues a ready task on the current worker, or spreads submissions from other threads over the workers
+static void schedule(ArrayFuture* f) {
+    Worker* w = current_worker;
+    if (!w) {
+        size_t next = __atomic_fetch_add(&pool.next_worker, 1, __ATOMIC_RELAXED);
+        w = &pool.workers[next % pool.n_workers];
+    }
+    // Counted before it is visible, so the count never drops below zero
+    __atomic_add_fetch(&pool.queued, 1, __ATOMIC_SEQ_CST);
+    while (!deque_push(w, f)) {
+        // Out of memory for a larger deque: wait for the workers to drain it
+        sched_yield();
+    }
+    if (__atomic_load_n(&pool.sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool.sleep_lock);
+        pthread_cond_signal(&pool.wake_cond);
+        pthread_mutex_unlock(&pool.sleep_lock);
+    }
+}
+
+/**
+ * Publish the outcome of a task and release what it held.
+ *
+ * Dependents whose last dependency this was are queued, then the completion
+ * callbacks run on the current thread.
+ */
+static void complete_task(ArrayFuture* f, Array* result, ArrayError error, const char* message) {
+    pthread_mutex_lock(&f->lock);
+    f->result = result;
+    f->error = error;
+    snprintf(f->message, sizeof(f->message), "%s", message);
+    f->done = 1;
+    ArrayFuture** dependents = f->dependents;
+    size_t n_dependents = f->n_dependents;
+    CallbackNode* callbacks = f->callbacks;
+    f->dependents = NULL;
+    f->n_dependents = 0;
+    f->callbacks = NULL;
+    pthread_cond_broadcast(&f->done_cond);
+    pthread_mutex_unlock(&f->lock);
+
+    for (size_t i = 0; i < n_dependents; i++) {
+        if (__atomic_sub_fetch(&dependents[i]->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+            schedule(dependents[i]);
+        }
+    }
+    free(dependents);
+    for (CallbackNode* node = callbacks; node;) {
+        CallbackNode* next = node->next;
+        node->callback(f, node->user_data);
+        free(node);
+        node = next;
+    }
+
+    for (size_t i = 0; i < f->n_deps; i++) {
+        release_future(f->deps[i]);
+    }
+    f->n_deps = 0;
+    release_future(f);
+
+    if (__atomic_sub_fetch(&pool.active, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&pool.sleep_lock);
+        pthread_cond_broadcast(&pool.idle_cond);
+        pthread_mutex_unlock(&pool.sleep_lock);
+    }
+}
+
+static void run_task(ArrayFuture* f) {
+    Array* inputs[f->n_deps ? f->n_deps : 1];
+    ArrayError error = ARRAY_OK;
+    const char* message = "";
+    for (size_t i = 0; i < f->n_deps; i++) {
+        if (f->deps[i]->error != ARRAY_OK) {
+            error = f->deps[i]->error;
+            message = f->deps[i]->message;
+            break;
+        }
+        inputs[i] = f->deps[i]->result;
+    }
+
+    Array* result = NULL;
+    if (error == ARRAY_OK) {
+        clear_last_error();
+        result = f->func(inputs, f->ctx);
+        error = get_last_error();
+        message = get_last_error_message();
+    }
+    complete_task(f, result, error, message);
+}
+
+// Runs a task from inside future_wait, keeping the error state of the waiting task
+static void run_nested_task(ArrayFuture* f) {
+    ArrayError error = get_last_error();
+    char message[FUTURE_MESSAGE_MAX];
+    snprintf(message, sizeof(message), "%s", get_last_error_message());
+    nested_tasks++;
+    run_task(f);
+    nested_tasks--;
+    restore_last_error(error, message);
+}
+
+static int is_done(ArrayFuture* f) {
+    pthread_mutex_lock(&f->lock);
+    int done = f->done;
+    pthread_mutex_unlock(&f->lock);
+    return done;
+}
+
+// Runs queued tasks until the future completes
+static void help_until_done(Worker* w, ArrayFuture* future) {
+    while (!is_done(future)) {
+        ArrayFuture* f = find_task(w);
+        if (f) {
+            run_nested_task(f);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+typedef struct {
+    Worker* worker;
+    ArrayFuture* future;
+} HelperArgs;
+
+// Carries on the wait of a worker that reached MAX_NESTED_TASKS on a fresh stack,
+// serving the same deque; blocking instead could stall the pool on long chains
+// of tasks waiting on one another
+static void* helper_main(void* arg) {
+    HelperArgs* args = arg;
+    current_worker = args->worker;
+    bind_thread_to_node(args->worker->node);
+    set_thread_num_threads(1);
+    help_until_done(args->worker, args->future);
+    return NULL;
+}
+
+static void* worker_main(void* arg) {
+    Worker* self = arg;
+    current_worker = self;
+    bind_thread_to_node(self->node);
+    // Operations inside a task stay on this worker; the pool provides the parallelism
+    set_thread_num_threads(1);
+
+    for (;;) {
+        ArrayFuture* f = find_task(self);
+        if (f) {
+            run_task(f);
+            continue;
+        }
+        pthread_mutex_lock(&pool.sleep_lock);
+        __atomic_add_fetch(&pool.sleepers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&pool.queued, __ATOMIC_SEQ_CST) == 0 && !pool.shutdown) {
+            pthread_cond_wait(&pool.wake_cond, &pool.sleep_lock);
+        }
+        __atomic_sub_fetch(&pool.sleepers, 1, __ATOMIC_SEQ_CST);
+        int stop = pool.shutdown && __atomic_load_n(&pool.queued, __ATOMIC_SEQ_CST) == 0;
+        pthread_mutex_unlock(&pool.sleep_lock);
+        if (stop) {
+            return NULL;
+        }
+    }
+}
+
+static int start_pool() {
+    if (__atomic_load_n(&pool.started, __ATOMIC_ACQUIRE)) {
+        return 1;
+    }
+    pthread_mutex_lock(&pool.start_lock);
+    if (!pool.started) {
+        size_t n = get_num_threads();
+        pool.workers = calloc(n, sizeof(Worker));
+        if (!pool.workers) {
+            log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for task pool");
+            pthread_mutex_unlock(&pool.start_lock);
+            return 0;
+        }
+        pool.shutdown = 0;
+        pool.n_workers = n;
+        for (size_t i = 0; i < n; i++) {
+            pthread_mutex_init(&pool.workers[i].lock, NULL);
+            pool.workers[i].seed = (uint32_t)(2654435761u * (i + 1));
+            pool.workers[i].node = i * get_numa_nodes() / n;
+        }
+        // Tasks queued on a worker whose thread failed to start are stolen by the others
+        size_t running = 0;
+        for (size_t i = 0; i < n; i++) {
+            pool.workers[i].running = pthread_create(&pool.workers[i].thread, NULL, worker_main, &pool.workers[i]) == 0;
+            running += pool.workers[i].running;
+        }
+        if (running == 0) {
+            log_error(ARRAY_ERROR_VALUE, "Failed to start worker threads");
+            free(pool.workers);
+            pool.workers = NULL;
+            pthread_mutex_unlock(&pool.start_lock);
+            return 0;
+        }
+        __atomic_store_n(&pool.started, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&pool.start_lock);
+    return 1;
+}
+
+/**
+ * Submit a task that runs once its dependencies have completed.
+ *
+ * The task registers itself with every unfinished dependency; the last
+ * dependency to complete queues it. A pending count that starts at one keeps
+ * the task from being queued before registration is finished.
+ *
+ * @return A new future, or NULL on error.
+ */
+ArrayFuture* submit_async(AsyncFunc func, void* ctx, ArrayFuture** deps, size_t n_deps) {
+    #if DEBUG_MODE
+        if (!func || (n_deps && !deps)) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return NULL;
+        }
+        for (size_t i = 0; i < n_deps; i++) {
+            if (!deps[i]) {
+                log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+                return NULL;
+            }
+        }
+    #endif
+
+    if (!start_pool()) {
+        return NULL;
+    }
+    ArrayFuture* f = create_future();
+    if (!f) {
+        return NULL;
+    }
+    f->deps = malloc((n_deps ? n_deps : 1) * sizeof(ArrayFuture*));
+    if (!f->deps) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for future");
+        release_future(f);
+        return NULL;
+    }
+    f->func = func;
+    f->ctx = ctx;
+    f->n_deps = n_deps;
+    f->refs = 2;  // The caller and the scheduler
+    f->pending = 1;
+    __atomic_add_fetch(&pool.active, 1, __ATOMIC_ACQ_REL);
+
+    for (size_t i = 0; i < n_deps; i++) {
+        ArrayFuture* dep = deps[i];
+        __atomic_add_fetch(&dep->refs, 1, __ATOMIC_RELAXED);
+        f->deps[i] = dep;
+
+        pthread_mutex_lock(&dep->lock);
+        if (!dep->done) {
+            if (dep->n_dependents == dep->dependents_capacity) {
+                size_t capacity = dep->dependents_capacity ? 2 * dep->dependents_capacity : 4;
+                ArrayFuture** dependents = realloc(dep->dependents, capacity * sizeof(ArrayFuture*));
+                if (!dependents) {
+                    // Wait for the dependency instead of registering with it
+                    pthread_mutex_unlock(&dep->lock);
+                    future_wait(dep);
+                    continue;
+                }
+                dep->dependents = dependents;
+                dep->dependents_capacity = capacity;
+            }
+            dep->dependents[dep->n_dependents++] = f;
+            __atomic_add_fetch(&f->pending, 1, __ATOMIC_ACQ_REL);
+        }
+        pthread_mutex_unlock(&dep->lock);
+    }
+
+    if (__atomic_sub_fetch(&f->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        schedule(f);
+    }
+    return f;
+}
+
+ArrayFuture* future_from_array(Array* arr) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    ArrayFuture* f = create_future();
+    if (!f) {
+        return NULL;
+    }
+    f->result = arr;
+    f->owns_result = 0;
+    f->done = 1;
+    return f;
+}
+
+// Task bodies of the asynchronous operations; scalar arguments travel in ctx
+static Array* broadcast_task(Array** inputs, void* ctx) {
+    return broadcast_arrays(inputs[0], inputs[1], (char)(uintptr_t)ctx);
+}
+
+static Array* sum_along_axis_task(Array** inputs, void* ctx) {
+    return sum_along_axis(inputs[0], (size_t)(uintptr_t)ctx);
+}
+
+static Array* matmul_task(Array** inputs, void* ctx) {
+    (void)ctx;
+    return matmul(inputs[0], inputs[1]);
+}
+
+static Array* solve_task(Array** inputs, void* ctx) {
+    (void)ctx;
+    return solve(inputs[0], inputs[1]);
+}
+
+static Array* fft_task(Array** inputs, void* ctx) {
+    return fft(inputs[0], (size_t)(uintptr_t)ctx);
+}
+
+ArrayFuture* broadcast_arrays_async(ArrayFuture* arr_a, ArrayFuture* arr_b, char operation_symbol) {
+    ArrayFuture* deps[2] = { arr_a, arr_b };
+    return submit_async(broadcast_task, (void*)(uintptr_t)(unsigned char)operation_symbol, deps, 2);
+}
+
+ArrayFuture* sum_along_axis_async(ArrayFuture* arr, size_t axis) {
+    return submit_async(sum_along_axis_task, (void*)(uintptr_t)axis, &arr, 1);
+}
+
+ArrayFuture* matmul_async(ArrayFuture* arr_a, ArrayFuture* arr_b) {
+    ArrayFuture* deps[2] = { arr_a, arr_b };
+    return submit_async(matmul_task, NULL, deps, 2);
+}
+
+ArrayFuture* solve_async(ArrayFuture* arr_a, ArrayFuture* arr_b) {
+    ArrayFuture* deps[2] = { arr_a, arr_b };
+    return submit_async(solve_task, NULL, deps, 2);
+}
+
+ArrayFuture* fft_async(ArrayFuture* arr, size_t axis) {
+    return submit_async(fft_task, (void*)(uintptr_t)axis, &arr, 1);
+}
+
+/**
+ * Wait for a future to complete.
+ *
+ * Threads outside the pool sleep until the task completes. Workers keep
+ * running queued tasks instead, so a task waiting on another task cannot
+ * deadlock the pool. These nested tasks keep the error state of the waiting
+ * task, and at most MAX_NESTED_TASKS of them run inside one another on one
+ * stack; deeper waits continue on a helper thread.
+ *
+ * @return The result, or NULL if the task failed.
+ */
+Array* future_wait(ArrayFuture* future) {
+    #if DEBUG_MODE
+        if (!future) {
+            log_error(ARRAY_ERROR_NULL, "Future is NULL");
+            return NULL;
+        }
+    #endif
+
+    pthread_t helper;
+    if (current_worker && nested_tasks < MAX_NESTED_TASKS) {
+        help_until_done(current_worker, future);
+    } else if (current_worker && pthread_create(&helper, NULL, helper_main,
+                                                &(HelperArgs){ current_worker, future }) == 0) {
+        pthread_join(helper, NULL);
+    } else {
+        pthread_mutex_lock(&future->lock);
+        while (!future->done) {
+            pthread_cond_wait(&future->done_cond, &future->lock);
+        }
+        pthread_mutex_unlock(&future->lock);
+    }
+
+    if (future->error != ARRAY_OK) {
+        restore_last_error(future->error, future->message);
+        return NULL;
+    }
+    return future->result;
+}
+
+int future_wait_all(ArrayFuture** futures, size_t n) {
+    #if DEBUG_MODE
+        if (n && !futures) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return 0;
+        }
+    #endif
+
+    int ok = 1;
+    for (size_t i = 0; i < n; i++) {
+        future_wait(futures[i]);
+        ok &= futures[i]->error == ARRAY_OK;
+    }
+    return ok;
+}
+
+int future_is_done(ArrayFuture* future) {
+    #if DEBUG_MODE
+        if (!future) {
+            log_error(ARRAY_ERROR_NULL, "Future is NULL");
+            return 0;
+        }
+    #endif
+    return is_done(future);
+}
+
+ArrayError future_error(ArrayFuture* future) {
+    #if DEBUG_MODE
+        if (!future) {
+            log_error(ARRAY_ERROR_NULL, "Future is NULL");
+            return ARRAY_ERROR_NULL;
+        }
+    #endif
+
+    pthread_mutex_lock(&future->lock);
+    ArrayError error = future->done ? future->error : ARRAY_OK;
+    pthread_mutex_unlock(&future->lock);
+    return error;
+}
+
+int future_on_complete(ArrayFuture* future, FutureCallback callback, void* user_data) {
+    #if DEBUG_MODE
+        if (!future || !callback) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return 0;
+        }
+    #endif
+
+    pthread_mutex_lock(&future->lock);
+    if (future->done) {
+        pthread_mutex_unlock(&future->lock);
+        callback(future, user_data);
+        return 1;
+    }
+    CallbackNode* node = malloc(sizeof(CallbackNode));
+    if (!node) {
+        pthread_mutex_unlock(&future->lock);
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for callback");
+        return 0;
+    }
+    // Callbacks run in registration order
+    node->callback = callback;
+    node->user_data = user_data;
+    node->next = NULL;
+    CallbackNode** tail = &future->callbacks;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = node;
+    pthread_mutex_unlock(&future->lock);
+    return 1;
+}
+
+void future_free(ArrayFuture* future) {
+    if (future) {
+        release_future(future);
+    }
+}
+
+void async_shutdown() {
+    pthread_mutex_lock(&pool.start_lock);
+    if (!pool.started) {
+        pthread_mutex_unlock(&pool.start_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.sleep_lock);
+    while (__atomic_load_n(&pool.active, __ATOMIC_ACQUIRE) != 0) {
+        pthread_cond_wait(&pool.idle_cond, &pool.sleep_lock);
+    }
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool.wake_cond);
+    pthread_mutex_unlock(&pool.sleep_lock);
+
+    for (size_t i = 0; i < pool.n_workers; i++) {
+        if (pool.workers[i].running) {
+            pthread_join(pool.workers[i].thread, NULL);
+        }
+        pthread_mutex_destroy(&pool.workers[i].lock);
+        free(pool.workers[i].tasks);
+    }
+    free(pool.workers);
+    pool.workers = NULL;
+    pool.n_workers = 0;
+    __atomic_store_n(&pool.started, 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&pool.start_lock);
+}
@@ -19,11 +19,11 @@
 size_t* broadcast_shapes(size_t* shapeA, size_t ndimA, size_t* shapeB, size_t ndimB, size_t* result_ndim) {
     #if DEBUG_MODE
         if (!shapeA || !shapeB) {
-            log_error("One of the inputs is NULL");
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
             return NULL;
         }
         if (ndimA == 0 || ndimB == 0) {
-            log_error("Number of dimensions is 0");
+            log_error(ARRAY_ERROR_SHAPE, "Number of dimensions is 0");
             return NULL; 
         }
     #endif
@@ -42,7 +42,7 @@ size_t* broadcast_shapes(size_t* shapeA, size_t ndimA, size_t* shapeB, size_t nd
 
         if (!are_dims_compatible(dimA, dimB)) {
             free(result_shape);
-            log_error("Shapes are not broadcastable");
+            log_error(ARRAY_ERROR_SHAPE, "Shapes are not broadcastable");
             return NULL; 
         }
         // The broadcasted dimension is the maximum of the two (since one may be 1)
@@ -107,7 +107,7 @@ size_t* map_broadcasted_to_original_indices(
 ) {
     #if DEBUG_MODE
         if (!broadcasted_shape || !original_shape || !broadcasted_indices) {
-            log_error("One of the inputs is NULL");
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
             return NULL;
         }
     #endif
@@ -128,7 +128,7 @@ size_t* map_broadcasted_to_original_indices(
         // Validate that the broadcast index is within the bounds of the broadcasted dimension
         if (broadcast_index >= broadcast_dim) {
             free(original_indices);
-            log_error("Broadcast index out of bounds for the current dimension");
+            log_error(ARRAY_ERROR_INDEX, "Broadcast index out of bounds for the current dimension");
             return NULL;
         }
         
@@ -140,7 +140,7 @@ size_t* map_broadcasted_to_original_indices(
             original_indices[i] = 0;
         } else {
             free(original_indices);
-            log_error("Shapes are incompatible");
+            log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
             return NULL;
         }
     }
@@ -149,41 +149,249 @@ size_t* map_broadcasted_to_original_indices(
 }
 
 /**
- * Fast broadcasting for arrays with identical shapes.
+ * Compute the byte strides of an array viewed with a broadcasted shape.
  *
- * When two arrays have the same shape, no index remapping is needed.
- * This function simply applies the operation element-wise.
+ * The original shape is aligned to the right of the broadcasted shape.
+ * Dimensions where the original array has size 1 (or that do not exist in it)
+ * are broadcast and get a stride of 0, so walking them repeats the same elements.
  *
- * @param arr_a First input array.
- * @param arr_b Second input array.
- * @param operation_symbol The operation to apply.
- * @return A new array containing the results.
+ * @param arr The original array.
+ * @param result_shape The broadcasted shape.
+ * @param result_ndim Number of dimensions in the broadcasted shape.
+ * @return A newly allocated array of byte strides, or NULL if the shapes are incompatible.
  */
-Array* broadcast_arrays_fast(Array* arr_a, Array* arr_b, char operation_symbol) {
-    size_t data_size = arr_a->size * get_dtype_size(arr_a->dtype);
-    Array* result = create_array(arr_a->dtype, arr_a->ndim, arr_a->shape, NULL);
-    if (!result) {
+size_t* broadcast_strides(Array* arr, size_t* result_shape, size_t result_ndim) {
+    #if DEBUG_MODE
+        if (!arr || !result_shape) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (arr->ndim > result_ndim) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
         return NULL;
     }
-   
 
+    size_t* strides = allocate_shape_memory(result_ndim);
+    if (!strides) {
+        return NULL;
+    }
 
-    // Loop through each element in the arrays
-    for (size_t i = 0; i < arr_a->size; i++) {
-        void* elem_a = (char*)arr_a->data + i * get_dtype_size(arr_a->dtype);
-        void* elem_b = (char*)arr_b->data + i * get_dtype_size(arr_b->dtype);
-        void* elem_res = (char*)result->data + i * get_dtype_size(result->dtype);
+    size_t shape_offset = result_ndim - arr->ndim;
+    size_t stride = get_dtype_size(arr->dtype);
+    // Walk the original dimensions from the rightmost side, accumulating the row-major stride
+    for (size_t i = arr->ndim; i-- > 0;) {
+        size_t original_dim = arr->shape[i];
+        size_t broadcast_dim = result_shape[i + shape_offset];
 
-        apply_operation(operation_symbol, elem_res, elem_a, elem_b, arr_a->dtype);
+        if (original_dim == broadcast_dim) {
+            strides[i + shape_offset] = stride;
+        } else if (original_dim == 1) {
+            strides[i + shape_offset] = 0;
+        } else {
+            free(strides);
+            log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+            return NULL;
+        }
+        stride *= original_dim;
+    }
+    // Leading dimensions missing from the original array stay at 0 (calloc)
+
+    return strides;
+}
+
+// Work shared by the threads of broadcast_apply
+typedef struct {
+    Array* result;
+    size_t n_inputs;
+    char* bases[MAX_BROADCAST_INPUTS];
+    size_t inner_strides[MAX_BROADCAST_INPUTS];
+    size_t* strides[MAX_BROADCAST_INPUTS];  // NULL when every input has the result shape
+    StridedLoopFunc loop;
+    // Result shape and input strides padded to FIXED_LOOP_RANK, for results of that rank or less
+    size_t shape[FIXED_LOOP_RANK];
+    size_t fixed_strides[MAX_BROADCAST_INPUTS][FIXED_LOOP_RANK];
+} BroadcastContext;
+
+// Applies the loop to the elements [begin, end) of inputs that all have the result shape
+static void broadcast_contiguous(size_t begin, size_t end, void* ctx) {
+    BroadcastContext* b = ctx;
+    size_t out_size = get_dtype_size(b->result->dtype);
+    char* ptrs[MAX_BROADCAST_INPUTS];
+    for (size_t k = 0; k < b->n_inputs; k++) {
+        ptrs[k] = b->bases[k] + begin * b->inner_strides[k];
+    }
+    b->loop((char*)b->result->data + begin * out_size, ptrs, b->inner_strides, end - begin);
+}
+
+// Applies the loop to the result rows [begin, end) of a result of rank FIXED_LOOP_RANK or
+// less, walking its padded outer dimensions as a fixed loop nest resumed at row begin
+static void broadcast_rows_fixed(size_t begin, size_t end, void* ctx) {
+    BroadcastContext* b = ctx;
+    const size_t s0 = b->shape[0], s1 = b->shape[1], s2 = b->shape[2], inner = b->shape[3];
+    const size_t n_inputs = b->n_inputs;
+    size_t row_bytes = inner * get_dtype_size(b->result->dtype);
+    char* out = (char*)b->result->data + begin * row_bytes;
+    char* ptrs[MAX_BROADCAST_INPUTS];
+
+    size_t i2 = begin % s2, i1 = begin / s2 % s1, i0 = begin / s2 / s1;
+    size_t rows = end - begin;
+    for (; i0 < s0; i0++, i1 = 0) {
+        for (; i1 < s1; i1++, i2 = 0) {
+            for (; i2 < s2; i2++) {
+                if (rows-- == 0) {
+                    return;
+                }
+                for (size_t k = 0; k < n_inputs; k++) {
+                    const size_t* st = b->fixed_strides[k];
+                    ptrs[k] = b->bases[k] + i0 * st[0] + i1 * st[1] + i2 * st[2];
+                }
+                b->loop(out, ptrs, b->inner_strides, inner);
+                out += row_bytes;
+            }
+        }
+    }
+}
+
+// Applies the loop to the result rows [begin, end) of a result of any rank
+static void broadcast_rows(size_t begin, size_t end, void* ctx) {
+    BroadcastContext* b = ctx;
+    const size_t* shape = b->result->shape;
+    size_t ndim = b->result->ndim;
+    size_t inner = shape[ndim - 1];
+    size_t row_bytes = inner * get_dtype_size(b->result->dtype);
+
+    // Start the odometer at row begin
+    size_t counter[ndim];
+    char* ptrs[MAX_BROADCAST_INPUTS];
+    for (size_t k = 0; k < b->n_inputs; k++) {
+        ptrs[k] = b->bases[k];
+    }
+    counter[ndim - 1] = 0;
+    for (size_t d = ndim - 1, rest = begin; d-- > 0;) {
+        counter[d] = rest % shape[d];
+        rest /= shape[d];
+        for (size_t k = 0; k < b->n_inputs; k++) {
+            ptrs[k] += counter[d] * b->strides[k][d];
+        }
+    }
+
+    char* out = (char*)b->result->data + begin * row_bytes;
+    for (size_t row = begin; row < end; row++) {
+        b->loop(out, ptrs, b->inner_strides, inner);
+        out += row_bytes;
+
+        // Advance the odometer over the outer dimensions
+        for (size_t d = ndim - 1; d-- > 0;) {
+            counter[d]++;
+            for (size_t k = 0; k < b->n_inputs; k++) {
+                ptrs[k] += b->strides[k][d];
+            }
+            if (counter[d] < shape[d]) {
+                break;
+            }
+            for (size_t k = 0; k < b->n_inputs; k++) {
+                ptrs[k] -= b->strides[k][d] * shape[d];
+            }
+            counter[d] = 0;
+        }
     }
-    return result;
+}
+
+/**
+ * Apply a strided inner loop over every row of a broadcasted result.
+ *
+ * The last dimension of the result is handed to the loop in one call. Results
+ * of rank FIXED_LOOP_RANK or less walk their outer dimensions as a fixed loop
+ * nest; higher ranks use an odometer that bumps the input pointers by their
+ * broadcast strides. Either way no per-element division or index mapping is
+ * needed. When every input already has the result shape the whole buffer is
+ * processed as a single contiguous row. Large results are split into
+ * contiguous ranges across threads, so each range of a NUMA-placed result is
+ * written on its own node.
+ *
+ * @param result The preallocated result array.
+ * @param inputs The input arrays.
+ * @param n_inputs Number of input arrays (at most MAX_BROADCAST_INPUTS).
+ * @param loop The inner loop to apply.
+ * @return 1 on success, 0 on error.
+ */
+int broadcast_apply(Array* result, Array** inputs, size_t n_inputs, StridedLoopFunc loop) {
+    #if DEBUG_MODE
+        if (!result || !inputs || !loop) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return 0;
+        }
+        if (n_inputs == 0 || n_inputs > MAX_BROADCAST_INPUTS) {
+            log_error(ARRAY_ERROR_VALUE, "Unsupported number of broadcast inputs");
+            return 0;
+        }
+    #endif
+
+    if (!make_array_writable(result)) {
+        return 0;
+    }
+
+    BroadcastContext b = { result, n_inputs, { 0 }, { 0 }, { 0 }, loop, { 0 }, { { 0 } } };
+    size_t elem_bytes = get_dtype_size(result->dtype);
+
+    // Fast path: identical shapes need no index remapping at all
+    int all_equal = 1;
+    for (size_t k = 0; k < n_inputs; k++) {
+        b.bases[k] = inputs[k]->data;
+        b.inner_strides[k] = get_dtype_size(inputs[k]->dtype);
+        if (!are_shapes_equal(inputs[k]->shape, inputs[k]->ndim, result->shape, result->ndim)) {
+            all_equal = 0;
+        }
+    }
+    if (result->size == 0) {
+        return 1;
+    }
+    if (all_equal) {
+        parallel_for(result->size, PARALLEL_GRAIN_BYTES / elem_bytes + 1, broadcast_contiguous, &b);
+        return 1;
+    }
+
+    size_t ndim = result->ndim;
+    for (size_t k = 0; k < n_inputs; k++) {
+        b.strides[k] = broadcast_strides(inputs[k], result->shape, ndim);
+        if (!b.strides[k]) {
+            while (k-- > 0) {
+                free(b.strides[k]);
+            }
+            return 0;
+        }
+        b.inner_strides[k] = b.strides[k][ndim - 1];
+    }
+
+    ParallelFunc rows = broadcast_rows;
+    if (ndim <= FIXED_LOOP_RANK) {
+        size_t pad = FIXED_LOOP_RANK - ndim;
+        for (size_t d = 0; d < FIXED_LOOP_RANK; d++) {
+            b.shape[d] = d < pad ? 1 : result->shape[d - pad];
+            for (size_t k = 0; k < n_inputs; k++) {
+                b.fixed_strides[k][d] = d < pad ? 0 : b.strides[k][d - pad];
+            }
+        }
+        rows = broadcast_rows_fixed;
+    }
+
+    size_t inner = result->shape[ndim - 1];
+    size_t outer = result->size / inner;
+    parallel_for(outer, PARALLEL_GRAIN_BYTES / (inner * elem_bytes) + 1, rows, &b);
+
+    for (size_t k = 0; k < n_inputs; k++) {
+        free(b.strides[k]);
+    }
+    return 1;
 }
 
 /**
  * Broadcast two arrays and apply an operation on each element.
  *
- * This function computes the broadcasted shape of the two arrays, remaps
- * the indices appropriately, and then applies the operation element-wise.
+ * This function computes the broadcasted shape of the two arrays and then
+ * runs the typed loop for the operation through broadcast_apply.
  *
  * @param arr_a First input array.
  * @param arr_b Second input array.
@@ -193,24 +401,23 @@ Array* broadcast_arrays_fast(Array* arr_a, Array* arr_b, char operation_symbol)
 Array* broadcast_arrays(Array* arr_a, Array* arr_b, char operation_symbol) {
     #if DEBUG_MODE
         if (!arr_a || !arr_b) {
-            log_error("One of the arrays is NULL");
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
             return NULL;
         }
         if (arr_a->ndim == 0 || arr_b->ndim == 0) {
-            log_error("Empty array detected. Broadcasting is not possible.");
+            log_error(ARRAY_ERROR_SHAPE, "Empty array detected. Broadcasting is not possible.");
             return NULL;
         }
         if (arr_a->dtype != arr_b->dtype) {
-            log_error("Data types are not equal");
+            log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
             return NULL;
         }
     #endif
-    
-    // If the shapes are identical, use the fast broadcast method
-    if (are_shapes_equal(arr_a->shape, arr_a->ndim, arr_b->shape, arr_b->ndim)) {
-        return broadcast_arrays_fast(arr_a, arr_b, operation_symbol);
-    }
 
+    StridedLoopFunc loop = get_operation_loop(operation_symbol, arr_a->dtype);
+    if (!loop) {
+        return NULL;
+    }
 
     size_t result_ndim;
     size_t* result_shape = broadcast_shapes(arr_a->shape, arr_a->ndim, arr_b->shape, arr_b->ndim, &result_ndim);
@@ -219,53 +426,16 @@ Array* broadcast_arrays(Array* arr_a, Array* arr_b, char operation_symbol) {
     }
 
     Array* result = create_array(arr_a->dtype, result_ndim, result_shape, NULL);
+    free(result_shape); // create_array makes a copy
     if (!result) {
-        free(result_shape);
         return NULL;
     }
-    free(result_shape); // Assume create_array makes a copy if needed
 
-    // Allocate temporary memory to hold the broadcasted indices
-    size_t* indices = allocate_shape_memory(result_ndim);
-    if (!indices) {
+    Array* inputs[2] = { arr_a, arr_b };
+    if (!broadcast_apply(result, inputs, 2, loop)) {
         free_array(result);
         return NULL;
     }
-
-    // Iterate over every element in the result array
-    for (size_t i = 0; i < result->size; i++) {
-        size_t remaining_index = i;
-        // Compute multi-dimensional indices for the result array
-        for (size_t j = result_ndim; j-- > 0;) {
-            indices[j] = remaining_index % result->shape[j];
-            remaining_index /= result->shape[j];
-        }
-
-        // Map broadcasted indices to indices in the original arrays
-        size_t* indices_a = map_broadcasted_to_original_indices(result->shape, result_ndim, arr_a->shape, arr_a->ndim, indices);
-        size_t* indices_b = map_broadcasted_to_original_indices(result->shape, result_ndim, arr_b->shape, arr_b->ndim, indices);
-
-        if (!indices_a || !indices_b) {
-            free_array(result);
-            free(indices);
-            free(indices_a);
-            free(indices_b);
-            return NULL;
-        }
-
-        // Retrieve element pointers using the computed indices
-        void* elem_a = get_element(arr_a, indices_a);
-        void* elem_b = get_element(arr_b, indices_b);
-        void* elem_res = get_element(result, indices);
-
-        apply_operation(operation_symbol, elem_res, elem_a, elem_b, arr_a->dtype);
-
-        free(indices_a);
-        free(indices_b);
-    }
-
-    free(indices);
     return result;
 }
 
-
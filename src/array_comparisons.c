@@ -0,0 +1,832 @@
+#include "array.h"
+#include <stdint.h>
+#include <math.h>
+
+// Strided row loop producing a boolean mask from a comparison of two typed rows.
+// The contiguous and scalar-broadcast cases get their own loops so the compiler can vectorize them.
+#define DEFINE_COMPARE_LOOP(name, type, op)                                            \
+    static void name(char* out, char** in, const size_t* in_strides, size_t n) {       \
+        unsigned char* res = (unsigned char*)out;                                      \
+        const char* a = in[0];                                                         \
+        const char* b = in[1];                                                         \
+        if (in_strides[0] == sizeof(type) && in_strides[1] == sizeof(type)) {          \
+            const type* pa = (const type*)a;                                           \
+            const type* pb = (const type*)b;                                           \
+            for (size_t i = 0; i < n; i++) res[i] = pa[i] op pb[i];                    \
+        } else if (in_strides[0] == sizeof(type) && in_strides[1] == 0) {              \
+            const type* pa = (const type*)a;                                           \
+            const type vb = *(const type*)b;                                           \
+            for (size_t i = 0; i < n; i++) res[i] = pa[i] op vb;                       \
+        } else {                                                                       \
+            for (size_t i = 0; i < n; i++) {                                           \
+                res[i] = *(const type*)(a + i * in_strides[0]) op                      \
+                         *(const type*)(b + i * in_strides[1]);                        \
+            }                                                                          \
+        }                                                                              \
+    }
+
+#define DEFINE_COMPARE_LOOPS(suffix, type)                  \
+    DEFINE_COMPARE_LOOP(lt_##suffix##_loop, type, <)        \
+    DEFINE_COMPARE_LOOP(le_##suffix##_loop, type, <=)       \
+    DEFINE_COMPARE_LOOP(eq_##suffix##_loop, type, ==)       \
+    DEFINE_COMPARE_LOOP(ne_##suffix##_loop, type, !=)       \
+    DEFINE_COMPARE_LOOP(gt_##suffix##_loop, type, >)        \
+    DEFINE_COMPARE_LOOP(ge_##suffix##_loop, type, >=)
+
+DEFINE_COMPARE_LOOPS(int, int)
+DEFINE_COMPARE_LOOPS(float, float)
+DEFINE_COMPARE_LOOPS(double, double)
+DEFINE_COMPARE_LOOPS(bool, unsigned char)
+
+#define COMPARE_LOOP_ROW(suffix) \
+    { lt_##suffix##_loop, le_##suffix##_loop, eq_##suffix##_loop, ne_##suffix##_loop, gt_##suffix##_loop, ge_##suffix##_loop }
+
+// Comparison loops indexed by [dtype][comparison index]
+static StridedLoopFunc compare_loops[][6] = {
+    COMPARE_LOOP_ROW(int),
+    COMPARE_LOOP_ROW(float),
+    COMPARE_LOOP_ROW(double),
+    COMPARE_LOOP_ROW(bool),
+};
+
+// Maps comparison symbols to table indices
+static int get_comparison_index(const char* comparison) {
+    if (!comparison) return -1;
+    if (strcmp(comparison, "<") == 0) return 0;
+    if (strcmp(comparison, "<=") == 0) return 1;
+    if (strcmp(comparison, "==") == 0) return 2;
+    if (strcmp(comparison, "!=") == 0) return 3;
+    if (strcmp(comparison, ">") == 0) return 4;
+    if (strcmp(comparison, ">=") == 0) return 5;
+    return -1;
+}
+
+// Logical loops on masks. Any nonzero byte counts as true, the result is always 0 or 1.
+#define DEFINE_LOGICAL_LOOP(name, op)                                                  \
+    static void name(char* out, char** in, const size_t* in_strides, size_t n) {       \
+        unsigned char* res = (unsigned char*)out;                                      \
+        const unsigned char* a = (const unsigned char*)in[0];                          \
+        const unsigned char* b = (const unsigned char*)in[1];                          \
+        if (in_strides[0] == 1 && in_strides[1] == 1) {                                \
+            for (size_t i = 0; i < n; i++) res[i] = (a[i] != 0) op (b[i] != 0);        \
+        } else {                                                                       \
+            for (size_t i = 0; i < n; i++) {                                           \
+                res[i] = (a[i * in_strides[0]] != 0) op (b[i * in_strides[1]] != 0);   \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_LOGICAL_LOOP(and_loop, &)
+DEFINE_LOGICAL_LOOP(or_loop, |)
+DEFINE_LOGICAL_LOOP(xor_loop, ^)
+
+static void not_loop(char* out, char** in, const size_t* in_strides, size_t n) {
+    unsigned char* res = (unsigned char*)out;
+    const unsigned char* a = (const unsigned char*)in[0];
+    for (size_t i = 0; i < n; i++) {
+        res[i] = a[i * in_strides[0]] == 0;
+    }
+}
+
+// Branchless select loops, keyed on the element size so one loop serves every dtype of that width
+#define DEFINE_WHERE_LOOP(name, type)                                                  \
+    static void name(char* out, char** in, const size_t* in_strides, size_t n) {       \
+        type* res = (type*)out;                                                        \
+        const unsigned char* m = (const unsigned char*)in[0];                          \
+        const char* a = in[1];                                                         \
+        const char* b = in[2];                                                         \
+        if (in_strides[0] == 1 && in_strides[1] == sizeof(type) &&                     \
+            in_strides[2] == sizeof(type)) {                                           \
+            const type* pa = (const type*)a;                                           \
+            const type* pb = (const type*)b;                                           \
+            for (size_t i = 0; i < n; i++) res[i] = m[i] ? pa[i] : pb[i];              \
+        } else {                                                                       \
+            for (size_t i = 0; i < n; i++) {                                           \
+                res[i] = m[i * in_strides[0]] ? *(const type*)(a + i * in_strides[1])  \
+                                              : *(const type*)(b + i * in_strides[2]); \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_WHERE_LOOP(where_8_loop, uint8_t)
+DEFINE_WHERE_LOOP(where_32_loop, uint32_t)
+DEFINE_WHERE_LOOP(where_64_loop, uint64_t)
+
+static StridedLoopFunc get_where_loop(size_t dtype_size) {
+    switch (dtype_size) {
+        case 1: return where_8_loop;
+        case 4: return where_32_loop;
+        case 8: return where_64_loop;
+        default: return NULL;
+    }
+}
+
+/**
+ * Allocate a result array with the broadcasted shape of two arrays.
+ *
+ * @param arr_a First input array.
+ * @param arr_b Second input array.
+ * @param dtype Data type of the result.
+ * @return A new zero-initialized array, or NULL if the shapes are not broadcastable.
+ */
+static Array* create_broadcast_result(Array* arr_a, Array* arr_b, DataType dtype) {
+    size_t result_ndim;
+    size_t* result_shape = broadcast_shapes(arr_a->shape, arr_a->ndim, arr_b->shape, arr_b->ndim, &result_ndim);
+    if (!result_shape) {
+        return NULL;
+    }
+    Array* result = create_array(dtype, result_ndim, result_shape, NULL);
+    free(result_shape);
+    return result;
+}
+
+/**
+ * Compare two arrays element-wise with broadcasting.
+ *
+ * @param arr_a First input array.
+ * @param arr_b Second input array.
+ * @param comparison The comparison to apply ("<", "<=", "==", "!=", ">", ">=").
+ * @return A new TYPE_BOOL array, or NULL on error.
+ */
+Array* compare_arrays(Array* arr_a, Array* arr_b, const char* comparison) {
+    #if DEBUG_MODE
+        if (!arr_a || !arr_b) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+        if (arr_a->dtype != arr_b->dtype) {
+            log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+            return NULL;
+        }
+    #endif
+
+    int cmp_index = get_comparison_index(comparison);
+    if (cmp_index == -1) {
+        log_error(ARRAY_ERROR_VALUE, "Invalid comparison");
+        return NULL;
+    }
+    if (arr_a->dtype < TYPE_INT || arr_a->dtype > TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    Array* result = create_broadcast_result(arr_a, arr_b, TYPE_BOOL);
+    if (!result) {
+        return NULL;
+    }
+
+    Array* inputs[2] = { arr_a, arr_b };
+    if (!broadcast_apply(result, inputs, 2, compare_loops[arr_a->dtype][cmp_index])) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Combine two boolean masks element-wise with broadcasting.
+ *
+ * @param mask_a First mask.
+ * @param mask_b Second mask.
+ * @param operation_symbol The logical operation to apply ('&', '|', '^').
+ * @return A new TYPE_BOOL array, or NULL on error.
+ */
+Array* logical_arrays(Array* mask_a, Array* mask_b, char operation_symbol) {
+    #if DEBUG_MODE
+        if (!mask_a || !mask_b) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (mask_a->dtype != TYPE_BOOL || mask_b->dtype != TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Logical operations require boolean masks");
+        return NULL;
+    }
+
+    StridedLoopFunc loop;
+    switch (operation_symbol) {
+        case '&': loop = and_loop; break;
+        case '|': loop = or_loop; break;
+        case '^': loop = xor_loop; break;
+        default:
+            log_error(ARRAY_ERROR_VALUE, "Invalid logical operation");
+            return NULL;
+    }
+
+    Array* result = create_broadcast_result(mask_a, mask_b, TYPE_BOOL);
+    if (!result) {
+        return NULL;
+    }
+
+    Array* inputs[2] = { mask_a, mask_b };
+    if (!broadcast_apply(result, inputs, 2, loop)) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Negate a boolean mask element-wise.
+ *
+ * @param mask The mask to negate.
+ * @return A new TYPE_BOOL array, or NULL on error.
+ */
+Array* logical_not(Array* mask) {
+    #if DEBUG_MODE
+        if (!mask) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (mask->dtype != TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Logical operations require boolean masks");
+        return NULL;
+    }
+
+    Array* result = create_array(TYPE_BOOL, mask->ndim, mask->shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    Array* inputs[1] = { mask };
+    if (!broadcast_apply(result, inputs, 1, not_loop)) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Select elements from two arrays based on a mask.
+ *
+ * The mask and both value arrays are broadcast together in a single pass,
+ * so no intermediate arrays are materialized.
+ *
+ * @param mask The TYPE_BOOL selector.
+ * @param arr_a Values used where the mask is true.
+ * @param arr_b Values used where the mask is false.
+ * @return A new array with the dtype of arr_a, or NULL on error.
+ */
+Array* where(Array* mask, Array* arr_a, Array* arr_b) {
+    #if DEBUG_MODE
+        if (!mask || !arr_a || !arr_b) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+        if (arr_a->dtype != arr_b->dtype) {
+            log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+            return NULL;
+        }
+    #endif
+
+    if (mask->dtype != TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Mask must be a boolean array");
+        return NULL;
+    }
+
+    StridedLoopFunc loop = get_where_loop(get_dtype_size(arr_a->dtype));
+    if (!loop) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    size_t ab_ndim;
+    size_t* ab_shape = broadcast_shapes(arr_a->shape, arr_a->ndim, arr_b->shape, arr_b->ndim, &ab_ndim);
+    if (!ab_shape) {
+        return NULL;
+    }
+    size_t result_ndim;
+    size_t* result_shape = broadcast_shapes(mask->shape, mask->ndim, ab_shape, ab_ndim, &result_ndim);
+    free(ab_shape);
+    if (!result_shape) {
+        return NULL;
+    }
+
+    Array* result = create_array(arr_a->dtype, result_ndim, result_shape, NULL);
+    free(result_shape);
+    if (!result) {
+        return NULL;
+    }
+
+    Array* inputs[3] = { mask, arr_a, arr_b };
+    if (!broadcast_apply(result, inputs, 3, loop)) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+
+// Mask compaction
+//
+// The mask is processed eight bytes at a time in a 64-bit register. Each byte is
+// first normalized to 0/1, after which multiplying by 0x0101010101010101 leaves the
+// inclusive prefix sum of the eight lanes in the eight bytes of the product. The top
+// byte is the population count of the group, and the lower bytes give every selected
+// lane its output position without a branch per lane.
+
+#define MASK_LANES 8
+#define MASK_LOW_BITS 0x7f7f7f7f7f7f7f7fULL
+#define MASK_ONES 0x0101010101010101ULL
+#define COMPACT_BLOCK 4096
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    #define MASK_SWAR 1
+#else
+    #define MASK_SWAR 0
+#endif
+
+// Loads eight mask bytes and maps every nonzero byte to 1.
+static inline uint64_t load_mask_lanes(const unsigned char* mask) {
+    uint64_t x;
+    memcpy(&x, mask, sizeof(x));
+    return ((((x & MASK_LOW_BITS) + MASK_LOW_BITS) | x) >> 7) & MASK_ONES;
+}
+
+// Counts the nonzero bytes in a run of the mask.
+static size_t count_mask_run(const unsigned char* mask, size_t n) {
+    size_t count = 0;
+    size_t i = 0;
+#if MASK_SWAR
+    for (; i + MASK_LANES <= n; i += MASK_LANES) {
+        count += (load_mask_lanes(mask + i) * MASK_ONES) >> 56;
+    }
+#endif
+    for (; i < n; i++) {
+        count += mask[i] != 0;
+    }
+    return count;
+}
+
+// Compacts one block of the mask into dst, one loop per element width.
+#define DEFINE_COMPACT_RUN(name, type)                                                 \
+    static void name(char* dst_bytes, const char* src_bytes,                           \
+                     const unsigned char* mask, size_t n) {                            \
+        type* dst = (type*)dst_bytes;                                                  \
+        const type* src = (const type*)src_bytes;                                      \
+        size_t i = 0;                                                                  \
+        if (MASK_SWAR) {                                                               \
+            for (; i + MASK_LANES <= n; i += MASK_LANES) {                             \
+                uint64_t lanes = load_mask_lanes(mask + i);                            \
+                if (lanes == 0) continue;                                              \
+                if (lanes == MASK_ONES) {                                              \
+                    memcpy(dst, src + i, MASK_LANES * sizeof(type));                   \
+                    dst += MASK_LANES;                                                 \
+                    continue;                                                          \
+                }                                                                      \
+                uint64_t prefix = lanes * MASK_ONES;                                   \
+                for (size_t k = 0; k < MASK_LANES; k++) {                              \
+                    if ((lanes >> (8 * k)) & 1) {                                      \
+                        dst[((prefix >> (8 * k)) & 0xff) - 1] = src[i + k];            \
+                    }                                                                  \
+                }                                                                      \
+                dst += prefix >> 56;                                                   \
+            }                                                                          \
+        }                                                                              \
+        for (; i < n; i++) {                                                           \
+            if (mask[i]) *dst++ = src[i];                                              \
+        }                                                                              \
+    }
+
+DEFINE_COMPACT_RUN(compact_8_run, uint8_t)
+DEFINE_COMPACT_RUN(compact_32_run, uint32_t)
+DEFINE_COMPACT_RUN(compact_64_run, uint64_t)
+
+/**
+ * Count the true elements of a boolean mask.
+ *
+ * @param mask The TYPE_BOOL array.
+ * @return The number of nonzero elements.
+ */
+size_t count_nonzero(Array* mask) {
+    #if DEBUG_MODE
+        if (!mask) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return 0;
+        }
+    #endif
+
+    if (mask->dtype != TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Mask must be a boolean array");
+        return 0;
+    }
+    return count_mask_run(mask->data, mask->size);
+}
+
+/**
+ * Gather the elements of an array where the mask is true (arr[mask]).
+ *
+ * An exclusive prefix sum over per-block counts gives every block of the mask
+ * its starting position in the output; the blocks are then compacted
+ * independently using the in-register prefix sums described above.
+ *
+ * @param arr The array to select from.
+ * @param mask A TYPE_BOOL array with the same shape as arr.
+ * @return A new one-dimensional array, or NULL on error or if nothing is selected.
+ */
+Array* masked_select(Array* arr, Array* mask) {
+    #if DEBUG_MODE
+        if (!arr || !mask) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (mask->dtype != TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Mask must be a boolean array");
+        return NULL;
+    }
+    if (!are_shapes_equal(arr->shape, arr->ndim, mask->shape, mask->ndim)) {
+        log_error(ARRAY_ERROR_SHAPE, "Mask shape does not match array shape");
+        return NULL;
+    }
+
+    size_t dtype_size = get_dtype_size(arr->dtype);
+    void (*compact_run)(char*, const char*, const unsigned char*, size_t);
+    switch (dtype_size) {
+        case 1: compact_run = compact_8_run; break;
+        case 4: compact_run = compact_32_run; break;
+        case 8: compact_run = compact_64_run; break;
+        default:
+            log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+            return NULL;
+    }
+
+    const unsigned char* mask_data = mask->data;
+    size_t n_blocks = (arr->size + COMPACT_BLOCK - 1) / COMPACT_BLOCK;
+    size_t* block_offsets = malloc((n_blocks + 1) * sizeof(size_t));
+    if (!block_offsets) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for block offsets");
+        return NULL;
+    }
+
+    // Exclusive prefix sum of the per-block counts
+    block_offsets[0] = 0;
+    for (size_t b = 0; b < n_blocks; b++) {
+        size_t start = b * COMPACT_BLOCK;
+        size_t len = (arr->size - start < COMPACT_BLOCK) ? arr->size - start : COMPACT_BLOCK;
+        block_offsets[b + 1] = block_offsets[b] + count_mask_run(mask_data + start, len);
+    }
+
+    size_t selected = block_offsets[n_blocks];
+    if (selected == 0) {
+        free(block_offsets);
+        log_error(ARRAY_ERROR_VALUE, "Mask selects no elements");
+        return NULL;
+    }
+
+    size_t result_shape[1] = { selected };
+    Array* result = create_array(arr->dtype, 1, result_shape, NULL);
+    if (!result) {
+        free(block_offsets);
+        return NULL;
+    }
+
+    for (size_t b = 0; b < n_blocks; b++) {
+        if (block_offsets[b + 1] == block_offsets[b]) {
+            continue;
+        }
+        size_t start = b * COMPACT_BLOCK;
+        size_t len = (arr->size - start < COMPACT_BLOCK) ? arr->size - start : COMPACT_BLOCK;
+        compact_run((char*)result->data + block_offsets[b] * dtype_size,
+                    (const char*)arr->data + start * dtype_size,
+                    mask_data + start, len);
+    }
+
+    free(block_offsets);
+    return result;
+}
+
+
+// Elements tested per block before looking for the exact mismatch; the block test has no
+// early exit, so the compiler can vectorize it
+#define CLOSE_BLOCK 256
+
+typedef struct CloseContext CloseContext;
+
+// Returns the index of the first of n strided element pairs that is not close, or n
+typedef size_t (*CloseRunFunc)(const char* a, size_t stride_a, const char* b, size_t stride_b,
+                               size_t n, const CloseContext* c);
+
+// Work shared by the threads of a closeness check
+struct CloseContext {
+    const char* a;
+    const char* b;
+    const size_t* shape;         // Broadcast shape
+    size_t ndim;
+    size_t elem_bytes;
+    size_t* strides[2];          // Broadcast byte strides, NULL when the shapes are equal
+    double rtol, atol;
+    uint64_t max_ulps;
+    CloseRunFunc run;
+    size_t first_mismatch;       // Lowest mismatch index found so far, updated atomically
+};
+
+// Maps the bits of a float onto integers ordered like the floats, so that the
+// difference of two mapped values is their distance in units in the last place
+static inline int64_t float_ulp_order(float x) {
+    int32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits < 0 ? (int64_t)INT32_MIN - bits : bits;
+}
+
+static inline int64_t double_ulp_order(double x) {
+    int64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits < 0 ? INT64_MIN - bits : bits;
+}
+
+static inline int float_within_ulps(float x, float y, uint64_t max_ulps) {
+    int64_t d = float_ulp_order(x) - float_ulp_order(y);
+    return x == x && y == y && (uint64_t)(d < 0 ? -d : d) <= max_ulps;
+}
+
+static inline int double_within_ulps(double x, double y, uint64_t max_ulps) {
+    int64_t ox = double_ulp_order(x), oy = double_ulp_order(y);
+    uint64_t d = ox > oy ? (uint64_t)ox - (uint64_t)oy : (uint64_t)oy - (uint64_t)ox;
+    return x == x && y == y && d <= max_ulps;
+}
+
+// Infinities and NaN are only close to an equal value: with y infinite the tolerance
+// would be infinite too
+static inline int value_within_tolerance(double x, double y, const CloseContext* c) {
+    if (!isfinite(x) || !isfinite(y)) {
+        return x == y;
+    }
+    return fabs(x - y) <= c->atol + c->rtol * fabs(y);
+}
+
+static inline int complex_within_tolerance(double xr, double xi, double yr, double yi,
+                                           const CloseContext* c) {
+    if (!isfinite(xr) || !isfinite(xi) || !isfinite(yr) || !isfinite(yi)) {
+        return xr == yr && xi == yi;
+    }
+    return hypot(xr - yr, xi - yi) <= c->atol + c->rtol * hypot(yr, yi);
+}
+
+// Closeness tests on pointers to one element of each array; integers measure ULPs as
+// their absolute difference, and complex values are compared by magnitude (tolerance)
+// or component-wise (ULPs)
+#define TOLERANCE_TEST(x, y, c) value_within_tolerance((x)[0], (y)[0], c)
+#define COMPLEX_TOLERANCE_TEST(x, y, c)                                                \
+    complex_within_tolerance((x)[0], (x)[1], (y)[0], (y)[1], c)
+#define INT_ULP_TEST(x, y, c)                                                          \
+    (((x)[0] > (y)[0] ? (uint64_t)(x)[0] - (uint64_t)(y)[0]                            \
+                      : (uint64_t)(y)[0] - (uint64_t)(x)[0]) <= (c)->max_ulps)
+#define FLOAT_ULP_TEST(x, y, c) float_within_ulps((x)[0], (y)[0], (c)->max_ulps)
+#define DOUBLE_ULP_TEST(x, y, c) double_within_ulps((x)[0], (y)[0], (c)->max_ulps)
+#define COMPLEX_FLOAT_ULP_TEST(x, y, c)                                                \
+    (FLOAT_ULP_TEST(x, y, c) && FLOAT_ULP_TEST((x) + 1, (y) + 1, c))
+#define COMPLEX_DOUBLE_ULP_TEST(x, y, c)                                               \
+    (DOUBLE_ULP_TEST(x, y, c) && DOUBLE_ULP_TEST((x) + 1, (y) + 1, c))
+
+// Closeness run over elements of W scalars of type T; contiguous runs get their own
+// loop so the compiler can vectorize the block test
+#define DEFINE_CLOSE_RUN(name, T, W, TEST)                                             \
+    static size_t name(const char* a, size_t stride_a, const char* b, size_t stride_b, \
+                       size_t n, const CloseContext* c) {                              \
+        int contiguous = stride_a == W * sizeof(T) && stride_b == W * sizeof(T);       \
+        for (size_t start = 0; start < n; start += CLOSE_BLOCK) {                      \
+            size_t stop = n - start < CLOSE_BLOCK ? n : start + CLOSE_BLOCK;           \
+            int bad = 0;                                                               \
+            if (contiguous) {                                                          \
+                const T* x = (const T*)a;                                              \
+                const T* y = (const T*)b;                                              \
+                for (size_t i = start; i < stop; i++) {                                \
+                    bad |= !(TEST(x + i * W, y + i * W, c));                           \
+                }                                                                      \
+            } else {                                                                   \
+                for (size_t i = start; i < stop; i++) {                                \
+                    bad |= !(TEST((const T*)(a + i * stride_a),                        \
+                                  (const T*)(b + i * stride_b), c));                   \
+                }                                                                      \
+            }                                                                          \
+            if (!bad) {                                                                \
+                continue;                                                              \
+            }                                                                          \
+            for (size_t i = start; i < stop; i++) {                                    \
+                const T* x = (const T*)(a + i * stride_a);                             \
+                const T* y = (const T*)(b + i * stride_b);                             \
+                if (!(TEST(x, y, c))) {                                                \
+                    return i;                                                          \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+        return n;                                                                      \
+    }
+
+DEFINE_CLOSE_RUN(close_tol_int, int, 1, TOLERANCE_TEST)
+DEFINE_CLOSE_RUN(close_tol_float, float, 1, TOLERANCE_TEST)
+DEFINE_CLOSE_RUN(close_tol_double, double, 1, TOLERANCE_TEST)
+DEFINE_CLOSE_RUN(close_tol_bool, unsigned char, 1, TOLERANCE_TEST)
+DEFINE_CLOSE_RUN(close_tol_complex_float, float, 2, COMPLEX_TOLERANCE_TEST)
+DEFINE_CLOSE_RUN(close_tol_complex_double, double, 2, COMPLEX_TOLERANCE_TEST)
+DEFINE_CLOSE_RUN(close_ulp_int, int, 1, INT_ULP_TEST)
+DEFINE_CLOSE_RUN(close_ulp_float, float, 1, FLOAT_ULP_TEST)
+DEFINE_CLOSE_RUN(close_ulp_double, double, 1, DOUBLE_ULP_TEST)
+DEFINE_CLOSE_RUN(close_ulp_bool, unsigned char, 1, INT_ULP_TEST)
+DEFINE_CLOSE_RUN(close_ulp_complex_float, float, 2, COMPLEX_FLOAT_ULP_TEST)
+DEFINE_CLOSE_RUN(close_ulp_complex_double, double, 2, COMPLEX_DOUBLE_ULP_TEST)
+
+// Closeness runs indexed by dtype
+static const CloseRunFunc close_tol_runs[] = {
+    close_tol_int, close_tol_float, close_tol_double,
+    close_tol_bool, close_tol_complex_float, close_tol_complex_double,
+};
+static const CloseRunFunc close_ulp_runs[] = {
+    close_ulp_int, close_ulp_float, close_ulp_double,
+    close_ulp_bool, close_ulp_complex_float, close_ulp_complex_double,
+};
+
+static void record_mismatch(CloseContext* c, size_t index) {
+    size_t current = __atomic_load_n(&c->first_mismatch, __ATOMIC_RELAXED);
+    while (index < current &&
+           !__atomic_compare_exchange_n(&c->first_mismatch, &current, index, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Checks the elements [begin, end) of arrays of equal shape, in blocks, stopping once a
+// mismatch before the current block is known
+static void close_contiguous(size_t begin, size_t end, void* ctx) {
+    CloseContext* c = ctx;
+    size_t block = CLOSE_BLOCK * 16;
+    for (size_t start = begin; start < end; start += block) {
+        if (__atomic_load_n(&c->first_mismatch, __ATOMIC_RELAXED) < start) {
+            return;
+        }
+        size_t len = end - start < block ? end - start : block;
+        size_t offset = start * c->elem_bytes;
+        size_t i = c->run(c->a + offset, c->elem_bytes, c->b + offset, c->elem_bytes, len, c);
+        if (i < len) {
+            record_mismatch(c, start + i);
+            return;
+        }
+    }
+}
+
+// Checks the broadcast rows [begin, end), walking the outer dimensions with an odometer
+static void close_rows(size_t begin, size_t end, void* ctx) {
+    CloseContext* c = ctx;
+    size_t ndim = c->ndim;
+    size_t inner = c->shape[ndim - 1];
+    const size_t* sa = c->strides[0];
+    const size_t* sb = c->strides[1];
+
+    size_t counter[ndim];
+    const char* pa = c->a;
+    const char* pb = c->b;
+    counter[ndim - 1] = 0;
+    for (size_t d = ndim - 1, rest = begin; d-- > 0;) {
+        counter[d] = rest % c->shape[d];
+        rest /= c->shape[d];
+        pa += counter[d] * sa[d];
+        pb += counter[d] * sb[d];
+    }
+
+    for (size_t row = begin; row < end; row++) {
+        if (__atomic_load_n(&c->first_mismatch, __ATOMIC_RELAXED) < row * inner) {
+            return;
+        }
+        size_t i = c->run(pa, sa[ndim - 1], pb, sb[ndim - 1], inner, c);
+        if (i < inner) {
+            record_mismatch(c, row * inner + i);
+            return;
+        }
+
+        for (size_t d = ndim - 1; d-- > 0;) {
+            counter[d]++;
+            pa += sa[d];
+            pb += sb[d];
+            if (counter[d] < c->shape[d]) {
+                break;
+            }
+            pa -= sa[d] * c->shape[d];
+            pb -= sb[d] * c->shape[d];
+            counter[d] = 0;
+        }
+    }
+}
+
+/**
+ * Check two arrays for closeness with a closeness run, broadcasting them.
+ *
+ * Arrays of equal shape are checked as flat buffers; otherwise the rows of
+ * the broadcast shape are walked with broadcast strides. Threads skip work
+ * past the first mismatch found so far, so the reported index is the lowest
+ * mismatch in row-major order.
+ *
+ * @param c The context, with rtol, atol or max_ulps set.
+ * @param arr_a First input array.
+ * @param arr_b Second input array.
+ * @param runs The closeness runs indexed by dtype.
+ * @param mismatch_index Receives the index of the first mismatch, or the broadcast size.
+ * @return 1 if every element is close, 0 otherwise or on error.
+ */
+static int check_close(CloseContext* c, Array* arr_a, Array* arr_b,
+                       const CloseRunFunc* runs, size_t* mismatch_index) {
+    if (mismatch_index) {
+        *mismatch_index = (size_t)-1;
+    }
+    if (!arr_a || !arr_b) {
+        log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+        return 0;
+    }
+    if (arr_a->dtype != arr_b->dtype) {
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+        return 0;
+    }
+    if (arr_a->dtype > TYPE_COMPLEX_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return 0;
+    }
+
+    c->a = arr_a->data;
+    c->b = arr_b->data;
+    c->elem_bytes = get_dtype_size(arr_a->dtype);
+    c->run = runs[arr_a->dtype];
+
+    size_t size;
+    size_t* shape = NULL;
+    if (are_shapes_equal(arr_a->shape, arr_a->ndim, arr_b->shape, arr_b->ndim)) {
+        size = arr_a->size;
+        c->first_mismatch = size;
+        parallel_for(size, PARALLEL_GRAIN_BYTES / c->elem_bytes + 1, close_contiguous, c);
+    } else {
+        shape = broadcast_shapes(arr_a->shape, arr_a->ndim, arr_b->shape, arr_b->ndim, &c->ndim);
+        if (!shape) {
+            return 0;
+        }
+        c->shape = shape;
+        c->strides[0] = broadcast_strides(arr_a, shape, c->ndim);
+        c->strides[1] = broadcast_strides(arr_b, shape, c->ndim);
+        if (!c->strides[0] || !c->strides[1]) {
+            free(c->strides[0]);
+            free(c->strides[1]);
+            free(shape);
+            return 0;
+        }
+
+        size = 1;
+        for (size_t d = 0; d < c->ndim; d++) {
+            size *= shape[d];
+        }
+        c->first_mismatch = size;
+        if (size > 0) {
+            size_t inner = shape[c->ndim - 1];
+            parallel_for(size / inner, PARALLEL_GRAIN_BYTES / (inner * c->elem_bytes) + 1, close_rows, c);
+        }
+        free(c->strides[0]);
+        free(c->strides[1]);
+        free(shape);
+    }
+
+    if (mismatch_index) {
+        *mismatch_index = c->first_mismatch;
+    }
+    return c->first_mismatch == size;
+}
+
+/**
+ * Check whether two arrays are element-wise equal within a tolerance.
+ *
+ * Elements x of arr_a and y of arr_b are close when |x - y| <= atol + rtol * |y|.
+ * Equal infinities are close and NaN is never close.
+ *
+ * @param arr_a First input array.
+ * @param arr_b Second input array, broadcast against the first.
+ * @param rtol Relative tolerance.
+ * @param atol Absolute tolerance.
+ * @param mismatch_index If not NULL, receives the row-major index of the first element
+ *        that is not close, the broadcast size if all are, or (size_t)-1 on error.
+ * @return 1 if every element is close, 0 otherwise or on error.
+ */
+int arrays_allclose(Array* arr_a, Array* arr_b, double rtol, double atol, size_t* mismatch_index) {
+    CloseContext c = { 0 };
+    c.rtol = rtol;
+    c.atol = atol;
+    return check_close(&c, arr_a, arr_b, close_tol_runs, mismatch_index);
+}
+
+/**
+ * Check whether two arrays are element-wise equal within a number of units in the last place.
+ *
+ * Floating point elements are compared by the number of representable values between
+ * them (so 0.0 and -0.0 are 0 ULPs apart and NaN is never close); integer and boolean
+ * elements by their absolute difference; complex elements component-wise.
+ *
+ * @param arr_a First input array.
+ * @param arr_b Second input array, broadcast against the first.
+ * @param max_ulps Largest accepted distance.
+ * @param mismatch_index If not NULL, receives the row-major index of the first element
+ *        that is not close, the broadcast size if all are, or (size_t)-1 on error.
+ * @return 1 if every element is close, 0 otherwise or on error.
+ */
+int arrays_allclose_ulp(Array* arr_a, Array* arr_b, size_t max_ulps, size_t* mismatch_index) {
+    CloseContext c = { 0 };
+    c.max_ulps = max_ulps;
+    return check_close(&c, arr_a, arr_b, close_ulp_runs, mismatch_index);
+}
@@ -0,0 +1,349 @@
+#include "array.h"
+#include <stddef.h>
+
+// Filters with at least this many taps per output (input channels x kernel
+// height x kernel width) and this many output channels use im2col + GEMM;
+// smaller filters use the direct kernel
+#define CONV_IM2COL_MIN_TAPS 16
+#define CONV_IM2COL_MIN_OUT 4
+
+// Output columns computed together by the direct kernel, so an output row
+// segment stays in cache while every tap is accumulated into it
+#define CONV_DIRECT_TILE 4096
+
+// Output positions unrolled together by im2col, bounding the column buffer
+#define CONV_IM2COL_TILE 512
+
+// Every convolution is computed as a two-dimensional correlation of
+// (batch, c_in, in_h, in_w) with (c_out, c_in, k_h, k_w) weights; 1-D
+// problems have in_h = k_h = out_h = 1, and convolution flips the weights.
+typedef struct {
+    size_t batch, c_in, c_out;
+    size_t in_h, in_w;
+    size_t k_h, k_w;
+    size_t out_h, out_w;
+    size_t stride, dilation;
+    size_t pad_top, pad_left;
+    DataType dtype;
+    const char* input;
+    const char* weights;
+    char* output;
+    size_t tiles;          // Tiles per output plane (direct) or per batch element (im2col)
+    int failed;            // Set by a thread that could not allocate its work space or GEMM buffers
+} ConvGeometry;
+
+// First and one-past-last output index o with 0 <= o * stride + offset < n, clamped to [lo, hi)
+static void valid_outputs(ptrdiff_t offset, size_t n, size_t stride, size_t lo, size_t hi,
+                          size_t* first, size_t* last) {
+    ptrdiff_t s = (ptrdiff_t)stride;
+    ptrdiff_t begin = offset >= 0 ? 0 : (-offset + s - 1) / s;
+    ptrdiff_t end = (ptrdiff_t)n - offset <= 0 ? 0 : ((ptrdiff_t)n - offset - 1) / s + 1;
+    *first = begin > (ptrdiff_t)lo ? (size_t)begin : lo;
+    *last = end < (ptrdiff_t)hi ? (size_t)end : hi;
+    if (*last < *first) {
+        *last = *first;
+    }
+}
+
+#define DEFINE_CONV_KERNELS(T, suffix)                                                 \
+    /* Direct kernel: every tap adds a scaled input row segment to an output row */    \
+    static void conv_direct_##suffix(size_t begin, size_t end, void* ctx) {            \
+        const ConvGeometry* g = ctx;                                                   \
+        const T* weights = (const T*)g->weights;                                       \
+        for (size_t task = begin; task < end; task++) {                                \
+            size_t plane = task / g->tiles;                                            \
+            size_t w0 = task % g->tiles * CONV_DIRECT_TILE;                            \
+            size_t w1 = g->out_w - w0 < CONV_DIRECT_TILE ? g->out_w : w0 + CONV_DIRECT_TILE; \
+            size_t n = plane / g->c_out, co = plane % g->c_out;                        \
+            T* out = (T*)g->output + plane * g->out_h * g->out_w;                      \
+            for (size_t oh = 0; oh < g->out_h; oh++) {                                 \
+                T* restrict out_row = out + oh * g->out_w;                             \
+                for (size_t ci = 0; ci < g->c_in; ci++) {                              \
+                    const T* in = (const T*)g->input + (n * g->c_in + ci) * g->in_h * g->in_w; \
+                    const T* w = weights + (co * g->c_in + ci) * g->k_h * g->k_w;      \
+                    for (size_t kh = 0; kh < g->k_h; kh++) {                           \
+                        ptrdiff_t ih = (ptrdiff_t)(oh * g->stride + kh * g->dilation)  \
+                                     - (ptrdiff_t)g->pad_top;                          \
+                        if (ih < 0 || ih >= (ptrdiff_t)g->in_h) continue;              \
+                        const T* in_row = in + ih * g->in_w;                           \
+                        for (size_t kw = 0; kw < g->k_w; kw++) {                       \
+                            const T wv = w[kh * g->k_w + kw];                          \
+                            ptrdiff_t offset = (ptrdiff_t)(kw * g->dilation)           \
+                                             - (ptrdiff_t)g->pad_left;                 \
+                            size_t lo, hi;                                             \
+                            valid_outputs(offset, g->in_w, g->stride, w0, w1, &lo, &hi); \
+                            if (g->stride == 1) {                                      \
+                                const T* restrict src = in_row + offset;               \
+                                for (size_t ow = lo; ow < hi; ow++) {                  \
+                                    out_row[ow] += wv * src[ow];                       \
+                                }                                                      \
+                            } else {                                                   \
+                                for (size_t ow = lo; ow < hi; ow++) {                  \
+                                    out_row[ow] += wv * in_row[(ptrdiff_t)(ow * g->stride) + offset]; \
+                                }                                                      \
+                            }                                                          \
+                        }                                                              \
+                    }                                                                  \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* Unrolls the receptive fields of output positions [p0, p1) into columns */       \
+    static void im2col_##suffix(const ConvGeometry* g, size_t n, size_t p0, size_t p1, \
+                                T* col) {                                              \
+        size_t width = p1 - p0;                                                        \
+        for (size_t ci = 0; ci < g->c_in; ci++) {                                      \
+            const T* in = (const T*)g->input + (n * g->c_in + ci) * g->in_h * g->in_w; \
+            for (size_t kh = 0; kh < g->k_h; kh++) {                                   \
+                for (size_t kw = 0; kw < g->k_w; kw++) {                               \
+                    T* restrict dst = col + ((ci * g->k_h + kh) * g->k_w + kw) * width; \
+                    ptrdiff_t offset = (ptrdiff_t)(kw * g->dilation) - (ptrdiff_t)g->pad_left; \
+                    size_t oh = p0 / g->out_w, ow = p0 % g->out_w;                     \
+                    for (size_t p = 0; p < width; ) {                                  \
+                        /* One output row segment at a time */                         \
+                        size_t run = g->out_w - ow < width - p ? g->out_w - ow : width - p; \
+                        ptrdiff_t ih = (ptrdiff_t)(oh * g->stride + kh * g->dilation)  \
+                                     - (ptrdiff_t)g->pad_top;                          \
+                        size_t lo = ow, hi = ow;                                       \
+                        if (ih >= 0 && ih < (ptrdiff_t)g->in_h) {                      \
+                            valid_outputs(offset, g->in_w, g->stride, ow, ow + run, &lo, &hi); \
+                        }                                                              \
+                        const T* in_row = in + (ih < 0 ? 0 : ih) * g->in_w;            \
+                        for (size_t o = ow; o < ow + run; o++) {                       \
+                            dst[p + o - ow] = o >= lo && o < hi                        \
+                                ? in_row[(ptrdiff_t)(o * g->stride) + offset] : 0;     \
+                        }                                                              \
+                        p += run;                                                      \
+                        oh++;                                                          \
+                        ow = 0;                                                        \
+                    }                                                                  \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static void conv_im2col_##suffix(size_t begin, size_t end, void* ctx) {            \
+        const ConvGeometry* g = ctx;                                                   \
+        size_t taps = g->c_in * g->k_h * g->k_w;                                       \
+        size_t positions = g->out_h * g->out_w;                                        \
+        T* col = malloc(taps * CONV_IM2COL_TILE * sizeof(T));                          \
+        if (!col) {                                                                    \
+            log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for im2col");     \
+            __atomic_store_n(&((ConvGeometry*)ctx)->failed, 1, __ATOMIC_RELAXED);      \
+            return;                                                                    \
+        }                                                                              \
+        for (size_t task = begin; task < end; task++) {                                \
+            size_t n = task / g->tiles;                                                \
+            size_t p0 = task % g->tiles * CONV_IM2COL_TILE;                            \
+            size_t p1 = positions - p0 < CONV_IM2COL_TILE ? positions : p0 + CONV_IM2COL_TILE; \
+            im2col_##suffix(g, n, p0, p1, col);                                        \
+            T* out = (T*)g->output + n * g->c_out * positions + p0;                    \
+            if (!gemm(g->dtype, g->c_out, p1 - p0, taps, 1, g->weights, taps, 0,       \
+                      col, p1 - p0, 0, out, positions, 0)) {                           \
+                __atomic_store_n(&((ConvGeometry*)ctx)->failed, 1, __ATOMIC_RELAXED);  \
+                break;                                                                 \
+            }                                                                          \
+        }                                                                              \
+        free(col);                                                                     \
+    }
+
+DEFINE_CONV_KERNELS(int, int)
+DEFINE_CONV_KERNELS(float, float)
+DEFINE_CONV_KERNELS(double, double)
+
+// Indexed by dtype; TYPE_BOOL has no convolution
+static const ParallelFunc conv_direct_kernels[3] = { conv_direct_int, conv_direct_float, conv_direct_double };
+static const ParallelFunc conv_im2col_kernels[3] = { conv_im2col_int, conv_im2col_float, conv_im2col_double };
+
+/**
+ * Compute the padding and output length of one spatial axis.
+ *
+ * @return 1 on success, 0 if the output would be empty.
+ */
+static int conv_axis(size_t in, size_t k, size_t stride, size_t dilation, ConvMode mode,
+                     int flip, size_t* pad, size_t* out) {
+    size_t extent = (k - 1) * dilation + 1;
+    switch (mode) {
+        case CONV_VALID:
+            if (extent > in) {
+                log_error(ARRAY_ERROR_SHAPE, "Kernel is larger than the input");
+                return 0;
+            }
+            *pad = 0;
+            *out = (in - extent) / stride + 1;
+            return 1;
+        case CONV_SAME:
+            // Centered like numpy.convolve; correlation mirrors the offset
+            *pad = flip ? extent / 2 : (extent - 1) / 2;
+            *out = (in - 1) / stride + 1;
+            return 1;
+        case CONV_FULL:
+            *pad = extent - 1;
+            *out = (in + extent - 2) / stride + 1;
+            return 1;
+    }
+    log_error(ARRAY_ERROR_VALUE, "Invalid convolution mode");
+    return 0;
+}
+
+/**
+ * Convolve or correlate an input with a kernel over its last one or two axes.
+ *
+ * A kernel with only spatial axes is applied to every slice of the input. A
+ * kernel with (c_out, c_in) leading axes mixes the c_in channels of the input
+ * (the axis before the spatial ones) into c_out output channels.
+ *
+ * @param input The input array, of shape (..., [c_in,] spatial...).
+ * @param kernel The kernel, of shape ([c_out, c_in,] spatial...).
+ * @param spatial Number of spatial axes (1 or 2).
+ * @param flip 1 for convolution, 0 for correlation.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+static Array* convolve(Array* input, Array* kernel, size_t spatial, ConvMode mode,
+                       size_t stride, size_t dilation, int flip) {
+    #if DEBUG_MODE
+        if (!input || !kernel) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (input->dtype != kernel->dtype) {
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+        return NULL;
+    }
+    if (input->dtype > TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+    if (stride == 0 || dilation == 0) {
+        log_error(ARRAY_ERROR_VALUE, "Stride and dilation must be positive");
+        return NULL;
+    }
+
+    int channels = kernel->ndim == spatial + 2;
+    if ((!channels && kernel->ndim != spatial) || input->ndim < spatial + (size_t)channels) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+        return NULL;
+    }
+    size_t lead = input->ndim - spatial - (size_t)channels;
+    if (channels && input->shape[lead] != kernel->shape[1]) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+        return NULL;
+    }
+
+    ConvGeometry g = { 0 };
+    g.dtype = input->dtype;
+    g.c_in = channels ? kernel->shape[1] : 1;
+    g.c_out = channels ? kernel->shape[0] : 1;
+    g.in_h = spatial == 2 ? input->shape[input->ndim - 2] : 1;
+    g.in_w = input->shape[input->ndim - 1];
+    g.k_h = spatial == 2 ? kernel->shape[kernel->ndim - 2] : 1;
+    g.k_w = kernel->shape[kernel->ndim - 1];
+    g.stride = stride;
+    g.dilation = dilation;
+    g.out_h = 1;
+    if ((spatial == 2 && !conv_axis(g.in_h, g.k_h, stride, dilation, mode, flip, &g.pad_top, &g.out_h)) ||
+        !conv_axis(g.in_w, g.k_w, stride, dilation, mode, flip, &g.pad_left, &g.out_w)) {
+        return NULL;
+    }
+    g.batch = input->size / (g.c_in * g.in_h * g.in_w);
+
+    size_t shape[input->ndim];
+    memcpy(shape, input->shape, lead * sizeof(size_t));
+    if (channels) {
+        shape[lead] = g.c_out;
+    }
+    if (spatial == 2) {
+        shape[input->ndim - 2] = g.out_h;
+    }
+    shape[input->ndim - 1] = g.out_w;
+    Array* result = create_array(input->dtype, input->ndim, shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    // Convolution is correlation with the spatially reversed kernel
+    size_t elem_size = get_dtype_size(input->dtype);
+    size_t taps = g.k_h * g.k_w;
+    char* weights = malloc(kernel->size * elem_size);
+    if (!weights) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for convolution weights");
+        free_array(result);
+        return NULL;
+    }
+    for (size_t f = 0; f < kernel->size / taps; f++) {
+        for (size_t t = 0; t < taps; t++) {
+            size_t src = flip ? taps - 1 - t : t;
+            memcpy(weights + (f * taps + t) * elem_size, (char*)kernel->data + (f * taps + src) * elem_size, elem_size);
+        }
+    }
+    g.input = input->data;
+    g.weights = weights;
+    g.output = result->data;
+
+    size_t positions = g.out_h * g.out_w;
+    if (g.c_in * taps >= CONV_IM2COL_MIN_TAPS && g.c_out >= CONV_IM2COL_MIN_OUT) {
+        g.tiles = (positions + CONV_IM2COL_TILE - 1) / CONV_IM2COL_TILE;
+        parallel_for(g.batch * g.tiles, 1, conv_im2col_kernels[g.dtype], &g);
+    } else {
+        g.tiles = (g.out_w + CONV_DIRECT_TILE - 1) / CONV_DIRECT_TILE;
+        size_t task_flops = g.out_h * (g.out_w < CONV_DIRECT_TILE ? g.out_w : CONV_DIRECT_TILE) * g.c_in * taps;
+        size_t grain = task_flops < PARALLEL_GRAIN_BYTES ? PARALLEL_GRAIN_BYTES / task_flops : 1;
+        parallel_for(g.batch * g.c_out * g.tiles, grain, conv_direct_kernels[g.dtype], &g);
+    }
+
+    free(weights);
+    if (g.failed) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Convolve an input with a kernel along its last axis.
+ *
+ * @param input The input array, of shape (..., length) or (..., c_in, length) for a channel kernel.
+ * @param kernel The kernel, of shape (k) or (c_out, c_in, k).
+ * @param mode CONV_VALID, CONV_SAME or CONV_FULL.
+ * @param stride Step between output positions.
+ * @param dilation Spacing between kernel taps.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* convolve1d(Array* input, Array* kernel, ConvMode mode, size_t stride, size_t dilation) {
+    return convolve(input, kernel, 1, mode, stride, dilation, 1);
+}
+
+/**
+ * Convolve an input with a kernel along its last two axes.
+ *
+ * @param input The input array, of shape (..., h, w) or (..., c_in, h, w) for a channel kernel.
+ * @param kernel The kernel, of shape (k_h, k_w) or (c_out, c_in, k_h, k_w).
+ * @param mode CONV_VALID, CONV_SAME or CONV_FULL.
+ * @param stride Step between output positions along both axes.
+ * @param dilation Spacing between kernel taps along both axes.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* convolve2d(Array* input, Array* kernel, ConvMode mode, size_t stride, size_t dilation) {
+    return convolve(input, kernel, 2, mode, stride, dilation, 1);
+}
+
+/**
+ * Correlate an input with a kernel along its last axis (convolution without flipping the kernel).
+ *
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* correlate1d(Array* input, Array* kernel, ConvMode mode, size_t stride, size_t dilation) {
+    return convolve(input, kernel, 1, mode, stride, dilation, 0);
+}
+
+/**
+ * Correlate an input with a kernel along its last two axes (convolution without flipping the kernel).
+ *
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* correlate2d(Array* input, Array* kernel, ConvMode mode, size_t stride, size_t dilation) {
+    return convolve(input, kernel, 2, mode, stride, dilation, 0);
+}
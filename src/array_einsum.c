@@ -0,0 +1,632 @@
+#include "array.h"
+
+// Subscript labels are the letters a-z and A-Z
+#define EINSUM_MAX_LABELS 52
+
+// Operand count up to which the contraction order is searched exhaustively;
+// larger expressions use a greedy order
+#define EINSUM_OPTIMAL_MAX 6
+
+// An operand or intermediate result and the labels of its axes
+typedef struct {
+    Array* arr;
+    int owned;                           // Whether arr is an intermediate to free
+    char labels[EINSUM_MAX_LABELS + 1];
+    uint64_t mask;                       // Set of labels
+} EinsumTerm;
+
+// Parsed subscripts and the size of every label
+typedef struct {
+    EinsumTerm* terms;
+    size_t n_terms;
+    char output[EINSUM_MAX_LABELS + 1];
+    uint64_t output_mask;
+    size_t dims[EINSUM_MAX_LABELS];
+    DataType dtype;
+} EinsumPlan;
+
+static int label_index(char c) {
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c >= 'A' && c <= 'Z') return 26 + c - 'A';
+    return -1;
+}
+
+static uint64_t label_bit(char c) {
+    return (uint64_t)1 << label_index(c);
+}
+
+// Number of elements spanned by a set of labels
+static double labels_size(const EinsumPlan* p, uint64_t mask) {
+    double size = 1;
+    for (int i = 0; i < EINSUM_MAX_LABELS; i++) {
+        if (mask & ((uint64_t)1 << i)) {
+            size *= p->dims[i];
+        }
+    }
+    return size;
+}
+
+
+// Array helpers
+
+static void release_term(EinsumTerm* t) {
+    if (t->owned) {
+        free_array(t->arr);
+    }
+    t->arr = NULL;
+    t->owned = 0;
+}
+
+// Returns an array sharing the data of arr with another shape of the same size;
+// an empty shape becomes (1,)
+static Array* view_as(Array* arr, size_t ndim, const size_t* shape) {
+    size_t one = 1;
+    if (ndim == 0) {
+        ndim = 1;
+        shape = &one;
+    }
+    Array* view = clone_array(arr);
+    if (!view) {
+        return NULL;
+    }
+    size_t* new_shape = allocate_shape_memory(ndim);
+    if (!new_shape) {
+        free_array(view);
+        return NULL;
+    }
+    memcpy(new_shape, shape, ndim * sizeof(size_t));
+    free(view->shape);
+    view->shape = new_shape;
+    view->ndim = ndim;
+    return view;
+}
+
+// Shape of a label string
+static void labels_shape(const EinsumPlan* p, const char* labels, size_t* shape) {
+    for (size_t i = 0; labels[i]; i++) {
+        shape[i] = p->dims[label_index(labels[i])];
+    }
+}
+
+// Returns the data of a term with its axes in the given label order, as a new array
+// (*owned set) or the term's own array when the order already matches
+static Array* term_in_order(EinsumTerm* t, const char* order, int* owned) {
+    size_t ndim = strlen(order);
+    size_t perm[EINSUM_MAX_LABELS];
+    int identity = 1;
+    for (size_t i = 0; i < ndim; i++) {
+        perm[i] = strchr(t->labels, order[i]) - t->labels;
+        identity &= perm[i] == i;
+    }
+    *owned = !identity;
+    return identity ? t->arr : transpose(t->arr, perm);
+}
+
+/**
+ * Take the diagonal over repeated labels of an operand ("ii->i").
+ *
+ * The result has each label once, in order of first appearance; the source
+ * stride of a label is the sum of the strides of every axis carrying it.
+ *
+ * @param p The plan, for the label sizes.
+ * @param t The term, replaced by its diagonal.
+ * @return 1 on success, 0 on error.
+ */
+static int take_diagonal(const EinsumPlan* p, EinsumTerm* t) {
+    size_t ndim = t->arr->ndim;
+    char labels[EINSUM_MAX_LABELS + 1];
+    size_t strides[EINSUM_MAX_LABELS] = { 0 };
+    size_t n_labels = 0;
+
+    size_t stride = 1;
+    size_t axis_strides[ndim];
+    for (size_t axis = ndim; axis-- > 0;) {
+        axis_strides[axis] = stride;
+        stride *= t->arr->shape[axis];
+    }
+    for (size_t axis = 0; axis < ndim; axis++) {
+        char* found = memchr(labels, t->labels[axis], n_labels);
+        size_t j = found ? (size_t)(found - labels) : n_labels++;
+        labels[j] = t->labels[axis];
+        strides[j] += axis_strides[axis];
+    }
+    labels[n_labels] = '\0';
+
+    size_t shape[EINSUM_MAX_LABELS];
+    labels_shape(p, labels, shape);
+    Array* result = create_array(t->arr->dtype, n_labels, shape, NULL);
+    if (!result) {
+        return 0;
+    }
+
+    // Walk the result with an odometer, bumping the source offset by the summed strides
+    size_t elem_size = get_dtype_size(t->arr->dtype);
+    size_t counter[EINSUM_MAX_LABELS] = { 0 };
+    size_t offset = 0;
+    for (size_t i = 0; i < result->size; i++) {
+        memcpy((char*)result->data + i * elem_size, (char*)t->arr->data + offset * elem_size, elem_size);
+        for (size_t d = n_labels; d-- > 0;) {
+            offset += strides[d];
+            if (++counter[d] < shape[d]) {
+                break;
+            }
+            offset -= strides[d] * shape[d];
+            counter[d] = 0;
+        }
+    }
+
+    release_term(t);
+    t->arr = result;
+    t->owned = 1;
+    memcpy(t->labels, labels, n_labels + 1);
+    return 1;
+}
+
+// Sums a term over every label outside keep
+static int sum_out(EinsumTerm* t, uint64_t keep) {
+    for (size_t axis = strlen(t->labels); axis-- > 0;) {
+        if (keep & label_bit(t->labels[axis])) {
+            continue;
+        }
+        Array* summed;
+        if (t->arr->ndim == 1) {
+            // sum_along_axis cannot produce a zero-dimensional array; keep the total as (1,)
+            size_t shape[2] = { 1, t->arr->shape[0] };
+            Array* row = view_as(t->arr, 2, shape);
+            summed = row ? sum_along_axis(row, 1) : NULL;
+            free_array(row);
+        } else {
+            summed = sum_along_axis(t->arr, axis);
+        }
+        if (!summed) {
+            return 0;
+        }
+        release_term(t);
+        t->arr = summed;
+        t->owned = 1;
+        memmove(t->labels + axis, t->labels + axis + 1, strlen(t->labels + axis));
+    }
+    t->mask &= keep;
+    return 1;
+}
+
+
+// Pairwise contraction
+
+// Work shared by the threads of a batched dot product
+typedef struct {
+    const char* x;
+    const char* y;
+    char* out;
+    size_t k;
+} DotContext;
+
+// Each task computes out[b] = sum_i x[b, i] * y[b, i] for a range of b
+#define DEFINE_DOT_KERNELS(T, suffix)                                                  \
+    static void dot_rows_##suffix(size_t begin, size_t end, void* ctx) {               \
+        const DotContext* c = ctx;                                                     \
+        for (size_t b = begin; b < end; b++) {                                         \
+            const T* x = (const T*)c->x + b * c->k;                                    \
+            const T* y = (const T*)c->y + b * c->k;                                    \
+            T acc = 0;                                                                 \
+            for (size_t i = 0; i < c->k; i++) acc += x[i] * y[i];                      \
+            ((T*)c->out)[b] = acc;                                                     \
+        }                                                                              \
+    }
+
+DEFINE_DOT_KERNELS(int, int)
+DEFINE_DOT_KERNELS(float, float)
+DEFINE_DOT_KERNELS(double, double)
+
+// Indexed by dtype
+static const ParallelFunc dot_kernels[3] = { dot_rows_int, dot_rows_float, dot_rows_double };
+
+// Appends the labels of src that are in mask to dst
+static size_t append_labels(char* dst, size_t len, const char* src, uint64_t mask) {
+    for (size_t i = 0; src[i]; i++) {
+        if (mask & label_bit(src[i])) {
+            dst[len++] = src[i];
+        }
+    }
+    dst[len] = '\0';
+    return len;
+}
+
+/**
+ * Contract two terms, keeping the labels in keep.
+ *
+ * Labels are grouped into batch (B: both terms, kept), contracted (K: both,
+ * not kept) and free labels of each term (M, N). With contracted labels the
+ * terms are laid out as (B, M, K) and (B, K, N) stacks and multiplied by
+ * matmul, or by a fused dot product when M and N are empty. Without
+ * contracted labels the product is the result itself, so the terms are
+ * broadcast against each other as (B, M, 1...) and (B, 1..., N). Only the
+ * result is materialized, never the full (B, M, N, K) product.
+ *
+ * @param p The plan.
+ * @param x The first term, released by the call.
+ * @param y The second term, released by the call.
+ * @param keep The labels needed by the output or by other terms.
+ * @param result Receives the contracted term, with labels B, M, N.
+ * @return 1 on success, 0 on error.
+ */
+static int contract_pair(const EinsumPlan* p, EinsumTerm* x, EinsumTerm* y, uint64_t keep, EinsumTerm* result) {
+    uint64_t both = x->mask & y->mask;
+    uint64_t batch = both & keep, contracted = both & ~keep;
+    uint64_t m_mask = x->mask & ~y->mask, n_mask = y->mask & ~x->mask;
+
+    char b[EINSUM_MAX_LABELS + 1], k[EINSUM_MAX_LABELS + 1];
+    char m[EINSUM_MAX_LABELS + 1], n[EINSUM_MAX_LABELS + 1];
+    size_t nb = append_labels(b, 0, x->labels, batch);
+    size_t nk = append_labels(k, 0, x->labels, contracted);
+    size_t nm = append_labels(m, 0, x->labels, m_mask);
+    size_t nn = append_labels(n, 0, y->labels, n_mask);
+    size_t bs = (size_t)labels_size(p, batch), ks = (size_t)labels_size(p, contracted);
+    size_t ms = (size_t)labels_size(p, m_mask), ns = (size_t)labels_size(p, n_mask);
+
+    // Axis orders of the operands and of the result
+    char x_order[EINSUM_MAX_LABELS + 1], y_order[EINSUM_MAX_LABELS + 1];
+    char* r = result->labels;
+    size_t len = append_labels(r, 0, b, batch);
+    len = append_labels(r, len, m, m_mask);
+    append_labels(r, len, n, n_mask);
+    if (nk == 0) {
+        strcpy(x_order, b); strcat(x_order, m);
+        strcpy(y_order, b); strcat(y_order, n);
+    } else {
+        strcpy(x_order, b); strcat(x_order, m); strcat(x_order, k);
+        strcpy(y_order, b); strcat(y_order, k); strcat(y_order, n);
+    }
+
+    int x_owned = 0, y_owned = 0;
+    Array* xa = term_in_order(x, x_order, &x_owned);
+    Array* ya = xa ? term_in_order(y, y_order, &y_owned) : NULL;
+    Array* xv = NULL;
+    Array* yv = NULL;
+    Array* out = NULL;
+    size_t shape[EINSUM_MAX_LABELS];
+    labels_shape(p, r, shape);
+
+    if (ya && nk == 0) {
+        // Hadamard or outer product: broadcast (B, M, 1...) against (B, 1..., N)
+        size_t xs[EINSUM_MAX_LABELS], ys[EINSUM_MAX_LABELS];
+        size_t nd = nb + nm + nn;
+        for (size_t i = 0; i < nd; i++) {
+            xs[i] = i < nb + nm ? shape[i] : 1;
+            ys[i] = i < nb || i >= nb + nm ? shape[i] : 1;
+        }
+        xv = view_as(xa, nd, xs);
+        yv = view_as(ya, nd, ys);
+        out = xv && yv ? broadcast_arrays(xv, yv, '*') : NULL;
+    } else if (ya && nm == 0 && nn == 0) {
+        size_t out_shape[1] = { bs };
+        out = create_array(p->dtype, 1, out_shape, NULL);
+        if (out) {
+            DotContext c = { xa->data, ya->data, out->data, ks };
+            parallel_for(bs, PARALLEL_GRAIN_BYTES / (ks * get_dtype_size(p->dtype)) + 1,
+                         dot_kernels[p->dtype], &c);
+        }
+    } else if (ya) {
+        size_t xs[3] = { bs, ms, ks }, ys[3] = { bs, ks, ns };
+        xv = view_as(xa, 3, xs);
+        yv = view_as(ya, 3, ys);
+        out = xv && yv ? matmul(xv, yv) : NULL;
+    }
+
+    if (out) {
+        Array* shaped = view_as(out, nb + nm + nn, shape);
+        free_array(out);
+        out = shaped;
+    }
+
+    free_array(xv);
+    free_array(yv);
+    if (xa && x_owned) free_array(xa);
+    if (ya && y_owned) free_array(ya);
+    release_term(x);
+    release_term(y);
+    if (!out) {
+        return 0;
+    }
+    result->arr = out;
+    result->owned = 1;
+    result->mask = batch | m_mask | n_mask;
+    return 1;
+}
+
+
+// Contraction order
+
+// Labels a set of terms must keep: those it contains that the output or another term needs
+static uint64_t subset_labels(const EinsumPlan* p, unsigned subset) {
+    uint64_t inside = 0, outside = p->output_mask;
+    for (size_t i = 0; i < p->n_terms; i++) {
+        if (subset & (1u << i)) {
+            inside |= p->terms[i].mask;
+        } else {
+            outside |= p->terms[i].mask;
+        }
+    }
+    return inside & outside;
+}
+
+// Contracts a subset of the terms along the optimal split found by find_optimal_order
+static int contract_subset(EinsumPlan* p, const unsigned* split, unsigned subset, EinsumTerm* result) {
+    if ((subset & (subset - 1)) == 0) {
+        size_t i = __builtin_ctz(subset);
+        *result = p->terms[i];
+        p->terms[i].arr = NULL;
+        p->terms[i].owned = 0;
+        return 1;
+    }
+    EinsumTerm x = { 0 }, y = { 0 };
+    int ok = contract_subset(p, split, split[subset], &x) &&
+             contract_subset(p, split, subset & ~split[subset], &y);
+    if (!ok) {
+        release_term(&x);
+        release_term(&y);
+        return 0;
+    }
+    return contract_pair(p, &x, &y, subset_labels(p, subset), result);
+}
+
+/**
+ * Find the pairwise contraction order with the fewest multiply-adds.
+ *
+ * Dynamic programming over subsets of terms: the cost of a subset is the
+ * cheapest split into two parts, each contracted optimally, plus the cost of
+ * contracting the two results, which is the size of the union of their labels.
+ *
+ * @param p The plan.
+ * @param split Receives, for each subset, one part of its best split.
+ */
+static void find_optimal_order(const EinsumPlan* p, unsigned* split) {
+    unsigned full = (1u << p->n_terms) - 1;
+    double cost[1u << EINSUM_OPTIMAL_MAX];
+    uint64_t labels[1u << EINSUM_OPTIMAL_MAX];
+    for (unsigned s = 1; s <= full; s++) {
+        labels[s] = subset_labels(p, s);
+        cost[s] = 0;
+        if ((s & (s - 1)) == 0) {
+            continue;
+        }
+        cost[s] = -1;
+        // Each split {a, s \ a} is visited once, with a holding the lowest term of s
+        unsigned low = s & -s;
+        for (unsigned a = (s - 1) & s; a > 0; a = (a - 1) & s) {
+            if (!(a & low)) {
+                continue;
+            }
+            unsigned b = s & ~a;
+            double c = cost[a] + cost[b] + labels_size(p, labels[a] | labels[b]);
+            if (cost[s] < 0 || c < cost[s]) {
+                cost[s] = c;
+                split[s] = a;
+            }
+        }
+    }
+}
+
+/**
+ * Contract the terms greedily, each step picking the pair whose result is
+ * smallest relative to its operands, then the cheapest.
+ *
+ * @param p The plan; its terms are consumed.
+ * @param result Receives the final term.
+ * @return 1 on success, 0 on error.
+ */
+static int contract_greedy(EinsumPlan* p, EinsumTerm* result) {
+    size_t n = p->n_terms;
+    while (n > 1) {
+        size_t best_i = 0, best_j = 1;
+        double best_score = 0, best_flops = 0;
+        uint64_t best_keep = 0;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = i + 1; j < n; j++) {
+                uint64_t others = p->output_mask;
+                for (size_t o = 0; o < n; o++) {
+                    if (o != i && o != j) others |= p->terms[o].mask;
+                }
+                uint64_t pair = p->terms[i].mask | p->terms[j].mask;
+                uint64_t keep = pair & others;
+                double score = labels_size(p, keep) - labels_size(p, p->terms[i].mask) -
+                               labels_size(p, p->terms[j].mask);
+                double flops = labels_size(p, pair);
+                if ((i == 0 && j == 1) || score < best_score ||
+                    (score == best_score && flops < best_flops)) {
+                    best_i = i, best_j = j;
+                    best_score = score, best_flops = flops;
+                    best_keep = keep;
+                }
+            }
+        }
+
+        EinsumTerm contracted = { 0 };
+        if (!contract_pair(p, &p->terms[best_i], &p->terms[best_j], best_keep, &contracted)) {
+            return 0;
+        }
+        p->terms[best_i] = contracted;
+        p->terms[best_j] = p->terms[--n];
+        p->terms[n].arr = NULL;
+        p->terms[n].owned = 0;
+    }
+    *result = p->terms[0];
+    p->terms[0].arr = NULL;
+    p->terms[0].owned = 0;
+    return 1;
+}
+
+
+// Parsing
+
+/**
+ * Parse einsum subscripts and check them against the operands.
+ *
+ * @param p The plan, with terms allocated for n_operands.
+ * @param subscripts The subscripts ("ij,jk->ik"); without "->" the output is
+ *        every label that appears once, in alphabetical order.
+ * @param operands The operands.
+ * @param n_operands Number of operands.
+ * @return 1 on success, 0 on error.
+ */
+static int parse_subscripts(EinsumPlan* p, const char* subscripts, Array** operands, size_t n_operands) {
+    size_t counts[EINSUM_MAX_LABELS] = { 0 };
+    const char* s = subscripts;
+    for (size_t t = 0; t < n_operands; t++) {
+        EinsumTerm* term = &p->terms[t];
+        size_t len = 0;
+        for (; *s && *s != ',' && *s != '-'; s++) {
+            if (*s == ' ') continue;
+            int label = label_index(*s);
+            if (label < 0 || len == EINSUM_MAX_LABELS) {
+                log_error(ARRAY_ERROR_VALUE, "Invalid subscripts");
+                return 0;
+            }
+            term->labels[len++] = *s;
+            term->mask |= label_bit(*s);
+            counts[label]++;
+        }
+        term->labels[len] = '\0';
+        if ((t + 1 < n_operands) != (*s == ',')) {
+            log_error(ARRAY_ERROR_VALUE, "Number of operands does not match the subscripts");
+            return 0;
+        }
+        if (*s == ',') s++;
+
+        Array* arr = operands[t];
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "One of the operands is NULL");
+            return 0;
+        }
+        if (arr->dtype != p->dtype) {
+            log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+            return 0;
+        }
+        if (len != arr->ndim) {
+            log_error(ARRAY_ERROR_SHAPE, "Subscripts do not match the number of dimensions");
+            return 0;
+        }
+        for (size_t axis = 0; axis < len; axis++) {
+            size_t* dim = &p->dims[label_index(term->labels[axis])];
+            if (*dim && *dim != arr->shape[axis]) {
+                log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible: a label has different sizes");
+                return 0;
+            }
+            *dim = arr->shape[axis];
+        }
+        term->arr = arr;
+    }
+
+    size_t len = 0;
+    if (s[0] == '-' && s[1] == '>') {
+        for (s += 2; *s; s++) {
+            if (*s == ' ') continue;
+            int label = label_index(*s);
+            if (label < 0 || !counts[label] || (p->output_mask & label_bit(*s))) {
+                log_error(ARRAY_ERROR_VALUE, "Invalid subscripts");
+                return 0;
+            }
+            p->output[len++] = *s;
+            p->output_mask |= label_bit(*s);
+        }
+    } else if (*s) {
+        log_error(ARRAY_ERROR_VALUE, "Invalid subscripts");
+        return 0;
+    } else {
+        // Implicit output: labels appearing once, in ASCII order
+        for (char c = 'A'; c <= 'z'; c++) {
+            int label = label_index(c);
+            if (label >= 0 && counts[label] == 1) {
+                p->output[len++] = c;
+                p->output_mask |= label_bit(c);
+            }
+        }
+    }
+    p->output[len] = '\0';
+    return 1;
+}
+
+/**
+ * Evaluate an Einstein summation over a list of operands.
+ *
+ * Each operand first takes its diagonal over repeated labels and is summed
+ * over labels no other operand or the output uses. The remaining operands are
+ * contracted pairwise, in the order with the fewest multiply-adds for up to
+ * EINSUM_OPTIMAL_MAX operands and greedily beyond, each contraction mapping
+ * to a stacked GEMM, a fused dot product or a broadcast product (see
+ * contract_pair). The result is finally permuted into the output order.
+ *
+ * @param subscripts The subscripts, e.g. "ij,jk->ik", "bij,bjk->bik", "ii->", "i,j".
+ * @param operands The int, float or double operands, all of the same dtype.
+ * @param n_operands Number of operands.
+ * @return A pointer to the new Array structure, or NULL on error. An output without
+ *         labels is returned as an array of shape (1,).
+ */
+Array* einsum(const char* subscripts, Array** operands, size_t n_operands) {
+    if (!subscripts || !operands || n_operands == 0) {
+        log_error(ARRAY_ERROR_NULL, "Subscripts or operands are NULL");
+        return NULL;
+    }
+    if (!operands[0]) {
+        log_error(ARRAY_ERROR_NULL, "One of the operands is NULL");
+        return NULL;
+    }
+    if (operands[0]->dtype > TYPE_DOUBLE || operands[0]->dtype == TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    EinsumPlan p = { 0 };
+    p.dtype = operands[0]->dtype;
+    p.n_terms = n_operands;
+    p.terms = calloc(n_operands, sizeof(EinsumTerm));
+    if (!p.terms) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for einsum terms");
+        return NULL;
+    }
+
+    Array* result = NULL;
+    EinsumTerm final = { 0 };
+    int ok = parse_subscripts(&p, subscripts, operands, n_operands);
+
+    // Diagonals, then sums over labels only one operand uses
+    for (size_t t = 0; ok && t < n_operands; t++) {
+        EinsumTerm* term = &p.terms[t];
+        if (strlen(term->labels) != (size_t)__builtin_popcountll(term->mask)) {
+            ok = take_diagonal(&p, term);
+        }
+        uint64_t keep = p.output_mask;
+        for (size_t o = 0; o < n_operands; o++) {
+            if (o != t) keep |= p.terms[o].mask;
+        }
+        ok = ok && sum_out(term, keep);
+    }
+
+    if (ok) {
+        if (n_operands <= EINSUM_OPTIMAL_MAX) {
+            unsigned split[1u << EINSUM_OPTIMAL_MAX];
+            find_optimal_order(&p, split);
+            ok = contract_subset(&p, split, (1u << n_operands) - 1, &final);
+        } else {
+            ok = contract_greedy(&p, &final);
+        }
+    }
+
+    if (ok) {
+        int owned;
+        Array* ordered = term_in_order(&final, p.output, &owned);
+        if (ordered) {
+            size_t shape[EINSUM_MAX_LABELS];
+            labels_shape(&p, p.output, shape);
+            result = view_as(ordered, strlen(p.output), shape);
+            if (owned) free_array(ordered);
+        }
+    }
+
+    release_term(&final);
+    for (size_t t = 0; t < n_operands; t++) {
+        release_term(&p.terms[t]);
+    }
+    free(p.terms);
+    return result;
+}
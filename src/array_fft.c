@@ -0,0 +1,518 @@
+#include "array.h"
+#include <math.h>
+#include <pthread.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Maximum number of radix passes of a plan (4^32 exceeds any addressable length)
+#define FFT_MAX_FACTORS 64
+
+typedef struct {
+    double re, im;
+} Complex;
+
+// Precomputed data for transforms of one length. Plans are immutable once
+// built and shared by every thread through the plan cache, a list that only
+// grows until fft_free_plans.
+typedef struct FftPlan {
+    size_t n;                 // Transform length
+    int real;                 // Real-input plan: half-length complex transform plus split twiddles
+    size_t n_factors;         // Number of radix passes (0 for Bluestein and real plans)
+    size_t factors[FFT_MAX_FACTORS];
+    Complex* twiddles;        // Radix passes: (n / radix) * (radix - 1) twiddles per pass, concatenated
+                              // Real plans: exp(-2 pi i k / n) for k <= n / 2
+    struct FftPlan* inner;    // Bluestein: smooth plan of length >= 2n - 1; real plans: plan of length n / 2
+    Complex* chirp;           // Bluestein: exp(-pi i k^2 / n) for k < n
+    Complex* chirp_fft;       // Bluestein: transform of the conjugate chirp, scaled by 1 / inner->n
+    size_t scratch;           // Complex elements of work space needed by fft_execute
+    struct FftPlan* next;
+} FftPlan;
+
+static FftPlan* plan_cache = NULL;
+static pthread_mutex_t plan_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static Complex cmul(Complex a, Complex b) {
+    return (Complex){ a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+}
+
+static Complex expi(double angle) {
+    return (Complex){ cos(angle), sin(angle) };
+}
+
+/**
+ * Split n into radix 4, 2, 3 and 5 passes.
+ *
+ * @return 1 if n only has the prime factors 2, 3 and 5, 0 otherwise.
+ */
+static int factorize(size_t n, size_t* factors, size_t* n_factors) {
+    static const size_t radices[] = { 4, 2, 3, 5 };
+    *n_factors = 0;
+    for (size_t r = 0; r < sizeof(radices) / sizeof(radices[0]); r++) {
+        while (n % radices[r] == 0) {
+            factors[(*n_factors)++] = radices[r];
+            n /= radices[r];
+        }
+    }
+    return n == 1;
+}
+
+// Smallest length >= n with no prime factors other than 2, 3 and 5
+static size_t next_smooth(size_t n) {
+    size_t factors[FFT_MAX_FACTORS], n_factors;
+    while (!factorize(n, factors, &n_factors)) {
+        n++;
+    }
+    return n;
+}
+
+static void free_plan(FftPlan* plan) {
+    free(plan->twiddles);
+    free(plan->chirp);
+    free(plan->chirp_fft);
+    free(plan);
+}
+
+static void fft_execute(const FftPlan* plan, Complex* data, Complex* work);
+static FftPlan* lookup_plan(size_t n, int real);
+
+// Builds a plan; called with plan_cache_lock held
+static FftPlan* build_plan(size_t n, int real) {
+    FftPlan* plan = calloc(1, sizeof(FftPlan));
+    if (!plan) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for FFT plan");
+        return NULL;
+    }
+    plan->n = n;
+    plan->real = real;
+
+    if (real) {
+        // Even-length real transforms pack pairs of samples into one complex transform of half the length
+        plan->inner = lookup_plan(n / 2, 0);
+        plan->twiddles = malloc((n / 2 + 1) * sizeof(Complex));
+        if (!plan->inner || !plan->twiddles) {
+            free_plan(plan);
+            return NULL;
+        }
+        for (size_t k = 0; k <= n / 2; k++) {
+            plan->twiddles[k] = expi(-2 * M_PI * (double)k / (double)n);
+        }
+        plan->scratch = plan->inner->scratch;
+        return plan;
+    }
+
+    if (factorize(n, plan->factors, &plan->n_factors)) {
+        // Stockham passes: the pass of radix r on sub-length len needs the
+        // twiddles exp(-2 pi i p k / len) for p < len / r and 1 <= k < r
+        size_t total = 0, len = n;
+        for (size_t f = 0; f < plan->n_factors; f++) {
+            total += len / plan->factors[f] * (plan->factors[f] - 1);
+            len /= plan->factors[f];
+        }
+        plan->twiddles = malloc((total ? total : 1) * sizeof(Complex));
+        if (!plan->twiddles) {
+            free_plan(plan);
+            return NULL;
+        }
+        Complex* tw = plan->twiddles;
+        len = n;
+        for (size_t f = 0; f < plan->n_factors; f++) {
+            size_t r = plan->factors[f], m = len / r;
+            for (size_t p = 0; p < m; p++) {
+                for (size_t k = 1; k < r; k++) {
+                    *tw++ = expi(-2 * M_PI * (double)(p * k) / (double)len);
+                }
+            }
+            len = m;
+        }
+        plan->scratch = n;
+        return plan;
+    }
+
+    // Bluestein: a length-n transform is a convolution with a chirp, computed with a smooth transform
+    plan->n_factors = 0;
+    size_t m = next_smooth(2 * n - 1);
+    plan->inner = lookup_plan(m, 0);
+    plan->chirp = malloc(n * sizeof(Complex));
+    plan->chirp_fft = calloc(m, sizeof(Complex));
+    Complex* work = malloc(m * sizeof(Complex));
+    if (!plan->inner || !plan->chirp || !plan->chirp_fft || !work) {
+        free(work);
+        free_plan(plan);
+        return NULL;
+    }
+    for (size_t k = 0; k < n; k++) {
+        // k^2 mod 2n keeps the angle small and accurate
+        size_t k2 = (size_t)((unsigned long long)k * k % (2 * (unsigned long long)n));
+        plan->chirp[k] = expi(-M_PI * (double)k2 / (double)n);
+    }
+    for (size_t k = 0; k < n; k++) {
+        Complex c = { plan->chirp[k].re / (double)m, -plan->chirp[k].im / (double)m };
+        plan->chirp_fft[k] = c;
+        if (k) {
+            plan->chirp_fft[m - k] = c;
+        }
+    }
+    fft_execute(plan->inner, plan->chirp_fft, work);
+    free(work);
+    plan->scratch = 2 * m;
+    return plan;
+}
+
+// Finds or builds the plan of a length; called with plan_cache_lock held
+static FftPlan* lookup_plan(size_t n, int real) {
+    for (FftPlan* plan = plan_cache; plan; plan = plan->next) {
+        if (plan->n == n && plan->real == real) {
+            return plan;
+        }
+    }
+    FftPlan* plan = build_plan(n, real);
+    if (plan) {
+        // Published fully built, so lock-free readers never see a partial plan
+        plan->next = plan_cache;
+        __atomic_store_n(&plan_cache, plan, __ATOMIC_RELEASE);
+    }
+    return plan;
+}
+
+// Cached plans are found without locking; only building a new plan takes the lock
+static const FftPlan* get_plan(size_t n, int real) {
+    for (FftPlan* plan = __atomic_load_n(&plan_cache, __ATOMIC_ACQUIRE); plan; plan = plan->next) {
+        if (plan->n == n && plan->real == real) {
+            return plan;
+        }
+    }
+    pthread_mutex_lock(&plan_cache_lock);
+    const FftPlan* plan = lookup_plan(n, real);
+    pthread_mutex_unlock(&plan_cache_lock);
+    return plan;
+}
+
+/**
+ * Free every cached FFT plan.
+ *
+ * Must not be called while a transform is running.
+ */
+void fft_free_plans() {
+    pthread_mutex_lock(&plan_cache_lock);
+    while (plan_cache) {
+        FftPlan* next = plan_cache->next;
+        free_plan(plan_cache);
+        plan_cache = next;
+    }
+    pthread_mutex_unlock(&plan_cache_lock);
+}
+
+/**
+ * One Stockham pass of radix r over sub-transforms of length len = n / s.
+ *
+ * Element q + s * (p + j * m) of x feeds output q + s * (r * p + k) of y.
+ * The inner loop over q has a fixed twiddle and unit stride, so the
+ * butterflies vectorize across the s interleaved sub-transforms.
+ */
+static void stockham_pass(size_t r, size_t m, size_t s, const Complex* restrict tw,
+                          const Complex* restrict x, Complex* restrict y) {
+    const double s3 = 0.86602540378443864676;  // sin(2 pi / 3)
+    const double c51 = 0.30901699437494742410, c52 = -0.80901699437494742410;  // cos(2 pi / 5), cos(4 pi / 5)
+    const double s51 = 0.95105651629515357212, s52 = 0.58778525229247312917;   // sin(2 pi / 5), sin(4 pi / 5)
+
+    for (size_t p = 0; p < m; p++) {
+        const Complex* w = tw + p * (r - 1);
+        const Complex* in = x + s * p;
+        Complex* out = y + s * r * p;
+        switch (r) {
+            case 2:
+                for (size_t q = 0; q < s; q++) {
+                    Complex a0 = in[q], a1 = in[q + s * m];
+                    out[q] = (Complex){ a0.re + a1.re, a0.im + a1.im };
+                    out[q + s] = cmul((Complex){ a0.re - a1.re, a0.im - a1.im }, w[0]);
+                }
+                break;
+            case 3:
+                for (size_t q = 0; q < s; q++) {
+                    Complex a0 = in[q], a1 = in[q + s * m], a2 = in[q + 2 * s * m];
+                    Complex t = { a1.re + a2.re, a1.im + a2.im };
+                    Complex u = { a0.re - 0.5 * t.re, a0.im - 0.5 * t.im };
+                    Complex v = { s3 * (a1.im - a2.im), -s3 * (a1.re - a2.re) };  // -i sin(2 pi / 3) (a1 - a2)
+                    out[q] = (Complex){ a0.re + t.re, a0.im + t.im };
+                    out[q + s] = cmul((Complex){ u.re + v.re, u.im + v.im }, w[0]);
+                    out[q + 2 * s] = cmul((Complex){ u.re - v.re, u.im - v.im }, w[1]);
+                }
+                break;
+            case 4:
+                for (size_t q = 0; q < s; q++) {
+                    Complex a0 = in[q], a1 = in[q + s * m], a2 = in[q + 2 * s * m], a3 = in[q + 3 * s * m];
+                    Complex t0 = { a0.re + a2.re, a0.im + a2.im };
+                    Complex t1 = { a0.re - a2.re, a0.im - a2.im };
+                    Complex t2 = { a1.re + a3.re, a1.im + a3.im };
+                    Complex t3 = { a1.im - a3.im, a3.re - a1.re };  // -i (a1 - a3)
+                    out[q] = (Complex){ t0.re + t2.re, t0.im + t2.im };
+                    out[q + s] = cmul((Complex){ t1.re + t3.re, t1.im + t3.im }, w[0]);
+                    out[q + 2 * s] = cmul((Complex){ t0.re - t2.re, t0.im - t2.im }, w[1]);
+                    out[q + 3 * s] = cmul((Complex){ t1.re - t3.re, t1.im - t3.im }, w[2]);
+                }
+                break;
+            case 5:
+                for (size_t q = 0; q < s; q++) {
+                    Complex a0 = in[q], a1 = in[q + s * m], a2 = in[q + 2 * s * m];
+                    Complex a3 = in[q + 3 * s * m], a4 = in[q + 4 * s * m];
+                    Complex t1 = { a1.re + a4.re, a1.im + a4.im }, t2 = { a2.re + a3.re, a2.im + a3.im };
+                    Complex t3 = { a1.re - a4.re, a1.im - a4.im }, t4 = { a2.re - a3.re, a2.im - a3.im };
+                    Complex u1 = { a0.re + c51 * t1.re + c52 * t2.re, a0.im + c51 * t1.im + c52 * t2.im };
+                    Complex u2 = { a0.re + c52 * t1.re + c51 * t2.re, a0.im + c52 * t1.im + c51 * t2.im };
+                    // v1 = -i (s51 t3 + s52 t4), v2 = -i (s52 t3 - s51 t4)
+                    Complex v1 = { s51 * t3.im + s52 * t4.im, -(s51 * t3.re + s52 * t4.re) };
+                    Complex v2 = { s52 * t3.im - s51 * t4.im, -(s52 * t3.re - s51 * t4.re) };
+                    out[q] = (Complex){ a0.re + t1.re + t2.re, a0.im + t1.im + t2.im };
+                    out[q + s] = cmul((Complex){ u1.re + v1.re, u1.im + v1.im }, w[0]);
+                    out[q + 2 * s] = cmul((Complex){ u2.re + v2.re, u2.im + v2.im }, w[1]);
+                    out[q + 3 * s] = cmul((Complex){ u2.re - v2.re, u2.im - v2.im }, w[2]);
+                    out[q + 4 * s] = cmul((Complex){ u1.re - v1.re, u1.im - v1.im }, w[3]);
+                }
+                break;
+        }
+    }
+}
+
+/**
+ * Compute the forward transform of data in place.
+ *
+ * @param work Scratch space of plan->scratch elements.
+ */
+static void fft_execute(const FftPlan* plan, Complex* data, Complex* work) {
+    size_t n = plan->n;
+    if (plan->n_factors || n == 1) {
+        Complex* x = data;
+        Complex* y = work;
+        const Complex* tw = plan->twiddles;
+        size_t s = 1;
+        for (size_t f = 0; f < plan->n_factors; f++) {
+            size_t r = plan->factors[f], m = n / (s * r);
+            stockham_pass(r, m, s, tw, x, y);
+            tw += m * (r - 1);
+            s *= r;
+            Complex* t = x;
+            x = y;
+            y = t;
+        }
+        if (x != data) {
+            memcpy(data, x, n * sizeof(Complex));
+        }
+        return;
+    }
+
+    // Bluestein: X_k = chirp_k * ifft(fft(x * chirp) * fft(conj(chirp)))_k
+    size_t m = plan->inner->n;
+    Complex* a = work;
+    for (size_t k = 0; k < n; k++) {
+        a[k] = cmul(data[k], plan->chirp[k]);
+    }
+    memset(a + n, 0, (m - n) * sizeof(Complex));
+    fft_execute(plan->inner, a, work + m);
+    for (size_t k = 0; k < m; k++) {
+        // Conjugate the product so the forward transform computes the inverse
+        Complex c = cmul(a[k], plan->chirp_fft[k]);
+        a[k] = (Complex){ c.re, -c.im };
+    }
+    fft_execute(plan->inner, a, work + m);
+    for (size_t k = 0; k < n; k++) {
+        data[k] = cmul((Complex){ a[k].re, -a[k].im }, plan->chirp[k]);
+    }
+}
+
+typedef enum {
+    FFT_FORWARD,
+    FFT_INVERSE,
+    FFT_REAL
+} FftKind;
+
+typedef struct {
+    const FftPlan* plan;
+    FftKind kind;
+    DataType in_dtype, out_dtype;
+    const char* input;
+    char* output;
+    size_t n;           // Length of the transformed axis
+    size_t n_out;       // Length of the output axis
+    size_t inner;       // Elements after the axis (element stride along the axis)
+    int failed;
+} FftContext;
+
+static Complex load_element(const char* data, DataType dtype, size_t i) {
+    switch (dtype) {
+        case TYPE_INT: return (Complex){ ((const int*)data)[i], 0 };
+        case TYPE_FLOAT: return (Complex){ ((const float*)data)[i], 0 };
+        case TYPE_DOUBLE: return (Complex){ ((const double*)data)[i], 0 };
+        case TYPE_COMPLEX_FLOAT: return (Complex){ ((const float*)data)[2 * i], ((const float*)data)[2 * i + 1] };
+        case TYPE_COMPLEX_DOUBLE: return ((const Complex*)data)[i];
+        default: return (Complex){ 0, 0 };
+    }
+}
+
+// Transforms the lines [begin, end) of the axis, gathering each line from the strided input
+static void fft_lines(size_t begin, size_t end, void* ctx) {
+    FftContext* c = ctx;
+    const FftPlan* plan = c->plan;
+    size_t n = c->n;
+    // The real plan packs n samples into n / 2 complex values
+    size_t len = plan->real ? n / 2 : n;
+    Complex* line = malloc((len + 1 + plan->scratch) * sizeof(Complex));
+    if (!line) {
+        __atomic_store_n(&c->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    Complex* work = line + len + 1;
+    double scale = c->kind == FFT_INVERSE ? 1.0 / (double)n : 1.0;
+
+    for (size_t l = begin; l < end; l++) {
+        size_t outer = l / c->inner, i = l % c->inner;
+        size_t in_base = outer * n * c->inner + i;
+        size_t out_base = outer * c->n_out * c->inner + i;
+
+        if (plan->real) {
+            for (size_t k = 0; k < len; k++) {
+                line[k].re = load_element(c->input, c->in_dtype, in_base + 2 * k * c->inner).re;
+                line[k].im = load_element(c->input, c->in_dtype, in_base + (2 * k + 1) * c->inner).re;
+            }
+            fft_execute(plan->inner, line, work);
+            // Split the packed transform Z into the even and odd sample spectra E and O: X_k = E_k + w^k O_k
+            line[len] = line[0];
+            for (size_t k = 0; k <= len / 2; k++) {
+                Complex z = line[k], zc = { line[len - k].re, -line[len - k].im };
+                Complex y = line[len - k], yc = { line[k].re, -line[k].im };
+                Complex e = { 0.5 * (z.re + zc.re), 0.5 * (z.im + zc.im) };
+                Complex o = { 0.5 * (z.im - zc.im), -0.5 * (z.re - zc.re) };
+                Complex e2 = { 0.5 * (y.re + yc.re), 0.5 * (y.im + yc.im) };
+                Complex o2 = { 0.5 * (y.im - yc.im), -0.5 * (y.re - yc.re) };
+                Complex x = cmul(o, plan->twiddles[k]);
+                Complex x2 = cmul(o2, plan->twiddles[len - k]);
+                line[k] = (Complex){ e.re + x.re, e.im + x.im };
+                line[len - k] = (Complex){ e2.re + x2.re, e2.im + x2.im };
+            }
+        } else {
+            // The inverse transform is the conjugate of the forward transform of the conjugate
+            double sign = c->kind == FFT_INVERSE ? -1.0 : 1.0;
+            for (size_t k = 0; k < n; k++) {
+                Complex v = load_element(c->input, c->in_dtype, in_base + k * c->inner);
+                line[k] = (Complex){ v.re, sign * v.im };
+            }
+            fft_execute(plan, line, work);
+            for (size_t k = 0; k < c->n_out; k++) {
+                line[k] = (Complex){ scale * line[k].re, sign * scale * line[k].im };
+            }
+        }
+
+        if (c->out_dtype == TYPE_COMPLEX_FLOAT) {
+            float* out = (float*)c->output;
+            for (size_t k = 0; k < c->n_out; k++) {
+                size_t o = out_base + k * c->inner;
+                out[2 * o] = (float)line[k].re;
+                out[2 * o + 1] = (float)line[k].im;
+            }
+        } else {
+            Complex* out = (Complex*)c->output;
+            for (size_t k = 0; k < c->n_out; k++) {
+                out[out_base + k * c->inner] = line[k];
+            }
+        }
+    }
+    free(line);
+}
+
+/**
+ * Compute a transform along an axis.
+ *
+ * @return A pointer to the new complex Array structure, or NULL on error.
+ */
+static Array* fft_along_axis(Array* arr, size_t axis, FftKind kind) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (axis >= arr->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return NULL;
+    }
+    int complex_input = arr->dtype == TYPE_COMPLEX_FLOAT || arr->dtype == TYPE_COMPLEX_DOUBLE;
+    if (arr->dtype == TYPE_BOOL || arr->dtype > TYPE_COMPLEX_DOUBLE || (kind == FFT_REAL && complex_input)) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    FftContext c = { 0 };
+    c.kind = kind;
+    c.in_dtype = arr->dtype;
+    c.out_dtype = arr->dtype == TYPE_FLOAT || arr->dtype == TYPE_COMPLEX_FLOAT ? TYPE_COMPLEX_FLOAT : TYPE_COMPLEX_DOUBLE;
+    c.input = arr->data;
+    c.n = arr->shape[axis];
+    c.n_out = kind == FFT_REAL ? c.n / 2 + 1 : c.n;
+    c.inner = 1;
+    for (size_t d = axis + 1; d < arr->ndim; d++) {
+        c.inner *= arr->shape[d];
+    }
+    // Odd-length real transforms fall back to a complex transform of the real input
+    c.plan = get_plan(c.n, kind == FFT_REAL && c.n % 2 == 0);
+    if (!c.plan) {
+        return NULL;
+    }
+
+    size_t shape[arr->ndim];
+    memcpy(shape, arr->shape, arr->ndim * sizeof(size_t));
+    shape[axis] = c.n_out;
+    Array* result = create_array(c.out_dtype, arr->ndim, shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    c.output = result->data;
+
+    // Each line costs about n log n butterflies; give every thread enough lines to amortize its start
+    size_t lines = arr->size / c.n;
+    size_t line_cost = c.n * 16;
+    size_t grain = line_cost < PARALLEL_GRAIN_BYTES ? PARALLEL_GRAIN_BYTES / line_cost : 1;
+    parallel_for(lines, grain, fft_lines, &c);
+
+    if (c.failed) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for FFT work space");
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Compute the discrete Fourier transform along an axis.
+ *
+ * @param arr The input array (int, float, double or complex).
+ * @param axis The axis to transform.
+ * @return A pointer to the new complex Array structure, or NULL on error.
+ */
+Array* fft(Array* arr, size_t axis) {
+    return fft_along_axis(arr, axis, FFT_FORWARD);
+}
+
+/**
+ * Compute the inverse discrete Fourier transform along an axis, scaled by 1 / n.
+ *
+ * @param arr The input array (int, float, double or complex).
+ * @param axis The axis to transform.
+ * @return A pointer to the new complex Array structure, or NULL on error.
+ */
+Array* ifft(Array* arr, size_t axis) {
+    return fft_along_axis(arr, axis, FFT_INVERSE);
+}
+
+/**
+ * Compute the discrete Fourier transform of real input along an axis,
+ * keeping the n / 2 + 1 non-negative frequencies.
+ *
+ * @param arr The input array (int, float or double).
+ * @param axis The axis to transform.
+ * @return A pointer to the new complex Array structure, or NULL on error.
+ */
+Array* rfft(Array* arr, size_t axis) {
+    return fft_along_axis(arr, axis, FFT_REAL);
+}
@@ -0,0 +1,711 @@
+#include "array.h"
+#include <stdint.h>
+#include <math.h>
+
+// Inputs with at least this many elements are counted with per-thread histograms
+#define HISTOGRAM_PARALLEL_MIN (1 << 16)
+
+// Number of bin indices computed together before they are counted
+#define BIN_BLOCK 256
+
+// unique() counts directly into a table indexed by value when the value range is at most this large
+#define UNIQUE_TABLE_MAX (1 << 24)
+
+// Reads element i of an array as a double
+static inline double load_as_double(const void* data, DataType dtype, size_t i) {
+    switch (dtype) {
+        case TYPE_INT: return ((const int*)data)[i];
+        case TYPE_FLOAT: return ((const float*)data)[i];
+        case TYPE_DOUBLE: return ((const double*)data)[i];
+        case TYPE_BOOL: return ((const unsigned char*)data)[i];
+        default: return 0;
+    }
+}
+
+
+// Per-thread private histograms
+//
+// Every chunk of the input is counted into its own histogram, so threads never
+// write to shared bins; the histograms are summed bin by bin at the end.
+
+// Counts elements [begin, end) into hist (size_t bins, or double bins when weighted)
+typedef void (*CountFunc)(size_t begin, size_t end, void* hist, void* ctx);
+
+typedef struct {
+    CountFunc count;
+    void* ctx;
+    size_t n;
+    size_t n_bins;
+    size_t n_chunks;
+    int weighted;
+    char* hists;       // n_chunks consecutive histograms
+} HistogramContext;
+
+static void count_chunks(size_t begin, size_t end, void* ctx) {
+    HistogramContext* h = ctx;
+    for (size_t c = begin; c < end; c++) {
+        h->count(h->n * c / h->n_chunks, h->n * (c + 1) / h->n_chunks,
+                 h->hists + c * h->n_bins * sizeof(size_t), h->ctx);
+    }
+}
+
+static void merge_bins(size_t begin, size_t end, void* ctx) {
+    HistogramContext* h = ctx;
+    for (size_t c = 1; c < h->n_chunks; c++) {
+        char* hist = h->hists + c * h->n_bins * sizeof(size_t);
+        if (h->weighted) {
+            double* total = (double*)h->hists;
+            const double* part = (const double*)hist;
+            for (size_t b = begin; b < end; b++) total[b] += part[b];
+        } else {
+            size_t* total = (size_t*)h->hists;
+            const size_t* part = (const size_t*)hist;
+            for (size_t b = begin; b < end; b++) total[b] += part[b];
+        }
+    }
+}
+
+/**
+ * Count n elements into n_bins bins.
+ *
+ * Private histograms are only used when the input is large and the bins are
+ * few enough that summing the histograms is cheap compared to counting.
+ *
+ * @return A calloc'd histogram of n_bins size_t (or double when weighted) bins, or NULL on error.
+ */
+static void* count_into_bins(size_t n, size_t n_bins, int weighted, CountFunc count, void* ctx) {
+    size_t n_chunks = get_num_threads();
+    if (n < HISTOGRAM_PARALLEL_MIN || n_bins * n_chunks > n) {
+        n_chunks = 1;
+    }
+
+    // size_t and double bins have the same size
+    HistogramContext h = { count, ctx, n, n_bins, n_chunks, weighted, calloc(n_chunks * n_bins, sizeof(size_t)) };
+    if (!h.hists) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for histogram");
+        return NULL;
+    }
+
+    parallel_for(n_chunks, 1, count_chunks, &h);
+    if (n_chunks > 1) {
+        parallel_for(n_bins, PARALLEL_GRAIN_BYTES / sizeof(size_t), merge_bins, &h);
+    }
+    return h.hists;
+}
+
+// Converts n_bins size_t counts into a new one-dimensional TYPE_INT array
+static Array* counts_to_array(const size_t* hist, size_t n_bins) {
+    size_t shape[1] = { n_bins };
+    Array* result = create_array(TYPE_INT, 1, shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    int* counts = result->data;
+    for (size_t b = 0; b < n_bins; b++) {
+        counts[b] = (int)hist[b];
+    }
+    return result;
+}
+
+
+// bincount
+
+typedef struct {
+    const int* values;
+    Array* weights;
+} BincountContext;
+
+static void count_values(size_t begin, size_t end, void* hist, void* ctx) {
+    BincountContext* b = ctx;
+    size_t* bins = hist;
+    for (size_t i = begin; i < end; i++) {
+        bins[b->values[i]]++;
+    }
+}
+
+static void sum_weights(size_t begin, size_t end, void* hist, void* ctx) {
+    BincountContext* b = ctx;
+    double* bins = hist;
+    for (size_t i = begin; i < end; i++) {
+        bins[b->values[i]] += load_as_double(b->weights->data, b->weights->dtype, i);
+    }
+}
+
+/**
+ * Count the occurrences of every non-negative integer value.
+ *
+ * @param arr TYPE_INT array of non-negative values, of any shape.
+ * @param weights Optional array of the same size; when given, bins sum the weights instead of counting.
+ * @param minlength Minimum number of bins.
+ * @return A one-dimensional TYPE_INT array of counts (TYPE_DOUBLE when weighted), or NULL on error.
+ */
+Array* bincount(Array* arr, Array* weights, size_t minlength) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (arr->dtype != TYPE_INT) {
+        log_error(ARRAY_ERROR_DTYPE, "bincount requires a TYPE_INT array");
+        return NULL;
+    }
+    if (weights && weights->size != arr->size) {
+        log_error(ARRAY_ERROR_SHAPE, "Weights must have the same size as the array");
+        return NULL;
+    }
+
+    // One sweep for the range; OR-reducing the sign keeps it vectorizable
+    const int* values = arr->data;
+    int max_value = 0;
+    unsigned int negative = 0;
+    for (size_t i = 0; i < arr->size; i++) {
+        max_value = values[i] > max_value ? values[i] : max_value;
+        negative |= (unsigned int)values[i] >> 31;
+    }
+    if (negative) {
+        log_error(ARRAY_ERROR_VALUE, "bincount requires non-negative values");
+        return NULL;
+    }
+
+    size_t n_bins = (size_t)max_value + 1;
+    if (n_bins < minlength) {
+        n_bins = minlength;
+    }
+
+    BincountContext ctx = { values, weights };
+    void* hist = count_into_bins(arr->size, n_bins, weights != NULL, weights ? sum_weights : count_values, &ctx);
+    if (!hist) {
+        return NULL;
+    }
+
+    Array* result;
+    if (weights) {
+        size_t shape[1] = { n_bins };
+        result = create_array(TYPE_DOUBLE, 1, shape, hist);
+    } else {
+        result = counts_to_array(hist, n_bins);
+    }
+    free(hist);
+    return result;
+}
+
+
+// histogram
+
+typedef struct {
+    Array* arr;
+    size_t n_bins;
+    double min;
+    double scale;          // n_bins / (max - min), for uniform bins
+    double max;
+    const double* edges;   // n_bins + 1 increasing edges, for explicit bins
+} BinContext;
+
+// Uniform bins: the bin of every element of a block is computed first in a
+// branch-free loop that the compiler vectorizes, then the block is counted.
+// Values outside [min, max] and NaNs go to the discard bin n_bins.
+#define DEFINE_UNIFORM_COUNT(name, type)                                               \
+    static void name(size_t begin, size_t end, void* hist, void* ctx) {                \
+        BinContext* b = ctx;                                                           \
+        size_t* bins = hist;                                                           \
+        const type* data = (const type*)b->arr->data;                                  \
+        const double min = b->min, max = b->max, scale = b->scale;                     \
+        const size_t last = b->n_bins - 1;                                             \
+        size_t idx[BIN_BLOCK];                                                         \
+        for (size_t start = begin; start < end; start += BIN_BLOCK) {                  \
+            size_t len = (end - start < BIN_BLOCK) ? end - start : BIN_BLOCK;          \
+            for (size_t i = 0; i < len; i++) {                                         \
+                double x = (double)data[start + i];                                    \
+                double pos = (x - min) * scale;                                        \
+                size_t bin = (pos < (double)last) ? (size_t)pos : last;                \
+                idx[i] = (x >= min && x <= max) ? bin : last + 1;                      \
+            }                                                                          \
+            for (size_t i = 0; i < len; i++) {                                         \
+                bins[idx[i]]++;                                                        \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_UNIFORM_COUNT(count_uniform_int, int)
+DEFINE_UNIFORM_COUNT(count_uniform_float, float)
+DEFINE_UNIFORM_COUNT(count_uniform_double, double)
+DEFINE_UNIFORM_COUNT(count_uniform_bool, unsigned char)
+
+// Explicit bins: branch-free binary search for the last edge <= x
+static void count_edges(size_t begin, size_t end, void* hist, void* ctx) {
+    BinContext* b = ctx;
+    size_t* bins = hist;
+    const double* edges = b->edges;
+    size_t n_edges = b->n_bins + 1;
+    for (size_t i = begin; i < end; i++) {
+        double x = load_as_double(b->arr->data, b->arr->dtype, i);
+        size_t lo = 0;
+        for (size_t len = n_edges; len > 1;) {
+            size_t half = len / 2;
+            lo = (x >= edges[lo + half]) ? lo + half : lo;
+            len -= half;
+        }
+        // The last bin includes its right edge
+        lo = (lo == b->n_bins) ? lo - 1 : lo;
+        bins[(x >= edges[0] && x <= edges[b->n_bins]) ? lo : b->n_bins]++;
+    }
+}
+
+static CountFunc uniform_counters[] = {
+    count_uniform_int, count_uniform_float, count_uniform_double, count_uniform_bool
+};
+
+/**
+ * Count the elements of an array in n_bins equal-width bins over [min, max].
+ *
+ * Elements outside the range are ignored and the last bin includes max. When
+ * min >= max the range of the data is used.
+ *
+ * @param arr The input array, of any shape.
+ * @param n_bins Number of bins.
+ * @param min Lower edge of the first bin.
+ * @param max Upper edge of the last bin.
+ * @param bin_edges Optional; receives a new TYPE_DOUBLE array of the n_bins + 1 edges.
+ * @return A one-dimensional TYPE_INT array of counts, or NULL on error.
+ */
+Array* histogram(Array* arr, size_t n_bins, double min, double max, Array** bin_edges) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (n_bins == 0) {
+        log_error(ARRAY_ERROR_VALUE, "Number of bins is 0");
+        return NULL;
+    }
+    if (arr->dtype < TYPE_INT || arr->dtype > TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    if (min >= max) {
+        min = max = load_as_double(arr->data, arr->dtype, 0);
+        for (size_t i = 1; i < arr->size; i++) {
+            double x = load_as_double(arr->data, arr->dtype, i);
+            min = x < min ? x : min;
+            max = x > max ? x : max;
+        }
+        if (min == max) {
+            min -= 0.5;
+            max += 0.5;
+        }
+    }
+
+    BinContext ctx = { arr, n_bins, min, (double)n_bins / (max - min), max, NULL };
+    size_t* hist = count_into_bins(arr->size, n_bins + 1, 0, uniform_counters[arr->dtype], &ctx);
+    if (!hist) {
+        return NULL;
+    }
+    Array* result = counts_to_array(hist, n_bins);
+    free(hist);
+    if (!result) {
+        return NULL;
+    }
+
+    if (bin_edges) {
+        size_t shape[1] = { n_bins + 1 };
+        *bin_edges = create_array(TYPE_DOUBLE, 1, shape, NULL);
+        if (!*bin_edges) {
+            free_array(result);
+            return NULL;
+        }
+        double* edges = (*bin_edges)->data;
+        for (size_t b = 0; b <= n_bins; b++) {
+            edges[b] = min + (max - min) * (double)b / (double)n_bins;
+        }
+    }
+    return result;
+}
+
+/**
+ * Count the elements of an array in bins given by explicit edges.
+ *
+ * @param arr The input array, of any shape.
+ * @param edges One-dimensional TYPE_DOUBLE array of at least two increasing edges.
+ * @return A one-dimensional TYPE_INT array of edges->size - 1 counts, or NULL on error.
+ */
+Array* histogram_edges(Array* arr, Array* edges) {
+    #if DEBUG_MODE
+        if (!arr || !edges) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (edges->dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Edges must be a TYPE_DOUBLE array");
+        return NULL;
+    }
+    if (edges->ndim != 1 || edges->size < 2) {
+        log_error(ARRAY_ERROR_SHAPE, "Edges must be one-dimensional with at least two entries");
+        return NULL;
+    }
+    const double* e = edges->data;
+    for (size_t i = 1; i < edges->size; i++) {
+        if (!(e[i] >= e[i - 1])) {
+            log_error(ARRAY_ERROR_VALUE, "Edges must be increasing");
+            return NULL;
+        }
+    }
+
+    size_t n_bins = edges->size - 1;
+    BinContext ctx = { arr, n_bins, e[0], 0, e[n_bins], e };
+    size_t* hist = count_into_bins(arr->size, n_bins + 1, 0, count_edges, &ctx);
+    if (!hist) {
+        return NULL;
+    }
+    Array* result = counts_to_array(hist, n_bins);
+    free(hist);
+    return result;
+}
+
+
+// unique
+
+typedef struct {
+    const int* values;
+    int min;
+} TableContext;
+
+static void count_table(size_t begin, size_t end, void* hist, void* ctx) {
+    TableContext* t = ctx;
+    size_t* bins = hist;
+    for (size_t i = begin; i < end; i++) {
+        bins[(size_t)((long long)t->values[i] - t->min)]++;
+    }
+}
+
+// Writes the outputs of unique() for integers from a table of counts per value
+static int unique_from_table(Array* arr, int min, const size_t* table, size_t range,
+                             Array** values, Array** counts, Array** inverse) {
+    int* rank = malloc(range * sizeof(int));
+    if (!rank) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for unique ranks");
+        return 0;
+    }
+    size_t n_unique = 0;
+    for (size_t v = 0; v < range; v++) {
+        rank[v] = (int)n_unique;
+        n_unique += table[v] != 0;
+    }
+
+    size_t shape[1] = { n_unique };
+    *values = create_array(arr->dtype, 1, shape, NULL);
+    if (counts) {
+        *counts = create_array(TYPE_INT, 1, shape, NULL);
+    }
+    if (inverse) {
+        *inverse = create_array(TYPE_INT, arr->ndim, arr->shape, NULL);
+    }
+    if (!*values || (counts && !*counts) || (inverse && !*inverse)) {
+        free(rank);
+        return 0;
+    }
+
+    for (size_t v = 0; v < range; v++) {
+        if (table[v] == 0) {
+            continue;
+        }
+        size_t u = rank[v];
+        if (arr->dtype == TYPE_BOOL) {
+            ((unsigned char*)(*values)->data)[u] = (unsigned char)(v + min);
+        } else {
+            ((int*)(*values)->data)[u] = (int)((long long)v + min);
+        }
+        if (counts) {
+            ((int*)(*counts)->data)[u] = (int)table[v];
+        }
+    }
+    if (inverse) {
+        int* inv = (*inverse)->data;
+        for (size_t i = 0; i < arr->size; i++) {
+            long long x = (long long)load_as_double(arr->data, arr->dtype, i);
+            inv[i] = rank[x - min];
+        }
+    }
+    free(rank);
+    return 1;
+}
+
+/**
+ * Open-addressing hash set over element bit patterns.
+ *
+ * Used by unique() when the values are not small integers. Every element is
+ * looked up once; its slot id (order of first appearance) is recorded so the
+ * inverse can be built without a second lookup.
+ */
+typedef struct {
+    uint64_t* keys;
+    uint32_t* ids;       // UINT32_MAX marks an empty slot
+    size_t capacity;     // Power of two
+    size_t count;
+} UniqueSet;
+
+static inline uint64_t hash_bits(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static int unique_set_init(UniqueSet* set, size_t capacity) {
+    set->capacity = capacity;
+    set->count = 0;
+    set->keys = malloc(capacity * sizeof(uint64_t));
+    set->ids = malloc(capacity * sizeof(uint32_t));
+    if (!set->keys || !set->ids) {
+        free(set->keys);
+        free(set->ids);
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for unique hash set");
+        return 0;
+    }
+    memset(set->ids, 0xff, capacity * sizeof(uint32_t));
+    return 1;
+}
+
+static inline size_t unique_set_find(const UniqueSet* set, uint64_t key) {
+    size_t mask = set->capacity - 1;
+    size_t slot = hash_bits(key) & mask;
+    while (set->ids[slot] != UINT32_MAX && set->keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int unique_set_grow(UniqueSet* set) {
+    UniqueSet bigger;
+    if (!unique_set_init(&bigger, set->capacity * 2)) {
+        return 0;
+    }
+    for (size_t s = 0; s < set->capacity; s++) {
+        if (set->ids[s] != UINT32_MAX) {
+            size_t slot = unique_set_find(&bigger, set->keys[s]);
+            bigger.keys[slot] = set->keys[s];
+            bigger.ids[slot] = set->ids[s];
+        }
+    }
+    bigger.count = set->count;
+    free(set->keys);
+    free(set->ids);
+    *set = bigger;
+    return 1;
+}
+
+// Bit pattern of an element, with -0.0 folded into 0.0 and every NaN into one NaN
+static inline uint64_t element_bits(const void* data, DataType dtype, size_t i) {
+    uint64_t bits = 0;
+    switch (dtype) {
+        case TYPE_FLOAT: {
+            float x = ((const float*)data)[i];
+            x = (x == 0.0f) ? 0.0f : (x != x) ? NAN : x;
+            memcpy(&bits, &x, sizeof(x));
+            break;
+        }
+        case TYPE_DOUBLE: {
+            double x = ((const double*)data)[i];
+            x = (x == 0.0) ? 0.0 : (x != x) ? NAN : x;
+            memcpy(&bits, &x, sizeof(x));
+            break;
+        }
+        default:
+            memcpy(&bits, (const char*)data + i * get_dtype_size(dtype), get_dtype_size(dtype));
+            break;
+    }
+    return bits;
+}
+
+static int unique_by_hash(Array* arr, Array** values, Array** counts, Array** inverse) {
+    size_t dtype_size = get_dtype_size(arr->dtype);
+    UniqueSet set;
+    uint32_t* first_ids = malloc(arr->size * sizeof(uint32_t));
+    size_t count_capacity = 1024;
+    size_t* id_counts = calloc(count_capacity, sizeof(size_t));
+    char* id_values = malloc(count_capacity * dtype_size);
+    if (!first_ids || !id_counts || !id_values || !unique_set_init(&set, 1024)) {
+        free(first_ids);
+        free(id_counts);
+        free(id_values);
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for unique");
+        return 0;
+    }
+
+    int ok = 1;
+    for (size_t i = 0; i < arr->size; i++) {
+        uint64_t key = element_bits(arr->data, arr->dtype, i);
+        size_t slot = unique_set_find(&set, key);
+        uint32_t id = set.ids[slot];
+        if (id == UINT32_MAX) {
+            if (set.count == count_capacity) {
+                count_capacity *= 2;
+                size_t* grown_counts = realloc(id_counts, count_capacity * sizeof(size_t));
+                if (grown_counts) {
+                    id_counts = grown_counts;
+                    memset(id_counts + set.count, 0, (count_capacity - set.count) * sizeof(size_t));
+                }
+                char* grown_values = realloc(id_values, count_capacity * dtype_size);
+                if (grown_values) {
+                    id_values = grown_values;
+                }
+                if (!grown_counts || !grown_values) {
+                    log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for unique");
+                    ok = 0;
+                    break;
+                }
+            }
+            id = (uint32_t)set.count++;
+            set.keys[slot] = key;
+            set.ids[slot] = id;
+            memcpy(id_values + id * dtype_size, &key, dtype_size);
+            if (2 * set.count > set.capacity && !unique_set_grow(&set)) {
+                ok = 0;
+                break;
+            }
+        }
+        first_ids[i] = id;
+        id_counts[id]++;
+    }
+    free(set.keys);
+    free(set.ids);
+
+    // The set holds only the distinct values, so sorting them is cheap
+    Array* distinct = NULL;
+    Array* order = NULL;
+    if (ok) {
+        size_t shape[1] = { set.count };
+        distinct = create_array(arr->dtype, 1, shape, id_values);
+        order = distinct ? argsort(distinct, 0) : NULL;
+        ok = order != NULL;
+    }
+    if (ok) {
+        *values = gather(distinct, order, 0);
+        if (counts) {
+            *counts = create_array(TYPE_INT, 1, distinct->shape, NULL);
+        }
+        if (inverse) {
+            *inverse = create_array(TYPE_INT, arr->ndim, arr->shape, NULL);
+        }
+        ok = *values && (!counts || *counts) && (!inverse || *inverse);
+    }
+    if (ok) {
+        const int* perm = order->data;
+        int* ranks = malloc(set.count * sizeof(int));
+        if (!ranks) {
+            log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for unique ranks");
+            ok = 0;
+        } else {
+            for (size_t u = 0; u < set.count; u++) {
+                ranks[perm[u]] = (int)u;
+                if (counts) {
+                    ((int*)(*counts)->data)[u] = (int)id_counts[perm[u]];
+                }
+            }
+            if (inverse) {
+                int* inv = (*inverse)->data;
+                for (size_t i = 0; i < arr->size; i++) {
+                    inv[i] = ranks[first_ids[i]];
+                }
+            }
+            free(ranks);
+        }
+    }
+
+    free_array(distinct);
+    free_array(order);
+    free(first_ids);
+    free(id_counts);
+    free(id_values);
+    return ok;
+}
+
+/**
+ * Find the sorted distinct values of an array.
+ *
+ * Integers whose value range is small are counted directly into a table
+ * indexed by value (with per-thread tables for large inputs), which yields the
+ * values already sorted. Other inputs go through a hash set, and only the
+ * distinct values are sorted afterwards.
+ *
+ * @param arr The input array, of any shape.
+ * @param values Receives a new one-dimensional array of the sorted distinct values.
+ * @param counts Optional; receives a new TYPE_INT array with the number of occurrences of each value.
+ * @param inverse Optional; receives a new TYPE_INT array of arr's shape with the position of each element in values.
+ * @return 1 on success, 0 on error.
+ */
+int unique(Array* arr, Array** values, Array** counts, Array** inverse) {
+    #if DEBUG_MODE
+        if (!arr || !values) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return 0;
+        }
+    #endif
+
+    if (arr->dtype < TYPE_INT || arr->dtype > TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return 0;
+    }
+
+    *values = NULL;
+    if (counts) *counts = NULL;
+    if (inverse) *inverse = NULL;
+
+    int ok = 0;
+    int handled = 0;
+    if (arr->dtype == TYPE_INT || arr->dtype == TYPE_BOOL) {
+        int min = (int)load_as_double(arr->data, arr->dtype, 0), max = min;
+        if (arr->dtype == TYPE_INT) {
+            const int* data = arr->data;
+            for (size_t i = 1; i < arr->size; i++) {
+                min = data[i] < min ? data[i] : min;
+                max = data[i] > max ? data[i] : max;
+            }
+        } else {
+            min = 0;
+            max = UINT8_MAX;
+        }
+        size_t range = (size_t)((long long)max - min) + 1;
+        if (range <= UNIQUE_TABLE_MAX && (range <= 2 * arr->size || range <= (1 << 16))) {
+            size_t* table;
+            if (arr->dtype == TYPE_INT) {
+                TableContext ctx = { arr->data, min };
+                table = count_into_bins(arr->size, range, 0, count_table, &ctx);
+            } else {
+                table = calloc(range, sizeof(size_t));
+                if (table) {
+                    const unsigned char* data = arr->data;
+                    for (size_t i = 0; i < arr->size; i++) table[data[i]]++;
+                }
+            }
+            ok = table && unique_from_table(arr, min, table, range, values, counts, inverse);
+            free(table);
+            handled = 1;
+        }
+    }
+    if (!handled) {
+        ok = unique_by_hash(arr, values, counts, inverse);
+    }
+
+    if (!ok) {
+        free_array(*values);
+        *values = NULL;
+        if (counts) {
+            free_array(*counts);
+            *counts = NULL;
+        }
+        if (inverse) {
+            free_array(*inverse);
+            *inverse = NULL;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,426 @@
+#include "array.h"
+#include <stdint.h>
+
+// How many rows ahead random accesses are prefetched
+#define PREFETCH_DISTANCE 16
+
+#if defined(__GNUC__)
+    #define PREFETCH_READ(addr) __builtin_prefetch((addr), 0)
+    #define PREFETCH_WRITE(addr) __builtin_prefetch((addr), 1)
+#else
+    #define PREFETCH_READ(addr) ((void)(addr))
+    #define PREFETCH_WRITE(addr) ((void)(addr))
+#endif
+
+/**
+ * Check that every index lies in [0, dim) in one branch-free sweep.
+ *
+ * The comparisons are OR-reduced instead of returning early, which lets the
+ * compiler vectorize the loop. Negative indices wrap to large unsigned values
+ * and are rejected by the same comparison.
+ *
+ * @param indices The indices to check.
+ * @param n Number of indices.
+ * @param dim Size of the indexed dimension.
+ * @return 1 if all indices are in bounds, 0 otherwise.
+ */
+static int indices_in_bounds(const int* indices, size_t n, size_t dim) {
+    unsigned int bad = 0;
+    if (dim > UINT32_MAX) {
+        for (size_t i = 0; i < n; i++) {
+            bad |= indices[i] < 0;
+        }
+    } else {
+        unsigned int limit = (unsigned int)dim;
+        for (size_t i = 0; i < n; i++) {
+            bad |= (unsigned int)indices[i] >= limit;
+        }
+    }
+    return bad == 0;
+}
+
+/**
+ * Check a batch of multi-indices against the shape of an array.
+ *
+ * @param arr The indexed array.
+ * @param indices n rows of arr->ndim indices, row-major.
+ * @param n Number of multi-indices.
+ * @return 1 if all indices are in bounds, 0 otherwise.
+ */
+static int multi_indices_in_bounds(Array* arr, const size_t* indices, size_t n) {
+    size_t ndim = arr->ndim;
+    size_t bad = 0;
+    for (size_t d = 0; d < ndim; d++) {
+        size_t dim = arr->shape[d];
+        for (size_t i = 0; i < n; i++) {
+            bad |= indices[i * ndim + d] >= dim;
+        }
+    }
+    return bad == 0;
+}
+
+/**
+ * Split an array into (outer, axis, inner) around an axis.
+ *
+ * @param arr The array.
+ * @param axis The axis.
+ * @param outer Receives the product of the dimensions before the axis.
+ * @param inner_bytes Receives the bytes of one slice below the axis.
+ */
+static void split_at_axis(Array* arr, size_t axis, size_t* outer, size_t* inner_bytes) {
+    *outer = 1;
+    for (size_t i = 0; i < axis; i++) {
+        *outer *= arr->shape[i];
+    }
+    *inner_bytes = get_dtype_size(arr->dtype);
+    for (size_t i = axis + 1; i < arr->ndim; i++) {
+        *inner_bytes *= arr->shape[i];
+    }
+}
+
+/**
+ * Compute the shape of a gather result, arr.shape[:axis] + indices.shape + arr.shape[axis+1:].
+ *
+ * @param arr The indexed array.
+ * @param indices The index array.
+ * @param axis The indexed axis.
+ * @param out_shape Buffer of arr->ndim - 1 + indices->ndim entries.
+ * @return Number of dimensions of the result.
+ */
+static size_t gathered_shape(Array* arr, Array* indices, size_t axis, size_t* out_shape) {
+    size_t ndim = 0;
+    for (size_t i = 0; i < axis; i++) {
+        out_shape[ndim++] = arr->shape[i];
+    }
+    for (size_t i = 0; i < indices->ndim; i++) {
+        out_shape[ndim++] = indices->shape[i];
+    }
+    for (size_t i = axis + 1; i < arr->ndim; i++) {
+        out_shape[ndim++] = arr->shape[i];
+    }
+    return ndim;
+}
+
+static int validate_index_array(Array* arr, Array* indices, size_t axis) {
+    #if DEBUG_MODE
+        if (!arr || !indices) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return 0;
+        }
+    #endif
+
+    if (axis >= arr->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return 0;
+    }
+    if (indices->dtype != TYPE_INT) {
+        log_error(ARRAY_ERROR_DTYPE, "Index array must be of type TYPE_INT");
+        return 0;
+    }
+    if (!indices_in_bounds(indices->data, indices->size, arr->shape[axis])) {
+        log_error(ARRAY_ERROR_INDEX, "Index out of bounds");
+        return 0;
+    }
+    return 1;
+}
+
+
+// Gathering
+
+typedef struct {
+    char* out;
+    const char* in;
+    const int* indices;
+    size_t n_indices;
+    size_t axis_dim;
+    size_t inner_bytes;
+} GatherContext;
+
+// Element-sized gathers copy with a typed load so the compiler does not emit a memcpy call
+#define DEFINE_GATHER_ROWS(name, type)                                                 \
+    static void name(size_t begin, size_t end, void* ctx) {                            \
+        GatherContext* g = ctx;                                                        \
+        type* out = (type*)g->out;                                                     \
+        const type* in = (const type*)g->in;                                           \
+        for (size_t r = begin; r < end; r++) {                                         \
+            size_t o = r / g->n_indices;                                               \
+            size_t i = r - o * g->n_indices;                                           \
+            if (i + PREFETCH_DISTANCE < g->n_indices) {                                \
+                PREFETCH_READ(in + o * g->axis_dim + g->indices[i + PREFETCH_DISTANCE]); \
+            }                                                                          \
+            out[r] = in[o * g->axis_dim + g->indices[i]];                              \
+        }                                                                              \
+    }
+
+DEFINE_GATHER_ROWS(gather_rows_8, uint8_t)
+DEFINE_GATHER_ROWS(gather_rows_32, uint32_t)
+DEFINE_GATHER_ROWS(gather_rows_64, uint64_t)
+
+static void gather_rows(size_t begin, size_t end, void* ctx) {
+    GatherContext* g = ctx;
+    for (size_t r = begin; r < end; r++) {
+        size_t o = r / g->n_indices;
+        size_t i = r - o * g->n_indices;
+        const char* base = g->in + o * g->axis_dim * g->inner_bytes;
+        if (i + PREFETCH_DISTANCE < g->n_indices) {
+            PREFETCH_READ(base + g->indices[i + PREFETCH_DISTANCE] * g->inner_bytes);
+        }
+        memcpy(g->out + r * g->inner_bytes, base + g->indices[i] * g->inner_bytes, g->inner_bytes);
+    }
+}
+
+/**
+ * Take slices of an array along an axis at the positions in an index array.
+ *
+ * All indices are bounds-checked up front in one sweep, after which each
+ * selected slice below the axis is copied as one contiguous run. Slices that
+ * are a single element use typed loads, and the source of upcoming rows is
+ * prefetched to hide the latency of random access.
+ *
+ * @param arr The array to gather from.
+ * @param indices TYPE_INT array of positions along axis.
+ * @param axis The axis to index.
+ * @return A new array of shape arr.shape[:axis] + indices.shape + arr.shape[axis+1:], or NULL on error.
+ */
+Array* gather(Array* arr, Array* indices, size_t axis) {
+    if (!validate_index_array(arr, indices, axis)) {
+        return NULL;
+    }
+
+    size_t out_shape[arr->ndim - 1 + indices->ndim];
+    size_t out_ndim = gathered_shape(arr, indices, axis, out_shape);
+    Array* result = create_array(arr->dtype, out_ndim, out_shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    size_t outer, inner_bytes;
+    split_at_axis(arr, axis, &outer, &inner_bytes);
+
+    GatherContext ctx = { result->data, arr->data, indices->data, indices->size, arr->shape[axis], inner_bytes };
+    ParallelFunc rows = gather_rows;
+    if (inner_bytes == get_dtype_size(arr->dtype)) {
+        switch (inner_bytes) {
+            case 1: rows = gather_rows_8; break;
+            case 4: rows = gather_rows_32; break;
+            case 8: rows = gather_rows_64; break;
+        }
+    }
+
+    size_t grain = PARALLEL_GRAIN_BYTES / inner_bytes + 1;
+    parallel_for(outer * indices->size, grain, rows, &ctx);
+    return result;
+}
+
+
+// Scattering
+
+/**
+ * Write slices into an array along an axis at the positions in an index array.
+ *
+ * With operation '=' the slices are assigned (later duplicates win); with '+'
+ * they are added to the existing values, so duplicate indices accumulate.
+ * Accumulation reuses the strided operation loops of the broadcasting engine.
+ * Nothing is written if any index is out of bounds.
+ *
+ * @param arr The array to write into.
+ * @param indices TYPE_INT array of positions along axis.
+ * @param values Array of shape arr.shape[:axis] + indices.shape + arr.shape[axis+1:] and the dtype of arr.
+ * @param axis The axis to index.
+ * @param operation_symbol '=' to assign or '+' to accumulate.
+ * @return 1 on success, 0 on error.
+ */
+int scatter(Array* arr, Array* indices, Array* values, size_t axis, char operation_symbol) {
+    if (!validate_index_array(arr, indices, axis)) {
+        return 0;
+    }
+    #if DEBUG_MODE
+        if (!values) {
+            log_error(ARRAY_ERROR_NULL, "Values array is NULL");
+            return 0;
+        }
+    #endif
+
+    if (values->dtype != arr->dtype) {
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+        return 0;
+    }
+    size_t expected_shape[arr->ndim - 1 + indices->ndim];
+    size_t expected_ndim = gathered_shape(arr, indices, axis, expected_shape);
+    if (!are_shapes_equal(values->shape, values->ndim, expected_shape, expected_ndim)) {
+        log_error(ARRAY_ERROR_SHAPE, "Values shape does not match the indexed shape");
+        return 0;
+    }
+
+    StridedLoopFunc accumulate = NULL;
+    if (operation_symbol == '+') {
+        accumulate = get_operation_loop('+', arr->dtype);
+        if (!accumulate) {
+            return 0;
+        }
+    } else if (operation_symbol != '=') {
+        log_error(ARRAY_ERROR_VALUE, "Invalid scatter operation");
+        return 0;
+    }
+
+    if (!make_array_writable(arr)) {
+        return 0;
+    }
+
+    size_t outer, inner_bytes;
+    split_at_axis(arr, axis, &outer, &inner_bytes);
+    size_t dtype_size = get_dtype_size(arr->dtype);
+    size_t inner = inner_bytes / dtype_size;
+    size_t strides[2] = { dtype_size, dtype_size };
+
+    const int* idx = indices->data;
+    size_t n_indices = indices->size;
+    const char* src = values->data;
+
+    // Duplicate indices make the order of writes significant, so this runs on one thread
+    for (size_t o = 0; o < outer; o++) {
+        char* base = (char*)arr->data + o * arr->shape[axis] * inner_bytes;
+        for (size_t i = 0; i < n_indices; i++, src += inner_bytes) {
+            if (i + PREFETCH_DISTANCE < n_indices) {
+                PREFETCH_WRITE(base + idx[i + PREFETCH_DISTANCE] * inner_bytes);
+            }
+            char* dst = base + idx[i] * inner_bytes;
+            if (accumulate) {
+                char* in[2] = { dst, (char*)src };
+                accumulate(dst, in, strides, inner);
+            } else {
+                memcpy(dst, src, inner_bytes);
+            }
+        }
+    }
+    return 1;
+}
+
+
+// Batched element access
+//
+// Multi-indices are processed in blocks: the linear offsets of a block are computed
+// first, then the elements are moved while the offsets a few positions ahead are
+// prefetched.
+
+#define OFFSET_BLOCK 256
+
+static void block_offsets(const size_t* strides, size_t ndim, const size_t* indices,
+                          size_t n, size_t* offsets) {
+    for (size_t i = 0; i < n; i++) {
+        const size_t* index = indices + i * ndim;
+        size_t offset = 0;
+        for (size_t d = 0; d < ndim; d++) {
+            offset += index[d] * strides[d];
+        }
+        offsets[i] = offset;
+    }
+}
+
+#define DEFINE_MOVE_ELEMENTS(name, type)                                               \
+    static void name(char* data, char* buffer, const size_t* offsets, size_t n,        \
+                     int write) {                                                      \
+        type* elems = (type*)data;                                                     \
+        type* values = (type*)buffer;                                                  \
+        for (size_t i = 0; i < n; i++) {                                               \
+            if (i + PREFETCH_DISTANCE < n) {                                           \
+                PREFETCH_WRITE(elems + offsets[i + PREFETCH_DISTANCE]);                \
+            }                                                                          \
+            if (write) {                                                               \
+                elems[offsets[i]] = values[i];                                         \
+            } else {                                                                   \
+                values[i] = elems[offsets[i]];                                         \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_MOVE_ELEMENTS(move_elements_8, uint8_t)
+DEFINE_MOVE_ELEMENTS(move_elements_32, uint32_t)
+DEFINE_MOVE_ELEMENTS(move_elements_64, uint64_t)
+
+/**
+ * Move a batch of elements between an array and a buffer.
+ *
+ * @param arr The indexed array.
+ * @param indices n rows of arr->ndim indices, row-major.
+ * @param n Number of elements.
+ * @param buffer Buffer of n elements.
+ * @param write 1 to store the buffer into the array, 0 to load it from the array.
+ * @return 1 on success, 0 on error.
+ */
+static int move_elements(Array* arr, size_t* indices, size_t n, void* buffer, int write) {
+    #if DEBUG_MODE
+        if (!arr || !indices || !buffer) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return 0;
+        }
+    #endif
+
+    if (!multi_indices_in_bounds(arr, indices, n)) {
+        log_error(ARRAY_ERROR_INDEX, "Index out of bounds");
+        return 0;
+    }
+
+    void (*move)(char*, char*, const size_t*, size_t, int);
+    size_t dtype_size = get_dtype_size(arr->dtype);
+    switch (dtype_size) {
+        case 1: move = move_elements_8; break;
+        case 4: move = move_elements_32; break;
+        case 8: move = move_elements_64; break;
+        default:
+            log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+            return 0;
+    }
+
+    if (write && !make_array_writable(arr)) {
+        return 0;
+    }
+
+    size_t* strides = calculate_strides(arr->shape, arr->ndim);
+    if (!strides) {
+        return 0;
+    }
+
+    size_t offsets[OFFSET_BLOCK];
+    for (size_t start = 0; start < n; start += OFFSET_BLOCK) {
+        size_t len = (n - start < OFFSET_BLOCK) ? n - start : OFFSET_BLOCK;
+        block_offsets(strides, arr->ndim, indices + start * arr->ndim, len, offsets);
+        move(arr->data, (char*)buffer + start * dtype_size, offsets, len, write);
+    }
+
+    free(strides);
+    return 1;
+}
+
+/**
+ * Read a batch of elements given as multi-indices.
+ *
+ * The strides are computed once and all indices are bounds-checked in a
+ * single sweep before any element is read, replacing one validate_indices and
+ * calculate_offset pass per element.
+ *
+ * @param arr The array to read from.
+ * @param indices n rows of arr->ndim indices, row-major.
+ * @param n Number of elements to read.
+ * @param out Buffer of n elements receiving the values.
+ * @return 1 on success, 0 if any index is out of bounds.
+ */
+int get_elements(Array* arr, size_t* indices, size_t n, void* out) {
+    return move_elements(arr, indices, n, out, 0);
+}
+
+/**
+ * Write a batch of elements given as multi-indices.
+ *
+ * All indices are checked before anything is written, so a failed call leaves
+ * the array unchanged.
+ *
+ * @param arr The array to write into.
+ * @param indices n rows of arr->ndim indices, row-major.
+ * @param n Number of elements to write.
+ * @param values Buffer of n elements to store.
+ * @return 1 on success, 0 if any index is out of bounds.
+ */
+int set_elements(Array* arr, size_t* indices, size_t n, void* values) {
+    return move_elements(arr, indices, n, values, 1);
+}
@@ -0,0 +1,995 @@
+#include "array.h"
+#include <math.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Input bytes parsed by one task of array_from_csv
+#define CSV_PIECE_BYTES (1 << 20)
+
+// Elements formatted by one task of array_to_csv, and tasks formatted before writing
+#define CSV_PIECE_ELEMENTS (1 << 15)
+#define CSV_PIECES_PER_THREAD 4
+
+// Longest field handed to strtod or strtof when a number does not take the exact fast path
+#define CSV_FIELD_MAX 128
+
+// Bytes buffered by print_array before writing
+#define PRINT_BUFFER_BYTES (1 << 16)
+
+// Powers of ten that are exact doubles
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+
+// Number formatting
+
+// Writes the digits of v backwards from end; returns the start of the digits
+static char* format_digits(char* end, uint64_t v) {
+    do {
+        *--end = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    return end;
+}
+
+static size_t format_int(char* buf, int64_t v) {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* start = format_digits(end, v < 0 ? 0 - (uint64_t)v : (uint64_t)v);
+    size_t len = 0;
+    if (v < 0) {
+        buf[len++] = '-';
+    }
+    memcpy(buf + len, start, end - start);
+    return len + (end - start);
+}
+
+// Shortest round-trip formatting (Ryu, Adams 2018)
+//
+// A value m * 2^e2 is multiplied by a 128-bit fixed-point power of five, which
+// gives the scaled value and the two ends of its rounding interval as 64-bit
+// integers in a common power of ten. Digits are then removed while the ends
+// still differ, which leaves the fewest digits that read back, rounded
+// correctly. The tables are exact and computed once with big integers.
+
+#define POW5_INV_BITCOUNT 125
+#define POW5_BITCOUNT 125
+#define POW5_INV_ENTRIES 342   // Largest q for doubles is 341
+#define POW5_ENTRIES 326       // Largest i for doubles is 325
+
+// Big integers of the table computation: 2^POW5_BIG_SHIFT is above every 2^j / 5^q used
+#define POW5_BIG_SHIFT 1024
+#define POW5_BIG_WORDS (POW5_BIG_SHIFT / 32 + 1)
+
+// pow5_split[i] holds the top POW5_BITCOUNT bits of 5^i and pow5_inv_split[q] holds
+// floor(2^j / 5^q) + 1 with POW5_INV_BITCOUNT bits, low word first
+static uint64_t pow5_split[POW5_ENTRIES][2];
+static uint64_t pow5_inv_split[POW5_INV_ENTRIES][2];
+static pthread_once_t pow5_tables_once = PTHREAD_ONCE_INIT;
+
+// Number of bits of 5^e (1 for e = 0), valid for e up to 3528
+static inline int pow5_bits(int e) {
+    return (int)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+// floor(e * log10(2)) and floor(e * log10(5)), valid for e up to 1650 and 2620
+static inline uint32_t log10_pow2(int e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+static inline uint32_t log10_pow5(int e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+// Bits [shift, shift + 128) of a little-endian big integer, zero outside it
+static void big_extract(const uint32_t* x, int shift, uint64_t out[2]) {
+    out[0] = out[1] = 0;
+    for (int b = 0; b < 128; b++) {
+        int bit = shift + b;
+        if (bit >= 0 && bit < POW5_BIG_WORDS * 32 && (x[bit / 32] >> (bit % 32)) & 1) {
+            out[b / 64] |= 1ull << (b % 64);
+        }
+    }
+}
+
+static int big_bit_length(const uint32_t* x) {
+    for (int w = POW5_BIG_WORDS - 1; w >= 0; w--) {
+        if (x[w]) {
+            return w * 32 + 32 - __builtin_clz(x[w]);
+        }
+    }
+    return 0;
+}
+
+// 5^i by repeated multiplication, and floor(2^N / 5^q) by repeated division by 5,
+// since floor(floor(x / a) / b) = floor(x / (a * b))
+static void compute_pow5_tables(void) {
+    uint32_t pow5[POW5_BIG_WORDS] = { 1 };
+    uint32_t inv[POW5_BIG_WORDS] = { 0 };
+    inv[POW5_BIG_SHIFT / 32] = 1u << (POW5_BIG_SHIFT % 32);
+    for (int q = 0; q < POW5_INV_ENTRIES; q++) {
+        if (q > 0) {
+            uint64_t carry = 0;
+            for (int w = 0; w < POW5_BIG_WORDS; w++) {
+                carry += (uint64_t)pow5[w] * 5;
+                pow5[w] = (uint32_t)carry;
+                carry >>= 32;
+            }
+            uint64_t rem = 0;
+            for (int w = POW5_BIG_WORDS - 1; w >= 0; w--) {
+                rem = rem << 32 | inv[w];
+                inv[w] = (uint32_t)(rem / 5);
+                rem %= 5;
+            }
+        }
+        int bits = big_bit_length(pow5);
+        if (q < POW5_ENTRIES) {
+            big_extract(pow5, bits - POW5_BITCOUNT, pow5_split[q]);
+        }
+        // floor(2^j / 5^q) with j = bits - 1 + POW5_INV_BITCOUNT, plus one
+        big_extract(inv, POW5_BIG_SHIFT - (bits - 1 + POW5_INV_BITCOUNT), pow5_inv_split[q]);
+        if (++pow5_inv_split[q][0] == 0) {
+            pow5_inv_split[q][1]++;
+        }
+    }
+}
+
+// (m * mul) >> j for a 128-bit mul and j >= 64
+static inline uint64_t mul_shift(uint64_t m, const uint64_t mul[2], int j) {
+    unsigned __int128 low = (unsigned __int128)m * mul[0];
+    unsigned __int128 high = (unsigned __int128)m * mul[1];
+    return (uint64_t)(((low >> 64) + high) >> (j - 64));
+}
+
+static inline int pow5_factor(uint64_t v) {
+    int count = 0;
+    while (v % 5 == 0) {
+        v /= 5;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Find the shortest decimal that reads back to a binary floating point value.
+ *
+ * @param mantissa The stored mantissa bits.
+ * @param exponent The stored (biased) exponent bits, not all ones.
+ * @param mantissa_bits 52 for doubles, 23 for floats.
+ * @param bias 1023 for doubles, 127 for floats.
+ * @param digits Receives the decimal digits as an integer.
+ * @return The power of ten of the last digit.
+ */
+static int shortest_decimal(uint64_t mantissa, uint32_t exponent, int mantissa_bits, int bias,
+                            uint64_t* digits) {
+    pthread_once(&pow5_tables_once, compute_pow5_tables);
+
+    int e2;
+    uint64_t m2;
+    if (exponent == 0) {
+        e2 = 1 - bias - mantissa_bits - 2;
+        m2 = mantissa;
+    } else {
+        e2 = (int)exponent - bias - mantissa_bits - 2;
+        m2 = (1ull << mantissa_bits) | mantissa;
+    }
+    // Halfway cases round to even, so an even mantissa owns the ends of its interval
+    int accept_bounds = (m2 & 1) == 0;
+
+    // The interval around the value v = mv * 2^e2 is [mm, mp] in the same scale
+    uint64_t mv = 4 * m2;
+    uint32_t mm_shift = mantissa != 0 || exponent <= 1;
+    uint64_t vr, vp, vm;
+    int e10;
+    int vm_trailing_zeros = 0, vr_trailing_zeros = 0;
+    if (e2 >= 0) {
+        uint32_t q = log10_pow2(e2) - (e2 > 3);
+        e10 = (int)q;
+        int j = -e2 + (int)q + POW5_INV_BITCOUNT + pow5_bits(q) - 1;
+        vr = mul_shift(4 * m2, pow5_inv_split[q], j);
+        vp = mul_shift(4 * m2 + 2, pow5_inv_split[q], j);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, pow5_inv_split[q], j);
+        if (q <= 21) {
+            // Only one of mp, mv and mm can be a multiple of 5
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = pow5_factor(mv) >= (int)q;
+            } else if (accept_bounds) {
+                vm_trailing_zeros = pow5_factor(mv - 1 - mm_shift) >= (int)q;
+            } else {
+                vp -= pow5_factor(mv + 2) >= (int)q;
+            }
+        }
+    } else {
+        uint32_t q = log10_pow5(-e2) - (-e2 > 1);
+        e10 = (int)q + e2;
+        int i = -e2 - (int)q;
+        int j = (int)q - (pow5_bits(i) - POW5_BITCOUNT);
+        vr = mul_shift(4 * m2, pow5_split[i], j);
+        vp = mul_shift(4 * m2 + 2, pow5_split[i], j);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, pow5_split[i], j);
+        if (q <= 1) {
+            // mv has at least q trailing zero bits, and so do mm and mp
+            vr_trailing_zeros = 1;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vr_trailing_zeros = (mv & ((1ull << q) - 1)) == 0;
+        }
+    }
+
+    int removed = 0;
+    uint64_t output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        // Rare: the exact ends or the value itself end in zeros
+        int last_removed = 0;
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = (int)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = (int)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+            // Exactly halfway: round to even
+            last_removed = 4;
+        }
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        int round_up = 0;
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+    *digits = output;
+    return e10 + removed;
+}
+
+/**
+ * Format a floating point value with the fewest digits that read back exactly.
+ *
+ * Values in [1e-5, 1e15) are written in fixed-point notation and the others
+ * like printf's %g, as d.ddde+XX.
+ *
+ * @param buf The output buffer, with room for FORMAT_VALUE_MAX bytes.
+ * @param v The value.
+ * @param is_float Nonzero to round-trip through float rather than double.
+ * @return The number of bytes written.
+ */
+static size_t format_real(char* buf, double v, int is_float) {
+    if (v != v) {
+        memcpy(buf, "nan", 3);
+        return 3;
+    }
+    if (isinf(v)) {
+        memcpy(buf, v < 0 ? "-inf" : "inf", v < 0 ? 4 : 3);
+        return v < 0 ? 4 : 3;
+    }
+    if (v == 0) {
+        memcpy(buf, signbit(v) ? "-0" : "0", signbit(v) ? 2 : 1);
+        return signbit(v) ? 2 : 1;
+    }
+
+    uint64_t digits_value;
+    int e10;
+    if (is_float) {
+        float f = (float)v;
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        e10 = shortest_decimal(bits & 0x7FFFFF, (bits >> 23) & 0xFF, 23, 127, &digits_value);
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        e10 = shortest_decimal(bits & 0xFFFFFFFFFFFFFull, (uint32_t)(bits >> 52) & 0x7FF, 52, 1023,
+                               &digits_value);
+    }
+
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* start = format_digits(end, digits_value);
+    int n = (int)(end - start);
+    int leading = e10 + n - 1;   // Power of ten of the first digit
+
+    size_t len = 0;
+    if (v < 0) {
+        buf[len++] = '-';
+    }
+    if (leading >= -5 && leading < 15) {
+        if (e10 >= 0) {
+            memcpy(buf + len, start, n);
+            len += n;
+            memset(buf + len, '0', e10);
+            len += e10;
+        } else if (leading >= 0) {
+            memcpy(buf + len, start, leading + 1);
+            len += leading + 1;
+            buf[len++] = '.';
+            memcpy(buf + len, start + leading + 1, n - leading - 1);
+            len += n - leading - 1;
+        } else {
+            buf[len++] = '0';
+            buf[len++] = '.';
+            memset(buf + len, '0', -leading - 1);
+            len += -leading - 1;
+            memcpy(buf + len, start, n);
+            len += n;
+        }
+        return len;
+    }
+
+    buf[len++] = start[0];
+    if (n > 1) {
+        buf[len++] = '.';
+        memcpy(buf + len, start + 1, n - 1);
+        len += n - 1;
+    }
+    buf[len++] = 'e';
+    buf[len++] = leading < 0 ? '-' : '+';
+    int magnitude = leading < 0 ? -leading : leading;
+    if (magnitude < 10) {
+        buf[len++] = '0';
+    }
+    char exp_digits[8];
+    char* exp_end = exp_digits + sizeof(exp_digits);
+    char* exp_start = format_digits(exp_end, (uint64_t)magnitude);
+    memcpy(buf + len, exp_start, exp_end - exp_start);
+    return len + (exp_end - exp_start);
+}
+
+/**
+ * Format one element of an array as text.
+ *
+ * Integers and booleans are written as decimal integers. Floating point
+ * values are written with the fewest digits that read back to the same value.
+ * Complex values are written as "re+imj".
+ *
+ * @param buf The output buffer, with room for FORMAT_VALUE_MAX bytes.
+ * @param dtype The data type of the element.
+ * @param element Pointer to the element.
+ * @return The number of bytes written (not null-terminated).
+ */
+size_t format_element(char* buf, DataType dtype, const void* element) {
+    switch (dtype) {
+        case TYPE_INT:
+            return format_int(buf, *(const int*)element);
+        case TYPE_BOOL:
+            buf[0] = *(const unsigned char*)element ? '1' : '0';
+            return 1;
+        case TYPE_FLOAT:
+            return format_real(buf, *(const float*)element, 1);
+        case TYPE_DOUBLE:
+            return format_real(buf, *(const double*)element, 0);
+        case TYPE_COMPLEX_FLOAT:
+        case TYPE_COMPLEX_DOUBLE: {
+            int is_float = dtype == TYPE_COMPLEX_FLOAT;
+            double re = is_float ? ((const float*)element)[0] : ((const double*)element)[0];
+            double im = is_float ? ((const float*)element)[1] : ((const double*)element)[1];
+            size_t len = format_real(buf, re, is_float);
+            if (!signbit(im) || im != im) {
+                buf[len++] = '+';
+            }
+            len += format_real(buf + len, im, is_float);
+            buf[len++] = 'j';
+            return len;
+        }
+        default:
+            return 0;
+    }
+}
+
+
+// Number parsing
+
+static inline int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Copies a field so it can be null-terminated; returns 0 if it is empty or too long
+static int copy_field(const char* p, const char* end, char field[CSV_FIELD_MAX]) {
+    size_t len = end - p;
+    if (len == 0 || len >= CSV_FIELD_MAX) {
+        return 0;
+    }
+    memcpy(field, p, len);
+    field[len] = '\0';
+    return 1;
+}
+
+// Parses a field with strtod
+static int parse_real_slow(const char* p, const char* end, double* out) {
+    char field[CSV_FIELD_MAX];
+    if (!copy_field(p, end, field)) {
+        return 0;
+    }
+    char* stop;
+    *out = strtod(field, &stop);
+    return stop == field + (end - p);
+}
+
+// Parses a field with strtof, which rounds once instead of through a double
+static int parse_float_slow(const char* p, const char* end, float* out) {
+    char field[CSV_FIELD_MAX];
+    if (!copy_field(p, end, field)) {
+        return 0;
+    }
+    char* stop;
+    *out = strtof(field, &stop);
+    return stop == field + (end - p);
+}
+
+// A decimal number as sign * mantissa * 10^exponent
+typedef struct {
+    int negative;
+    uint64_t mantissa;   // At most 19 significant digits
+    int exponent;
+    int truncated;       // Nonzero digits beyond the first 19 were dropped
+} Decimal;
+
+/**
+ * Split a field of the form [sign] digits [. digits] [e [sign] digits].
+ *
+ * @param p Start of the field.
+ * @param end End of the field.
+ * @param d Receives the number.
+ * @return 1 on success, 0 if the field is not a number, -1 if it has no
+ *         digits and is left to strtod (inf, nan).
+ */
+static int scan_decimal(const char* p, const char* end, Decimal* d) {
+    d->negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        d->negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0, any_digit = 0, truncated = 0;
+    for (; p < end && is_digit(*p); p++) {
+        any_digit = 1;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+            truncated |= *p != '0';
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && is_digit(*p); p++) {
+            any_digit = 1;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+    if (!any_digit) {
+        return -1;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        int exp_negative = 0;
+        if (p < end && (*p == '-' || *p == '+')) {
+            exp_negative = *p == '-';
+            p++;
+        }
+        if (p == end || !is_digit(*p)) {
+            return 0;
+        }
+        int e = 0;
+        for (; p < end && is_digit(*p); p++) {
+            if (e < 100000) {
+                e = e * 10 + (*p - '0');
+            }
+        }
+        exponent += exp_negative ? -e : e;
+    }
+    if (p != end) {
+        return 0;
+    }
+
+    d->mantissa = mantissa;
+    d->exponent = exponent;
+    d->truncated = truncated;
+    return 1;
+}
+
+/**
+ * Parse a decimal floating point number.
+ *
+ * Numbers with at most 19 significant digits whose mantissa is below 2^53
+ * and whose decimal exponent is within ±22 are exact: the mantissa and the
+ * power of ten are both exact doubles, so one correctly rounded multiply or
+ * divide gives the correctly rounded result. Everything else (long mantissas,
+ * large exponents, inf, nan) goes through strtod.
+ *
+ * @param p Start of the field.
+ * @param end End of the field.
+ * @param out Receives the value.
+ * @return 1 on success, 0 if the field is not a number.
+ */
+static int parse_real(const char* p, const char* end, double* out) {
+    Decimal d;
+    int scanned = scan_decimal(p, end, &d);
+    if (scanned <= 0) {
+        return scanned < 0 && parse_real_slow(p, end, out);
+    }
+    if (d.truncated || d.mantissa >= (1ull << 53) || d.exponent < -22 || d.exponent > 22) {
+        return parse_real_slow(p, end, out);
+    }
+    double v = (double)d.mantissa;
+    v = d.exponent < 0 ? v / exact_powers_of_ten[-d.exponent] : v * exact_powers_of_ten[d.exponent];
+    *out = d.negative ? -v : v;
+    return 1;
+}
+
+/**
+ * Parse a decimal floating point number directly into a float.
+ *
+ * Rounding the double from parse_real again could be off by one ulp, so the
+ * exact fast path is repeated in float precision (mantissa below 2^24,
+ * exponent within ±10) and everything else goes through strtof.
+ *
+ * @param p Start of the field.
+ * @param end End of the field.
+ * @param out Receives the value.
+ * @return 1 on success, 0 if the field is not a number.
+ */
+static int parse_float(const char* p, const char* end, float* out) {
+    Decimal d;
+    int scanned = scan_decimal(p, end, &d);
+    if (scanned <= 0) {
+        return scanned < 0 && parse_float_slow(p, end, out);
+    }
+    if (d.truncated || d.mantissa >= (1ull << 24) || d.exponent < -10 || d.exponent > 10) {
+        return parse_float_slow(p, end, out);
+    }
+    float v = (float)d.mantissa;
+    float power = (float)exact_powers_of_ten[d.exponent < 0 ? -d.exponent : d.exponent];
+    v = d.exponent < 0 ? v / power : v * power;
+    *out = d.negative ? -v : v;
+    return 1;
+}
+
+static int parse_int(const char* p, const char* end, int* out) {
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end) {
+        return 0;
+    }
+    int64_t v = 0;
+    for (; p < end; p++) {
+        if (!is_digit(*p)) {
+            return 0;
+        }
+        v = v * 10 + (*p - '0');
+        if (v > (int64_t)INT32_MAX + 1) {
+            return 0;
+        }
+    }
+    v = negative ? -v : v;
+    if (v > INT32_MAX) {
+        return 0;
+    }
+    *out = (int)v;
+    return 1;
+}
+
+static int parse_bool(const char* p, const char* end, unsigned char* out) {
+    size_t len = end - p;
+    if ((len == 1 && *p == '1') || (len == 4 && memcmp(p, "true", 4) == 0)) {
+        *out = 1;
+        return 1;
+    }
+    if ((len == 1 && *p == '0') || (len == 5 && memcmp(p, "false", 5) == 0)) {
+        *out = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static int parse_field(const char* p, const char* end, DataType dtype, char* dst) {
+    switch (dtype) {
+        case TYPE_INT:
+            return parse_int(p, end, (int*)dst);
+        case TYPE_BOOL:
+            return parse_bool(p, end, (unsigned char*)dst);
+        case TYPE_FLOAT:
+            return parse_float(p, end, (float*)dst);
+        case TYPE_DOUBLE:
+            return parse_real(p, end, (double*)dst);
+        default:
+            return 0;
+    }
+}
+
+
+// CSV loading
+
+// A range of whole lines of the input, parsed by one task
+typedef struct {
+    const char* begin;
+    const char* end;
+    size_t lines;            // Lines in the piece, counting blank ones
+    size_t rows;             // Non-blank lines
+    size_t cols;             // Fields in the first row, 0 if the piece has no rows
+    size_t first_line;       // Line number of begin (0-based)
+    size_t first_row;        // Row index of the first row of the piece
+    size_t error_line;       // Line of the first error, or SIZE_MAX; relative to the piece while counting
+} CsvPiece;
+
+typedef struct {
+    CsvPiece* pieces;
+    DataType dtype;
+    size_t cols;
+    size_t elem_bytes;
+    char* data;
+} CsvContext;
+
+static inline int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Trims blanks around a field
+static void trim_field(const char** p, const char** end) {
+    while (*p < *end && is_blank(**p)) (*p)++;
+    while (*end > *p && is_blank((*end)[-1])) (*end)--;
+}
+
+// Returns the end of the line starting at p (the newline, or end)
+static const char* line_end(const char* p, const char* end) {
+    const char* nl = memchr(p, '\n', end - p);
+    return nl ? nl : end;
+}
+
+static int is_blank_line(const char* p, const char* end) {
+    while (p < end && is_blank(*p)) p++;
+    return p == end;
+}
+
+// Counts lines, rows and fields of each piece; a row whose field count differs from
+// the first row of its piece is an error, recorded as a line of the piece
+static void count_pieces(size_t begin, size_t end, void* ctx) {
+    CsvContext* c = ctx;
+    for (size_t i = begin; i < end; i++) {
+        CsvPiece* piece = &c->pieces[i];
+        piece->error_line = SIZE_MAX;
+        for (const char* p = piece->begin; p < piece->end; piece->lines++) {
+            const char* stop = line_end(p, piece->end);
+            if (!is_blank_line(p, stop)) {
+                size_t fields = 1;
+                for (const char* q = p; (q = memchr(q, ',', stop - q)); q++) {
+                    fields++;
+                }
+                if (piece->rows == 0) {
+                    piece->cols = fields;
+                } else if (fields != piece->cols && piece->error_line == SIZE_MAX) {
+                    piece->error_line = piece->lines;
+                }
+                piece->rows++;
+            }
+            p = stop + 1;
+        }
+    }
+}
+
+static void parse_pieces(size_t begin, size_t end, void* ctx) {
+    CsvContext* c = ctx;
+    for (size_t i = begin; i < end; i++) {
+        CsvPiece* piece = &c->pieces[i];
+        char* dst = c->data + piece->first_row * c->cols * c->elem_bytes;
+        size_t line = piece->first_line;
+        for (const char* p = piece->begin; p < piece->end; line++) {
+            const char* stop = line_end(p, piece->end);
+            if (!is_blank_line(p, stop)) {
+                const char* field = p;
+                for (size_t col = 0; col < c->cols; col++) {
+                    const char* field_end = memchr(field, ',', stop - field);
+                    if (!field_end) field_end = stop;
+                    const char* f = field;
+                    const char* f_end = field_end;
+                    trim_field(&f, &f_end);
+                    if (!parse_field(f, f_end, c->dtype, dst)) {
+                        piece->error_line = line;
+                        return;
+                    }
+                    dst += c->elem_bytes;
+                    field = field_end + 1;
+                }
+            }
+            p = stop + 1;
+        }
+    }
+}
+
+/**
+ * Load a two-dimensional array from a CSV file.
+ *
+ * The file is mapped into memory and cut into pieces of whole lines. A first
+ * parallel pass counts the rows of each piece and checks the field counts;
+ * after a prefix sum gives each piece its first row, a second parallel pass
+ * parses the fields straight into the result. Fields are separated by commas
+ * and may be surrounded by blanks; blank lines are skipped.
+ *
+ * @param path The path of the file.
+ * @param dtype TYPE_INT, TYPE_FLOAT, TYPE_DOUBLE or TYPE_BOOL.
+ * @return A pointer to a new (rows, columns) Array structure, or NULL on error.
+ */
+Array* array_from_csv(const char* path, DataType dtype) {
+    if (!path) {
+        log_error(ARRAY_ERROR_NULL, "Path is NULL");
+        return NULL;
+    }
+    if (dtype > TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        log_error(ARRAY_ERROR_VALUE, "Failed to open file");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        log_error(ARRAY_ERROR_VALUE, "File is empty");
+        return NULL;
+    }
+    size_t n_bytes = st.st_size;
+    const char* text = mmap(NULL, n_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        log_error(ARRAY_ERROR_VALUE, "Failed to map file");
+        return NULL;
+    }
+
+    // Cut the text into pieces that end on a newline
+    size_t max_pieces = n_bytes / CSV_PIECE_BYTES + 1;
+    CsvPiece* pieces = calloc(max_pieces, sizeof(CsvPiece));
+    if (!pieces) {
+        munmap((void*)text, n_bytes);
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for CSV pieces");
+        return NULL;
+    }
+    size_t n_pieces = 0;
+    for (const char* p = text, *end = text + n_bytes; p < end; n_pieces++) {
+        const char* stop = end - p > CSV_PIECE_BYTES ? p + CSV_PIECE_BYTES : end;
+        if (stop < end) {
+            stop = line_end(stop, end);
+            stop = stop < end ? stop + 1 : end;
+        }
+        pieces[n_pieces].begin = p;
+        pieces[n_pieces].end = stop;
+        p = stop;
+    }
+
+    CsvContext c = { pieces, dtype, 0, get_dtype_size(dtype), NULL };
+    parallel_for(n_pieces, 1, count_pieces, &c);
+
+    size_t rows = 0, lines = 0;
+    size_t error_line = SIZE_MAX;
+    for (size_t i = 0; i < n_pieces; i++) {
+        pieces[i].first_row = rows;
+        pieces[i].first_line = lines;
+        if (pieces[i].error_line != SIZE_MAX && error_line == SIZE_MAX) {
+            error_line = pieces[i].error_line + lines;
+        }
+        if (pieces[i].rows > 0) {
+            if (c.cols == 0) {
+                c.cols = pieces[i].cols;
+            } else if (pieces[i].cols != c.cols && error_line == SIZE_MAX) {
+                // The first row of this piece disagrees with the earlier rows; find its line
+                const char* p = pieces[i].begin;
+                size_t line = lines;
+                while (is_blank_line(p, line_end(p, pieces[i].end))) {
+                    p = line_end(p, pieces[i].end) + 1;
+                    line++;
+                }
+                error_line = line;
+            }
+        }
+        rows += pieces[i].rows;
+        lines += pieces[i].lines;
+    }
+
+    Array* result = NULL;
+    // The message outlives this call as the thread's last error
+    static _Thread_local char message[96];
+    if (error_line != SIZE_MAX) {
+        snprintf(message, sizeof(message), "Wrong number of fields on line %zu", error_line + 1);
+        log_error(ARRAY_ERROR_VALUE, message);
+    } else if (rows == 0) {
+        log_error(ARRAY_ERROR_VALUE, "File has no rows");
+    } else {
+        size_t shape[2] = { rows, c.cols };
+        result = create_array(dtype, 2, shape, NULL);
+    }
+
+    if (result) {
+        c.data = result->data;
+        parallel_for(n_pieces, 1, parse_pieces, &c);
+        for (size_t i = 0; i < n_pieces; i++) {
+            if (pieces[i].error_line != SIZE_MAX) {
+                snprintf(message, sizeof(message), "Invalid value on line %zu", pieces[i].error_line + 1);
+                log_error(ARRAY_ERROR_VALUE, message);
+                free_array(result);
+                result = NULL;
+                break;
+            }
+        }
+    }
+
+    free(pieces);
+    munmap((void*)text, n_bytes);
+    return result;
+}
+
+
+// CSV writing
+
+typedef struct {
+    const Array* arr;
+    size_t inner;            // Elements per output line
+    size_t first;            // First element of the batch
+    size_t size;             // Elements in the batch
+    char** buffers;          // One per piece
+    size_t* lengths;
+} CsvWriteContext;
+
+static void format_pieces(size_t begin, size_t end, void* ctx) {
+    CsvWriteContext* c = ctx;
+    size_t elem_bytes = get_dtype_size(c->arr->dtype);
+    for (size_t piece = begin; piece < end; piece++) {
+        size_t i = c->first + piece * CSV_PIECE_ELEMENTS;
+        size_t stop = c->first + c->size;
+        if (stop > i + CSV_PIECE_ELEMENTS) {
+            stop = i + CSV_PIECE_ELEMENTS;
+        }
+        char* out = c->buffers[piece];
+        const char* element = (const char*)c->arr->data + i * elem_bytes;
+        for (; i < stop; i++, element += elem_bytes) {
+            out += format_element(out, c->arr->dtype, element);
+            *out++ = (i + 1) % c->inner ? ',' : '\n';
+        }
+        c->lengths[piece] = out - c->buffers[piece];
+    }
+}
+
+/**
+ * Write an array to a CSV file.
+ *
+ * Each line holds one row of the last dimension, so a two-dimensional array
+ * round-trips through array_from_csv. Batches of elements are formatted into
+ * per-piece buffers on multiple threads and written in order.
+ *
+ * @param arr The array to write.
+ * @param path The path of the file, created or truncated.
+ * @return 1 on success, 0 on error.
+ */
+int array_to_csv(Array* arr, const char* path) {
+    if (!arr || !path) {
+        log_error(ARRAY_ERROR_NULL, "Array or path is NULL");
+        return 0;
+    }
+    if (arr->dtype > TYPE_COMPLEX_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return 0;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        log_error(ARRAY_ERROR_VALUE, "Failed to open file");
+        return 0;
+    }
+
+    size_t n_pieces = get_num_threads() * CSV_PIECES_PER_THREAD;
+    CsvWriteContext c = { arr, arr->ndim > 0 ? arr->shape[arr->ndim - 1] : 1, 0, 0, NULL, NULL };
+    c.buffers = calloc(n_pieces, sizeof(char*));
+    c.lengths = calloc(n_pieces, sizeof(size_t));
+    int ok = c.buffers && c.lengths;
+    for (size_t i = 0; ok && i < n_pieces; i++) {
+        c.buffers[i] = malloc(CSV_PIECE_ELEMENTS * (FORMAT_VALUE_MAX + 1));
+        ok = c.buffers[i] != NULL;
+    }
+    if (!ok) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for CSV buffers");
+    }
+
+    size_t batch = n_pieces * CSV_PIECE_ELEMENTS;
+    for (c.first = 0; ok && c.first < arr->size; c.first += batch) {
+        c.size = arr->size - c.first < batch ? arr->size - c.first : batch;
+        size_t used = (c.size + CSV_PIECE_ELEMENTS - 1) / CSV_PIECE_ELEMENTS;
+        parallel_for(used, 1, format_pieces, &c);
+        for (size_t i = 0; ok && i < used; i++) {
+            if (fwrite(c.buffers[i], 1, c.lengths[i], file) != c.lengths[i]) {
+                log_error(ARRAY_ERROR_VALUE, "Failed to write file");
+                ok = 0;
+            }
+        }
+    }
+
+    for (size_t i = 0; c.buffers && i < n_pieces; i++) {
+        free(c.buffers[i]);
+    }
+    free(c.buffers);
+    free(c.lengths);
+    if (fclose(file) != 0 && ok) {
+        log_error(ARRAY_ERROR_VALUE, "Failed to write file");
+        ok = 0;
+    }
+    return ok;
+}
+
+
+/**
+ * Print an array, one row of its last dimension per line.
+ *
+ * Elements are formatted with format_element into a buffer that is written
+ * when full, instead of one printf per element.
+ *
+ * @param arr The array to print.
+ */
+void print_array(Array* arr) {
+    if (!arr) {
+        printf("\033[31mArray: NULL\033[0m\n");  // Red for NULL
+        return;
+    }
+
+    size_t inner = arr->ndim > 0 ? arr->shape[arr->ndim - 1] : 1;
+    size_t elem_bytes = get_dtype_size(arr->dtype);
+    const char* element = arr->data;
+    char buffer[PRINT_BUFFER_BYTES];
+    size_t len = 0;
+
+    for (size_t i = 0; i < arr->size; i++, element += elem_bytes) {
+        if (len + FORMAT_VALUE_MAX + 2 > sizeof(buffer)) {
+            fwrite(buffer, 1, len, stdout);
+            len = 0;
+        }
+        len += format_element(buffer + len, arr->dtype, element);
+        if ((i + 1) % inner) {
+            buffer[len++] = ',';
+            buffer[len++] = ' ';
+        } else {
+            buffer[len++] = '\n';
+        }
+    }
+    fwrite(buffer, 1, len, stdout);
+}
@@ -0,0 +1,428 @@
+#include "array.h"
+
+// Every joining operation reduces to the same layout: the output is a sequence of
+// `outer` rows, and each row is the concatenation of one contiguous run from every
+// source. Only the run lengths differ between concatenate and stack.
+typedef struct {
+    char* out;
+    const char** srcs;
+    const size_t* run_bytes;  // Bytes contributed by each source to one output row
+    size_t n_srcs;
+    size_t row_bytes;         // Sum of run_bytes
+} JoinContext;
+
+static void join_rows(size_t begin, size_t end, void* ctx) {
+    JoinContext* join = ctx;
+    for (size_t row = begin; row < end; row++) {
+        char* out = join->out + row * join->row_bytes;
+        for (size_t k = 0; k < join->n_srcs; k++) {
+            const char* src = join->srcs[k] + row * join->run_bytes[k];
+            if (out != src) {
+                memcpy(out, src, join->run_bytes[k]);
+            }
+            out += join->run_bytes[k];
+        }
+    }
+}
+
+/**
+ * Copy the sources into the output row by row.
+ *
+ * With a single output row (joining along axis 0) every source is one
+ * contiguous block, which is copied with a parallel memcpy. Otherwise the rows
+ * are distributed over the threads.
+ */
+static void join_copy(JoinContext* join, size_t outer) {
+    if (outer == 1) {
+        char* out = join->out;
+        for (size_t k = 0; k < join->n_srcs; k++) {
+            parallel_memcpy(out, join->srcs[k], join->run_bytes[k]);
+            out += join->run_bytes[k];
+        }
+        return;
+    }
+    size_t grain = PARALLEL_GRAIN_BYTES / join->row_bytes + 1;
+    parallel_for(outer, grain, join_rows, join);
+}
+
+/**
+ * Validate the inputs of concatenate and compute the output shape.
+ *
+ * @param arrays The arrays to join.
+ * @param n_arrays Number of arrays.
+ * @param axis The axis along which they are joined.
+ * @param out_shape Buffer of arrays[0]->ndim entries receiving the joined shape.
+ * @return 1 if the arrays can be concatenated, 0 otherwise.
+ */
+static int concatenated_shape(Array** arrays, size_t n_arrays, size_t axis, size_t* out_shape) {
+    #if DEBUG_MODE
+        if (!arrays || n_arrays == 0) {
+            log_error(ARRAY_ERROR_VALUE, "No arrays to join");
+            return 0;
+        }
+        for (size_t k = 0; k < n_arrays; k++) {
+            if (!arrays[k]) {
+                log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+                return 0;
+            }
+        }
+    #endif
+
+    Array* first = arrays[0];
+    if (axis >= first->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return 0;
+    }
+
+    memcpy(out_shape, first->shape, first->ndim * sizeof(size_t));
+    for (size_t k = 1; k < n_arrays; k++) {
+        Array* arr = arrays[k];
+        if (arr->dtype != first->dtype) {
+            log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+            return 0;
+        }
+        if (arr->ndim != first->ndim) {
+            log_error(ARRAY_ERROR_SHAPE, "Number of dimensions are not equal");
+            return 0;
+        }
+        for (size_t i = 0; i < arr->ndim; i++) {
+            if (i != axis && arr->shape[i] != first->shape[i]) {
+                log_error(ARRAY_ERROR_SHAPE, "Shapes are not equal outside the concatenation axis");
+                return 0;
+            }
+        }
+        out_shape[axis] += arr->shape[axis];
+    }
+    return 1;
+}
+
+/**
+ * Copy the arrays into a preallocated output, joined along an axis.
+ *
+ * Each array contributes one contiguous run per output row, so the copy is a
+ * memcpy per run. Along axis 0 every array is a single run; an array whose data
+ * already lives at its destination inside out (for example because it was
+ * filled in place) is skipped, which makes assembling a batch zero-copy.
+ *
+ * @param out The preallocated output array.
+ * @param arrays The arrays to join.
+ * @param n_arrays Number of arrays.
+ * @param axis The axis along which they are joined.
+ * @return 1 on success, 0 on error.
+ */
+int concatenate_into(Array* out, Array** arrays, size_t n_arrays, size_t axis) {
+    #if DEBUG_MODE
+        if (!out) {
+            log_error(ARRAY_ERROR_NULL, "Output array is NULL");
+            return 0;
+        }
+    #endif
+
+    if (!arrays || n_arrays == 0 || !arrays[0]) {
+        log_error(ARRAY_ERROR_VALUE, "No arrays to join");
+        return 0;
+    }
+    size_t ndim = arrays[0]->ndim;
+    size_t out_shape[ndim];
+    if (!concatenated_shape(arrays, n_arrays, axis, out_shape)) {
+        return 0;
+    }
+    if (out->dtype != arrays[0]->dtype || !are_shapes_equal(out->shape, out->ndim, out_shape, ndim)) {
+        log_error(ARRAY_ERROR_SHAPE, "Output array does not match the concatenated shape");
+        return 0;
+    }
+    if (!make_array_writable(out)) {
+        return 0;
+    }
+
+    size_t dtype_size = get_dtype_size(out->dtype);
+    size_t outer = 1;
+    for (size_t i = 0; i < axis; i++) {
+        outer *= out_shape[i];
+    }
+    size_t inner_bytes = dtype_size;
+    for (size_t i = axis + 1; i < ndim; i++) {
+        inner_bytes *= out_shape[i];
+    }
+
+    const char* srcs[n_arrays];
+    size_t run_bytes[n_arrays];
+    for (size_t k = 0; k < n_arrays; k++) {
+        srcs[k] = arrays[k]->data;
+        run_bytes[k] = arrays[k]->shape[axis] * inner_bytes;
+    }
+
+    JoinContext join = { out->data, srcs, run_bytes, n_arrays, out_shape[axis] * inner_bytes };
+    join_copy(&join, outer);
+    return 1;
+}
+
+Array* concatenate(Array** arrays, size_t n_arrays, size_t axis) {
+    if (!arrays || n_arrays == 0 || !arrays[0]) {
+        log_error(ARRAY_ERROR_VALUE, "No arrays to join");
+        return NULL;
+    }
+    size_t ndim = arrays[0]->ndim;
+    size_t out_shape[ndim];
+    if (!concatenated_shape(arrays, n_arrays, axis, out_shape)) {
+        return NULL;
+    }
+
+    Array* result = create_array(arrays[0]->dtype, ndim, out_shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    if (!concatenate_into(result, arrays, n_arrays, axis)) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Join arrays of identical shape along a new axis.
+ *
+ * This is a concatenation in which every array contributes a run of
+ * inner_bytes per output row, where the rows are indexed by the dimensions
+ * before the new axis.
+ *
+ * @param arrays The arrays to join.
+ * @param n_arrays Number of arrays.
+ * @param axis Position of the new axis in the result (0 to ndim).
+ * @return A new array with one more dimension, or NULL on error.
+ */
+Array* stack(Array** arrays, size_t n_arrays, size_t axis) {
+    #if DEBUG_MODE
+        if (!arrays || n_arrays == 0) {
+            log_error(ARRAY_ERROR_VALUE, "No arrays to join");
+            return NULL;
+        }
+        for (size_t k = 0; k < n_arrays; k++) {
+            if (!arrays[k]) {
+                log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+                return NULL;
+            }
+        }
+    #endif
+
+    Array* first = arrays[0];
+    if (axis > first->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return NULL;
+    }
+    for (size_t k = 1; k < n_arrays; k++) {
+        if (arrays[k]->dtype != first->dtype) {
+            log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+            return NULL;
+        }
+        if (!are_shapes_equal(arrays[k]->shape, arrays[k]->ndim, first->shape, first->ndim)) {
+            log_error(ARRAY_ERROR_SHAPE, "Shapes are not equal");
+            return NULL;
+        }
+    }
+
+    size_t ndim = first->ndim + 1;
+    size_t out_shape[ndim];
+    for (size_t i = 0, j = 0; i < ndim; i++) {
+        out_shape[i] = (i == axis) ? n_arrays : first->shape[j++];
+    }
+
+    Array* result = create_array(first->dtype, ndim, out_shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    size_t outer = 1;
+    for (size_t i = 0; i < axis; i++) {
+        outer *= first->shape[i];
+    }
+    size_t inner_bytes = get_dtype_size(first->dtype);
+    for (size_t i = axis; i < first->ndim; i++) {
+        inner_bytes *= first->shape[i];
+    }
+
+    const char* srcs[n_arrays];
+    size_t run_bytes[n_arrays];
+    for (size_t k = 0; k < n_arrays; k++) {
+        srcs[k] = arrays[k]->data;
+        run_bytes[k] = inner_bytes;
+    }
+
+    JoinContext join = { result->data, srcs, run_bytes, n_arrays, n_arrays * inner_bytes };
+    join_copy(&join, outer);
+    return result;
+}
+
+
+// Tiling
+
+typedef struct {
+    char* out;
+    const char* in;
+    const size_t* shape;      // Input shape, padded to ndim
+    const size_t* reps;       // Repetitions, padded to ndim
+    const size_t* in_block;   // Bytes of the input sub-block below each dimension
+    const size_t* out_block;  // Bytes of the tiled sub-block below each dimension
+    size_t ndim;
+} TileContext;
+
+// Replicates the first block_bytes of out count times in total.
+static void replicate_block(char* out, size_t block_bytes, size_t count) {
+    for (size_t r = 1; r < count; r++) {
+        memcpy(out + r * block_bytes, out, block_bytes);
+    }
+}
+
+/**
+ * Fill the tiled block of dimensions d..ndim-1 for one input sub-block.
+ *
+ * The input rows along the last dimension are copied with one memcpy each,
+ * and every higher dimension is then completed by replicating the block that
+ * was just built, so all copies are whole contiguous runs.
+ */
+static void tile_fill(TileContext* tile, char* out, const char* in, size_t d) {
+    size_t span = tile->shape[d] * tile->out_block[d];
+    if (d == tile->ndim - 1) {
+        memcpy(out, in, tile->shape[d] * tile->in_block[d]);
+    } else {
+        for (size_t j = 0; j < tile->shape[d]; j++) {
+            tile_fill(tile, out + j * tile->out_block[d], in + j * tile->in_block[d], d + 1);
+        }
+    }
+    replicate_block(out, span, tile->reps[d]);
+}
+
+static void tile_top_rows(size_t begin, size_t end, void* ctx) {
+    TileContext* tile = ctx;
+    for (size_t j = begin; j < end; j++) {
+        if (tile->ndim == 1) {
+            memcpy(tile->out + j * tile->out_block[0], tile->in + j * tile->in_block[0], tile->in_block[0]);
+        } else {
+            tile_fill(tile, tile->out + j * tile->out_block[0], tile->in + j * tile->in_block[0], 1);
+        }
+    }
+}
+
+Array* tile(Array* arr, size_t* reps, size_t n_reps) {
+    #if DEBUG_MODE
+        if (!arr || !reps) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return NULL;
+        }
+        if (n_reps == 0) {
+            log_error(ARRAY_ERROR_VALUE, "Number of repetitions is 0");
+            return NULL;
+        }
+    #endif
+
+    // Align the input shape and the repetitions to the right, padding with 1
+    size_t ndim = (arr->ndim > n_reps) ? arr->ndim : n_reps;
+    size_t shape[ndim], padded_reps[ndim], out_shape[ndim];
+    for (size_t i = 0; i < ndim; i++) {
+        shape[i] = (i < ndim - arr->ndim) ? 1 : arr->shape[i - (ndim - arr->ndim)];
+        padded_reps[i] = (i < ndim - n_reps) ? 1 : reps[i - (ndim - n_reps)];
+        if (padded_reps[i] == 0) {
+            log_error(ARRAY_ERROR_VALUE, "Repetitions must be positive");
+            return NULL;
+        }
+        out_shape[i] = shape[i] * padded_reps[i];
+    }
+
+    Array* result = create_array(arr->dtype, ndim, out_shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    size_t in_block[ndim], out_block[ndim];
+    in_block[ndim - 1] = out_block[ndim - 1] = get_dtype_size(arr->dtype);
+    for (size_t i = ndim - 1; i-- > 0;) {
+        in_block[i] = in_block[i + 1] * shape[i + 1];
+        out_block[i] = out_block[i + 1] * out_shape[i + 1];
+    }
+
+    TileContext ctx = { result->data, arr->data, shape, padded_reps, in_block, out_block, ndim };
+
+    // The rows of the outermost dimension are independent; build them in parallel,
+    // then replicate the whole first tile along the outermost dimension.
+    size_t grain = PARALLEL_GRAIN_BYTES / out_block[0] + 1;
+    parallel_for(shape[0], grain, tile_top_rows, &ctx);
+    size_t first_tile = shape[0] * out_block[0];
+    for (size_t r = 1; r < padded_reps[0]; r++) {
+        parallel_memcpy((char*)result->data + r * first_tile, result->data, first_tile);
+    }
+    return result;
+}
+
+
+// Repeating
+
+typedef struct {
+    char* out;
+    const char* in;
+    size_t slab_bytes;  // Bytes of one slice along the repeated axis
+    size_t repeats;
+} RepeatContext;
+
+static void repeat_slabs(size_t begin, size_t end, void* ctx) {
+    RepeatContext* rep = ctx;
+    for (size_t s = begin; s < end; s++) {
+        const char* src = rep->in + s * rep->slab_bytes;
+        char* dst = rep->out + s * rep->repeats * rep->slab_bytes;
+        for (size_t r = 0; r < rep->repeats; r++) {
+            memcpy(dst + r * rep->slab_bytes, src, rep->slab_bytes);
+        }
+    }
+}
+
+/**
+ * Repeat every element of an array along an axis.
+ *
+ * The input is viewed as a sequence of slabs, one per index of the dimensions
+ * up to and including the axis; each slab (everything below the axis) is one
+ * contiguous run that is copied repeats times back to back.
+ *
+ * @param arr The array to repeat.
+ * @param repeats Number of times each element is repeated.
+ * @param axis The axis along which to repeat.
+ * @return A new array, or NULL on error.
+ */
+Array* repeat(Array* arr, size_t repeats, size_t axis) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (axis >= arr->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return NULL;
+    }
+    if (repeats == 0) {
+        log_error(ARRAY_ERROR_VALUE, "Repetitions must be positive");
+        return NULL;
+    }
+
+    size_t out_shape[arr->ndim];
+    memcpy(out_shape, arr->shape, arr->ndim * sizeof(size_t));
+    out_shape[axis] *= repeats;
+
+    Array* result = create_array(arr->dtype, arr->ndim, out_shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    size_t n_slabs = 1;
+    for (size_t i = 0; i <= axis; i++) {
+        n_slabs *= arr->shape[i];
+    }
+    size_t slab_bytes = get_dtype_size(arr->dtype);
+    for (size_t i = axis + 1; i < arr->ndim; i++) {
+        slab_bytes *= arr->shape[i];
+    }
+
+    RepeatContext ctx = { result->data, arr->data, slab_bytes, repeats };
+    size_t grain = PARALLEL_GRAIN_BYTES / (slab_bytes * repeats) + 1;
+    parallel_for(n_slabs, grain, repeat_slabs, &ctx);
+    return result;
+}
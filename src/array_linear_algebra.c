@@ -1,10 +1,11 @@
 #include "array.h"
+#include <stdint.h>
 
 
 size_t* calculate_strides(const size_t* shape, size_t ndim) {
     size_t* strides = malloc(ndim * sizeof(size_t));
     if (!strides) {
-        log_error("Failed to allocate memory for strides");
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for strides");
         return NULL;
     }
 
@@ -34,17 +35,109 @@ int is_valid_permutation(const size_t* perm, size_t ndim) {
 
 
 
+// Work shared by the threads of reorder_data: the destination shape and the source
+// element strides along each destination dimension, padded to FIXED_LOOP_RANK
+typedef struct {
+    const char* src;
+    char* dst;
+    size_t shape[FIXED_LOOP_RANK];
+    size_t strides[FIXED_LOOP_RANK];
+} ReorderContext;
+
+// 16-byte element (complex double), copied as a unit
+typedef struct {
+    double re, im;
+} ReorderElement16;
+
+// Each task gathers destination rows [begin, end) with a fixed loop nest resumed at row
+// begin; the copy is typed by element size, so no per-element memcpy call is made
+#define DEFINE_REORDER_KERNELS(T, suffix)                                              \
+    static void reorder_rows_##suffix(size_t begin, size_t end, void* ctx) {           \
+        const ReorderContext* c = ctx;                                                 \
+        const size_t s0 = c->shape[0], s1 = c->shape[1], s2 = c->shape[2];             \
+        const size_t s3 = c->shape[3];                                                 \
+        const size_t t0 = c->strides[0], t1 = c->strides[1], t2 = c->strides[2];       \
+        const size_t t3 = c->strides[3];                                               \
+        const T* src = (const T*)c->src;                                               \
+        T* restrict dst = (T*)c->dst + begin * s3;                                     \
+        size_t i2 = begin % s2, i1 = begin / s2 % s1, i0 = begin / s2 / s1;            \
+        size_t rows = end - begin;                                                     \
+        for (; i0 < s0; i0++, i1 = 0) {                                                \
+            for (; i1 < s1; i1++, i2 = 0) {                                            \
+                for (; i2 < s2; i2++) {                                                \
+                    if (rows-- == 0) {                                                 \
+                        return;                                                        \
+                    }                                                                  \
+                    const T* restrict row = src + i0 * t0 + i1 * t1 + i2 * t2;         \
+                    for (size_t i3 = 0; i3 < s3; i3++) {                               \
+                        dst[i3] = row[i3 * t3];                                        \
+                    }                                                                  \
+                    dst += s3;                                                         \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_REORDER_KERNELS(uint8_t, 1)
+DEFINE_REORDER_KERNELS(uint32_t, 4)
+DEFINE_REORDER_KERNELS(uint64_t, 8)
+DEFINE_REORDER_KERNELS(ReorderElement16, 16)
+
+/**
+ * Gather the data of an array into the order of a permuted shape.
+ *
+ * Arrays of rank FIXED_LOOP_RANK or less walk the destination as a fixed loop
+ * nest over the permuted source strides, split across threads by rows; higher
+ * ranks map every source element to its destination index.
+ *
+ * @param arr The input array.
+ * @param permutation The permutation of the dimensions.
+ * @param new_shape The shape after the permutation.
+ * @return A pointer to the reordered data, or NULL on error.
+ */
 void* reorder_data(Array* arr, size_t* permutation, size_t* new_shape) {
     size_t dsize = get_dtype_size(arr->dtype);
     void* reordered_data = allocate_data_memory(arr->size * dsize);
     if (!reordered_data) {
-        log_error("Failed to allocate memory for reordered data");
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for reordered data");
         return NULL;
     }
+    if (arr->size == 0) {
+        return reordered_data;
+    }
+
+    if (arr->ndim <= FIXED_LOOP_RANK) {
+        ParallelFunc kernel = NULL;
+        switch (dsize) {
+            case 1: kernel = reorder_rows_1; break;
+            case 4: kernel = reorder_rows_4; break;
+            case 8: kernel = reorder_rows_8; break;
+            case 16: kernel = reorder_rows_16; break;
+        }
+        if (kernel) {
+            ReorderContext c = { arr->data, reordered_data, { 1, 1, 1, 1 }, { 0 } };
+            size_t pad = FIXED_LOOP_RANK - arr->ndim;
+            size_t stride = 1;
+            size_t strides[FIXED_LOOP_RANK];
+            for (size_t j = arr->ndim; j-- > 0;) {
+                strides[j] = stride;
+                stride *= arr->shape[j];
+            }
+            for (size_t j = 0; j < arr->ndim; j++) {
+                c.shape[j + pad] = new_shape[j];
+                c.strides[j + pad] = strides[permutation[j]];
+            }
+
+            size_t row_bytes = c.shape[FIXED_LOOP_RANK - 1] * dsize;
+            parallel_for(arr->size / c.shape[FIXED_LOOP_RANK - 1], PARALLEL_GRAIN_BYTES / row_bytes + 1, kernel, &c);
+            return reordered_data;
+        }
+    }
 
     // Compute new strides based on the transposed shape
     size_t* new_strides = calculate_strides(new_shape, arr->ndim);
     if (!new_strides) {
+        free(reordered_data);
         return NULL;
     }
 
@@ -76,15 +169,15 @@ void* reorder_data(Array* arr, size_t* permutation, size_t* new_shape) {
 Array* transpose(Array* arr, size_t* permutation) {
     #if DEBUG_MODE
         if (!arr) {
-            log_error("Array is NULL");
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
             return NULL;
         }
         if (!permutation) {
-            log_error("Permutation is NULL");
+            log_error(ARRAY_ERROR_NULL, "Permutation is NULL");
             return NULL;
         }
         if (arr->ndim < 1) {
-            log_error("Array has less than 1 dimension");
+            log_error(ARRAY_ERROR_SHAPE, "Array has less than 1 dimension");
             return NULL;
         }
     #endif
@@ -96,7 +189,8 @@ Array* transpose(Array* arr, size_t* permutation) {
     }
 
     if (!is_valid_permutation(permutation, arr->ndim)) {
-        log_error("Invalid permutation");
+        free(new_shape);
+        log_error(ARRAY_ERROR_VALUE, "Invalid permutation");
         return NULL;
     }
 
@@ -114,114 +208,113 @@ Array* transpose(Array* arr, size_t* permutation) {
 
     // Only reorder data if more than one dimension exists
     if (arr->ndim > 1) {
+        free(result->data);
         result->data = reorder_data(arr, permutation, new_shape);
         if (!result->data) {
+            free(new_shape);
             free_array(result);
             return NULL;
         }
     }
+    free(new_shape);
     return result;
 }
 
 
+// Output columns summed together by one task, so the slab of every input row stays in cache
+#define SUM_COLUMN_BLOCK 4096
+
+// Work shared by the threads of sum_along_axis: the input is viewed as
+// (outer, len, inner) and the output as (outer, inner)
+typedef struct {
+    const char* input;
+    char* output;
+    size_t len, inner;
+    size_t col_blocks;     // Column blocks per output row
+} SumContext;
+
+// Each task sums one block of output columns of one outer index; rows are
+// added in order, so the result matches a sequential sum
+#define DEFINE_SUM_KERNELS(T, suffix)                                                  \
+    static void sum_tasks_##suffix(size_t begin, size_t end, void* ctx) {              \
+        const SumContext* c = ctx;                                                     \
+        for (size_t task = begin; task < end; task++) {                                \
+            size_t o = task / c->col_blocks;                                           \
+            size_t c0 = task % c->col_blocks * SUM_COLUMN_BLOCK;                       \
+            size_t c1 = c0 + SUM_COLUMN_BLOCK;                                         \
+            if (c1 > c->inner) c1 = c->inner;                                          \
+            const T* src = (const T*)c->input + o * c->len * c->inner;                 \
+            T* restrict dst = (T*)c->output + o * c->inner;                            \
+            if (c->inner == 1) {                                                       \
+                T acc = 0;                                                             \
+                for (size_t j = 0; j < c->len; j++) acc += src[j];                     \
+                dst[0] = acc;                                                          \
+                continue;                                                              \
+            }                                                                          \
+            for (size_t j = 0; j < c->len; j++) {                                      \
+                const T* restrict row = src + j * c->inner;                            \
+                for (size_t col = c0; col < c1; col++) dst[col] += row[col];           \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_SUM_KERNELS(int, int)
+DEFINE_SUM_KERNELS(float, float)
+DEFINE_SUM_KERNELS(double, double)
+
+// Indexed by dtype; TYPE_BOOL has no sum
+static const ParallelFunc sum_kernels[3] = { sum_tasks_int, sum_tasks_float, sum_tasks_double };
+
+/**
+ * Sum the elements of an array along an axis.
+ *
+ * Output rows (or column blocks of them) are split across threads as
+ * contiguous ranges, so each thread reads the slab of input that lives on
+ * its NUMA node.
+ *
+ * @param arr The input array.
+ * @param axis The axis to sum over.
+ * @return A pointer to the new Array structure without that axis, or NULL on error.
+ */
 Array* sum_along_axis(Array* arr, size_t axis) {
     if (!arr) {
-        log_error("Array is NULL");
+        log_error(ARRAY_ERROR_NULL, "Array is NULL");
         return NULL;
     }
     if (axis >= arr->ndim) {
-        log_error("Invalid axis: Out of range");
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
         return NULL;
     }
-
-    // Compute the new shape after reduction
-    size_t* new_shape = malloc((arr->ndim - 1) * sizeof(size_t));
-    if (!new_shape) {
-        log_error("Failed to allocate memory for new shape");
+    if (arr->dtype > TYPE_DOUBLE || arr->dtype == TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
         return NULL;
     }
 
-    size_t new_size = 1;
-    size_t axis_size = arr->shape[axis]; // Elements to sum along this axis
+    // Compute the new shape after reduction
+    size_t new_shape[arr->ndim];
+    SumContext c = { arr->data, NULL, arr->shape[axis], 1, 1 };
+    size_t outer = 1;
     for (size_t i = 0, j = 0; i < arr->ndim; i++) {
         if (i != axis) {
             new_shape[j++] = arr->shape[i];
-            new_size *= arr->shape[i];
         }
-    }
-
-    // Allocate memory for the reduced data
-    size_t dtype_size = get_dtype_size(arr->dtype);
-    void* reduced_data = allocate_data_memory(new_size * dtype_size);
-    if (!reduced_data) {
-        log_error("Failed to allocate memory for reduced data");
-        free(new_shape);
-        return NULL;
-    }
-
-    // Compute strides for accessing elements
-    size_t* strides = calculate_strides(arr->shape, arr->ndim);
-    if (!strides) {
-        free(new_shape);
-        free(reduced_data);
-        return NULL;
-    }
-
-    // Temporary storage for the sum
-    void* temp_sum = malloc(dtype_size);
-    if (!temp_sum) {
-        free(new_shape);
-        free(reduced_data);
-        free(strides);
-        log_error("Failed to allocate memory for temp sum");
-        return NULL;
-    }
-
-    // Iterate and sum along the axis
-    for (size_t i = 0; i < new_size; i++) {
-        size_t base_idx = 0;
-        size_t temp = i;
-        size_t original_indices[arr->ndim];
-
-        // Compute original indices in the non-reduced dimensions
-        for (size_t j = 0, k = 0; j < arr->ndim; j++) {
-            if (j == axis) {
-                original_indices[j] = 0; // Will iterate over this later
-            } else {
-                original_indices[j] = temp % new_shape[k++];
-                temp /= new_shape[k - 1];
-            }
-            base_idx += original_indices[j] * strides[j];
-        }
-
-        // Initialize sum to zero
-        memset(temp_sum, 0, dtype_size);
-
-        // Perform summation using apply_operation
-        for (size_t j = 0; j < axis_size; j++) {
-            original_indices[axis] = j;
-            size_t index = 0;
-            for (size_t k = 0; k < arr->ndim; k++) {
-                index += original_indices[k] * strides[k];
-            }
-
-            apply_operation('+', temp_sum, temp_sum, (char*)arr->data + index * dtype_size, arr->dtype);
+        if (i < axis) {
+            outer *= arr->shape[i];
+        } else if (i > axis) {
+            c.inner *= arr->shape[i];
         }
-
-        // Store result in the reduced data array
-        memcpy((char*)reduced_data + i * dtype_size, temp_sum, dtype_size);
     }
 
-    // Clean up
-    free(strides);
-    free(temp_sum);
-
-    // Create and return the new array
-    Array* result = create_array(arr->dtype, arr->ndim - 1, new_shape, reduced_data);
-    free(new_shape);
+    Array* result = create_array(arr->dtype, arr->ndim - 1, new_shape, NULL);
     if (!result) {
-        free(reduced_data);
+        return NULL;
     }
+    c.output = result->data;
+    c.col_blocks = (c.inner + SUM_COLUMN_BLOCK - 1) / SUM_COLUMN_BLOCK;
+
+    size_t task_bytes = c.len * (c.inner < SUM_COLUMN_BLOCK ? c.inner : SUM_COLUMN_BLOCK) * get_dtype_size(arr->dtype);
+    size_t grain = task_bytes && task_bytes < PARALLEL_GRAIN_BYTES ? PARALLEL_GRAIN_BYTES / task_bytes : 1;
+    parallel_for(outer * c.col_blocks, grain, sum_kernels[arr->dtype], &c);
     return result;
 }
 
@@ -34,7 +34,9 @@ void* get_element(Array* arr, size_t* indices) {
 
 int set_element(Array* arr, size_t* indices, void* value) {
     void* element = get_element(arr, indices);
-    if (element) {
+    if (element && make_array_writable(arr)) {
+        // A shared block was just copied, so the element moved
+        element = get_element(arr, indices);
         memcpy(element, value, get_dtype_size(arr->dtype));
         return 1; // Success
     }
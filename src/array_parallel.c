@@ -0,0 +1,240 @@
+#define _GNU_SOURCE  // For CPU affinity
+#include "array.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <unistd.h>
+
+// Highest NUMA node number probed in sysfs
+#define MAX_NUMA_NODES 64
+
+// Number of worker threads used by parallel_for, 0 means "not yet detected"
+static size_t num_threads = 0;
+
+// Per-thread override of num_threads, 0 means "use num_threads". Worker
+// threads set it to 1 so nested parallel_for calls run inline.
+static _Thread_local size_t thread_num_threads = 0;
+
+size_t get_num_threads() {
+    if (thread_num_threads) {
+        return thread_num_threads;
+    }
+    size_t n = __atomic_load_n(&num_threads, __ATOMIC_RELAXED);
+    if (n == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        n = (online > 0) ? (size_t)online : 1;
+        __atomic_store_n(&num_threads, n, __ATOMIC_RELAXED);
+    }
+    return n;
+}
+
+void set_num_threads(size_t n) {
+    __atomic_store_n(&num_threads, n, __ATOMIC_RELAXED);
+}
+
+void set_thread_num_threads(size_t n) {
+    thread_num_threads = n;
+}
+
+// NUMA nodes that have CPUs, detected once from sysfs
+static struct {
+    size_t n_nodes;
+    cpu_set_t cpus[MAX_NUMA_NODES];
+} topology;
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+
+// Adds the CPUs of a sysfs cpulist such as "0-3,8-11" to a set
+static void parse_cpulist(FILE* file, cpu_set_t* cpus) {
+    unsigned long first, last;
+    int c;
+    while (fscanf(file, "%lu", &first) == 1) {
+        last = first;
+        c = fgetc(file);
+        if (c == '-') {
+            if (fscanf(file, "%lu", &last) != 1) {
+                return;
+            }
+            c = fgetc(file);
+        }
+        for (unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, cpus);
+        }
+        if (c != ',') {
+            return;
+        }
+    }
+}
+
+static void detect_topology() {
+    for (size_t node = 0; node < MAX_NUMA_NODES; node++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu/cpulist", node);
+        FILE* file = fopen(path, "r");
+        if (!file) {
+            continue;
+        }
+        cpu_set_t* cpus = &topology.cpus[topology.n_nodes];
+        CPU_ZERO(cpus);
+        parse_cpulist(file, cpus);
+        fclose(file);
+        // Memory-only nodes run no threads
+        if (CPU_COUNT(cpus) > 0) {
+            topology.n_nodes++;
+        }
+    }
+}
+
+size_t get_numa_nodes() {
+    pthread_once(&topology_once, detect_topology);
+    return topology.n_nodes ? topology.n_nodes : 1;
+}
+
+int bind_thread_to_node(size_t node) {
+    if (get_numa_nodes() < 2) {
+        return 1;
+    }
+    if (node >= topology.n_nodes) {
+        log_error(ARRAY_ERROR_INDEX, "NUMA node out of range");
+        return 0;
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &topology.cpus[node]) == 0;
+}
+
+// Work handed to a single thread
+typedef struct {
+    ParallelFunc body;
+    void* ctx;
+    size_t begin;
+    size_t end;
+    size_t node;             // NUMA node the thread runs on, or SIZE_MAX to leave it unbound
+    ArrayError error;        // Last error raised by a worker thread
+    const char* message;
+} ParallelChunk;
+
+static void* run_chunk(void* arg) {
+    ParallelChunk* chunk = arg;
+    chunk->body(chunk->begin, chunk->end, chunk->ctx);
+    return NULL;
+}
+
+// Entry point of worker threads: keeps nested loops inline and saves the error state for the caller
+static void* run_worker(void* arg) {
+    ParallelChunk* chunk = arg;
+    thread_num_threads = 1;
+    if (chunk->node != SIZE_MAX) {
+        bind_thread_to_node(chunk->node);
+    }
+    run_chunk(chunk);
+    chunk->error = get_last_error();
+    chunk->message = get_last_error_message();
+    return NULL;
+}
+
+/**
+ * Split the range [0, n) into contiguous chunks and run them on separate threads.
+ *
+ * The number of threads is bounded by get_num_threads() and by n / grain, so
+ * small ranges run inline on the calling thread without any thread overhead.
+ * The calling thread processes the first chunk itself. If a thread cannot be
+ * created its chunk is run inline, so the body always covers the whole range.
+ * Errors raised on worker threads are recorded on the calling thread once
+ * they have joined.
+ *
+ * On NUMA machines chunk t of c runs on node t * nodes / c, including the
+ * first one. Every loop over an array thus maps the same fraction of its
+ * range to the same node, so the pages touched first by one loop (see
+ * allocate_data_memory) are processed on their own node by the next.
+ *
+ * @param n Number of iterations.
+ * @param grain Minimum number of iterations per thread.
+ * @param body Function processing a half-open range of iterations.
+ * @param ctx User data passed to every call of body.
+ */
+void parallel_for(size_t n, size_t grain, ParallelFunc body, void* ctx) {
+    if (n == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+
+    size_t n_chunks = n / grain;
+    size_t max_threads = get_num_threads();
+    if (n_chunks > max_threads) {
+        n_chunks = max_threads;
+    }
+    if (n_chunks <= 1) {
+        body(0, n, ctx);
+        return;
+    }
+
+    ParallelChunk chunks[n_chunks];
+    pthread_t threads[n_chunks];
+    int started[n_chunks];
+    size_t n_nodes = get_numa_nodes();
+
+    for (size_t t = 0; t < n_chunks; t++) {
+        chunks[t].body = body;
+        chunks[t].ctx = ctx;
+        chunks[t].begin = n * t / n_chunks;
+        chunks[t].end = n * (t + 1) / n_chunks;
+        chunks[t].node = n_nodes > 1 ? t * n_nodes / n_chunks : SIZE_MAX;
+        chunks[t].error = ARRAY_OK;
+        started[t] = 0;
+    }
+
+    // The calling thread may run on any node, so with NUMA every chunk gets a bound thread
+    size_t first_spawned = n_nodes > 1 ? 0 : 1;
+    for (size_t t = first_spawned; t < n_chunks; t++) {
+        started[t] = pthread_create(&threads[t], NULL, run_worker, &chunks[t]) == 0;
+    }
+
+    if (first_spawned == 1) {
+        run_chunk(&chunks[0]);
+    }
+    for (size_t t = first_spawned; t < n_chunks; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+            if (chunks[t].error != ARRAY_OK) {
+                restore_last_error(chunks[t].error, chunks[t].message);
+            }
+        } else {
+            run_chunk(&chunks[t]);
+        }
+    }
+}
+
+// Arguments for a chunked memcpy
+typedef struct {
+    char* dst;
+    const char* src;
+} CopyContext;
+
+static void copy_range(size_t begin, size_t end, void* ctx) {
+    CopyContext* copy = ctx;
+    memcpy(copy->dst + begin, copy->src + begin, end - begin);
+}
+
+void parallel_memcpy(void* dst, const void* src, size_t n_bytes) {
+    if (dst == src) {
+        return;
+    }
+    CopyContext copy = { dst, src };
+    parallel_for(n_bytes, PARALLEL_GRAIN_BYTES, copy_range, &copy);
+}
+
+// Arguments for a chunked memset
+typedef struct {
+    char* dst;
+    int value;
+} SetContext;
+
+static void set_range(size_t begin, size_t end, void* ctx) {
+    SetContext* set = ctx;
+    memset(set->dst + begin, set->value, end - begin);
+}
+
+void parallel_memset(void* dst, int value, size_t n_bytes) {
+    SetContext set = { dst, value };
+    parallel_for(n_bytes, PARALLEL_GRAIN_BYTES, set_range, &set);
+}
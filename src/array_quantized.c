@@ -0,0 +1,934 @@
+#include "array_quantized.h"
+#include <float.h>
+#include <math.h>
+
+// The matrix product uses the widest 8-bit dot product the compiler targets:
+// VNNI (vpdpbusd) multiplies unsigned by signed bytes and adds groups of four into
+// 32-bit lanes; plain AVX2 widens to 16 bits and uses vpmaddwd instead of
+// vpmaddubsw, whose 16-bit pair sums saturate for 8-bit operands near full range.
+// Other targets use the portable loops.
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+    #include <immintrin.h>
+    #define QGEMM_DPBUSD _mm256_dpbusd_epi32
+#elif defined(__AVXVNNI__)
+    #include <immintrin.h>
+    #define QGEMM_DPBUSD _mm256_dpbusd_avx_epi32
+#elif defined(__AVX2__)
+    #include <immintrin.h>
+    #define QGEMM_MADDWD 1
+#endif
+
+// Elements per task of a per-tensor conversion
+#define QUANT_CHUNK (1 << 16)
+
+// Register tile of the matrix product: MR rows of A times NR columns of B
+#define QGEMM_MR 4
+#define QGEMM_NR 8
+
+// Rows of A packed and multiplied by one task
+#define QGEMM_MC 64
+
+// Groups of four products accumulated in 32 bits before being added to the 64-bit
+// tile; a group adds at most 4 * 255 * 128 to a lane, so this stays below 2^31
+#define QGEMM_FLUSH_GROUPS 8192
+
+// Rows summed in 32 bits by quantized_sum_along_axis before being added to 64-bit totals
+#define QSUM_FLUSH_ROWS (1 << 23)
+
+// Number of columns summed together when the reduced axis is not the last one
+#define QSUM_COLUMN_BLOCK 1024
+
+static const int32_t quant_min[2] = { -128, 0 };
+static const int32_t quant_max[2] = { 127, 255 };
+
+/**
+ * Allocate a quantized array with uninitialized values and parameters.
+ *
+ * @return A pointer to the new QuantizedArray structure, or NULL on error.
+ */
+static QuantizedArray* allocate_quantized(QuantType qtype, size_t ndim, const size_t* shape, size_t axis) {
+    QuantizedArray* q = calloc(1, sizeof(QuantizedArray));
+    if (!q) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for quantized array");
+        return NULL;
+    }
+
+    q->qtype = qtype;
+    q->ndim = ndim;
+    q->axis = axis;
+    q->size = 1;
+    for (size_t i = 0; i < ndim; i++) {
+        q->size *= shape[i];
+    }
+    q->n_params = axis == QUANT_PER_TENSOR ? 1 : shape[axis];
+    q->shape = malloc(ndim * sizeof(size_t));
+    q->data = malloc(q->size ? q->size : 1);
+    q->scales = malloc((q->n_params ? q->n_params : 1) * sizeof(float));
+    q->zero_points = malloc((q->n_params ? q->n_params : 1) * sizeof(int32_t));
+
+    if (!q->shape || !q->data || !q->scales || !q->zero_points) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for quantized array");
+        free_quantized_array(q);
+        return NULL;
+    }
+    memcpy(q->shape, shape, ndim * sizeof(size_t));
+    return q;
+}
+
+/**
+ * Free the memory allocated for a QuantizedArray structure.
+ *
+ * @param q The quantized array (may be NULL).
+ */
+void free_quantized_array(QuantizedArray* q) {
+    if (!q) {
+        return;
+    }
+    free(q->shape);
+    free(q->data);
+    free(q->scales);
+    free(q->zero_points);
+    free(q);
+}
+
+
+// Conversions
+//
+// The array is viewed as (outer, len, inner) with one parameter index per
+// position along len. Per-tensor arrays are viewed as (1, chunks, QUANT_CHUNK)
+// with parameter 0 everywhere, so both cases split across threads along len.
+
+typedef struct {
+    const void* src;
+    void* dst;
+    size_t outer, len, inner, size;
+    int per_tensor;
+    const float* scales;
+    const int32_t* zero_points;
+    double* lo;              // Range pass: minimum and maximum of each position along len
+    double* hi;
+} QuantContext;
+
+static void init_quant_context(QuantContext* c, const size_t* shape, size_t ndim, size_t size, size_t axis) {
+    memset(c, 0, sizeof(*c));
+    c->size = size;
+    c->per_tensor = axis == QUANT_PER_TENSOR;
+    if (c->per_tensor) {
+        c->outer = 1;
+        c->len = (size + QUANT_CHUNK - 1) / QUANT_CHUNK;
+        c->inner = QUANT_CHUNK;
+        return;
+    }
+    c->outer = 1;
+    c->inner = 1;
+    c->len = shape[axis];
+    for (size_t i = 0; i < ndim; i++) {
+        if (i < axis) {
+            c->outer *= shape[i];
+        } else if (i > axis) {
+            c->inner *= shape[i];
+        }
+    }
+}
+
+static void run_conversion(QuantContext* c, size_t elem_size, ParallelFunc kernel) {
+    size_t task_bytes = c->outer * c->inner * elem_size + 1;
+    parallel_for(c->len, PARALLEL_GRAIN_BYTES / task_bytes + 1, kernel, c);
+}
+
+// Visits the contiguous runs [base, base + n) of the positions [begin, end) along
+// len; k is the parameter index of the run
+#define FOR_EACH_RUN(c, begin, end, ...)                                               \
+    for (size_t o = 0; o < (c)->outer; o++) {                                          \
+        for (size_t p = (begin); p < (end); p++) {                                     \
+            size_t base = (o * (c)->len + p) * (c)->inner;                             \
+            size_t n = (c)->size - base < (c)->inner ? (c)->size - base : (c)->inner;  \
+            size_t k = (c)->per_tensor ? 0 : p;                                        \
+            (void)k;                                                                   \
+            __VA_ARGS__                                                                \
+        }                                                                              \
+    }
+
+// NaNs fail both comparisons and are left out of the range
+#define DEFINE_RANGE_KERNEL(T, suffix)                                                 \
+    static void range_##suffix(size_t begin, size_t end, void* ctx) {                  \
+        const QuantContext* c = ctx;                                                   \
+        const T* src = c->src;                                                         \
+        for (size_t p = begin; p < end; p++) {                                         \
+            c->lo[p] = INFINITY;                                                       \
+            c->hi[p] = -INFINITY;                                                      \
+        }                                                                              \
+        FOR_EACH_RUN(c, begin, end, {                                                  \
+            T lo = (T)c->lo[p], hi = (T)c->hi[p];                                      \
+            for (size_t i = 0; i < n; i++) {                                           \
+                T x = src[base + i];                                                   \
+                lo = x < lo ? x : lo;                                                  \
+                hi = x > hi ? x : hi;                                                  \
+            }                                                                          \
+            c->lo[p] = lo;                                                             \
+            c->hi[p] = hi;                                                             \
+        })                                                                             \
+    }
+
+DEFINE_RANGE_KERNEL(float, float)
+DEFINE_RANGE_KERNEL(double, double)
+
+// Values are scaled, shifted by the zero point and clamped in floating point, then
+// rounded to nearest even; NaNs clamp to the lowest value
+#define DEFINE_CONVERT_KERNELS(T, Q, suffix, ROUND)                                    \
+    static void quantize_##suffix(size_t begin, size_t end, void* ctx) {               \
+        const QuantContext* c = ctx;                                                   \
+        const T* src = c->src;                                                         \
+        Q* dst = c->dst;                                                               \
+        T qmin = (Q)-1 > 0 ? 0 : -128, qmax = (Q)-1 > 0 ? 255 : 127;                   \
+        FOR_EACH_RUN(c, begin, end, {                                                  \
+            T inv = (T)(1.0 / c->scales[k]), zero = (T)c->zero_points[k];              \
+            for (size_t i = 0; i < n; i++) {                                           \
+                T v = src[base + i] * inv + zero;                                      \
+                v = v > qmin ? (v < qmax ? v : qmax) : qmin;                           \
+                dst[base + i] = (Q)ROUND(v);                                           \
+            }                                                                          \
+        })                                                                             \
+    }                                                                                  \
+                                                                                       \
+    static void dequantize_##suffix(size_t begin, size_t end, void* ctx) {             \
+        const QuantContext* c = ctx;                                                   \
+        const Q* src = c->src;                                                         \
+        T* dst = c->dst;                                                               \
+        FOR_EACH_RUN(c, begin, end, {                                                  \
+            T scale = (T)c->scales[k];                                                 \
+            int32_t zero = c->zero_points[k];                                          \
+            for (size_t i = 0; i < n; i++) {                                           \
+                dst[base + i] = scale * (T)((int32_t)src[base + i] - zero);            \
+            }                                                                          \
+        })                                                                             \
+    }
+
+DEFINE_CONVERT_KERNELS(float, int8_t, float_int8, nearbyintf)
+DEFINE_CONVERT_KERNELS(float, uint8_t, float_uint8, nearbyintf)
+DEFINE_CONVERT_KERNELS(double, int8_t, double_int8, nearbyint)
+DEFINE_CONVERT_KERNELS(double, uint8_t, double_uint8, nearbyint)
+
+// Indexed by [dtype - TYPE_FLOAT][qtype]
+static const ParallelFunc quantize_kernels[2][2] = {
+    { quantize_float_int8, quantize_float_uint8 },
+    { quantize_double_int8, quantize_double_uint8 },
+};
+static const ParallelFunc dequantize_kernels[2][2] = {
+    { dequantize_float_int8, dequantize_float_uint8 },
+    { dequantize_double_int8, dequantize_double_uint8 },
+};
+
+/**
+ * Choose the scale and zero point of a range of values.
+ *
+ * The range is widened to contain 0 so that zero is represented exactly.
+ *
+ * @return 1 on success, 0 if the range has no finite float scale.
+ */
+static int choose_params(QuantType qtype, double lo, double hi, float* scale, int32_t* zero_point) {
+    lo = lo < 0 ? lo : 0;
+    hi = hi > 0 ? hi : 0;
+    if (qtype == QUANT_INT8) {
+        double m = -lo > hi ? -lo : hi;
+        *scale = (float)(m / 127);
+        *zero_point = 0;
+    } else {
+        *scale = (float)((hi - lo) / 255);
+        if (*scale > 0) {
+            double zero = nearbyint(-lo / *scale);
+            *zero_point = zero > 255 ? 255 : (int32_t)zero;
+        } else {
+            *zero_point = 0;
+        }
+    }
+    if (*scale == 0) {
+        *scale = 1;
+    }
+    return isfinite(*scale) && *scale >= FLT_MIN;
+}
+
+/**
+ * Quantize a TYPE_FLOAT or TYPE_DOUBLE array to 8-bit values.
+ *
+ * A first pass finds the range of each parameter index and a second one
+ * converts the values; both run on multiple threads.
+ *
+ * @param arr The array to quantize.
+ * @param qtype QUANT_INT8 (symmetric) or QUANT_UINT8 (asymmetric).
+ * @param axis The axis with one scale and zero point per index, or QUANT_PER_TENSOR.
+ * @return A pointer to the new QuantizedArray structure, or NULL on error.
+ */
+QuantizedArray* quantize(Array* arr, QuantType qtype, size_t axis) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (arr->dtype != TYPE_FLOAT && arr->dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+    if (qtype != QUANT_INT8 && qtype != QUANT_UINT8) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid quantization type");
+        return NULL;
+    }
+    if (axis != QUANT_PER_TENSOR && axis >= arr->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return NULL;
+    }
+
+    QuantizedArray* q = allocate_quantized(qtype, arr->ndim, arr->shape, axis);
+    if (!q) {
+        return NULL;
+    }
+
+    QuantContext c;
+    init_quant_context(&c, arr->shape, arr->ndim, arr->size, axis);
+    c.src = arr->data;
+    c.dst = q->data;
+    c.lo = malloc((c.len ? c.len : 1) * sizeof(double));
+    c.hi = malloc((c.len ? c.len : 1) * sizeof(double));
+    if (!c.lo || !c.hi) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for quantization ranges");
+        free(c.lo);
+        free(c.hi);
+        free_quantized_array(q);
+        return NULL;
+    }
+
+    size_t elem_size = get_dtype_size(arr->dtype);
+    run_conversion(&c, elem_size, arr->dtype == TYPE_FLOAT ? range_float : range_double);
+    if (c.per_tensor) {
+        for (size_t p = 1; p < c.len; p++) {
+            c.lo[0] = c.lo[p] < c.lo[0] ? c.lo[p] : c.lo[0];
+            c.hi[0] = c.hi[p] > c.hi[0] ? c.hi[p] : c.hi[0];
+        }
+    }
+
+    int ok = 1;
+    for (size_t k = 0; k < q->n_params; k++) {
+        // Empty arrays and all-NaN ranges have lo > hi; choose_params widens them to [0, 0]
+        double lo = c.len ? c.lo[k] : 0, hi = c.len ? c.hi[k] : 0;
+        ok &= isfinite(lo) || lo > 0;
+        ok &= isfinite(hi) || hi < 0;
+        ok &= choose_params(qtype, lo, hi, &q->scales[k], &q->zero_points[k]);
+    }
+    free(c.lo);
+    free(c.hi);
+    if (!ok) {
+        log_error(ARRAY_ERROR_VALUE, "Values cannot be quantized with a finite float scale");
+        free_quantized_array(q);
+        return NULL;
+    }
+
+    c.scales = q->scales;
+    c.zero_points = q->zero_points;
+    run_conversion(&c, elem_size, quantize_kernels[arr->dtype - TYPE_FLOAT][qtype]);
+    return q;
+}
+
+/**
+ * Convert a quantized array back to real values.
+ *
+ * @param q The quantized array.
+ * @param dtype TYPE_FLOAT or TYPE_DOUBLE.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* dequantize(QuantizedArray* q, DataType dtype) {
+    #if DEBUG_MODE
+        if (!q) {
+            log_error(ARRAY_ERROR_NULL, "Quantized array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (dtype != TYPE_FLOAT && dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    Array* result = create_array(dtype, q->ndim, q->shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    QuantContext c;
+    init_quant_context(&c, q->shape, q->ndim, q->size, q->axis);
+    c.src = q->data;
+    c.dst = result->data;
+    c.scales = q->scales;
+    c.zero_points = q->zero_points;
+    run_conversion(&c, get_dtype_size(dtype), dequantize_kernels[dtype - TYPE_FLOAT][q->qtype]);
+    return result;
+}
+
+
+// Element-wise operations
+//
+// Rescaling by a real multiplier M is done in integers: M is stored as
+// multiplier / 2^shift with multiplier below 2^30, and products are rounded
+// to nearest (halves up) by the shift. Sums and differences bring both
+// operands to a common shift so that the whole result is one integer.
+
+typedef struct {
+    const void* a;
+    const void* b;
+    void* out;
+    char op;
+    int32_t zero_a, zero_b, zero_out;
+    int64_t mult_a, mult_b;  // mult_b alone scales products
+    int shift;
+} QuantElementwiseContext;
+
+/**
+ * Find the shift that gives a real multiplier 30 bits of precision.
+ *
+ * @return The shift, at most 62 (tiny multipliers round towards 0).
+ */
+static int requantize_shift(double real) {
+    int exponent;
+    frexp(real, &exponent);
+    int shift = 30 - exponent;
+    return shift > 62 ? 62 : shift;
+}
+
+static int64_t requantize_multiplier(double real, int shift) {
+    return (int64_t)nearbyint(ldexp(real, shift));
+}
+
+static inline int32_t requantize(int64_t acc, int shift, int32_t zero, int32_t lo, int32_t hi) {
+    int64_t half = shift ? (int64_t)1 << (shift - 1) : 0;
+    int64_t v = ((acc + half) >> shift) + zero;
+    return (int32_t)(v < lo ? lo : v > hi ? hi : v);
+}
+
+#define DEFINE_ELEMENTWISE_KERNEL(QA, QB, suffix)                                      \
+    static void elementwise_##suffix(size_t begin, size_t end, void* ctx) {            \
+        const QuantElementwiseContext* c = ctx;                                        \
+        const QA* a = c->a;                                                            \
+        const QB* b = c->b;                                                            \
+        QA* out = c->out;                                                              \
+        int32_t lo = (QA)-1 > 0 ? 0 : -128, hi = (QA)-1 > 0 ? 255 : 127;               \
+        if (c->op == '*') {                                                            \
+            for (size_t i = begin; i < end; i++) {                                     \
+                int64_t acc = ((int32_t)a[i] - c->zero_a)                              \
+                            * ((int32_t)b[i] - c->zero_b);                             \
+                acc *= c->mult_b;                                                      \
+                out[i] = (QA)requantize(acc, c->shift, c->zero_out, lo, hi);           \
+            }                                                                          \
+        } else {                                                                       \
+            for (size_t i = begin; i < end; i++) {                                     \
+                int64_t acc = ((int32_t)a[i] - c->zero_a) * c->mult_a                  \
+                            + ((int32_t)b[i] - c->zero_b) * c->mult_b;                 \
+                out[i] = (QA)requantize(acc, c->shift, c->zero_out, lo, hi);           \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_ELEMENTWISE_KERNEL(int8_t, int8_t, int8_int8)
+DEFINE_ELEMENTWISE_KERNEL(int8_t, uint8_t, int8_uint8)
+DEFINE_ELEMENTWISE_KERNEL(uint8_t, int8_t, uint8_int8)
+DEFINE_ELEMENTWISE_KERNEL(uint8_t, uint8_t, uint8_uint8)
+
+// Indexed by [qtype of a][qtype of b]
+static const ParallelFunc elementwise_kernels[2][2] = {
+    { elementwise_int8_int8, elementwise_int8_uint8 },
+    { elementwise_uint8_int8, elementwise_uint8_uint8 },
+};
+
+/**
+ * Add, subtract or multiply two quantized arrays element-wise.
+ *
+ * @param q_a The first operand, quantized per tensor.
+ * @param q_b The second operand, quantized per tensor, with the shape of q_a.
+ * @param operation_symbol '+', '-' or '*'.
+ * @param out_scale The scale of the result.
+ * @param out_zero_point The zero point of the result.
+ * @return A pointer to the new QuantizedArray structure, or NULL on error.
+ */
+QuantizedArray* quantized_elementwise(QuantizedArray* q_a, QuantizedArray* q_b, char operation_symbol,
+                                      float out_scale, int32_t out_zero_point) {
+    #if DEBUG_MODE
+        if (!q_a || !q_b) {
+            log_error(ARRAY_ERROR_NULL, "One of the quantized arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (operation_symbol != '+' && operation_symbol != '-' && operation_symbol != '*') {
+        log_error(ARRAY_ERROR_VALUE, "Invalid operation symbol");
+        return NULL;
+    }
+    if (q_a->axis != QUANT_PER_TENSOR || q_b->axis != QUANT_PER_TENSOR) {
+        log_error(ARRAY_ERROR_VALUE, "Element-wise operations need per-tensor quantization");
+        return NULL;
+    }
+    if (q_a->ndim != q_b->ndim || memcmp(q_a->shape, q_b->shape, q_a->ndim * sizeof(size_t)) != 0) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+        return NULL;
+    }
+    if (!(out_scale > 0) || isinf(out_scale) ||
+        out_zero_point < quant_min[q_a->qtype] || out_zero_point > quant_max[q_a->qtype]) {
+        log_error(ARRAY_ERROR_VALUE, "Output scale must be positive and the zero point in range");
+        return NULL;
+    }
+
+    QuantElementwiseContext c = {
+        q_a->data, q_b->data, NULL, operation_symbol,
+        q_a->zero_points[0], q_b->zero_points[0], out_zero_point, 0, 0, 0
+    };
+    if (operation_symbol == '*') {
+        double real = (double)q_a->scales[0] * q_b->scales[0] / out_scale;
+        c.shift = requantize_shift(real);
+        c.mult_b = requantize_multiplier(real, c.shift);
+    } else {
+        double real_a = (double)q_a->scales[0] / out_scale;
+        double real_b = (double)q_b->scales[0] / out_scale;
+        c.shift = requantize_shift(real_a > real_b ? real_a : real_b);
+        c.mult_a = requantize_multiplier(real_a, c.shift);
+        c.mult_b = requantize_multiplier(operation_symbol == '-' ? -real_b : real_b, c.shift);
+    }
+    if (c.shift < 0) {
+        log_error(ARRAY_ERROR_VALUE, "Ratio of input to output scale is too large");
+        return NULL;
+    }
+
+    QuantizedArray* result = allocate_quantized(q_a->qtype, q_a->ndim, q_a->shape, QUANT_PER_TENSOR);
+    if (!result) {
+        return NULL;
+    }
+    result->scales[0] = out_scale;
+    result->zero_points[0] = out_zero_point;
+    c.out = result->data;
+    parallel_for(result->size, PARALLEL_GRAIN_BYTES, elementwise_kernels[q_a->qtype][q_b->qtype], &c);
+    return result;
+}
+
+
+// Reductions
+
+// The array is viewed as (outer, len, inner) and reduced along len. When the
+// parameters do not change along len, each output is scale * (sum of q - len * zero
+// point) with the sum taken in integers; otherwise every row is rescaled on its own.
+typedef struct {
+    const void* src;
+    void* dst;
+    DataType dtype;
+    size_t len, inner, col_blocks;
+    const float* scales;
+    const int32_t* zero_points;
+    int params_along_len;    // The quantization axis is the reduced axis
+    size_t param_inner;      // Elements per parameter index, and number of indices
+    size_t param_len;
+} QuantSumContext;
+
+static void store_real(void* dst, DataType dtype, size_t i, double v) {
+    if (dtype == TYPE_FLOAT) {
+        ((float*)dst)[i] = (float)v;
+    } else {
+        ((double*)dst)[i] = v;
+    }
+}
+
+#define DEFINE_QSUM_KERNEL(Q, suffix)                                                  \
+    static void qsum_tasks_##suffix(size_t begin, size_t end, void* ctx) {             \
+        const QuantSumContext* c = ctx;                                                \
+        int32_t part[QSUM_COLUMN_BLOCK];                                               \
+        int64_t total[QSUM_COLUMN_BLOCK];                                              \
+        double real[QSUM_COLUMN_BLOCK];                                                \
+        for (size_t task = begin; task < end; task++) {                                \
+            size_t o = task / c->col_blocks;                                           \
+            size_t c0 = task % c->col_blocks * QSUM_COLUMN_BLOCK;                      \
+            size_t width = c->inner - c0;                                              \
+            width = width < QSUM_COLUMN_BLOCK ? width : QSUM_COLUMN_BLOCK;             \
+            const Q* src = (const Q*)c->src + o * c->len * c->inner + c0;              \
+            if (c->params_along_len) {                                                 \
+                memset(real, 0, width * sizeof(double));                               \
+                for (size_t r = 0; r < c->len; r++) {                                  \
+                    const Q* row = src + r * c->inner;                                 \
+                    double scale = c->scales[r];                                       \
+                    int32_t zero = c->zero_points[r];                                  \
+                    for (size_t col = 0; col < width; col++) {                         \
+                        real[col] += scale * ((int32_t)row[col] - zero);               \
+                    }                                                                  \
+                }                                                                      \
+                for (size_t col = 0; col < width; col++) {                             \
+                    store_real(c->dst, c->dtype, o * c->inner + c0 + col, real[col]);  \
+                }                                                                      \
+                continue;                                                              \
+            }                                                                          \
+            memset(total, 0, width * sizeof(int64_t));                                 \
+            for (size_t r0 = 0; r0 < c->len; r0 += QSUM_FLUSH_ROWS) {                  \
+                size_t r1 = c->len - r0;                                               \
+                r1 = r1 < QSUM_FLUSH_ROWS ? c->len : r0 + QSUM_FLUSH_ROWS;             \
+                memset(part, 0, width * sizeof(int32_t));                              \
+                for (size_t r = r0; r < r1; r++) {                                     \
+                    const Q* row = src + r * c->inner;                                 \
+                    for (size_t col = 0; col < width; col++) {                         \
+                        part[col] += row[col];                                         \
+                    }                                                                  \
+                }                                                                      \
+                for (size_t col = 0; col < width; col++) {                             \
+                    total[col] += part[col];                                           \
+                }                                                                      \
+            }                                                                          \
+            for (size_t col = 0; col < width; col++) {                                 \
+                size_t first = o * c->len * c->inner + c0 + col;                       \
+                size_t k = first / c->param_inner % c->param_len;                      \
+                int64_t v = total[col] - (int64_t)c->len * c->zero_points[k];          \
+                store_real(c->dst, c->dtype, o * c->inner + c0 + col,                  \
+                           (double)c->scales[k] * (double)v);                          \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_QSUM_KERNEL(int8_t, int8)
+DEFINE_QSUM_KERNEL(uint8_t, uint8)
+
+static const ParallelFunc qsum_kernels[2] = { qsum_tasks_int8, qsum_tasks_uint8 };
+
+/**
+ * Sum the real values of a quantized array along an axis.
+ *
+ * @param q The quantized array.
+ * @param axis The axis to reduce.
+ * @param dtype TYPE_FLOAT or TYPE_DOUBLE.
+ * @return A pointer to the new Array structure without that axis, or NULL on error.
+ */
+Array* quantized_sum_along_axis(QuantizedArray* q, size_t axis, DataType dtype) {
+    #if DEBUG_MODE
+        if (!q) {
+            log_error(ARRAY_ERROR_NULL, "Quantized array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (axis >= q->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return NULL;
+    }
+    if (dtype != TYPE_FLOAT && dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    QuantSumContext c = { 0 };
+    size_t outer = 1;
+    c.inner = 1;
+    c.param_inner = 1;
+    for (size_t i = 0; i < q->ndim; i++) {
+        if (i < axis) {
+            outer *= q->shape[i];
+        } else if (i > axis) {
+            c.inner *= q->shape[i];
+        }
+        if (q->axis != QUANT_PER_TENSOR && i > q->axis) {
+            c.param_inner *= q->shape[i];
+        }
+    }
+    c.len = q->shape[axis];
+    c.param_len = q->n_params;
+    c.params_along_len = q->axis == axis;
+    c.scales = q->scales;
+    c.zero_points = q->zero_points;
+    c.src = q->data;
+    c.dtype = dtype;
+
+    size_t out_ndim = q->ndim > 1 ? q->ndim - 1 : 1;
+    size_t out_shape[out_ndim];
+    out_shape[0] = 1;
+    for (size_t i = 0, j = 0; i < q->ndim; i++) {
+        if (i != axis) {
+            out_shape[j++] = q->shape[i];
+        }
+    }
+    Array* result = create_array(dtype, out_ndim, out_shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    c.dst = result->data;
+
+    c.col_blocks = (c.inner + QSUM_COLUMN_BLOCK - 1) / QSUM_COLUMN_BLOCK;
+    size_t task_bytes = c.len * (c.inner < QSUM_COLUMN_BLOCK ? c.inner : QSUM_COLUMN_BLOCK) + 1;
+    parallel_for(outer * c.col_blocks, PARALLEL_GRAIN_BYTES / task_bytes + 1, qsum_kernels[q->qtype], &c);
+    return result;
+}
+
+
+// Matrix product
+//
+// Both operands are brought to the form the 8-bit dot products expect while they
+// are packed: A as unsigned and B as signed bytes, moving the zero points with the
+// values (an int8 A is offset by +128, a uint8 B by -128). The integer product
+// sum_p a'[i][p] * b'[p][j] is then corrected for the zero points with row sums of
+// A' and column sums of B', and only the final value is scaled to a real number.
+//
+// Panels hold groups of four consecutive p: A panels as [group][row][4] and B
+// panels as [group][column][4], so one group of a B panel fills a 32-byte vector
+// of eight columns and one row of an A panel is a broadcast 32-bit word.
+
+typedef struct {
+    const void* a;
+    const void* b;
+    void* c;
+    DataType dtype;
+    QuantType qtype_a, qtype_b;
+    size_t m, n, k, groups;
+    int8_t* b_pack;          // Column panels of B', QGEMM_NR columns each
+    int64_t* col_sums;       // Sums of the columns of B'
+    int32_t zero_a;          // Zero point of A'
+    const int32_t* zero_b;   // Zero points of B' (one per column, or one per tensor)
+    int per_column;
+    double scale_a;
+    const float* scale_b;
+    int failed;
+} QuantMatmulContext;
+
+static void pack_b_panels(size_t begin, size_t end, void* ctx) {
+    QuantMatmulContext* c = ctx;
+    int offset = c->qtype_b == QUANT_UINT8 ? -128 : 0;
+    for (size_t panel = begin; panel < end; panel++) {
+        int8_t* dst = c->b_pack + panel * c->groups * QGEMM_NR * 4;
+        size_t j0 = panel * QGEMM_NR;
+        int64_t sums[QGEMM_NR] = { 0 };
+        for (size_t g = 0; g < c->groups; g++) {
+            for (size_t t = 0; t < QGEMM_NR; t++) {
+                for (size_t u = 0; u < 4; u++) {
+                    size_t p = g * 4 + u, j = j0 + t;
+                    int v = 0;
+                    if (p < c->k && j < c->n) {
+                        v = c->qtype_b == QUANT_UINT8 ? ((const uint8_t*)c->b)[p * c->n + j]
+                                                      : ((const int8_t*)c->b)[p * c->n + j];
+                        v += offset;
+                    }
+                    dst[(g * QGEMM_NR + t) * 4 + u] = (int8_t)v;
+                    sums[t] += v;
+                }
+            }
+        }
+        for (size_t t = 0; t < QGEMM_NR && j0 + t < c->n; t++) {
+            c->col_sums[j0 + t] = sums[t];
+        }
+    }
+}
+
+// Packs rows [i0, i0 + QGEMM_MC) of A' as MR-row panels and sums each row
+static void pack_a_block(const QuantMatmulContext* c, uint8_t* dst, int64_t* row_sums, size_t i0, size_t mc) {
+    int offset = c->qtype_a == QUANT_INT8 ? 128 : 0;
+    for (size_t i = 0; i < (mc + QGEMM_MR - 1) / QGEMM_MR * QGEMM_MR; i++) {
+        uint8_t* panel = dst + (i / QGEMM_MR) * c->groups * QGEMM_MR * 4 + i % QGEMM_MR * 4;
+        int64_t sum = 0;
+        for (size_t p = 0; p < c->groups * 4; p++) {
+            int v = 0;
+            if (i < mc && p < c->k) {
+                v = c->qtype_a == QUANT_INT8 ? ((const int8_t*)c->a)[(i0 + i) * c->k + p]
+                                             : ((const uint8_t*)c->a)[(i0 + i) * c->k + p];
+                v += offset;
+            }
+            panel[p / 4 * QGEMM_MR * 4 + p % 4] = (uint8_t)v;
+            sum += v;
+        }
+        if (i < mc) {
+            row_sums[i] = sum;
+        }
+    }
+}
+
+// Multiplies an MR-row panel of A' by an NR-column panel of B' into tile
+static void qgemm_micro_kernel(size_t groups, const uint8_t* restrict a_panel, const int8_t* restrict b_panel,
+                               int64_t tile[QGEMM_MR][QGEMM_NR]) {
+    memset(tile, 0, QGEMM_MR * QGEMM_NR * sizeof(int64_t));
+    for (size_t g0 = 0; g0 < groups; g0 += QGEMM_FLUSH_GROUPS) {
+        size_t g1 = groups - g0 < QGEMM_FLUSH_GROUPS ? groups : g0 + QGEMM_FLUSH_GROUPS;
+        int32_t acc[QGEMM_MR][QGEMM_NR];
+#if defined(QGEMM_DPBUSD)
+        __m256i sum[QGEMM_MR];
+        for (size_t r = 0; r < QGEMM_MR; r++) {
+            sum[r] = _mm256_setzero_si256();
+        }
+        for (size_t g = g0; g < g1; g++) {
+            __m256i b = _mm256_loadu_si256((const __m256i*)(b_panel + g * QGEMM_NR * 4));
+            for (size_t r = 0; r < QGEMM_MR; r++) {
+                int32_t word;
+                memcpy(&word, a_panel + (g * QGEMM_MR + r) * 4, sizeof(word));
+                sum[r] = QGEMM_DPBUSD(sum[r], _mm256_set1_epi32(word), b);
+            }
+        }
+        for (size_t r = 0; r < QGEMM_MR; r++) {
+            _mm256_storeu_si256((__m256i*)acc[r], sum[r]);
+        }
+#elif defined(QGEMM_MADDWD)
+        // Each half of the B vector holds four columns; vpmaddwd leaves two partial
+        // sums per column, which are paired up once at the end
+        __m256i lo[QGEMM_MR], hi[QGEMM_MR];
+        for (size_t r = 0; r < QGEMM_MR; r++) {
+            lo[r] = _mm256_setzero_si256();
+            hi[r] = _mm256_setzero_si256();
+        }
+        for (size_t g = g0; g < g1; g++) {
+            __m256i b = _mm256_loadu_si256((const __m256i*)(b_panel + g * QGEMM_NR * 4));
+            __m256i b_lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(b));
+            __m256i b_hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(b, 1));
+            for (size_t r = 0; r < QGEMM_MR; r++) {
+                int32_t word;
+                memcpy(&word, a_panel + (g * QGEMM_MR + r) * 4, sizeof(word));
+                __m256i a = _mm256_cvtepu8_epi16(_mm_set1_epi32(word));
+                lo[r] = _mm256_add_epi32(lo[r], _mm256_madd_epi16(a, b_lo));
+                hi[r] = _mm256_add_epi32(hi[r], _mm256_madd_epi16(a, b_hi));
+            }
+        }
+        const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+        for (size_t r = 0; r < QGEMM_MR; r++) {
+            __m256i sum = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(lo[r], hi[r]), order);
+            _mm256_storeu_si256((__m256i*)acc[r], sum);
+        }
+#else
+        memset(acc, 0, sizeof(acc));
+        for (size_t g = g0; g < g1; g++) {
+            const uint8_t* a = a_panel + g * QGEMM_MR * 4;
+            const int8_t* b = b_panel + g * QGEMM_NR * 4;
+            for (size_t r = 0; r < QGEMM_MR; r++) {
+                const uint8_t* x = a + r * 4;
+                for (size_t t = 0; t < QGEMM_NR; t++) {
+                    const int8_t* y = b + t * 4;
+                    acc[r][t] += x[0] * y[0] + x[1] * y[1] + x[2] * y[2] + x[3] * y[3];
+                }
+            }
+        }
+#endif
+        for (size_t r = 0; r < QGEMM_MR; r++) {
+            for (size_t t = 0; t < QGEMM_NR; t++) {
+                tile[r][t] += acc[r][t];
+            }
+        }
+    }
+}
+
+static void qgemm_row_blocks(size_t begin, size_t end, void* ctx) {
+    QuantMatmulContext* c = ctx;
+    uint8_t* a_pack = malloc(QGEMM_MC * c->groups * 4);
+    int64_t row_sums[QGEMM_MC];
+    if (!a_pack) {
+        __atomic_store_n(&c->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    int64_t tile[QGEMM_MR][QGEMM_NR];
+    for (size_t block = begin; block < end; block++) {
+        size_t i0 = block * QGEMM_MC;
+        size_t mc = c->m - i0 < QGEMM_MC ? c->m - i0 : QGEMM_MC;
+        pack_a_block(c, a_pack, row_sums, i0, mc);
+        for (size_t j = 0; j < c->n; j += QGEMM_NR) {
+            const int8_t* b_panel = c->b_pack + j / QGEMM_NR * c->groups * QGEMM_NR * 4;
+            for (size_t i = 0; i < mc; i += QGEMM_MR) {
+                qgemm_micro_kernel(c->groups, a_pack + i * c->groups * 4, b_panel, tile);
+                for (size_t r = 0; r < QGEMM_MR && i + r < mc; r++) {
+                    for (size_t t = 0; t < QGEMM_NR && j + t < c->n; t++) {
+                        size_t col = j + t;
+                        int64_t zero_b = c->zero_b[c->per_column ? col : 0];
+                        int64_t v = tile[r][t] - zero_b * row_sums[i + r]
+                                  - c->zero_a * c->col_sums[col]
+                                  + (int64_t)c->k * c->zero_a * zero_b;
+                        double scale = c->scale_a * c->scale_b[c->per_column ? col : 0];
+                        store_real(c->c, c->dtype, (i0 + i + r) * c->n + col, scale * (double)v);
+                    }
+                }
+            }
+        }
+    }
+    free(a_pack);
+}
+
+/**
+ * Multiply two quantized matrices.
+ *
+ * The 8-bit products are accumulated in integers, split across threads by
+ * blocks of QGEMM_MC rows, and each result is scaled to a real value once.
+ *
+ * @param q_a The (m, k) left operand, quantized per tensor.
+ * @param q_b The (k, n) right operand, quantized per tensor or per column.
+ * @param dtype TYPE_FLOAT or TYPE_DOUBLE.
+ * @return A pointer to the new (m, n) Array structure, or NULL on error.
+ */
+Array* quantized_matmul(QuantizedArray* q_a, QuantizedArray* q_b, DataType dtype) {
+    #if DEBUG_MODE
+        if (!q_a || !q_b) {
+            log_error(ARRAY_ERROR_NULL, "One of the quantized arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (dtype != TYPE_FLOAT && dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+    if (q_a->ndim != 2 || q_b->ndim != 2) {
+        log_error(ARRAY_ERROR_SHAPE, "Array must have two dimensions");
+        return NULL;
+    }
+    if (q_a->shape[1] != q_b->shape[0]) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+        return NULL;
+    }
+    if (q_a->axis != QUANT_PER_TENSOR || (q_b->axis != QUANT_PER_TENSOR && q_b->axis != 1)) {
+        log_error(ARRAY_ERROR_VALUE, "A must be quantized per tensor and B per tensor or per column");
+        return NULL;
+    }
+
+    QuantMatmulContext c = { 0 };
+    c.a = q_a->data;
+    c.b = q_b->data;
+    c.dtype = dtype;
+    c.qtype_a = q_a->qtype;
+    c.qtype_b = q_b->qtype;
+    c.m = q_a->shape[0];
+    c.k = q_a->shape[1];
+    c.n = q_b->shape[1];
+    c.groups = (c.k + 3) / 4;
+    c.per_column = q_b->axis == 1;
+    c.scale_a = q_a->scales[0];
+    c.scale_b = q_b->scales;
+    c.zero_a = q_a->zero_points[0] + (q_a->qtype == QUANT_INT8 ? 128 : 0);
+
+    size_t out_shape[2] = { c.m, c.n };
+    Array* result = create_array(dtype, 2, out_shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    if (result->size == 0 || c.k == 0) {
+        return result;
+    }
+    c.c = result->data;
+
+    size_t panels = (c.n + QGEMM_NR - 1) / QGEMM_NR;
+    int32_t* zero_b = malloc(q_b->n_params * sizeof(int32_t));
+    c.b_pack = malloc(panels * c.groups * QGEMM_NR * 4);
+    c.col_sums = malloc(c.n * sizeof(int64_t));
+    if (!zero_b || !c.b_pack || !c.col_sums) {
+        c.failed = 1;
+    } else {
+        for (size_t j = 0; j < q_b->n_params; j++) {
+            zero_b[j] = q_b->zero_points[j] - (q_b->qtype == QUANT_UINT8 ? 128 : 0);
+        }
+        c.zero_b = zero_b;
+
+        size_t panel_bytes = c.groups * QGEMM_NR * 4;
+        parallel_for(panels, PARALLEL_GRAIN_BYTES / panel_bytes + 1, pack_b_panels, &c);
+        size_t block_ops = QGEMM_MC * c.n * c.k;
+        parallel_for((c.m + QGEMM_MC - 1) / QGEMM_MC, block_ops < (1 << 21) ? (1 << 21) / block_ops : 1,
+                     qgemm_row_blocks, &c);
+    }
+
+    free(zero_b);
+    free(c.b_pack);
+    free(c.col_sums);
+    if (c.failed) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for quantized matrix product");
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
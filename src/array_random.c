@@ -0,0 +1,262 @@
+#include "array.h"
+#include <math.h>
+
+// Philox4x32-10 constants (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+// Philox blocks generated together; the rounds run over the whole batch so the
+// compiler can vectorize them across blocks
+#define PHILOX_BATCH 64
+
+// Distributions, mixed into the counter so that the same seed gives unrelated
+// streams for different distributions
+enum { STREAM_UNIFORM = 1, STREAM_NORMAL, STREAM_INTEGERS };
+
+// Random bits for the blocks [first, first + n) of a stream: x[lane][j] is lane
+// `lane` of block first + j. Each block is a pure function of (seed, stream,
+// block index), so the output does not depend on how blocks are split across threads.
+static void philox_batch(uint64_t seed, uint32_t stream, size_t first, size_t n,
+                         uint32_t x[4][PHILOX_BATCH]) {
+    for (size_t j = 0; j < n; j++) {
+        uint64_t block = first + j;
+        x[0][j] = (uint32_t)block;
+        x[1][j] = (uint32_t)(block >> 32);
+        x[2][j] = stream;
+        x[3][j] = 0;
+    }
+
+    uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        for (size_t j = 0; j < n; j++) {
+            uint64_t p0 = (uint64_t)PHILOX_M0 * x[0][j];
+            uint64_t p1 = (uint64_t)PHILOX_M1 * x[2][j];
+            uint32_t c1 = x[1][j], c3 = x[3][j];
+            x[0][j] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            x[1][j] = (uint32_t)p1;
+            x[2][j] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            x[3][j] = (uint32_t)p0;
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// Uniform values in [0, 1) from 24 or 53 random bits
+static inline float bits_to_float(uint32_t a) {
+    return (float)(a >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline double bits_to_double(uint32_t a, uint32_t b) {
+    return (double)((((uint64_t)a << 32) | b) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Work shared by the threads of a random fill; each task generates whole Philox
+// blocks, and every block yields per_block consecutive elements
+typedef struct {
+    char* data;
+    size_t size;
+    size_t per_block;
+    uint64_t seed;
+    double a, b;         // low/high for uniform, mean/stddev for normal
+    int64_t low;         // random_integers: lower bound
+    uint64_t range;      // random_integers: number of values
+} RandomContext;
+
+// A float block gives four elements, a double block two. offset + scale * u can
+// round up to high, which is then replaced by the largest value below it
+#define DEFINE_UNIFORM_KERNEL(T, suffix, PER_BLOCK, CONVERT, NEXTAFTER)                \
+    static void uniform_blocks_##suffix(size_t begin, size_t end, void* ctx) {         \
+        const RandomContext* c = ctx;                                                  \
+        uint32_t x[4][PHILOX_BATCH];                                                   \
+        T* out = (T*)c->data;                                                          \
+        T scale = (T)(c->b - c->a), offset = (T)c->a;                                  \
+        T high = (T)c->b, below_high = NEXTAFTER(high, offset);                        \
+        int clamp = c->a < c->b;                                                       \
+        for (size_t first = begin; first < end; first += PHILOX_BATCH) {               \
+            size_t n = end - first < PHILOX_BATCH ? end - first : PHILOX_BATCH;        \
+            philox_batch(c->seed, STREAM_UNIFORM, first, n, x);                        \
+            for (size_t j = 0; j < n; j++) {                                           \
+                size_t base = (first + j) * PER_BLOCK;                                 \
+                for (size_t lane = 0; lane < PER_BLOCK && base + lane < c->size; lane++) {\
+                    T v = offset + scale * CONVERT(x, lane, j);                        \
+                    out[base + lane] = clamp && v >= high ? below_high : v;            \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+    }
+
+#define FLOAT_BITS(x, lane, j) bits_to_float((x)[lane][j])
+#define DOUBLE_BITS(x, lane, j) bits_to_double((x)[2 * (lane)][j], (x)[2 * (lane) + 1][j])
+
+DEFINE_UNIFORM_KERNEL(float, float, 4, FLOAT_BITS, nextafterf)
+DEFINE_UNIFORM_KERNEL(double, double, 2, DOUBLE_BITS, nextafter)
+
+// Box-Muller: each block gives two 53-bit uniforms and so one pair of normals;
+// u1 is taken in (0, 1] so its logarithm is finite
+#define DEFINE_NORMAL_KERNEL(T, suffix)                                                \
+    static void normal_blocks_##suffix(size_t begin, size_t end, void* ctx) {          \
+        const RandomContext* c = ctx;                                                  \
+        uint32_t x[4][PHILOX_BATCH];                                                   \
+        T* out = (T*)c->data;                                                          \
+        for (size_t first = begin; first < end; first += PHILOX_BATCH) {               \
+            size_t n = end - first < PHILOX_BATCH ? end - first : PHILOX_BATCH;        \
+            philox_batch(c->seed, STREAM_NORMAL, first, n, x);                         \
+            for (size_t j = 0; j < n; j++) {                                           \
+                double u1 = 1.0 - bits_to_double(x[0][j], x[1][j]);                    \
+                double u2 = bits_to_double(x[2][j], x[3][j]);                          \
+                double r = c->b * sqrt(-2.0 * log(u1));                                \
+                double theta = 2.0 * M_PI * u2;                                        \
+                size_t base = (first + j) * 2;                                         \
+                out[base] = (T)(c->a + r * cos(theta));                                \
+                if (base + 1 < c->size) {                                              \
+                    out[base + 1] = (T)(c->a + r * sin(theta));                        \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_NORMAL_KERNEL(float, float)
+DEFINE_NORMAL_KERNEL(double, double)
+
+// Each block gives two 64-bit values, mapped onto the range with a 64x64-bit
+// multiply; the bias is below range / 2^64
+static void integer_blocks(size_t begin, size_t end, void* ctx) {
+    const RandomContext* c = ctx;
+    uint32_t x[4][PHILOX_BATCH];
+    int* out = (int*)c->data;
+    for (size_t first = begin; first < end; first += PHILOX_BATCH) {
+        size_t n = end - first < PHILOX_BATCH ? end - first : PHILOX_BATCH;
+        philox_batch(c->seed, STREAM_INTEGERS, first, n, x);
+        for (size_t j = 0; j < n; j++) {
+            size_t base = (first + j) * 2;
+            for (size_t lane = 0; lane < 2 && base + lane < c->size; lane++) {
+                uint64_t bits = ((uint64_t)x[2 * lane][j] << 32) | x[2 * lane + 1][j];
+                uint64_t offset = (uint64_t)(((unsigned __int128)bits * c->range) >> 64);
+                out[base + lane] = (int)(c->low + (int64_t)offset);
+            }
+        }
+    }
+}
+
+/**
+ * Create an array and fill it with a random kernel.
+ *
+ * Blocks are split across threads as contiguous ranges, so each thread fills
+ * the pages it first touched.
+ *
+ * @param dtype The data type of the array.
+ * @param ndim The number of dimensions.
+ * @param shape The shape of the array.
+ * @param c The fill context; data and size are set here.
+ * @param kernel The kernel generating a range of Philox blocks.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+static Array* create_random_array(DataType dtype, size_t ndim, size_t* shape,
+                                  RandomContext* c, ParallelFunc kernel) {
+    Array* result = create_array(dtype, ndim, shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    c->data = result->data;
+    c->size = result->size;
+
+    size_t n_blocks = (result->size + c->per_block - 1) / c->per_block;
+    size_t block_bytes = c->per_block * get_dtype_size(dtype);
+    parallel_for(n_blocks, PARALLEL_GRAIN_BYTES / block_bytes, kernel, c);
+    return result;
+}
+
+/**
+ * Create an array of uniformly distributed random values in [low, high).
+ *
+ * Values come from the counter-based Philox4x32-10 generator: element i
+ * depends only on the seed and i, so the result is the same for any number
+ * of threads.
+ *
+ * @param dtype TYPE_FLOAT or TYPE_DOUBLE.
+ * @param ndim The number of dimensions.
+ * @param shape The shape of the array.
+ * @param low The lower bound.
+ * @param high The upper bound.
+ * @param seed The seed of the generator.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* random_uniform(DataType dtype, size_t ndim, size_t* shape, double low, double high, uint64_t seed) {
+    if (dtype != TYPE_FLOAT && dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    RandomContext c = { 0 };
+    c.seed = seed;
+    c.a = low;
+    c.b = high;
+    if (dtype == TYPE_FLOAT) {
+        c.per_block = 4;
+        return create_random_array(dtype, ndim, shape, &c, uniform_blocks_float);
+    }
+    c.per_block = 2;
+    return create_random_array(dtype, ndim, shape, &c, uniform_blocks_double);
+}
+
+/**
+ * Create an array of normally distributed random values.
+ *
+ * Pairs of uniforms from the Philox4x32-10 generator are turned into pairs of
+ * normals with the Box-Muller transform; like random_uniform, the result does
+ * not depend on the number of threads.
+ *
+ * @param dtype TYPE_FLOAT or TYPE_DOUBLE.
+ * @param ndim The number of dimensions.
+ * @param shape The shape of the array.
+ * @param mean The mean of the distribution.
+ * @param stddev The standard deviation of the distribution.
+ * @param seed The seed of the generator.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* random_normal(DataType dtype, size_t ndim, size_t* shape, double mean, double stddev, uint64_t seed) {
+    if (dtype != TYPE_FLOAT && dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+    if (stddev < 0) {
+        log_error(ARRAY_ERROR_VALUE, "stddev is negative");
+        return NULL;
+    }
+
+    RandomContext c = { 0 };
+    c.seed = seed;
+    c.a = mean;
+    c.b = stddev;
+    c.per_block = 2;
+    return create_random_array(dtype, ndim, shape, &c,
+                               dtype == TYPE_FLOAT ? normal_blocks_float : normal_blocks_double);
+}
+
+/**
+ * Create a TYPE_INT array of uniformly distributed random integers in [low, high).
+ *
+ * @param ndim The number of dimensions.
+ * @param shape The shape of the array.
+ * @param low The lowest value.
+ * @param high One past the highest value.
+ * @param seed The seed of the generator.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* random_integers(size_t ndim, size_t* shape, int low, int high, uint64_t seed) {
+    if (low >= high) {
+        log_error(ARRAY_ERROR_VALUE, "low must be less than high");
+        return NULL;
+    }
+
+    RandomContext c = { 0 };
+    c.seed = seed;
+    c.low = low;
+    c.range = (uint64_t)((int64_t)high - low);
+    c.per_block = 2;
+    return create_random_array(TYPE_INT, ndim, shape, &c, integer_blocks);
+}
@@ -0,0 +1,314 @@
+#include "array.h"
+#include <math.h>
+
+// Number of columns whose running sums are updated together when the axis is not
+// the last one; the inner loop runs along contiguous memory across the columns
+#define ROLLING_COLUMN_BLOCK 256
+
+typedef enum { ROLLING_SUM, ROLLING_MEAN, ROLLING_MIN, ROLLING_MAX } RollingOp;
+
+// Work shared by the threads of a rolling operation: the input is viewed as
+// (outer, len, inner) and the output as (outer, out_len, inner)
+typedef struct {
+    const char* input;
+    char* output;
+    size_t len, inner, out_len;
+    size_t window, step;
+    size_t col_blocks;       // Column blocks per outer index (sums)
+    double scale;            // 1 for sums, 1 / window for means
+    int failed;              // Set if a task could not allocate its deque
+} RollingContext;
+
+// Non-finite values in the current window of each column of a block. They are
+// counted instead of summed: once added, a NaN or infinity could not be removed
+// from the running sum again and would spread to every later window.
+typedef struct {
+    size_t nan[ROLLING_COLUMN_BLOCK];
+    size_t pos_inf[ROLLING_COLUMN_BLOCK];
+    size_t neg_inf[ROLLING_COLUMN_BLOCK];
+} NonFiniteCounts;
+
+// Window sums of a block of columns of one outer index. Each window is reached from
+// the previous one by removing the rows that left it and adding the rows that
+// entered, with compensated (Kahan) accumulation so long runs do not drift; windows
+// that do not overlap are summed afresh. Every input row is read at most twice.
+// With HAS_NONFINITE only finite values are summed, and a window holding NaN, or
+// infinities of both signs, is NaN and one holding an infinity is that infinity.
+#define DEFINE_ROLLING_SUM_KERNELS(T, OUT, ACC, suffix, HAS_NONFINITE)                 \
+    static void kahan_add_##suffix(ACC* acc, ACC* comp, const T* row, size_t n,        \
+                                   ACC sign) {                                         \
+        for (size_t col = 0; col < n; col++) {                                         \
+            ACC y = sign * (ACC)row[col] - comp[col];                                  \
+            ACC t = acc[col] + y;                                                      \
+            comp[col] = (t - acc[col]) - y;                                            \
+            acc[col] = t;                                                              \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* Adds a row to the sums, counting its non-finite values instead */               \
+    static void add_row_##suffix(ACC* acc, ACC* comp, NonFiniteCounts* counts,         \
+                                 const T* row, size_t n, ACC sign) {                   \
+        int finite = 1;                                                                \
+        if (HAS_NONFINITE) {                                                           \
+            /* x - x is NaN for NaN and infinities; this test vectorizes */            \
+            for (size_t col = 0; col < n; col++) finite &= row[col] - row[col] == 0;   \
+        }                                                                              \
+        if (finite) {                                                                  \
+            kahan_add_##suffix(acc, comp, row, n, sign);                               \
+            return;                                                                    \
+        }                                                                              \
+        size_t delta = sign > 0 ? 1 : (size_t)-1;                                      \
+        for (size_t col = 0; col < n; col++) {                                         \
+            if (isfinite((double)row[col])) {                                          \
+                kahan_add_##suffix(acc + col, comp + col, row + col, 1, sign);         \
+            } else {                                                                   \
+                double x = (double)row[col];                                           \
+                size_t* count = x != x ? counts->nan                                   \
+                              : x > 0 ? counts->pos_inf : counts->neg_inf;             \
+                count[col] += delta;                                                   \
+            }                                                                          \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static void rolling_sum_tasks_##suffix(size_t begin, size_t end, void* ctx) {      \
+        const RollingContext* c = ctx;                                                 \
+        ACC acc[ROLLING_COLUMN_BLOCK], comp[ROLLING_COLUMN_BLOCK];                     \
+        NonFiniteCounts counts;                                                        \
+        for (size_t task = begin; task < end; task++) {                                \
+            size_t o = task / c->col_blocks;                                           \
+            size_t c0 = task % c->col_blocks * ROLLING_COLUMN_BLOCK;                   \
+            size_t width = c->inner - c0;                                              \
+            width = width < ROLLING_COLUMN_BLOCK ? width : ROLLING_COLUMN_BLOCK;       \
+            const T* src = (const T*)c->input + o * c->len * c->inner + c0;            \
+            OUT* dst = (OUT*)c->output + o * c->out_len * c->inner + c0;               \
+            for (size_t j = 0; j < c->out_len; j++) {                                  \
+                size_t start = j * c->step;                                            \
+                if (j == 0 || c->step >= c->window) {                                  \
+                    memset(acc, 0, width * sizeof(ACC));                               \
+                    memset(comp, 0, width * sizeof(ACC));                              \
+                    if (HAS_NONFINITE) {                                               \
+                        memset(counts.nan, 0, width * sizeof(size_t));                 \
+                        memset(counts.pos_inf, 0, width * sizeof(size_t));             \
+                        memset(counts.neg_inf, 0, width * sizeof(size_t));             \
+                    }                                                                  \
+                    for (size_t r = start; r < start + c->window; r++) {               \
+                        add_row_##suffix(acc, comp, &counts, src + r * c->inner,       \
+                                         width, 1);                                    \
+                    }                                                                  \
+                } else {                                                               \
+                    for (size_t r = start - c->step; r < start; r++) {                 \
+                        add_row_##suffix(acc, comp, &counts, src + r * c->inner,       \
+                                         width, -1);                                   \
+                    }                                                                  \
+                    size_t entered = start - c->step + c->window;                      \
+                    for (size_t r = entered; r < start + c->window; r++) {             \
+                        add_row_##suffix(acc, comp, &counts, src + r * c->inner,       \
+                                         width, 1);                                    \
+                    }                                                                  \
+                }                                                                      \
+                OUT* out = dst + j * c->inner;                                         \
+                for (size_t col = 0; col < width; col++) {                             \
+                    out[col] = (OUT)(c->scale == 1 ? acc[col] : acc[col] * c->scale);  \
+                    if (HAS_NONFINITE && (counts.nan[col] || counts.pos_inf[col] ||    \
+                                          counts.neg_inf[col])) {                      \
+                        int mixed = counts.pos_inf[col] && counts.neg_inf[col];        \
+                        out[col] = (OUT)(counts.nan[col] || mixed ? NAN                \
+                                         : counts.pos_inf[col] ? INFINITY : -INFINITY);\
+                    }                                                                  \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_ROLLING_SUM_KERNELS(int, int, long long, int, 0)
+DEFINE_ROLLING_SUM_KERNELS(int, double, double, int_mean, 0)
+DEFINE_ROLLING_SUM_KERNELS(float, float, double, float, 1)
+DEFINE_ROLLING_SUM_KERNELS(double, double, double, double, 1)
+
+// Window extremes of one line (outer index and column) with a monotonic deque of
+// indices, kept in a ring buffer: an index is dropped from the back once a later
+// element beats it, and from the front once it leaves the window, so the front is
+// always the extreme of the current window and each element is pushed and popped
+// at most once. KEEP(a, b) is true when a stays ahead of a later b.
+#define DEFINE_ROLLING_EXTREME_KERNEL(T, name, KEEP)                                   \
+    static void name(size_t begin, size_t end, void* ctx) {                            \
+        RollingContext* c = ctx;                                                       \
+        size_t capacity = c->window;                                                   \
+        size_t* deque = malloc(capacity * sizeof(size_t));                             \
+        if (!deque) {                                                                  \
+            __atomic_store_n(&c->failed, 1, __ATOMIC_RELAXED);                         \
+            return;                                                                    \
+        }                                                                              \
+        size_t last = (c->out_len - 1) * c->step + c->window;                          \
+        for (size_t line = begin; line < end; line++) {                                \
+            size_t o = line / c->inner, col = line % c->inner;                         \
+            const T* src = (const T*)c->input + o * c->len * c->inner + col;           \
+            T* dst = (T*)c->output + o * c->out_len * c->inner + col;                  \
+            size_t head = 0, count = 0, j = 0;                                         \
+            for (size_t i = 0; i < last; i++) {                                        \
+                T x = src[i * c->inner];                                               \
+                if (count && deque[head] + c->window <= i) {                           \
+                    head = head + 1 == capacity ? 0 : head + 1;                        \
+                    count--;                                                           \
+                }                                                                      \
+                while (count) {                                                        \
+                    size_t back = head + count - 1;                                    \
+                    back = back >= capacity ? back - capacity : back;                  \
+                    if (KEEP(src[deque[back] * c->inner], x)) break;                   \
+                    count--;                                                           \
+                }                                                                      \
+                size_t slot = head + count;                                            \
+                deque[slot >= capacity ? slot - capacity : slot] = i;                  \
+                count++;                                                               \
+                if (i + 1 >= c->window && (i + 1 - c->window) % c->step == 0) {        \
+                    dst[j++ * c->inner] = src[deque[head] * c->inner];                 \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+        free(deque);                                                                   \
+    }
+
+#define KEEP_MIN(a, b) ((a) < (b))
+#define KEEP_MAX(a, b) ((a) > (b))
+
+DEFINE_ROLLING_EXTREME_KERNEL(int, rolling_min_int, KEEP_MIN)
+DEFINE_ROLLING_EXTREME_KERNEL(float, rolling_min_float, KEEP_MIN)
+DEFINE_ROLLING_EXTREME_KERNEL(double, rolling_min_double, KEEP_MIN)
+DEFINE_ROLLING_EXTREME_KERNEL(int, rolling_max_int, KEEP_MAX)
+DEFINE_ROLLING_EXTREME_KERNEL(float, rolling_max_float, KEEP_MAX)
+DEFINE_ROLLING_EXTREME_KERNEL(double, rolling_max_double, KEEP_MAX)
+
+// Kernels indexed by [operation][dtype]; TYPE_BOOL has no rolling operations
+static const ParallelFunc rolling_kernels[4][3] = {
+    { rolling_sum_tasks_int, rolling_sum_tasks_float, rolling_sum_tasks_double },
+    { rolling_sum_tasks_int_mean, rolling_sum_tasks_float, rolling_sum_tasks_double },
+    { rolling_min_int, rolling_min_float, rolling_min_double },
+    { rolling_max_int, rolling_max_float, rolling_max_double },
+};
+
+/**
+ * Apply a rolling-window operation along an axis.
+ *
+ * Window j covers the elements [j * step, j * step + window) of the axis, so
+ * the axis of the result has (n - window) / step + 1 elements. The input is
+ * read in place, without materializing the windows. Sums and means split
+ * their work across threads by blocks of columns, minima and maxima by lines.
+ *
+ * @param arr The input array.
+ * @param axis The axis along which the window slides.
+ * @param window The number of elements in each window.
+ * @param step The distance between the starts of consecutive windows.
+ * @param op The operation.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+static Array* rolling(Array* arr, size_t axis, size_t window, size_t step, RollingOp op) {
+    if (!arr) {
+        log_error(ARRAY_ERROR_NULL, "Array is NULL");
+        return NULL;
+    }
+    if (axis >= arr->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return NULL;
+    }
+    if (arr->dtype > TYPE_DOUBLE || arr->dtype == TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+    if (window == 0 || step == 0 || window > arr->shape[axis]) {
+        log_error(ARRAY_ERROR_VALUE, "Window must be between 1 and the axis length, and step at least 1");
+        return NULL;
+    }
+
+    RollingContext c = { arr->data, NULL, arr->shape[axis], 1, 0, window, step, 0, 1, 0 };
+    size_t outer = 1;
+    for (size_t i = 0; i < arr->ndim; i++) {
+        if (i < axis) {
+            outer *= arr->shape[i];
+        } else if (i > axis) {
+            c.inner *= arr->shape[i];
+        }
+    }
+    c.out_len = (c.len - window) / step + 1;
+
+    size_t shape[arr->ndim];
+    memcpy(shape, arr->shape, arr->ndim * sizeof(size_t));
+    shape[axis] = c.out_len;
+    DataType out_dtype = op == ROLLING_MEAN && arr->dtype == TYPE_INT ? TYPE_DOUBLE : arr->dtype;
+    Array* result = create_array(out_dtype, arr->ndim, shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    c.output = result->data;
+
+    ParallelFunc kernel = rolling_kernels[op][arr->dtype];
+    size_t line_bytes = c.len * get_dtype_size(arr->dtype) + 1;
+    if (op == ROLLING_SUM || op == ROLLING_MEAN) {
+        c.scale = op == ROLLING_MEAN ? 1.0 / window : 1;
+        c.col_blocks = (c.inner + ROLLING_COLUMN_BLOCK - 1) / ROLLING_COLUMN_BLOCK;
+        size_t task_bytes = line_bytes * (c.inner < ROLLING_COLUMN_BLOCK ? c.inner : ROLLING_COLUMN_BLOCK);
+        parallel_for(outer * c.col_blocks, PARALLEL_GRAIN_BYTES / task_bytes + 1, kernel, &c);
+    } else {
+        parallel_for(outer * c.inner, PARALLEL_GRAIN_BYTES / line_bytes + 1, kernel, &c);
+    }
+
+    if (c.failed) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for the rolling window");
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Compute the sum of each window along an axis.
+ *
+ * @param arr The input array.
+ * @param axis The axis along which the window slides.
+ * @param window The number of elements in each window.
+ * @param step The distance between the starts of consecutive windows.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* rolling_sum(Array* arr, size_t axis, size_t window, size_t step) {
+    return rolling(arr, axis, window, step, ROLLING_SUM);
+}
+
+/**
+ * Compute the mean of each window along an axis.
+ *
+ * The mean of a TYPE_INT array is a TYPE_DOUBLE array.
+ *
+ * @param arr The input array.
+ * @param axis The axis along which the window slides.
+ * @param window The number of elements in each window.
+ * @param step The distance between the starts of consecutive windows.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* rolling_mean(Array* arr, size_t axis, size_t window, size_t step) {
+    return rolling(arr, axis, window, step, ROLLING_MEAN);
+}
+
+/**
+ * Compute the minimum of each window along an axis.
+ *
+ * @param arr The input array.
+ * @param axis The axis along which the window slides.
+ * @param window The number of elements in each window.
+ * @param step The distance between the starts of consecutive windows.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* rolling_min(Array* arr, size_t axis, size_t window, size_t step) {
+    return rolling(arr, axis, window, step, ROLLING_MIN);
+}
+
+/**
+ * Compute the maximum of each window along an axis.
+ *
+ * @param arr The input array.
+ * @param axis The axis along which the window slides.
+ * @param window The number of elements in each window.
+ * @param step The distance between the starts of consecutive windows.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* rolling_max(Array* arr, size_t axis, size_t window, size_t step) {
+    return rolling(arr, axis, window, step, ROLLING_MAX);
+}
@@ -0,0 +1,340 @@
+#include "array.h"
+
+// Rows along the scanned axis that are at least this long are split across threads
+#define SCAN_SPLIT_MIN (1 << 16)
+
+// Number of columns scanned together when the axis is not the last one
+#define SCAN_COLUMN_BLOCK 1024
+
+// GCC vector extensions give a portable in-register prefix over four lanes
+#if defined(__GNUC__) && !defined(__clang__)
+    #define SCAN_VECTOR 1
+    typedef int vint4 __attribute__((vector_size(4 * sizeof(int))));
+    typedef float vfloat4 __attribute__((vector_size(4 * sizeof(float))));
+    typedef double vdouble4 __attribute__((vector_size(4 * sizeof(double))));
+    typedef long long vmask4_64 __attribute__((vector_size(4 * sizeof(long long))));
+#else
+    #define SCAN_VECTOR 0
+#endif
+
+// Scans a contiguous run, continuing from *carry and leaving the last value in it.
+//
+// The vector version computes the prefix of four lanes with two shifted
+// additions (Hillis-Steele), then combines it with the carry broadcast from the
+// previous group, so the loop-carried dependency is one operation per four
+// elements instead of one per element.
+#if SCAN_VECTOR
+#define DEFINE_SCAN_RUN(name, type, vtype, mtype, op, identity)                        \
+    static void name(char* out_bytes, const char* in_bytes, size_t n, char* carry_bytes) { \
+        type* out = (type*)out_bytes;                                                  \
+        const type* in = (const type*)in_bytes;                                        \
+        type carry = *(type*)carry_bytes;                                              \
+        const vtype ident = { identity, identity, identity, identity };                \
+        const mtype shift1 = { 4, 0, 1, 2 };                                           \
+        const mtype shift2 = { 4, 5, 0, 1 };                                           \
+        const mtype last = { 3, 3, 3, 3 };                                             \
+        vtype vcarry = { carry, carry, carry, carry };                                 \
+        size_t i = 0;                                                                  \
+        for (; i + 4 <= n; i += 4) {                                                   \
+            vtype v;                                                                   \
+            memcpy(&v, in + i, sizeof(v));                                             \
+            v = v op __builtin_shuffle(v, ident, shift1);                              \
+            v = v op __builtin_shuffle(v, ident, shift2);                              \
+            v = v op vcarry;                                                           \
+            memcpy(out + i, &v, sizeof(v));                                            \
+            vcarry = __builtin_shuffle(v, last);                                       \
+        }                                                                              \
+        carry = vcarry[0];                                                             \
+        for (; i < n; i++) {                                                           \
+            carry = carry op in[i];                                                    \
+            out[i] = carry;                                                            \
+        }                                                                              \
+        *(type*)carry_bytes = carry;                                                   \
+    }
+#else
+#define DEFINE_SCAN_RUN(name, type, vtype, mtype, op, identity)                        \
+    static void name(char* out_bytes, const char* in_bytes, size_t n, char* carry_bytes) { \
+        type* out = (type*)out_bytes;                                                  \
+        const type* in = (const type*)in_bytes;                                        \
+        type carry = *(type*)carry_bytes;                                              \
+        for (size_t i = 0; i < n; i++) {                                               \
+            carry = carry op in[i];                                                    \
+            out[i] = carry;                                                            \
+        }                                                                              \
+        *(type*)carry_bytes = carry;                                                   \
+    }
+#endif
+
+// Applies the running value of all previous blocks to a block scanned on its own.
+#define DEFINE_SCAN_OFFSET(name, type, op)                                             \
+    static void name(char* out_bytes, size_t n, const char* offset_bytes) {            \
+        type* out = (type*)out_bytes;                                                  \
+        const type offset = *(const type*)offset_bytes;                                \
+        for (size_t i = 0; i < n; i++) {                                               \
+            out[i] = offset op out[i];                                                 \
+        }                                                                              \
+    }
+
+// Scans ncols neighbouring columns down the axis; the inner loop runs along
+// contiguous memory and vectorizes across the columns.
+#define DEFINE_SCAN_COLUMNS(name, type, op)                                            \
+    static void name(char* out_bytes, const char* in_bytes, size_t axis_dim,           \
+                     size_t inner, size_t ncols) {                                     \
+        type* out = (type*)out_bytes;                                                  \
+        const type* in = (const type*)in_bytes;                                        \
+        for (size_t c = 0; c < ncols; c++) {                                           \
+            out[c] = in[c];                                                            \
+        }                                                                              \
+        for (size_t j = 1; j < axis_dim; j++) {                                        \
+            type* row = out + j * inner;                                               \
+            const type* prev = row - inner;                                            \
+            const type* src = in + j * inner;                                          \
+            for (size_t c = 0; c < ncols; c++) {                                       \
+                row[c] = prev[c] op src[c];                                            \
+            }                                                                          \
+        }                                                                              \
+    }
+
+typedef struct {
+    void (*run)(char* out, const char* in, size_t n, char* carry);
+    void (*offset)(char* out, size_t n, const char* offset);
+    void (*columns)(char* out, const char* in, size_t axis_dim, size_t inner, size_t ncols);
+    double identity;
+} ScanKernels;
+
+#define DEFINE_SCAN_KERNELS(suffix, type, vtype, mtype, op, identity)                  \
+    DEFINE_SCAN_RUN(scan_run_##suffix, type, vtype, mtype, op, identity)               \
+    DEFINE_SCAN_OFFSET(scan_offset_##suffix, type, op)                                 \
+    DEFINE_SCAN_COLUMNS(scan_columns_##suffix, type, op)
+
+DEFINE_SCAN_KERNELS(sum_int, int, vint4, vint4, +, 0)
+DEFINE_SCAN_KERNELS(sum_float, float, vfloat4, vint4, +, 0.0f)
+DEFINE_SCAN_KERNELS(sum_double, double, vdouble4, vmask4_64, +, 0.0)
+DEFINE_SCAN_KERNELS(prod_int, int, vint4, vint4, *, 1)
+DEFINE_SCAN_KERNELS(prod_float, float, vfloat4, vint4, *, 1.0f)
+DEFINE_SCAN_KERNELS(prod_double, double, vdouble4, vmask4_64, *, 1.0)
+
+#define SCAN_KERNEL_ENTRY(suffix, identity) \
+    { scan_run_##suffix, scan_offset_##suffix, scan_columns_##suffix, identity }
+
+// Kernels indexed by [dtype], one table per operation
+static const ScanKernels sum_kernels[] = {
+    SCAN_KERNEL_ENTRY(sum_int, 0),
+    SCAN_KERNEL_ENTRY(sum_float, 0),
+    SCAN_KERNEL_ENTRY(sum_double, 0),
+};
+static const ScanKernels prod_kernels[] = {
+    SCAN_KERNEL_ENTRY(prod_int, 1),
+    SCAN_KERNEL_ENTRY(prod_float, 1),
+    SCAN_KERNEL_ENTRY(prod_double, 1),
+};
+
+// Stores the identity of a scan in an element of the given dtype
+static void set_identity(char* dst, const ScanKernels* kernels, DataType dtype) {
+    switch (dtype) {
+        case TYPE_INT: *(int*)dst = (int)kernels->identity; break;
+        case TYPE_FLOAT: *(float*)dst = (float)kernels->identity; break;
+        case TYPE_DOUBLE: *(double*)dst = kernels->identity; break;
+        default: break;
+    }
+}
+
+typedef struct {
+    const ScanKernels* kernels;
+    DataType dtype;
+    char* out;
+    const char* in;
+    size_t outer;
+    size_t axis_dim;
+    size_t inner;
+    size_t dtype_size;
+    size_t n_blocks;      // Blocks per row (long-row split) or column blocks per row
+    char* block_totals;   // One element per block (long-row split only)
+} ScanContext;
+
+// Independent contiguous rows, one scan per row
+static void scan_rows(size_t begin, size_t end, void* ctx) {
+    ScanContext* s = ctx;
+    size_t row_bytes = s->axis_dim * s->dtype_size;
+    char carry[sizeof(double)];
+    for (size_t r = begin; r < end; r++) {
+        set_identity(carry, s->kernels, s->dtype);
+        s->kernels->run(s->out + r * row_bytes, s->in + r * row_bytes, s->axis_dim, carry);
+    }
+}
+
+static void block_range(ScanContext* s, size_t block, size_t* start, size_t* len) {
+    *start = s->axis_dim * block / s->n_blocks;
+    *len = s->axis_dim * (block + 1) / s->n_blocks - *start;
+}
+
+// Pass 1 of the block scan: every block is scanned on its own
+static void scan_blocks_local(size_t begin, size_t end, void* ctx) {
+    ScanContext* s = ctx;
+    for (size_t b = begin; b < end; b++) {
+        size_t start, len;
+        block_range(s, b, &start, &len);
+        char* total = s->block_totals + b * s->dtype_size;
+        set_identity(total, s->kernels, s->dtype);
+        s->kernels->run(s->out + start * s->dtype_size, s->in + start * s->dtype_size, len, total);
+    }
+}
+
+// Pass 2 of the block scan: fold in the running value of the preceding blocks
+static void scan_blocks_offset(size_t begin, size_t end, void* ctx) {
+    ScanContext* s = ctx;
+    for (size_t b = begin; b < end; b++) {
+        if (b == 0) {
+            continue;
+        }
+        size_t start, len;
+        block_range(s, b, &start, &len);
+        s->kernels->offset(s->out + start * s->dtype_size, len, s->block_totals + (b - 1) * s->dtype_size);
+    }
+}
+
+// Column blocks of rows whose scanned axis is not the last dimension
+static void scan_column_blocks(size_t begin, size_t end, void* ctx) {
+    ScanContext* s = ctx;
+    size_t row_bytes = s->axis_dim * s->inner * s->dtype_size;
+    for (size_t t = begin; t < end; t++) {
+        size_t o = t / s->n_blocks;
+        size_t c0 = (t - o * s->n_blocks) * SCAN_COLUMN_BLOCK;
+        size_t ncols = (s->inner - c0 < SCAN_COLUMN_BLOCK) ? s->inner - c0 : SCAN_COLUMN_BLOCK;
+        size_t offset = o * row_bytes + c0 * s->dtype_size;
+        s->kernels->columns(s->out + offset, s->in + offset, s->axis_dim, s->inner, ncols);
+    }
+}
+
+/**
+ * Scan contiguous rows of length axis_dim.
+ *
+ * When there are enough rows to keep every thread busy, rows are distributed
+ * over the threads. A few long rows are instead scanned with a two-pass block
+ * scan: each thread scans its block independently, the block totals are
+ * combined serially, and a second parallel pass folds them into each block.
+ */
+static int scan_contiguous(ScanContext* s) {
+    size_t threads = get_num_threads();
+    if (s->outer >= threads || s->axis_dim < SCAN_SPLIT_MIN || threads == 1) {
+        size_t grain = PARALLEL_GRAIN_BYTES / (s->axis_dim * s->dtype_size) + 1;
+        parallel_for(s->outer, grain, scan_rows, s);
+        return 1;
+    }
+
+    s->n_blocks = threads;
+    s->block_totals = malloc(s->n_blocks * s->dtype_size);
+    if (!s->block_totals) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for block totals");
+        return 0;
+    }
+
+    char* out = s->out;
+    const char* in = s->in;
+    size_t row_bytes = s->axis_dim * s->dtype_size;
+    for (size_t r = 0; r < s->outer; r++) {
+        s->out = out + r * row_bytes;
+        s->in = in + r * row_bytes;
+        parallel_for(s->n_blocks, 1, scan_blocks_local, s);
+
+        // Inclusive scan of the block totals, so entry b - 1 is the offset of block b
+        char carry[sizeof(double)];
+        for (size_t b = 1; b < s->n_blocks; b++) {
+            char* total = s->block_totals + b * s->dtype_size;
+            memcpy(carry, total - s->dtype_size, s->dtype_size);
+            s->kernels->run(total, total, 1, carry);
+        }
+
+        parallel_for(s->n_blocks, 1, scan_blocks_offset, s);
+    }
+
+    free(s->block_totals);
+    return 1;
+}
+
+/**
+ * Compute the cumulative sum or product of an array along an axis.
+ *
+ * The array is viewed through its row-major strides as (outer, axis, inner):
+ * the stride of the axis is the inner size and rows along it are
+ * axis_dim * inner elements apart. Boolean arrays are scanned as TYPE_INT.
+ *
+ * @param arr The input array.
+ * @param axis The axis to scan along.
+ * @param operation_symbol '+' for cumsum, '*' for cumprod.
+ * @return A new array of the same shape, or NULL on error.
+ */
+static Array* cumulative(Array* arr, size_t axis, char operation_symbol) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (axis >= arr->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return NULL;
+    }
+
+    DataType dtype = (arr->dtype == TYPE_BOOL) ? TYPE_INT : arr->dtype;
+    if (dtype < TYPE_INT || dtype > TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+    const ScanKernels* kernels = (operation_symbol == '+') ? &sum_kernels[dtype] : &prod_kernels[dtype];
+
+    Array* result = create_array(dtype, arr->ndim, arr->shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    // Boolean masks are widened into the result and scanned in place
+    const char* input = arr->data;
+    if (arr->dtype == TYPE_BOOL) {
+        const unsigned char* mask = arr->data;
+        int* widened = result->data;
+        for (size_t i = 0; i < arr->size; i++) {
+            widened[i] = mask[i];
+        }
+        input = result->data;
+    }
+
+    size_t* strides = calculate_strides(arr->shape, arr->ndim);
+    if (!strides) {
+        free_array(result);
+        return NULL;
+    }
+
+    ScanContext ctx = {
+        .kernels = kernels,
+        .dtype = dtype,
+        .out = result->data,
+        .in = input,
+        .axis_dim = arr->shape[axis],
+        .inner = strides[axis],
+        .outer = arr->size / (arr->shape[axis] * strides[axis]),
+        .dtype_size = get_dtype_size(dtype),
+    };
+    free(strides);
+
+    if (ctx.inner == 1) {
+        if (!scan_contiguous(&ctx)) {
+            free_array(result);
+            return NULL;
+        }
+    } else {
+        ctx.n_blocks = (ctx.inner + SCAN_COLUMN_BLOCK - 1) / SCAN_COLUMN_BLOCK;
+        size_t block_bytes = ctx.axis_dim * SCAN_COLUMN_BLOCK * ctx.dtype_size;
+        parallel_for(ctx.outer * ctx.n_blocks, PARALLEL_GRAIN_BYTES / block_bytes + 1, scan_column_blocks, &ctx);
+    }
+    return result;
+}
+
+Array* cumsum(Array* arr, size_t axis) {
+    return cumulative(arr, axis, '+');
+}
+
+Array* cumprod(Array* arr, size_t axis) {
+    return cumulative(arr, axis, '*');
+}
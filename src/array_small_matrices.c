@@ -0,0 +1,647 @@
+#include "array.h"
+#include <stdint.h>
+#include <math.h>
+
+// Number of matrices processed together. A block of SMALL_LANES matrices is
+// interleaved element-major (structure of arrays): element (i, j) of all of
+// them is contiguous, so every scalar formula below becomes one vector
+// operation across the block.
+#define SMALL_LANES 8
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #define UNROLL _Pragma("GCC unroll 64")
+#elif defined(__clang__)
+    #define UNROLL _Pragma("unroll")
+#else
+    #define UNROLL
+#endif
+
+// Element (i, j) of lane l in an interleaved block of S x S matrices
+#define LANE(block, S, i, j) (block)[((i) * (S) + (j)) * SMALL_LANES + l]
+
+// Sizes with fixed-size kernels
+static int is_small_size(size_t s) {
+    return s == 2 || s == 3 || s == 4 || s == 8;
+}
+
+
+// Interleaving
+
+// Copies up to SMALL_LANES S x S matrices into an interleaved block; missing lanes are identity matrices
+#define DEFINE_INTERLEAVE(T, suffix, S)                                                \
+    static void interleave_##S##_##suffix(const void* in_v, size_t count, void* block_v) { \
+        const T* in = in_v;                                                            \
+        T* block = block_v;                                                            \
+        UNROLL                                                                         \
+        for (size_t e = 0; e < S * S; e++) {                                           \
+            for (size_t l = 0; l < SMALL_LANES; l++) {                                 \
+                block[e * SMALL_LANES + l] = l < count ? in[l * S * S + e]             \
+                                                       : (T)(e % (S + 1) == 0);        \
+            }                                                                          \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static void deinterleave_##S##_##suffix(const void* block_v, size_t count, void* out_v) { \
+        const T* block = block_v;                                                      \
+        T* out = out_v;                                                                \
+        for (size_t l = 0; l < count; l++) {                                           \
+            UNROLL                                                                     \
+            for (size_t e = 0; e < S * S; e++) {                                       \
+                out[l * S * S + e] = block[e * SMALL_LANES + l];                       \
+            }                                                                          \
+        }                                                                              \
+    }
+
+
+// Fixed-size kernels on interleaved blocks
+
+#define DEFINE_SMALL_MATMUL(T, suffix, S)                                              \
+    static void matmul_##S##_##suffix(const void* a_v, const void* b_v, void* c_v) {   \
+        const T* a = a_v;                                                              \
+        const T* b = b_v;                                                              \
+        T* c = c_v;                                                                    \
+        for (size_t i = 0; i < S; i++) {                                               \
+            UNROLL                                                                     \
+            for (size_t j = 0; j < S; j++) {                                           \
+                for (size_t l = 0; l < SMALL_LANES; l++) {                             \
+                    T sum = 0;                                                         \
+                    UNROLL                                                             \
+                    for (size_t k = 0; k < S; k++) {                                   \
+                        sum += LANE(a, S, i, k) * LANE(b, S, k, j);                    \
+                    }                                                                  \
+                    LANE(c, S, i, j) = sum;                                            \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+    }
+
+// Closed-form adjugates. The inverse is written to inv when it is not NULL.
+#define DEFINE_SMALL_INVERSE_2(T, suffix)                                              \
+    static void inverse_2_##suffix(const void* m_v, void* inv_v, void* det_v) {        \
+        const T* m = m_v;                                                              \
+        T* inv = inv_v;                                                                \
+        T* det = det_v;                                                                \
+        for (size_t l = 0; l < SMALL_LANES; l++) {                                     \
+            T a = LANE(m, 2, 0, 0), b = LANE(m, 2, 0, 1);                              \
+            T c = LANE(m, 2, 1, 0), d = LANE(m, 2, 1, 1);                              \
+            T dt = a * d - b * c;                                                      \
+            det[l] = dt;                                                               \
+            if (inv) {                                                                 \
+                T r = 1 / dt;                                                          \
+                LANE(inv, 2, 0, 0) = d * r;                                            \
+                LANE(inv, 2, 0, 1) = -b * r;                                           \
+                LANE(inv, 2, 1, 0) = -c * r;                                           \
+                LANE(inv, 2, 1, 1) = a * r;                                            \
+            }                                                                          \
+        }                                                                              \
+    }
+
+#define DEFINE_SMALL_INVERSE_3(T, suffix)                                              \
+    static void inverse_3_##suffix(const void* m_v, void* inv_v, void* det_v) {        \
+        const T* m = m_v;                                                              \
+        T* inv = inv_v;                                                                \
+        T* det = det_v;                                                                \
+        for (size_t l = 0; l < SMALL_LANES; l++) {                                     \
+            T m00 = LANE(m, 3, 0, 0), m01 = LANE(m, 3, 0, 1), m02 = LANE(m, 3, 0, 2);  \
+            T m10 = LANE(m, 3, 1, 0), m11 = LANE(m, 3, 1, 1), m12 = LANE(m, 3, 1, 2);  \
+            T m20 = LANE(m, 3, 2, 0), m21 = LANE(m, 3, 2, 1), m22 = LANE(m, 3, 2, 2);  \
+            T c00 = m11 * m22 - m12 * m21;                                             \
+            T c01 = m12 * m20 - m10 * m22;                                             \
+            T c02 = m10 * m21 - m11 * m20;                                             \
+            T dt = m00 * c00 + m01 * c01 + m02 * c02;                                  \
+            det[l] = dt;                                                               \
+            if (inv) {                                                                 \
+                T r = 1 / dt;                                                          \
+                LANE(inv, 3, 0, 0) = c00 * r;                                          \
+                LANE(inv, 3, 1, 0) = c01 * r;                                          \
+                LANE(inv, 3, 2, 0) = c02 * r;                                          \
+                LANE(inv, 3, 0, 1) = (m02 * m21 - m01 * m22) * r;                      \
+                LANE(inv, 3, 1, 1) = (m00 * m22 - m02 * m20) * r;                      \
+                LANE(inv, 3, 2, 1) = (m01 * m20 - m00 * m21) * r;                      \
+                LANE(inv, 3, 0, 2) = (m01 * m12 - m02 * m11) * r;                      \
+                LANE(inv, 3, 1, 2) = (m02 * m10 - m00 * m12) * r;                      \
+                LANE(inv, 3, 2, 2) = (m00 * m11 - m01 * m10) * r;                      \
+            }                                                                          \
+        }                                                                              \
+    }
+
+// 4x4 via the 2x2 minors of the top two rows (s) and bottom two rows (c)
+#define DEFINE_SMALL_INVERSE_4(T, suffix)                                              \
+    static void inverse_4_##suffix(const void* m_v, void* inv_v, void* det_v) {        \
+        const T* m = m_v;                                                              \
+        T* inv = inv_v;                                                                \
+        T* det = det_v;                                                                \
+        for (size_t l = 0; l < SMALL_LANES; l++) {                                     \
+            T m00 = LANE(m, 4, 0, 0), m01 = LANE(m, 4, 0, 1);                          \
+            T m02 = LANE(m, 4, 0, 2), m03 = LANE(m, 4, 0, 3);                          \
+            T m10 = LANE(m, 4, 1, 0), m11 = LANE(m, 4, 1, 1);                          \
+            T m12 = LANE(m, 4, 1, 2), m13 = LANE(m, 4, 1, 3);                          \
+            T m20 = LANE(m, 4, 2, 0), m21 = LANE(m, 4, 2, 1);                          \
+            T m22 = LANE(m, 4, 2, 2), m23 = LANE(m, 4, 2, 3);                          \
+            T m30 = LANE(m, 4, 3, 0), m31 = LANE(m, 4, 3, 1);                          \
+            T m32 = LANE(m, 4, 3, 2), m33 = LANE(m, 4, 3, 3);                          \
+            T s0 = m00 * m11 - m10 * m01, s1 = m00 * m12 - m10 * m02;                  \
+            T s2 = m00 * m13 - m10 * m03, s3 = m01 * m12 - m11 * m02;                  \
+            T s4 = m01 * m13 - m11 * m03, s5 = m02 * m13 - m12 * m03;                  \
+            T c5 = m22 * m33 - m32 * m23, c4 = m21 * m33 - m31 * m23;                  \
+            T c3 = m21 * m32 - m31 * m22, c2 = m20 * m33 - m30 * m23;                  \
+            T c1 = m20 * m32 - m30 * m22, c0 = m20 * m31 - m30 * m21;                  \
+            T dt = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;          \
+            det[l] = dt;                                                               \
+            if (inv) {                                                                 \
+                T r = 1 / dt;                                                          \
+                LANE(inv, 4, 0, 0) = ( m11 * c5 - m12 * c4 + m13 * c3) * r;            \
+                LANE(inv, 4, 0, 1) = (-m01 * c5 + m02 * c4 - m03 * c3) * r;            \
+                LANE(inv, 4, 0, 2) = ( m31 * s5 - m32 * s4 + m33 * s3) * r;            \
+                LANE(inv, 4, 0, 3) = (-m21 * s5 + m22 * s4 - m23 * s3) * r;            \
+                LANE(inv, 4, 1, 0) = (-m10 * c5 + m12 * c2 - m13 * c1) * r;            \
+                LANE(inv, 4, 1, 1) = ( m00 * c5 - m02 * c2 + m03 * c1) * r;            \
+                LANE(inv, 4, 1, 2) = (-m30 * s5 + m32 * s2 - m33 * s1) * r;            \
+                LANE(inv, 4, 1, 3) = ( m20 * s5 - m22 * s2 + m23 * s1) * r;            \
+                LANE(inv, 4, 2, 0) = ( m10 * c4 - m11 * c2 + m13 * c0) * r;            \
+                LANE(inv, 4, 2, 1) = (-m00 * c4 + m01 * c2 - m03 * c0) * r;            \
+                LANE(inv, 4, 2, 2) = ( m30 * s4 - m31 * s2 + m33 * s0) * r;            \
+                LANE(inv, 4, 2, 3) = (-m20 * s4 + m21 * s2 - m23 * s0) * r;            \
+                LANE(inv, 4, 3, 0) = (-m10 * c3 + m11 * c1 - m12 * c0) * r;            \
+                LANE(inv, 4, 3, 1) = ( m00 * c3 - m01 * c1 + m02 * c0) * r;            \
+                LANE(inv, 4, 3, 2) = (-m30 * s3 + m31 * s1 - m32 * s0) * r;            \
+                LANE(inv, 4, 3, 3) = ( m20 * s3 - m21 * s1 + m22 * s0) * r;            \
+            }                                                                          \
+        }                                                                              \
+    }
+
+// Gauss-Jordan elimination with partial pivoting for larger sizes. Pivot rows
+// are moved into place by conditional swaps (selects), so every lane follows
+// the same instruction stream whichever row it pivots on.
+#define DEFINE_SMALL_ELIMINATION(T, suffix, S)                                         \
+    static void inverse_##S##_##suffix(const void* m_v, void* inv_v, void* det_v) {    \
+        const T* m = m_v;                                                              \
+        T* inv = inv_v;                                                                \
+        T* det = det_v;                                                                \
+        T a[S * S * SMALL_LANES];                                                      \
+        T b[S * S * SMALL_LANES];                                                      \
+        memcpy(a, m, sizeof(a));                                                       \
+        for (size_t l = 0; l < SMALL_LANES; l++) {                                     \
+            det[l] = 1;                                                                \
+            UNROLL                                                                     \
+            for (size_t e = 0; e < S * S; e++) {                                       \
+                b[e * SMALL_LANES + l] = (T)(e % (S + 1) == 0);                        \
+            }                                                                          \
+        }                                                                              \
+        for (size_t c = 0; c < S; c++) {                                               \
+            for (size_t r = c + 1; r < S; r++) {                                       \
+                for (size_t l = 0; l < SMALL_LANES; l++) {                             \
+                    int swap = fabs(LANE(a, S, r, c)) > fabs(LANE(a, S, c, c));        \
+                    det[l] = swap ? -det[l] : det[l];                                  \
+                    UNROLL                                                             \
+                    for (size_t j = 0; j < S; j++) {                                   \
+                        T x = LANE(a, S, c, j), y = LANE(a, S, r, j);                  \
+                        LANE(a, S, c, j) = swap ? y : x;                               \
+                        LANE(a, S, r, j) = swap ? x : y;                               \
+                        x = LANE(b, S, c, j), y = LANE(b, S, r, j);                    \
+                        LANE(b, S, c, j) = swap ? y : x;                               \
+                        LANE(b, S, r, j) = swap ? x : y;                               \
+                    }                                                                  \
+                }                                                                      \
+            }                                                                          \
+            for (size_t l = 0; l < SMALL_LANES; l++) {                                 \
+                T d = LANE(a, S, c, c);                                                \
+                det[l] *= d;                                                           \
+                /* A zero pivot zeroes its row instead of spreading NaNs */            \
+                T rcp = d == 0 ? 0 : 1 / d;                                            \
+                UNROLL                                                                 \
+                for (size_t j = 0; j < S; j++) {                                       \
+                    LANE(a, S, c, j) *= rcp;                                           \
+                    LANE(b, S, c, j) *= rcp;                                           \
+                }                                                                      \
+            }                                                                          \
+            for (size_t r = 0; r < S; r++) {                                           \
+                if (r == c) continue;                                                  \
+                for (size_t l = 0; l < SMALL_LANES; l++) {                             \
+                    T f = LANE(a, S, r, c);                                            \
+                    UNROLL                                                             \
+                    for (size_t j = 0; j < S; j++) {                                   \
+                        LANE(a, S, r, j) -= f * LANE(a, S, c, j);                      \
+                        LANE(b, S, r, j) -= f * LANE(b, S, c, j);                      \
+                    }                                                                  \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+        if (inv) {                                                                     \
+            memcpy(inv, b, sizeof(b));                                                 \
+        }                                                                              \
+    }
+
+// Transposes count consecutive S x S matrices; only the element width matters
+#define DEFINE_SMALL_TRANSPOSE(T, suffix, S)                                           \
+    static void transpose_##S##_##suffix(const void* in_v, void* out_v, size_t count) { \
+        const T* in = in_v;                                                            \
+        T* out = out_v;                                                                \
+        for (size_t n = 0; n < count; n++, in += S * S, out += S * S) {                \
+            UNROLL                                                                     \
+            for (size_t i = 0; i < S; i++) {                                           \
+                UNROLL                                                                 \
+                for (size_t j = 0; j < S; j++) {                                       \
+                    out[j * S + i] = in[i * S + j];                                    \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+    }
+
+#define DEFINE_SMALL_TRANSPOSES(T, suffix)                                             \
+    DEFINE_SMALL_TRANSPOSE(T, suffix, 2)                                               \
+    DEFINE_SMALL_TRANSPOSE(T, suffix, 3)                                               \
+    DEFINE_SMALL_TRANSPOSE(T, suffix, 4)                                               \
+    DEFINE_SMALL_TRANSPOSE(T, suffix, 8)
+
+DEFINE_SMALL_TRANSPOSES(uint32_t, u32)
+DEFINE_SMALL_TRANSPOSES(uint64_t, u64)
+
+typedef void (*SmallTransposeFunc)(const void* in, void* out, size_t count);
+
+// Indexed by [element width == 8][size index]
+static const SmallTransposeFunc small_transposes[2][4] = {
+    { transpose_2_u32, transpose_3_u32, transpose_4_u32, transpose_8_u32 },
+    { transpose_2_u64, transpose_3_u64, transpose_4_u64, transpose_8_u64 },
+};
+
+#define DEFINE_SMALL_KERNELS(T, suffix)                                                \
+    DEFINE_INTERLEAVE(T, suffix, 2)                                                    \
+    DEFINE_INTERLEAVE(T, suffix, 3)                                                    \
+    DEFINE_INTERLEAVE(T, suffix, 4)                                                    \
+    DEFINE_INTERLEAVE(T, suffix, 8)                                                    \
+    DEFINE_SMALL_MATMUL(T, suffix, 2)                                                  \
+    DEFINE_SMALL_MATMUL(T, suffix, 3)                                                  \
+    DEFINE_SMALL_MATMUL(T, suffix, 4)                                                  \
+    DEFINE_SMALL_MATMUL(T, suffix, 8)                                                  \
+    DEFINE_SMALL_INVERSE_2(T, suffix)                                                  \
+    DEFINE_SMALL_INVERSE_3(T, suffix)                                                  \
+    DEFINE_SMALL_INVERSE_4(T, suffix)                                                  \
+    DEFINE_SMALL_ELIMINATION(T, suffix, 8)
+
+DEFINE_SMALL_KERNELS(float, float)
+DEFINE_SMALL_KERNELS(double, double)
+
+typedef void (*InterleaveFunc)(const void* in, size_t count, void* block);
+typedef void (*SmallMatmulFunc)(const void* a, const void* b, void* c);
+typedef void (*SmallInverseFunc)(const void* m, void* inv, void* det);
+
+typedef struct {
+    InterleaveFunc interleave;
+    InterleaveFunc deinterleave;
+    SmallMatmulFunc matmul;
+    SmallInverseFunc inverse;
+} SmallKernels;
+
+#define SMALL_KERNELS(S, suffix) {                                                     \
+    interleave_##S##_##suffix, deinterleave_##S##_##suffix,                            \
+    matmul_##S##_##suffix, inverse_##S##_##suffix }
+
+// Indexed by [dtype == TYPE_DOUBLE][size index]
+static const SmallKernels small_kernels[2][4] = {
+    { SMALL_KERNELS(2, float), SMALL_KERNELS(3, float), SMALL_KERNELS(4, float), SMALL_KERNELS(8, float) },
+    { SMALL_KERNELS(2, double), SMALL_KERNELS(3, double), SMALL_KERNELS(4, double), SMALL_KERNELS(8, double) },
+};
+
+static size_t small_size_index(size_t s) {
+    return s == 2 ? 0 : s == 3 ? 1 : s == 4 ? 2 : 3;
+}
+
+
+// Batches of interleaved blocks
+
+typedef struct {
+    const SmallKernels* kernels;
+    size_t count;              // Number of matrices
+    size_t matrix_bytes;
+    size_t elem_size;
+    const char* a;
+    const char* b;
+    size_t a_stride, b_stride; // Bytes between consecutive matrices; 0 when one matrix is broadcast
+    const void* a_block;       // Interleaved copy of a broadcast operand
+    const void* b_block;
+    char* out;
+    char* det;
+    int failed;
+} SmallContext;
+
+// Interleaves the operand for block starting at matrix base, or returns the broadcast block
+static const void* load_block(const SmallContext* c, const char* data, size_t stride,
+                              const void* broadcast, size_t base, size_t count, void* block) {
+    if (!stride) {
+        return broadcast;
+    }
+    c->kernels->interleave(data + base * stride, count, block);
+    return block;
+}
+
+static void matmul_blocks(size_t begin, size_t end, void* ctx) {
+    SmallContext* c = ctx;
+    _Alignas(64) double a_block[64 * SMALL_LANES];
+    _Alignas(64) double b_block[64 * SMALL_LANES];
+    _Alignas(64) double c_block[64 * SMALL_LANES];
+    for (size_t block = begin; block < end; block++) {
+        size_t base = block * SMALL_LANES;
+        size_t count = c->count - base < SMALL_LANES ? c->count - base : SMALL_LANES;
+        const void* a = load_block(c, c->a, c->a_stride, c->a_block, base, count, a_block);
+        const void* b = load_block(c, c->b, c->b_stride, c->b_block, base, count, b_block);
+        c->kernels->matmul(a, b, c_block);
+        c->kernels->deinterleave(c_block, count, c->out + base * c->matrix_bytes);
+    }
+}
+
+static void inverse_blocks(size_t begin, size_t end, void* ctx) {
+    SmallContext* c = ctx;
+    _Alignas(64) double m_block[64 * SMALL_LANES];
+    _Alignas(64) double inv_block[64 * SMALL_LANES];
+    _Alignas(64) double det[SMALL_LANES];
+    for (size_t block = begin; block < end; block++) {
+        size_t base = block * SMALL_LANES;
+        size_t count = c->count - base < SMALL_LANES ? c->count - base : SMALL_LANES;
+        c->kernels->interleave(c->a + base * c->matrix_bytes, count, m_block);
+        c->kernels->inverse(m_block, c->out ? inv_block : NULL, det);
+        if (c->out) {
+            // Unused lanes hold identity matrices and never report a zero determinant
+            for (size_t l = 0; l < SMALL_LANES; l++) {
+                double d = c->elem_size == sizeof(double) ? det[l] : ((float*)det)[l];
+                if (d == 0 || !isfinite(d)) {
+                    __atomic_store_n(&c->failed, 1, __ATOMIC_RELAXED);
+                }
+            }
+            c->kernels->deinterleave(inv_block, count, c->out + base * c->matrix_bytes);
+        } else {
+            memcpy(c->det + base * c->elem_size, det, count * c->elem_size);
+        }
+    }
+}
+
+// Checks that arr is a float or double stack of square matrices
+static int is_square_stack(Array* arr) {
+    if (arr->dtype != TYPE_FLOAT && arr->dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return 0;
+    }
+    if (arr->ndim < 2 || arr->shape[arr->ndim - 1] != arr->shape[arr->ndim - 2]) {
+        log_error(ARRAY_ERROR_SHAPE, "Matrix must be square");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Set up a batch of fixed-size kernels for arrays of shape (..., s, s).
+ *
+ * @return 1 if the dtype and size have fixed-size kernels, 0 otherwise.
+ */
+static int small_batch(SmallContext* c, Array* arr) {
+    if ((arr->dtype != TYPE_FLOAT && arr->dtype != TYPE_DOUBLE) || arr->ndim < 2) {
+        return 0;
+    }
+    size_t s = arr->shape[arr->ndim - 1];
+    if (arr->shape[arr->ndim - 2] != s || !is_small_size(s)) {
+        return 0;
+    }
+
+    c->kernels = &small_kernels[arr->dtype == TYPE_DOUBLE][small_size_index(s)];
+    c->elem_size = get_dtype_size(arr->dtype);
+    c->matrix_bytes = s * s * c->elem_size;
+    c->count = arr->size / (s * s);
+    c->a = arr->data;
+    c->a_stride = c->matrix_bytes;
+    return 1;
+}
+
+static void run_small_batch(SmallContext* c, ParallelFunc body) {
+    size_t blocks = (c->count + SMALL_LANES - 1) / SMALL_LANES;
+    size_t block_bytes = SMALL_LANES * c->matrix_bytes;
+    parallel_for(blocks, PARALLEL_GRAIN_BYTES / block_bytes, body, c);
+}
+
+/**
+ * Multiply stacks of 2x2, 3x3, 4x4 or 8x8 float or double matrices with the fixed-size kernels.
+ *
+ * The shapes must already have been checked by matmul; either operand may be
+ * a single matrix, which is interleaved once and reused for every block.
+ *
+ * @param arr_a The left operand, of shape (..., s, s).
+ * @param arr_b The right operand, of shape (..., s, s).
+ * @param result The preallocated result.
+ * @return 1 if the product was computed, 0 if the size or dtype has no fixed-size kernel.
+ */
+int small_matmul(Array* arr_a, Array* arr_b, Array* result) {
+    SmallContext c = { 0 };
+    if (!small_batch(&c, arr_a) || arr_b->shape[arr_b->ndim - 1] != arr_a->shape[arr_a->ndim - 1]) {
+        return 0;
+    }
+
+    _Alignas(64) double broadcast[64 * SMALL_LANES];
+    char copies[SMALL_LANES * c.matrix_bytes];
+    c.count = result->size / (c.matrix_bytes / c.elem_size);
+    c.b = arr_b->data;
+    c.a_stride = arr_a->ndim > 2 || arr_b->ndim == 2 ? c.matrix_bytes : 0;
+    c.b_stride = arr_b->ndim > 2 || arr_a->ndim == 2 ? c.matrix_bytes : 0;
+    if (!c.a_stride || !c.b_stride) {
+        for (size_t l = 0; l < SMALL_LANES; l++) {
+            memcpy(copies + l * c.matrix_bytes, c.a_stride ? c.b : c.a, c.matrix_bytes);
+        }
+        c.kernels->interleave(copies, SMALL_LANES, broadcast);
+        *(c.a_stride ? &c.b_block : &c.a_block) = broadcast;
+    }
+    c.out = result->data;
+    run_small_batch(&c, matmul_blocks);
+    return 1;
+}
+
+/**
+ * Invert a stack of square matrices.
+ *
+ * 2x2, 3x3 and 4x4 float and double matrices use closed-form adjugates and
+ * 8x8 matrices a fully unrolled Gauss-Jordan elimination, each computed on
+ * SMALL_LANES interleaved matrices at once. Other sizes are solved against the
+ * identity with LU.
+ *
+ * @param arr The float or double array of shape (..., n, n).
+ * @return A pointer to a new Array structure holding the inverses, or NULL on error (including singular matrices).
+ */
+Array* inverse(Array* arr) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (!is_square_stack(arr)) {
+        return NULL;
+    }
+
+    SmallContext c = { 0 };
+    if (!small_batch(&c, arr)) {
+        Array* identity = create_array(arr->dtype, arr->ndim, arr->shape, NULL);
+        if (!identity) {
+            return NULL;
+        }
+        size_t n = arr->shape[arr->ndim - 1];
+        for (size_t m = 0; m < identity->size; m += n * n) {
+            for (size_t i = m; i < m + n * n; i += n + 1) {
+                if (arr->dtype == TYPE_FLOAT) {
+                    ((float*)identity->data)[i] = 1;
+                } else {
+                    ((double*)identity->data)[i] = 1;
+                }
+            }
+        }
+        Array* result = solve(arr, identity);
+        free_array(identity);
+        return result;
+    }
+
+    Array* result = create_array(arr->dtype, arr->ndim, arr->shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    c.out = result->data;
+    run_small_batch(&c, inverse_blocks);
+    if (c.failed) {
+        log_error(ARRAY_ERROR_VALUE, "Matrix is singular");
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Compute the determinants of a stack of square matrices.
+ *
+ * 2x2, 3x3, 4x4 and 8x8 float and double matrices use the same fixed-size
+ * kernels as inverse() without forming the inverse. Other sizes use LU: the
+ * determinant is the product of the diagonal of U, negated once per row
+ * interchange.
+ *
+ * @param arr The float or double array of shape (..., n, n).
+ * @return A pointer to a new Array structure of shape (...) (shape (1) for a single matrix), or NULL on error.
+ */
+Array* determinant(Array* arr) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (!is_square_stack(arr)) {
+        return NULL;
+    }
+
+    size_t one = 1;
+    Array* result = create_array(arr->dtype, arr->ndim > 2 ? arr->ndim - 2 : 1,
+                                 arr->ndim > 2 ? arr->shape : &one, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    SmallContext c = { 0 };
+    if (small_batch(&c, arr)) {
+        c.det = result->data;
+        run_small_batch(&c, inverse_blocks);
+        return result;
+    }
+
+    Array* lu = NULL;
+    Array* pivots = NULL;
+    if (!lu_factor(arr, &lu, &pivots)) {
+        free_array(result);
+        return NULL;
+    }
+    size_t n = arr->shape[arr->ndim - 1];
+    const int* piv = pivots->data;
+    for (size_t m = 0; m < result->size; m++) {
+        double det = 1;
+        for (size_t i = 0; i < n; i++) {
+            size_t d = m * n * n + i * (n + 1);
+            det *= arr->dtype == TYPE_FLOAT ? ((float*)lu->data)[d] : ((double*)lu->data)[d];
+            if ((size_t)piv[m * n + i] != i) {
+                det = -det;
+            }
+        }
+        if (arr->dtype == TYPE_FLOAT) {
+            ((float*)result->data)[m] = (float)det;
+        } else {
+            ((double*)result->data)[m] = det;
+        }
+    }
+    free_array(lu);
+    free_array(pivots);
+    return result;
+}
+
+// Transposes the matrices [begin, end) with the fixed-size or generic loop
+typedef struct {
+    SmallTransposeFunc fixed;
+    size_t m, n;
+    size_t elem_size;
+    const char* in;
+    char* out;
+} TransposeContext;
+
+static void transpose_matrices(size_t begin, size_t end, void* ctx) {
+    TransposeContext* c = ctx;
+    size_t matrix_bytes = c->m * c->n * c->elem_size;
+    if (c->fixed) {
+        c->fixed(c->in + begin * matrix_bytes, c->out + begin * matrix_bytes, end - begin);
+        return;
+    }
+    for (size_t k = begin; k < end; k++) {
+        const char* in = c->in + k * matrix_bytes;
+        char* out = c->out + k * matrix_bytes;
+        for (size_t i = 0; i < c->m; i++) {
+            for (size_t j = 0; j < c->n; j++) {
+                memcpy(out + (j * c->m + i) * c->elem_size, in + (i * c->n + j) * c->elem_size, c->elem_size);
+            }
+        }
+    }
+}
+
+/**
+ * Transpose every matrix of a stack, swapping the last two axes.
+ *
+ * Square 2x2, 3x3, 4x4 and 8x8 matrices of 4- or 8-byte elements use fully
+ * unrolled copies; other shapes use a generic loop.
+ *
+ * @param arr The array of shape (..., m, n).
+ * @return A pointer to a new Array structure of shape (..., n, m), or NULL on error.
+ */
+Array* matrix_transpose(Array* arr) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (arr->ndim < 2) {
+        log_error(ARRAY_ERROR_SHAPE, "Array must have at least two dimensions");
+        return NULL;
+    }
+
+    size_t shape[arr->ndim];
+    memcpy(shape, arr->shape, arr->ndim * sizeof(size_t));
+    shape[arr->ndim - 2] = arr->shape[arr->ndim - 1];
+    shape[arr->ndim - 1] = arr->shape[arr->ndim - 2];
+    Array* result = create_array(arr->dtype, arr->ndim, shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    TransposeContext c = {
+        NULL, arr->shape[arr->ndim - 2], arr->shape[arr->ndim - 1], get_dtype_size(arr->dtype),
+        arr->data, result->data
+    };
+    if (c.m == c.n && is_small_size(c.m) && (c.elem_size == 4 || c.elem_size == 8)) {
+        c.fixed = small_transposes[c.elem_size == 8][small_size_index(c.m)];
+    }
+    size_t matrix_bytes = c.m * c.n * c.elem_size;
+    size_t grain = matrix_bytes < PARALLEL_GRAIN_BYTES ? PARALLEL_GRAIN_BYTES / matrix_bytes : 1;
+    parallel_for(arr->size / (c.m * c.n), grain, transpose_matrices, &c);
+    return result;
+}
@@ -0,0 +1,1052 @@
+#include "array.h"
+#include <math.h>
+
+// GEMM register tile: MR rows of A times NR columns of B are accumulated in registers
+#define GEMM_MR 4
+#define GEMM_NR 8
+
+// GEMM cache blocks: an MC x KC block of A stays in L2 while it is multiplied
+// by KC x NC blocks of B that stream through
+#define GEMM_MC 64
+#define GEMM_KC 256
+#define GEMM_NC 512
+
+// Products with at most this many multiply-adds skip packing and use direct loops
+#define GEMM_DIRECT_MAX (1 << 15)
+
+// Products with at least this many multiply-adds are split across threads
+#define GEMM_PARALLEL_MIN (1 << 21)
+
+// Panel width of the blocked factorizations and triangular solves
+#define SOLVER_BLOCK 64
+
+// Batched matrices are handed to threads in groups of at least this many flops
+#define SOLVER_GRAIN_FLOPS (1 << 16)
+
+
+// GEMM
+//
+// C += alpha * op(A) * op(B) on row-major matrices with leading dimensions,
+// where op() optionally transposes. Blocks of op(A) and op(B) are packed into
+// contiguous MR-row and NR-column panels (zero padded), so the register tile
+// reads both operands sequentially whatever their layout or transposition.
+// Threads split the rows of C into MC blocks and never write the same element.
+
+typedef struct {
+    size_t m, n, k;
+    double alpha;
+    const void* a;
+    size_t lda;
+    int trans_a;
+    const void* b;
+    size_t ldb;
+    int trans_b;
+    void* c;
+    size_t ldc;
+    int failed;            // Set by a thread that could not allocate its packing buffers
+} GemmContext;
+
+typedef int (*GemmFunc)(size_t m, size_t n, size_t k, double alpha,
+                         const void* a, size_t lda, int trans_a,
+                         const void* b, size_t ldb, int trans_b,
+                         void* c, size_t ldc, int threaded);
+
+#define ROUND_UP(x, to) (((x) + (to) - 1) / (to) * (to))
+
+#define DEFINE_GEMM_KERNELS(T, suffix)                                                 \
+    static void pack_a_##suffix(T* dst, const GemmContext* g, size_t i0, size_t mc,    \
+                                size_t p0, size_t kc) {                                \
+        const T* a = g->a;                                                             \
+        for (size_t i = 0; i < ROUND_UP(mc, GEMM_MR); i++) {                           \
+            T* panel = dst + (i / GEMM_MR) * kc * GEMM_MR + i % GEMM_MR;               \
+            for (size_t p = 0; p < kc; p++) {                                          \
+                panel[p * GEMM_MR] = i >= mc ? 0 : g->trans_a                          \
+                    ? a[(p0 + p) * g->lda + i0 + i] : a[(i0 + i) * g->lda + p0 + p];   \
+            }                                                                          \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static void pack_b_##suffix(T* dst, const GemmContext* g, size_t p0, size_t kc,    \
+                                size_t j0, size_t nc) {                                \
+        const T* b = g->b;                                                             \
+        for (size_t p = 0; p < kc; p++) {                                              \
+            for (size_t j = 0; j < ROUND_UP(nc, GEMM_NR); j++) {                       \
+                dst[(j / GEMM_NR) * kc * GEMM_NR + p * GEMM_NR + j % GEMM_NR] =        \
+                    j >= nc ? 0 : g->trans_b                                           \
+                    ? b[(j0 + j) * g->ldb + p0 + p] : b[(p0 + p) * g->ldb + j0 + j];   \
+            }                                                                          \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* Multiplies an MR-row panel of A by an NR-column panel of B into C */            \
+    static void micro_kernel_##suffix(size_t kc, T alpha, const T* restrict a_panel,   \
+                                      const T* restrict b_panel, T* c, size_t ldc,     \
+                                      size_t mr, size_t nr) {                          \
+        T acc[GEMM_MR][GEMM_NR] = { { 0 } };                                           \
+        for (size_t p = 0; p < kc; p++) {                                              \
+            const T* a = a_panel + p * GEMM_MR;                                        \
+            const T* b = b_panel + p * GEMM_NR;                                        \
+            for (size_t r = 0; r < GEMM_MR; r++) {                                     \
+                for (size_t t = 0; t < GEMM_NR; t++) {                                 \
+                    acc[r][t] += a[r] * b[t];                                          \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+        for (size_t r = 0; r < mr; r++) {                                              \
+            for (size_t t = 0; t < nr; t++) {                                          \
+                c[r * ldc + t] += alpha * acc[r][t];                                   \
+            }                                                                          \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static void gemm_row_blocks_##suffix(size_t begin, size_t end, void* ctx) {        \
+        const GemmContext* g = ctx;                                                    \
+        T alpha = (T)g->alpha;                                                         \
+        T* a_pack = malloc(GEMM_MC * GEMM_KC * sizeof(T));                             \
+        T* b_pack = malloc(GEMM_KC * GEMM_NC * sizeof(T));                             \
+        if (!a_pack || !b_pack) {                                                      \
+            __atomic_store_n(&((GemmContext*)ctx)->failed, 1, __ATOMIC_RELAXED);       \
+            free(a_pack);                                                              \
+            free(b_pack);                                                              \
+            return;                                                                    \
+        }                                                                              \
+        for (size_t block = begin; block < end; block++) {                             \
+            size_t i0 = block * GEMM_MC;                                               \
+            size_t mc = g->m - i0 < GEMM_MC ? g->m - i0 : GEMM_MC;                     \
+            for (size_t p0 = 0; p0 < g->k; p0 += GEMM_KC) {                            \
+                size_t kc = g->k - p0 < GEMM_KC ? g->k - p0 : GEMM_KC;                 \
+                pack_a_##suffix(a_pack, g, i0, mc, p0, kc);                            \
+                for (size_t j0 = 0; j0 < g->n; j0 += GEMM_NC) {                        \
+                    size_t nc = g->n - j0 < GEMM_NC ? g->n - j0 : GEMM_NC;             \
+                    pack_b_##suffix(b_pack, g, p0, kc, j0, nc);                        \
+                    for (size_t j = 0; j < nc; j += GEMM_NR) {                         \
+                        for (size_t i = 0; i < mc; i += GEMM_MR) {                     \
+                            T* c = (T*)g->c + (i0 + i) * g->ldc + j0 + j;              \
+                            micro_kernel_##suffix(kc, alpha, a_pack + i * kc,          \
+                                b_pack + j * kc, c, g->ldc,                            \
+                                mc - i < GEMM_MR ? mc - i : GEMM_MR,                   \
+                                nc - j < GEMM_NR ? nc - j : GEMM_NR);                  \
+                        }                                                              \
+                    }                                                                  \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+        free(a_pack);                                                                  \
+        free(b_pack);                                                                  \
+    }                                                                                  \
+                                                                                       \
+    /* Returns 0 if the packing buffers cannot be allocated */                         \
+    static int gemm_##suffix(size_t m, size_t n, size_t k, double alpha,               \
+                             const void* a, size_t lda, int trans_a,                   \
+                             const void* b, size_t ldb, int trans_b,                   \
+                             void* c, size_t ldc, int threaded) {                      \
+        if (m == 0 || n == 0 || k == 0) {                                              \
+            return 1;                                                                  \
+        }                                                                              \
+        if (m * n * k <= GEMM_DIRECT_MAX) {                                            \
+            const T* pa = a;                                                           \
+            const T* pb = b;                                                           \
+            for (size_t i = 0; i < m; i++) {                                           \
+                T* restrict row = (T*)c + i * ldc;                                     \
+                for (size_t p = 0; p < k; p++) {                                       \
+                    T s = (T)alpha * (trans_a ? pa[p * lda + i] : pa[i * lda + p]);    \
+                    if (trans_b) {                                                     \
+                        for (size_t j = 0; j < n; j++) row[j] += s * pb[j * ldb + p];  \
+                    } else {                                                           \
+                        const T* restrict b_row = pb + p * ldb;                        \
+                        for (size_t j = 0; j < n; j++) row[j] += s * b_row[j];         \
+                    }                                                                  \
+                }                                                                      \
+            }                                                                          \
+            return 1;                                                                  \
+        }                                                                              \
+        GemmContext g = { m, n, k, alpha, a, lda, trans_a, b, ldb, trans_b,            \
+                          c, ldc, 0 };                                                 \
+        size_t blocks = (m + GEMM_MC - 1) / GEMM_MC;                                   \
+        if (threaded && m * n * k >= GEMM_PARALLEL_MIN) {                              \
+            parallel_for(blocks, 1, gemm_row_blocks_##suffix, &g);                     \
+        } else {                                                                       \
+            gemm_row_blocks_##suffix(0, blocks, &g);                                   \
+        }                                                                              \
+        if (g.failed) {                                                                \
+            log_error(ARRAY_ERROR_MEMORY,                                              \
+                      "Failed to allocate memory for matrix product");                 \
+            return 0;                                                                  \
+        }                                                                              \
+        return 1;                                                                      \
+    }
+
+DEFINE_GEMM_KERNELS(int, int)
+DEFINE_GEMM_KERNELS(float, float)
+DEFINE_GEMM_KERNELS(double, double)
+
+// Indexed by dtype; TYPE_BOOL has no matrix product
+static const GemmFunc gemm_kernels[3] = { gemm_int, gemm_float, gemm_double };
+
+/**
+ * Compute C += alpha * op(A) * op(B) on row-major matrices.
+ *
+ * @param dtype TYPE_INT, TYPE_FLOAT or TYPE_DOUBLE.
+ * @param m Rows of op(A) and C.
+ * @param n Columns of op(B) and C.
+ * @param k Columns of op(A) and rows of op(B).
+ * @param alpha Scale of the product.
+ * @param a Matrix A with leading dimension lda; op(A) = A^T when trans_a is set.
+ * @param b Matrix B with leading dimension ldb; op(B) = B^T when trans_b is set.
+ * @param c Matrix C with leading dimension ldc, accumulated into.
+ * @param threaded Whether large products may be split across threads.
+ * @return 1 on success, 0 on error.
+ */
+int gemm(DataType dtype, size_t m, size_t n, size_t k, double alpha,
+         const void* a, size_t lda, int trans_a, const void* b, size_t ldb, int trans_b,
+         void* c, size_t ldc, int threaded) {
+    if (dtype > TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return 0;
+    }
+    return gemm_kernels[dtype](m, n, k, alpha, a, lda, trans_a, b, ldb, trans_b, c, ldc, threaded);
+}
+
+
+// Factorization kernels
+//
+// All kernels work in place on row-major n x n (or m x n) matrices and spend
+// most of their flops in GEMM updates of the trailing matrix, leaving only
+// SOLVER_BLOCK-wide panels to the unblocked loops.
+
+#define DEFINE_SOLVER_KERNELS(T, suffix, SQRT)                                         \
+    /* Solves op(A) X = B in place for a triangular n x n A and n x k B.             */ \
+    /* Returns ARRAY_ERROR_VALUE when a diagonal element is zero.                    */ \
+    static ArrayError trsm_##suffix(const void* a_mat, size_t n, size_t lda,           \
+                                    void* b_mat, size_t k, size_t ldb, int lower,      \
+                                    int unit, int threaded) {                          \
+        const T* a = a_mat;                                                            \
+        T* b = b_mat;                                                                  \
+        for (size_t done = 0; done < n; done += SOLVER_BLOCK) {                        \
+            size_t nb = n - done < SOLVER_BLOCK ? n - done : SOLVER_BLOCK;             \
+            size_t i0 = lower ? done : n - done - nb;                                  \
+            for (size_t s = 0; s < nb; s++) {                                          \
+                size_t r = lower ? i0 + s : i0 + nb - 1 - s;                           \
+                T* restrict x = b + r * ldb;                                           \
+                size_t t0 = lower ? i0 : r + 1;                                        \
+                size_t t1 = lower ? r : i0 + nb;                                       \
+                for (size_t t = t0; t < t1; t++) {                                     \
+                    const T l = a[r * lda + t];                                        \
+                    const T* restrict y = b + t * ldb;                                 \
+                    for (size_t j = 0; j < k; j++) x[j] -= l * y[j];                   \
+                }                                                                      \
+                if (!unit) {                                                           \
+                    const T d = a[r * lda + r];                                        \
+                    if (d == 0) {                                                      \
+                        return ARRAY_ERROR_VALUE;                                      \
+                    }                                                                  \
+                    for (size_t j = 0; j < k; j++) x[j] /= d;                          \
+                }                                                                      \
+            }                                                                          \
+            /* Remove the solved rows from the rows still to be solved */              \
+            int ok = 1;                                                                \
+            if (lower && i0 + nb < n) {                                                \
+                ok = gemm_##suffix(n - i0 - nb, k, nb, -1, a + (i0 + nb) * lda + i0,   \
+                                   lda, 0, b + i0 * ldb, ldb, 0, b + (i0 + nb) * ldb,  \
+                                   ldb, threaded);                                     \
+            } else if (!lower && i0 > 0) {                                             \
+                ok = gemm_##suffix(i0, k, nb, -1, a + i0, lda, 0,                      \
+                                   b + i0 * ldb, ldb, 0, b, ldb, threaded);            \
+            }                                                                          \
+            if (!ok) {                                                                 \
+                return ARRAY_ERROR_MEMORY;                                             \
+            }                                                                          \
+        }                                                                              \
+        return ARRAY_OK;                                                               \
+    }                                                                                  \
+                                                                                       \
+    /* LU with partial pivoting: rows are swapped whole, so the result is           */ \
+    /* L and U of P A with piv[i] the row swapped with row i at step i.             */ \
+    /* Returns ARRAY_ERROR_MEMORY if a trailing update fails.                       */ \
+    static ArrayError lu_##suffix(void* a_mat, size_t n, int* piv, int threaded) {     \
+        T* a = a_mat;                                                                  \
+        for (size_t j = 0; j < n; j += SOLVER_BLOCK) {                                 \
+            size_t jb = n - j < SOLVER_BLOCK ? n - j : SOLVER_BLOCK;                   \
+            for (size_t c = j; c < j + jb; c++) {                                      \
+                size_t p = c;                                                          \
+                T best = fabs(a[c * n + c]);                                           \
+                for (size_t r = c + 1; r < n; r++) {                                   \
+                    T v = fabs(a[r * n + c]);                                          \
+                    if (v > best) {                                                    \
+                        best = v;                                                      \
+                        p = r;                                                         \
+                    }                                                                  \
+                }                                                                      \
+                piv[c] = (int)p;                                                       \
+                if (p != c) {                                                          \
+                    for (size_t t = 0; t < n; t++) {                                   \
+                        T tmp = a[c * n + t];                                          \
+                        a[c * n + t] = a[p * n + t];                                   \
+                        a[p * n + t] = tmp;                                            \
+                    }                                                                  \
+                }                                                                      \
+                const T d = a[c * n + c];                                              \
+                if (d == 0) {                                                          \
+                    continue;                                                          \
+                }                                                                      \
+                const T* restrict pivot_row = a + c * n;                               \
+                for (size_t r = c + 1; r < n; r++) {                                   \
+                    T* restrict row = a + r * n;                                       \
+                    const T l = row[c] /= d;                                           \
+                    for (size_t t = c + 1; t < j + jb; t++) row[t] -= l * pivot_row[t]; \
+                }                                                                      \
+            }                                                                          \
+            if (j + jb < n) {                                                          \
+                /* U12 = L11^-1 A12, then A22 -= L21 U12 */                            \
+                ArrayError error = trsm_##suffix(a + j * n + j, jb, n, a + j * n + j + jb,\
+                                                 n - j - jb, n, 1, 1, threaded);       \
+                if (error) {                                                           \
+                    return error;                                                      \
+                }                                                                      \
+                if (!gemm_##suffix(n - j - jb, n - j - jb, jb, -1, a + (j + jb) * n + j,\
+                                   n, 0, a + j * n + j + jb, n, 0,                     \
+                                   a + (j + jb) * n + j + jb, n, threaded)) {          \
+                    return ARRAY_ERROR_MEMORY;                                         \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+        return ARRAY_OK;                                                               \
+    }                                                                                  \
+                                                                                       \
+    /* Left-looking Cholesky A = L L^T reading the lower triangle.                  */ \
+    /* Returns ARRAY_ERROR_VALUE when A is not positive definite.                   */ \
+    static ArrayError cholesky_##suffix(void* a_mat, size_t n, int threaded) {         \
+        T* a = a_mat;                                                                  \
+        for (size_t j = 0; j < n; j += SOLVER_BLOCK) {                                 \
+            size_t jb = n - j < SOLVER_BLOCK ? n - j : SOLVER_BLOCK;                   \
+            T* a11 = a + j * n + j;                                                    \
+            /* A11 -= L10 L10^T, A21 -= L20 L10^T */                                   \
+            if (!gemm_##suffix(n - j, jb, j, -1, a + j * n, n, 0, a + j * n, n, 1,     \
+                               a11, n, threaded)) {                                    \
+                return ARRAY_ERROR_MEMORY;                                             \
+            }                                                                          \
+            for (size_t c = 0; c < jb; c++) {                                          \
+                T d = a11[c * n + c];                                                  \
+                for (size_t t = 0; t < c; t++) d -= a11[c * n + t] * a11[c * n + t];   \
+                if (!(d > 0)) {                                                        \
+                    return ARRAY_ERROR_VALUE;                                          \
+                }                                                                      \
+                d = SQRT(d);                                                           \
+                a11[c * n + c] = d;                                                    \
+                for (size_t r = c + 1; r < jb; r++) {                                  \
+                    T s = a11[r * n + c];                                              \
+                    for (size_t t = 0; t < c; t++) s -= a11[r * n + t] * a11[c * n + t]; \
+                    a11[r * n + c] = s / d;                                            \
+                }                                                                      \
+            }                                                                          \
+            /* A21 = A21 L11^-T, one independent row at a time */                      \
+            for (size_t r = j + jb; r < n; r++) {                                      \
+                T* restrict x = a + r * n + j;                                         \
+                for (size_t c = 0; c < jb; c++) {                                      \
+                    T s = x[c];                                                        \
+                    for (size_t t = 0; t < c; t++) s -= x[t] * a11[c * n + t];         \
+                    x[c] = s / a11[c * n + c];                                         \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+        for (size_t r = 0; r < n; r++) {                                               \
+            memset(a + r * n + r + 1, 0, (n - r - 1) * sizeof(T));                     \
+        }                                                                              \
+        return ARRAY_OK;                                                               \
+    }                                                                                  \
+                                                                                       \
+    /* Householder reflectors of an m x nb panel: v (unit first element) is stored  */ \
+    /* below the diagonal, beta on it, and tau[c] such that H = I - tau v v^T.      */ \
+    static void qr_panel_##suffix(T* a, size_t m, size_t nb, size_t lda, T* tau) {     \
+        T s[nb];                                                                       \
+        for (size_t c = 0; c < nb && c < m; c++) {                                     \
+            T alpha = a[c * lda + c];                                                  \
+            T sigma = 0;                                                               \
+            for (size_t r = c + 1; r < m; r++) sigma += a[r * lda + c] * a[r * lda + c]; \
+            if (sigma == 0) {                                                          \
+                tau[c] = 0;                                                            \
+                continue;                                                              \
+            }                                                                          \
+            T beta = SQRT(alpha * alpha + sigma);                                      \
+            if (alpha > 0) beta = -beta;                                               \
+            tau[c] = (beta - alpha) / beta;                                            \
+            const T scale = 1 / (alpha - beta);                                        \
+            for (size_t r = c + 1; r < m; r++) a[r * lda + c] *= scale;                \
+            a[c * lda + c] = beta;                                                     \
+            /* Apply H to the remaining panel columns: s = v^T A, A -= tau v s */        \
+            size_t w = nb - c - 1;                                                     \
+            for (size_t t = 0; t < w; t++) s[t] = a[c * lda + c + 1 + t];              \
+            for (size_t r = c + 1; r < m; r++) {                                       \
+                const T v = a[r * lda + c];                                            \
+                for (size_t t = 0; t < w; t++) s[t] += v * a[r * lda + c + 1 + t];     \
+            }                                                                          \
+            for (size_t t = 0; t < w; t++) s[t] *= tau[c];                             \
+            for (size_t t = 0; t < w; t++) a[c * lda + c + 1 + t] -= s[t];             \
+            for (size_t r = c + 1; r < m; r++) {                                       \
+                const T v = a[r * lda + c];                                            \
+                for (size_t t = 0; t < w; t++) a[r * lda + c + 1 + t] -= v * s[t];     \
+            }                                                                          \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* Copies the panel reflectors into an explicit m x nb V and builds the upper   */ \
+    /* triangular T with H_0 ... H_nb-1 = I - V T V^T (forward, column-wise).       */ \
+    static void qr_block_reflector_##suffix(const T* a, size_t m, size_t nb, size_t lda, \
+                                            const T* tau, T* v, T* t) {                \
+        for (size_t r = 0; r < m; r++) {                                               \
+            for (size_t c = 0; c < nb; c++) {                                          \
+                v[r * nb + c] = r > c ? a[r * lda + c] : r == c ? 1 : 0;               \
+            }                                                                          \
+        }                                                                              \
+        memset(t, 0, nb * nb * sizeof(T));                                             \
+        T z[nb];                                                                       \
+        for (size_t i = 0; i < nb; i++) {                                              \
+            /* T[0:i, i] = -tau_i T[0:i, 0:i] V[:, 0:i]^T v_i */                       \
+            for (size_t c = 0; c < i; c++) z[c] = 0;                                   \
+            for (size_t r = i; r < m; r++) {                                           \
+                const T vi = v[r * nb + i];                                            \
+                for (size_t c = 0; c < i; c++) z[c] += v[r * nb + c] * vi;             \
+            }                                                                          \
+            for (size_t c = 0; c < i; c++) {                                           \
+                T s = 0;                                                               \
+                for (size_t q = c; q < i; q++) s += t[c * nb + q] * z[q];              \
+                t[c * nb + i] = -tau[i] * s;                                           \
+            }                                                                          \
+            t[i * nb + i] = tau[i];                                                    \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* C -= V op(T) V^T C for an m x nc C, with op(T) = T^T when transpose is set.  */ \
+    /* Returns 0 if the workspace cannot be allocated.                              */ \
+    static int apply_block_reflector_##suffix(const T* v, const T* t, size_t m,        \
+                                              size_t nb, T* c, size_t nc, size_t ldc,  \
+                                              int transpose, int threaded) {           \
+        T* w = calloc(nb * nc + 1, sizeof(T));                                         \
+        if (!w) {                                                                      \
+            log_error(ARRAY_ERROR_MEMORY,                                              \
+                      "Failed to allocate memory for QR workspace");                   \
+            return 0;                                                                  \
+        }                                                                              \
+        if (!gemm_##suffix(nb, nc, m, 1, v, nb, 1, c, ldc, 0, w, nc, threaded)) {      \
+            free(w);                                                                   \
+            return 0;                                                                  \
+        }                                                                              \
+        /* W = op(T) W in place; the triangle order keeps unread rows intact */        \
+        for (size_t s = 0; s < nb; s++) {                                              \
+            size_t i = transpose ? nb - 1 - s : s;                                     \
+            T* restrict wi = w + i * nc;                                               \
+            const T d = t[i * nb + i];                                                 \
+            for (size_t j = 0; j < nc; j++) wi[j] *= d;                                \
+            size_t q0 = transpose ? 0 : i + 1;                                         \
+            size_t q1 = transpose ? i : nb;                                            \
+            for (size_t q = q0; q < q1; q++) {                                         \
+                const T coef = transpose ? t[q * nb + i] : t[i * nb + q];              \
+                const T* restrict wq = w + q * nc;                                     \
+                for (size_t j = 0; j < nc; j++) wi[j] += coef * wq[j];                 \
+            }                                                                          \
+        }                                                                              \
+        int ok = gemm_##suffix(m, nc, nb, -1, v, nb, 0, w, nc, 0, c, ldc, threaded);   \
+        free(w);                                                                       \
+        return ok;                                                                     \
+    }                                                                                  \
+                                                                                       \
+    /* Householder QR of an m x n A: A is overwritten by R (zero below the          */ \
+    /* diagonal) and the m x min(m, n) Q is written to q.                            */ \
+    /* Returns 0 if the workspace cannot be allocated.                              */ \
+    static int qr_##suffix(void* a_mat, size_t m, size_t n, void* q_mat, int threaded) { \
+        T* a = a_mat;                                                                  \
+        T* q = q_mat;                                                                  \
+        size_t k = m < n ? m : n;                                                      \
+        T* tau = malloc(k * sizeof(T));                                                \
+        T* v = malloc(m * SOLVER_BLOCK * sizeof(T));                                   \
+        T* t = malloc(SOLVER_BLOCK * SOLVER_BLOCK * sizeof(T));                        \
+        int ok = tau && v && t;                                                        \
+        if (!ok) {                                                                     \
+            log_error(ARRAY_ERROR_MEMORY,                                              \
+                      "Failed to allocate memory for QR workspace");                   \
+        }                                                                              \
+        for (size_t j = 0; ok && j < k; j += SOLVER_BLOCK) {                           \
+            size_t jb = k - j < SOLVER_BLOCK ? k - j : SOLVER_BLOCK;                   \
+            T* panel = a + j * n + j;                                                  \
+            qr_panel_##suffix(panel, m - j, jb, n, tau + j);                           \
+            if (j + jb < n) {                                                          \
+                qr_block_reflector_##suffix(panel, m - j, jb, n, tau + j, v, t);       \
+                ok = apply_block_reflector_##suffix(v, t, m - j, jb, panel + jb,       \
+                                                    n - j - jb, n, 1, threaded);       \
+            }                                                                          \
+        }                                                                              \
+        /* Q = H_0 H_1 ... applied to the identity, last block first */                \
+        memset(q, 0, m * k * sizeof(T));                                               \
+        for (size_t i = 0; i < k; i++) q[i * k + i] = 1;                               \
+        for (size_t j = (k ? (k - 1) / SOLVER_BLOCK * SOLVER_BLOCK : 0);               \
+             ok && k > 0; j -= SOLVER_BLOCK) {                                         \
+            size_t jb = k - j < SOLVER_BLOCK ? k - j : SOLVER_BLOCK;                   \
+            qr_block_reflector_##suffix(a + j * n + j, m - j, jb, n, tau + j, v, t);   \
+            ok = apply_block_reflector_##suffix(v, t, m - j, jb, q + j * k + j, k - j, \
+                                                k, 0, threaded);                       \
+            if (j == 0) break;                                                         \
+        }                                                                              \
+        for (size_t r = 1; r < m; r++) {                                               \
+            memset(a + r * n, 0, (r < n ? r : n) * sizeof(T));                         \
+        }                                                                              \
+        free(tau);                                                                     \
+        free(v);                                                                       \
+        free(t);                                                                       \
+        return ok;                                                                     \
+    }
+
+DEFINE_SOLVER_KERNELS(float, float, sqrtf)
+DEFINE_SOLVER_KERNELS(double, double, sqrt)
+
+typedef struct {
+    ArrayError (*trsm)(const void* a, size_t n, size_t lda, void* b, size_t k, size_t ldb,
+                       int lower, int unit, int threaded);
+    ArrayError (*lu)(void* a, size_t n, int* piv, int threaded);
+    ArrayError (*cholesky)(void* a, size_t n, int threaded);
+    int (*qr)(void* a, size_t m, size_t n, void* q, int threaded);
+} SolverKernels;
+
+// Indexed by dtype == TYPE_DOUBLE
+static const SolverKernels solver_kernels[2] = {
+    { trsm_float, lu_float, cholesky_float, qr_float },
+    { trsm_double, lu_double, cholesky_double, qr_double },
+};
+
+
+// Batches
+//
+// Every operation accepts a stack of matrices of shape (..., m, n). Stacks are
+// split across threads one matrix at a time, with single-threaded GEMMs; a
+// single matrix instead runs its GEMM updates on all threads.
+
+typedef struct {
+    const SolverKernels* kernels;
+    size_t elem_size;
+    size_t m, n, k;        // Matrix rows and columns, right-hand side columns
+    char* a;               // Matrices factored in place
+    char* b;               // Right-hand sides solved in place, or Q for qr
+    int* piv;              // Pivots of lu_factor and solve
+    int lower;
+    int threaded;
+    ArrayError error;      // Set when any matrix of the batch fails
+} BatchContext;
+
+static void mark_failed(BatchContext* c, ArrayError error) {
+    __atomic_store_n(&c->error, error, __ATOMIC_RELAXED);
+}
+
+// Runs body over the batch, returns ARRAY_OK if no matrix failed or the error of one that did.
+// Allocation failures have already been logged; numerical ones are left to the caller.
+static ArrayError run_batch(BatchContext* c, size_t batch, ParallelFunc body) {
+    size_t flops = c->m * c->n * (c->n + c->k) + 1;
+    size_t grain = flops < SOLVER_GRAIN_FLOPS ? SOLVER_GRAIN_FLOPS / flops : 1;
+    c->threaded = batch == 1;
+    c->error = ARRAY_OK;
+    parallel_for(batch, grain, body, c);
+    return c->error;
+}
+
+/**
+ * Check that an array is a float or double stack of matrices.
+ *
+ * @param arr The array to check.
+ * @param square Whether the matrices must be square.
+ * @return The number of matrices in the stack, or 0 on error.
+ */
+static size_t matrix_batch(Array* arr, int square) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return 0;
+        }
+    #endif
+
+    if (arr->dtype != TYPE_FLOAT && arr->dtype != TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return 0;
+    }
+    if (arr->ndim < 2) {
+        log_error(ARRAY_ERROR_SHAPE, "Array must have at least two dimensions");
+        return 0;
+    }
+    if (square && arr->shape[arr->ndim - 1] != arr->shape[arr->ndim - 2]) {
+        log_error(ARRAY_ERROR_SHAPE, "Matrix must be square");
+        return 0;
+    }
+    return arr->size / (arr->shape[arr->ndim - 1] * arr->shape[arr->ndim - 2]);
+}
+
+/**
+ * Check that b holds right-hand sides for the stack of square matrices a.
+ *
+ * b is either a stack of vectors (..., n) or a stack of matrices (..., n, k)
+ * with the same leading dimensions as a.
+ *
+ * @return The number of right-hand side columns, or 0 on error.
+ */
+static size_t rhs_columns(Array* a, Array* b) {
+    #if DEBUG_MODE
+        if (!b) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return 0;
+        }
+    #endif
+
+    if (a->dtype != b->dtype) {
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+        return 0;
+    }
+
+    size_t batch_ndim = a->ndim - 2;
+    int vector = b->ndim == a->ndim - 1;
+    if ((!vector && b->ndim != a->ndim) || b->shape[batch_ndim] != a->shape[batch_ndim] ||
+        memcmp(a->shape, b->shape, batch_ndim * sizeof(size_t)) != 0) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+        return 0;
+    }
+    return vector ? 1 : b->shape[b->ndim - 1];
+}
+
+// Returns a copy of arr's data in a new array of the same shape
+static Array* copy_matrices(Array* arr) {
+    Array* copy = create_array(arr->dtype, arr->ndim, arr->shape, NULL);
+    if (copy) {
+        parallel_memcpy(copy->data, arr->data, arr->size * get_dtype_size(arr->dtype));
+    }
+    return copy;
+}
+
+
+// Matrix product
+
+typedef struct {
+    GemmFunc gemm;
+    size_t m, n, k;
+    const char* a;
+    const char* b;
+    char* c;
+    size_t stride_a, stride_b, stride_c;  // Bytes between consecutive matrices (0 when broadcast)
+    int failed;                           // Set when any product fails
+} MatmulContext;
+
+static void matmul_matrices(size_t begin, size_t end, void* ctx) {
+    MatmulContext* c = ctx;
+    for (size_t i = begin; i < end; i++) {
+        if (!c->gemm(c->m, c->n, c->k, 1, c->a + i * c->stride_a, c->k, 0,
+                     c->b + i * c->stride_b, c->n, 0, c->c + i * c->stride_c, c->n, 0)) {
+            __atomic_store_n(&c->failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * Multiply two stacks of matrices.
+ *
+ * A stack of shape (..., m, k) and a stack of shape (..., k, n) with the same
+ * leading dimensions give (..., m, n); a single two-dimensional operand is
+ * used for every matrix of the other stack. Stacks of 2x2, 3x3, 4x4 and 8x8
+ * float or double matrices use the fixed-size kernels of small_matmul; a
+ * stack times a single matrix is otherwise computed as one (... * m, k) x (k, n)
+ * product.
+ *
+ * @param arr_a The left operand.
+ * @param arr_b The right operand.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* matmul(Array* arr_a, Array* arr_b) {
+    #if DEBUG_MODE
+        if (!arr_a || !arr_b) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (arr_a->dtype != arr_b->dtype) {
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+        return NULL;
+    }
+    if (arr_a->dtype > TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+    if (arr_a->ndim < 2 || arr_b->ndim < 2) {
+        log_error(ARRAY_ERROR_SHAPE, "Array must have at least two dimensions");
+        return NULL;
+    }
+
+    size_t m = arr_a->shape[arr_a->ndim - 2];
+    size_t k = arr_a->shape[arr_a->ndim - 1];
+    size_t n = arr_b->shape[arr_b->ndim - 1];
+    if (arr_b->shape[arr_b->ndim - 2] != k ||
+        (arr_a->ndim != arr_b->ndim && arr_a->ndim != 2 && arr_b->ndim != 2) ||
+        (arr_a->ndim == arr_b->ndim &&
+         memcmp(arr_a->shape, arr_b->shape, (arr_a->ndim - 2) * sizeof(size_t)) != 0)) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+        return NULL;
+    }
+
+    Array* batched = arr_a->ndim >= arr_b->ndim ? arr_a : arr_b;
+    size_t shape[batched->ndim];
+    memcpy(shape, batched->shape, (batched->ndim - 2) * sizeof(size_t));
+    shape[batched->ndim - 2] = m;
+    shape[batched->ndim - 1] = n;
+    Array* result = create_array(arr_a->dtype, batched->ndim, shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    if (small_matmul(arr_a, arr_b, result)) {
+        return result;
+    }
+
+    size_t elem_size = get_dtype_size(arr_a->dtype);
+    size_t batch = result->size / (m * n);
+    MatmulContext c = {
+        gemm_kernels[arr_a->dtype], m, n, k, arr_a->data, arr_b->data, result->data,
+        arr_a->ndim > 2 || arr_b->ndim == 2 ? m * k * elem_size : 0,
+        arr_b->ndim > 2 || arr_a->ndim == 2 ? k * n * elem_size : 0,
+        m * n * elem_size, 0
+    };
+
+    if (batch == 1 || c.stride_b == 0) {
+        // One product, with the stack of left operands stacked as rows
+        c.failed = !c.gemm(batch * m, n, k, 1, c.a, k, 0, c.b, n, 0, c.c, n, 1);
+    } else {
+        size_t flops = m * n * k + 1;
+        parallel_for(batch, flops < SOLVER_GRAIN_FLOPS ? SOLVER_GRAIN_FLOPS / flops : 1,
+                     matmul_matrices, &c);
+    }
+    if (c.failed) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+
+// Factorizations
+
+static void lu_matrices(size_t begin, size_t end, void* ctx) {
+    BatchContext* c = ctx;
+    for (size_t i = begin; i < end; i++) {
+        ArrayError error = c->kernels->lu(c->a + i * c->n * c->n * c->elem_size, c->n,
+                                          c->piv + i * c->n, c->threaded);
+        if (error) {
+            mark_failed(c, error);
+        }
+    }
+}
+
+/**
+ * Compute the LU factorization with partial pivoting of a stack of square matrices.
+ *
+ * The factorization is blocked: each SOLVER_BLOCK-wide panel is factored
+ * directly and the trailing matrix is updated with one GEMM. Rows are
+ * interchanged across the whole matrix, so L and U are the factors of P A.
+ *
+ * @param arr The float or double array of shape (..., n, n).
+ * @param lu Receives L (unit diagonal, not stored) and U packed into one array of the same shape.
+ * @param pivots Receives a TYPE_INT array of shape (..., n): row i was interchanged with row pivots[i], in order.
+ * @return 1 on success, 0 on error. A zero on the diagonal of U means the matrix is singular.
+ */
+int lu_factor(Array* arr, Array** lu, Array** pivots) {
+    #if DEBUG_MODE
+        if (!lu || !pivots) {
+            log_error(ARRAY_ERROR_NULL, "Output pointers are NULL");
+            return 0;
+        }
+    #endif
+
+    size_t batch = matrix_batch(arr, 1);
+    if (!batch) {
+        return 0;
+    }
+
+    *lu = copy_matrices(arr);
+    *pivots = *lu ? create_array(TYPE_INT, arr->ndim - 1, arr->shape, NULL) : NULL;
+    if (!*pivots) {
+        free_array(*lu);
+        *lu = NULL;
+        return 0;
+    }
+
+    size_t n = arr->shape[arr->ndim - 1];
+    BatchContext c = {
+        .kernels = &solver_kernels[arr->dtype == TYPE_DOUBLE], .elem_size = get_dtype_size(arr->dtype),
+        .m = n, .n = n, .a = (*lu)->data, .piv = (*pivots)->data
+    };
+    if (run_batch(&c, batch, lu_matrices)) {
+        free_array(*lu);
+        free_array(*pivots);
+        *lu = NULL;
+        *pivots = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+static void cholesky_matrices(size_t begin, size_t end, void* ctx) {
+    BatchContext* c = ctx;
+    for (size_t i = begin; i < end; i++) {
+        ArrayError error = c->kernels->cholesky(c->a + i * c->n * c->n * c->elem_size, c->n,
+                                                c->threaded);
+        if (error) {
+            mark_failed(c, error);
+        }
+    }
+}
+
+/**
+ * Compute the Cholesky factorization A = L L^T of a stack of symmetric positive definite matrices.
+ *
+ * Only the lower triangle of each matrix is read. The factorization is
+ * left-looking: every panel is first updated with the columns to its left in
+ * one GEMM, then factored directly.
+ *
+ * @param arr The float or double array of shape (..., n, n).
+ * @return A pointer to a new array holding L (zero above the diagonal), or NULL on error.
+ */
+Array* cholesky(Array* arr) {
+    size_t batch = matrix_batch(arr, 1);
+    if (!batch) {
+        return NULL;
+    }
+
+    Array* result = copy_matrices(arr);
+    if (!result) {
+        return NULL;
+    }
+
+    size_t n = arr->shape[arr->ndim - 1];
+    BatchContext c = {
+        .kernels = &solver_kernels[arr->dtype == TYPE_DOUBLE], .elem_size = get_dtype_size(arr->dtype),
+        .m = n, .n = n, .a = result->data
+    };
+    ArrayError error = run_batch(&c, batch, cholesky_matrices);
+    if (error) {
+        if (error == ARRAY_ERROR_VALUE) {
+            log_error(ARRAY_ERROR_VALUE, "Matrix is not positive definite");
+        }
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+static void qr_matrices(size_t begin, size_t end, void* ctx) {
+    BatchContext* c = ctx;
+    size_t k = c->m < c->n ? c->m : c->n;
+    for (size_t i = begin; i < end; i++) {
+        if (!c->kernels->qr(c->a + i * c->m * c->n * c->elem_size, c->m, c->n,
+                            c->b + i * c->m * k * c->elem_size, c->threaded)) {
+            mark_failed(c, ARRAY_ERROR_MEMORY);
+        }
+    }
+}
+
+/**
+ * Compute the reduced QR factorization of a stack of matrices with Householder reflections.
+ *
+ * Each panel of reflectors is combined into a block reflector I - V T V^T
+ * and applied to the trailing matrix, and later to the identity to form Q,
+ * with two GEMMs.
+ *
+ * @param arr The float or double array of shape (..., m, n).
+ * @param q Receives Q of shape (..., m, min(m, n)) with orthonormal columns.
+ * @param r Receives the upper triangular R of shape (..., min(m, n), n).
+ * @return 1 on success, 0 on error.
+ */
+int qr(Array* arr, Array** q, Array** r) {
+    #if DEBUG_MODE
+        if (!q || !r) {
+            log_error(ARRAY_ERROR_NULL, "Output pointers are NULL");
+            return 0;
+        }
+    #endif
+
+    size_t batch = matrix_batch(arr, 0);
+    if (!batch) {
+        return 0;
+    }
+
+    size_t m = arr->shape[arr->ndim - 2];
+    size_t n = arr->shape[arr->ndim - 1];
+    size_t k = m < n ? m : n;
+    size_t shape[arr->ndim];
+    memcpy(shape, arr->shape, arr->ndim * sizeof(size_t));
+    shape[arr->ndim - 1] = k;
+
+    Array* work = copy_matrices(arr);
+    *q = work ? create_array(arr->dtype, arr->ndim, shape, NULL) : NULL;
+    if (!*q) {
+        free_array(work);
+        return 0;
+    }
+
+    size_t elem_size = get_dtype_size(arr->dtype);
+    BatchContext c = {
+        .kernels = &solver_kernels[arr->dtype == TYPE_DOUBLE], .elem_size = elem_size,
+        .m = m, .n = n, .a = work->data, .b = (*q)->data
+    };
+    if (run_batch(&c, batch, qr_matrices)) {
+        free_array(work);
+        free_array(*q);
+        *q = NULL;
+        return 0;
+    }
+
+    if (k == m) {
+        *r = work;
+        return 1;
+    }
+
+    // Tall matrices: R is the top k rows of each factored matrix
+    shape[arr->ndim - 2] = k;
+    shape[arr->ndim - 1] = n;
+    *r = create_array(arr->dtype, arr->ndim, shape, NULL);
+    if (*r) {
+        for (size_t i = 0; i < batch; i++) {
+            memcpy((char*)(*r)->data + i * k * n * elem_size,
+                   (char*)work->data + i * m * n * elem_size, k * n * elem_size);
+        }
+    }
+    free_array(work);
+    if (!*r) {
+        free_array(*q);
+        *q = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+
+// Solvers
+
+static void trsm_matrices(size_t begin, size_t end, void* ctx) {
+    BatchContext* c = ctx;
+    for (size_t i = begin; i < end; i++) {
+        ArrayError error = c->kernels->trsm(c->a + i * c->n * c->n * c->elem_size, c->n, c->n,
+                                            c->b + i * c->n * c->k * c->elem_size, c->k, c->k,
+                                            c->lower, 0, c->threaded);
+        if (error) {
+            mark_failed(c, error);
+        }
+    }
+}
+
+/**
+ * Solve A X = B for a stack of triangular matrices.
+ *
+ * Blocks of SOLVER_BLOCK rows are solved by substitution and removed from the
+ * remaining rows with one GEMM. Only the selected triangle of A is read.
+ *
+ * @param arr_a The float or double array of shape (..., n, n).
+ * @param arr_b The right-hand sides, of shape (..., n) or (..., n, k).
+ * @param lower 1 if A is lower triangular, 0 if upper triangular.
+ * @return A pointer to a new array holding X with the shape of arr_b, or NULL on error.
+ */
+Array* triangular_solve(Array* arr_a, Array* arr_b, int lower) {
+    size_t batch = matrix_batch(arr_a, 1);
+    size_t k = batch ? rhs_columns(arr_a, arr_b) : 0;
+    if (!k) {
+        return NULL;
+    }
+
+    Array* result = copy_matrices(arr_b);
+    if (!result) {
+        return NULL;
+    }
+
+    BatchContext c = {
+        .kernels = &solver_kernels[arr_a->dtype == TYPE_DOUBLE], .elem_size = get_dtype_size(arr_a->dtype),
+        .m = arr_a->shape[arr_a->ndim - 1], .n = arr_a->shape[arr_a->ndim - 1], .k = k,
+        .a = arr_a->data, .b = result->data, .lower = lower
+    };
+    ArrayError error = run_batch(&c, batch, trsm_matrices);
+    if (error) {
+        if (error == ARRAY_ERROR_VALUE) {
+            log_error(ARRAY_ERROR_VALUE, "Matrix is singular");
+        }
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+static void solve_matrices(size_t begin, size_t end, void* ctx) {
+    BatchContext* c = ctx;
+    size_t row_bytes = c->k * c->elem_size;
+    char tmp[row_bytes];
+    for (size_t i = begin; i < end; i++) {
+        char* a = c->a + i * c->n * c->n * c->elem_size;
+        char* b = c->b + i * c->n * row_bytes;
+        int* piv = c->piv + i * c->n;
+        ArrayError error = c->kernels->lu(a, c->n, piv, c->threaded);
+        if (error) {
+            mark_failed(c, error);
+            continue;
+        }
+
+        // Apply the row interchanges to B, then solve L Y = P B and U X = Y
+        for (size_t r = 0; r < c->n; r++) {
+            if ((size_t)piv[r] != r) {
+                memcpy(tmp, b + r * row_bytes, row_bytes);
+                memcpy(b + r * row_bytes, b + piv[r] * row_bytes, row_bytes);
+                memcpy(b + piv[r] * row_bytes, tmp, row_bytes);
+            }
+        }
+        error = c->kernels->trsm(a, c->n, c->n, b, c->k, c->k, 1, 1, c->threaded);
+        if (!error) {
+            error = c->kernels->trsm(a, c->n, c->n, b, c->k, c->k, 0, 0, c->threaded);
+        }
+        if (error) {
+            mark_failed(c, error);
+        }
+    }
+}
+
+/**
+ * Solve the linear systems A X = B for a stack of square matrices.
+ *
+ * Each matrix is factored with blocked LU with partial pivoting, followed by
+ * two blocked triangular solves.
+ *
+ * @param arr_a The float or double array of shape (..., n, n).
+ * @param arr_b The right-hand sides, of shape (..., n) or (..., n, k).
+ * @return A pointer to a new array holding X with the shape of arr_b, or NULL on error.
+ */
+Array* solve(Array* arr_a, Array* arr_b) {
+    size_t batch = matrix_batch(arr_a, 1);
+    size_t k = batch ? rhs_columns(arr_a, arr_b) : 0;
+    if (!k) {
+        return NULL;
+    }
+
+    size_t n = arr_a->shape[arr_a->ndim - 1];
+    Array* lu = copy_matrices(arr_a);
+    Array* result = lu ? copy_matrices(arr_b) : NULL;
+    int* piv = result ? malloc(batch * n * sizeof(int)) : NULL;
+    if (!piv) {
+        if (result) {
+            log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for pivots");
+        }
+        free_array(lu);
+        free_array(result);
+        return NULL;
+    }
+
+    BatchContext c = {
+        .kernels = &solver_kernels[arr_a->dtype == TYPE_DOUBLE], .elem_size = get_dtype_size(arr_a->dtype),
+        .m = n, .n = n, .k = k, .a = lu->data, .b = result->data, .piv = piv
+    };
+    ArrayError error = run_batch(&c, batch, solve_matrices);
+    free(piv);
+    free_array(lu);
+    if (error) {
+        if (error == ARRAY_ERROR_VALUE) {
+            log_error(ARRAY_ERROR_VALUE, "Matrix is singular");
+        }
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
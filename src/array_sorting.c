@@ -0,0 +1,709 @@
+#include "array.h"
+#include <stdint.h>
+
+// Runs up to this length are sorted with a branch-free sorting network
+#define SMALL_SORT 16
+
+// Runs at least this long are sorted with a radix sort instead of a merge sort
+#define RADIX_SORT_MIN 256
+
+// Lines at least this long are split across threads and merged back in parallel
+#define PARALLEL_SORT_MIN (1 << 18)
+
+// Every element is mapped to an unsigned key whose integer order is the order of
+// the values, so the kernels below never need a comparator. Integers flip their
+// sign bit; floating-point values flip all bits when negative and only the sign
+// bit otherwise. NaNs are canonicalized so they sort after +inf.
+
+static inline uint32_t int_to_key(int x) {
+    return (uint32_t)x ^ 0x80000000u;
+}
+
+static inline int key_to_int(uint32_t key) {
+    return (int)(key ^ 0x80000000u);
+}
+
+static inline uint32_t float_to_key(float x) {
+    uint32_t bits = 0x7fc00000u;
+    if (x == x) {
+        memcpy(&bits, &x, sizeof(bits));
+    }
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+static inline float key_to_float(uint32_t key) {
+    uint32_t bits = (key & 0x80000000u) ? key ^ 0x80000000u : ~key;
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+static inline uint64_t double_to_key(double x) {
+    uint64_t bits = 0x7ff8000000000000ull;
+    if (x == x) {
+        memcpy(&bits, &x, sizeof(bits));
+    }
+    return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+}
+
+static inline double key_to_double(uint64_t key) {
+    uint64_t bits = (key & 0x8000000000000000ull) ? key ^ 0x8000000000000000ull : ~key;
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+// Loads n strided elements of a line as keys
+static void load_keys(DataType dtype, const char* base, size_t stride, size_t n, void* keys) {
+    switch (dtype) {
+        case TYPE_INT:
+            for (size_t i = 0; i < n; i++) ((uint32_t*)keys)[i] = int_to_key(*(const int*)(base + i * stride));
+            break;
+        case TYPE_FLOAT:
+            for (size_t i = 0; i < n; i++) ((uint32_t*)keys)[i] = float_to_key(*(const float*)(base + i * stride));
+            break;
+        case TYPE_DOUBLE:
+            for (size_t i = 0; i < n; i++) ((uint64_t*)keys)[i] = double_to_key(*(const double*)(base + i * stride));
+            break;
+        case TYPE_BOOL:
+            for (size_t i = 0; i < n; i++) ((uint32_t*)keys)[i] = *(const unsigned char*)(base + i * stride);
+            break;
+        default:
+            break;
+    }
+}
+
+// Stores n keys as strided elements of a line
+static void store_keys(DataType dtype, char* base, size_t stride, size_t n, const void* keys) {
+    switch (dtype) {
+        case TYPE_INT:
+            for (size_t i = 0; i < n; i++) *(int*)(base + i * stride) = key_to_int(((const uint32_t*)keys)[i]);
+            break;
+        case TYPE_FLOAT:
+            for (size_t i = 0; i < n; i++) *(float*)(base + i * stride) = key_to_float(((const uint32_t*)keys)[i]);
+            break;
+        case TYPE_DOUBLE:
+            for (size_t i = 0; i < n; i++) *(double*)(base + i * stride) = key_to_double(((const uint64_t*)keys)[i]);
+            break;
+        case TYPE_BOOL:
+            for (size_t i = 0; i < n; i++) *(unsigned char*)(base + i * stride) = (unsigned char)((const uint32_t*)keys)[i];
+            break;
+        default:
+            break;
+    }
+}
+
+// Sorting kernels on keys, generated for 32-bit and 64-bit keys. idx is an
+// optional payload of original positions that travels with the keys; every
+// kernel that takes it is stable.
+#define DEFINE_SORT_KERNELS(suffix, key_t)                                             \
+                                                                                       \
+    /* Bitonic network over SMALL_SORT lanes, padded with the largest key. The */     \
+    /* compare-exchanges are min/max pairs and compile to conditional moves. */        \
+    static void network_sort_##suffix(key_t* keys, size_t n) {                         \
+        key_t v[SMALL_SORT];                                                           \
+        memcpy(v, keys, n * sizeof(key_t));                                            \
+        for (size_t i = n; i < SMALL_SORT; i++) v[i] = (key_t)~(key_t)0;               \
+        for (size_t k = 2; k <= SMALL_SORT; k <<= 1) {                                 \
+            for (size_t j = k >> 1; j > 0; j >>= 1) {                                  \
+                for (size_t i = 0; i < SMALL_SORT; i++) {                              \
+                    size_t l = i ^ j;                                                  \
+                    if (l > i) {                                                       \
+                        key_t x = v[i], y = v[l];                                      \
+                        key_t lo = x < y ? x : y;                                      \
+                        key_t hi = x < y ? y : x;                                      \
+                        int ascending = (i & k) == 0;                                  \
+                        v[i] = ascending ? lo : hi;                                    \
+                        v[l] = ascending ? hi : lo;                                    \
+                    }                                                                  \
+                }                                                                      \
+            }                                                                          \
+        }                                                                              \
+        memcpy(keys, v, n * sizeof(key_t));                                            \
+    }                                                                                  \
+                                                                                       \
+    static void insertion_sort_##suffix(key_t* keys, uint32_t* idx, size_t n) {        \
+        for (size_t i = 1; i < n; i++) {                                               \
+            key_t key = keys[i];                                                       \
+            uint32_t id = idx[i];                                                      \
+            size_t j = i;                                                              \
+            for (; j > 0 && keys[j - 1] > key; j--) {                                  \
+                keys[j] = keys[j - 1];                                                 \
+                idx[j] = idx[j - 1];                                                   \
+            }                                                                          \
+            keys[j] = key;                                                             \
+            idx[j] = id;                                                               \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static void merge_##suffix(const void* a_keys, const uint32_t* a_idx, size_t na,   \
+                               const void* b_keys, const uint32_t* b_idx, size_t nb,   \
+                               void* out_keys, uint32_t* out_idx) {                    \
+        const key_t* a = a_keys;                                                       \
+        const key_t* b = b_keys;                                                       \
+        key_t* out = out_keys;                                                         \
+        size_t i = 0, j = 0, o = 0;                                                    \
+        while (i < na && j < nb) {                                                     \
+            int take_b = b[j] < a[i];                                                  \
+            if (out_idx) out_idx[o] = take_b ? b_idx[j] : a_idx[i];                    \
+            out[o++] = take_b ? b[j] : a[i];                                           \
+            j += take_b;                                                               \
+            i += !take_b;                                                              \
+        }                                                                              \
+        memcpy(out + o, a + i, (na - i) * sizeof(key_t));                              \
+        memcpy(out + o + (na - i), b + j, (nb - j) * sizeof(key_t));                   \
+        if (out_idx) {                                                                 \
+            memcpy(out_idx + o, a_idx + i, (na - i) * sizeof(uint32_t));               \
+            memcpy(out_idx + o + (na - i), b_idx + j, (nb - j) * sizeof(uint32_t));    \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* Bottom-up merge sort on top of network (or insertion) sorted blocks */          \
+    static void merge_sort_##suffix(key_t* keys, uint32_t* idx, size_t n,              \
+                                    key_t* tmp, uint32_t* tmp_idx) {                   \
+        for (size_t start = 0; start < n; start += SMALL_SORT) {                       \
+            size_t len = (n - start < SMALL_SORT) ? n - start : SMALL_SORT;            \
+            if (idx) {                                                                 \
+                insertion_sort_##suffix(keys + start, idx + start, len);               \
+            } else {                                                                   \
+                network_sort_##suffix(keys + start, len);                              \
+            }                                                                          \
+        }                                                                              \
+        key_t* src = keys;                                                             \
+        key_t* dst = tmp;                                                              \
+        uint32_t* src_idx = idx;                                                       \
+        uint32_t* dst_idx = idx ? tmp_idx : NULL;                                      \
+        for (size_t width = SMALL_SORT; width < n; width *= 2) {                       \
+            for (size_t start = 0; start < n; start += 2 * width) {                    \
+                size_t mid = (start + width < n) ? start + width : n;                  \
+                size_t end = (start + 2 * width < n) ? start + 2 * width : n;          \
+                merge_##suffix(src + start, idx ? src_idx + start : NULL, mid - start, \
+                               src + mid, idx ? src_idx + mid : NULL, end - mid,       \
+                               dst + start, idx ? dst_idx + start : NULL);             \
+            }                                                                          \
+            key_t* swap = src; src = dst; dst = swap;                                  \
+            uint32_t* swap_idx = src_idx; src_idx = dst_idx; dst_idx = swap_idx;       \
+        }                                                                              \
+        if (src != keys) {                                                             \
+            memcpy(keys, src, n * sizeof(key_t));                                      \
+            if (idx) memcpy(idx, src_idx, n * sizeof(uint32_t));                       \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* LSD radix sort with 8-bit digits. All histograms are built in one read, */     \
+    /* and passes in which every key has the same digit are skipped. */                \
+    static void radix_sort_##suffix(key_t* keys, uint32_t* idx, size_t n,              \
+                                    key_t* tmp, uint32_t* tmp_idx) {                   \
+        size_t counts[sizeof(key_t)][256];                                             \
+        memset(counts, 0, sizeof(counts));                                             \
+        for (size_t i = 0; i < n; i++) {                                               \
+            key_t key = keys[i];                                                       \
+            for (size_t p = 0; p < sizeof(key_t); p++) {                               \
+                counts[p][(key >> (8 * p)) & 0xff]++;                                  \
+            }                                                                          \
+        }                                                                              \
+        key_t* src = keys;                                                             \
+        key_t* dst = tmp;                                                              \
+        uint32_t* src_idx = idx;                                                       \
+        uint32_t* dst_idx = idx ? tmp_idx : NULL;                                      \
+        for (size_t p = 0; p < sizeof(key_t); p++) {                                   \
+            size_t shift = 8 * p;                                                      \
+            if (counts[p][(src[0] >> shift) & 0xff] == n) continue;                    \
+            size_t offsets[256];                                                       \
+            size_t sum = 0;                                                            \
+            for (size_t d = 0; d < 256; d++) {                                         \
+                offsets[d] = sum;                                                      \
+                sum += counts[p][d];                                                   \
+            }                                                                          \
+            for (size_t i = 0; i < n; i++) {                                           \
+                size_t pos = offsets[(src[i] >> shift) & 0xff]++;                      \
+                dst[pos] = src[i];                                                     \
+                if (idx) dst_idx[pos] = src_idx[i];                                    \
+            }                                                                          \
+            key_t* swap = src; src = dst; dst = swap;                                  \
+            uint32_t* swap_idx = src_idx; src_idx = dst_idx; dst_idx = swap_idx;       \
+        }                                                                              \
+        if (src != keys) {                                                             \
+            memcpy(keys, src, n * sizeof(key_t));                                      \
+            if (idx) memcpy(idx, src_idx, n * sizeof(uint32_t));                       \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    static void sort_##suffix(void* keys_ptr, uint32_t* idx, size_t n,                 \
+                              void* tmp, uint32_t* tmp_idx) {                          \
+        key_t* keys = keys_ptr;                                                        \
+        if (n <= SMALL_SORT && !idx) {                                                 \
+            network_sort_##suffix(keys, n);                                            \
+        } else if (n < RADIX_SORT_MIN) {                                               \
+            merge_sort_##suffix(keys, idx, n, tmp, tmp_idx);                           \
+        } else {                                                                       \
+            radix_sort_##suffix(keys, idx, n, tmp, tmp_idx);                           \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* Introselect: quickselect with median-of-three pivots and a three-way */        \
+    /* partition, falling back to a full sort of the remaining range when the */      \
+    /* recursion depth exceeds 2 log2(n). */                                           \
+    static void select_##suffix(void* keys_ptr, uint32_t* idx, size_t n, size_t kth,   \
+                                void* tmp, uint32_t* tmp_idx) {                        \
+        key_t* keys = keys_ptr;                                                        \
+        size_t lo = 0, hi = n;                                                         \
+        size_t depth = 0;                                                              \
+        for (size_t m = n; m > 1; m >>= 1) depth += 2;                                 \
+        while (hi - lo > SMALL_SORT) {                                                 \
+            if (depth-- == 0) break;                                                   \
+            size_t mid = lo + (hi - lo) / 2;                                           \
+            key_t a = keys[lo], b = keys[mid], c = keys[hi - 1];                       \
+            key_t pivot = (a < b) ? ((b < c) ? b : (a < c ? c : a))                    \
+                                  : ((a < c) ? a : (b < c ? c : b));                   \
+            size_t lt = lo, i = lo, gt = hi;                                           \
+            while (i < gt) {                                                           \
+                key_t key = keys[i];                                                   \
+                if (key < pivot) {                                                     \
+                    keys[i] = keys[lt]; keys[lt] = key;                                \
+                    if (idx) { uint32_t t = idx[i]; idx[i] = idx[lt]; idx[lt] = t; }   \
+                    lt++; i++;                                                         \
+                } else if (key > pivot) {                                              \
+                    gt--;                                                              \
+                    keys[i] = keys[gt]; keys[gt] = key;                                \
+                    if (idx) { uint32_t t = idx[i]; idx[i] = idx[gt]; idx[gt] = t; }   \
+                } else {                                                               \
+                    i++;                                                               \
+                }                                                                      \
+            }                                                                          \
+            if (kth < lt) {                                                            \
+                hi = lt;                                                               \
+            } else if (kth >= gt) {                                                    \
+                lo = gt;                                                               \
+            } else {                                                                   \
+                return;                                                                \
+            }                                                                          \
+        }                                                                              \
+        sort_##suffix(keys + lo, idx ? idx + lo : NULL, hi - lo, tmp, tmp_idx);        \
+    }                                                                                  \
+                                                                                       \
+    static void complement_##suffix(void* keys_ptr, size_t n) {                        \
+        key_t* keys = keys_ptr;                                                        \
+        for (size_t i = 0; i < n; i++) keys[i] = ~keys[i];                             \
+    }
+
+DEFINE_SORT_KERNELS(u32, uint32_t)
+DEFINE_SORT_KERNELS(u64, uint64_t)
+
+typedef struct {
+    size_t key_size;
+    void (*sort)(void* keys, uint32_t* idx, size_t n, void* tmp, uint32_t* tmp_idx);
+    void (*merge)(const void* a, const uint32_t* a_idx, size_t na,
+                  const void* b, const uint32_t* b_idx, size_t nb,
+                  void* out, uint32_t* out_idx);
+    void (*select)(void* keys, uint32_t* idx, size_t n, size_t kth, void* tmp, uint32_t* tmp_idx);
+    void (*complement)(void* keys, size_t n);
+} SortKernels;
+
+static const SortKernels sort_kernels_u32 = { sizeof(uint32_t), sort_u32, merge_u32, select_u32, complement_u32 };
+static const SortKernels sort_kernels_u64 = { sizeof(uint64_t), sort_u64, merge_u64, select_u64, complement_u64 };
+
+
+// Line driver
+
+typedef enum {
+    SORT_VALUES,
+    SORT_INDICES,
+    SORT_PARTITION,
+    SORT_TOPK
+} SortMode;
+
+typedef struct {
+    const SortKernels* kernels;
+    SortMode mode;
+    DataType dtype;
+    const char* in;
+    char* values;       // Output values, or NULL
+    int* indices;       // Output indices, or NULL
+    size_t axis_dim;    // Length of every input line
+    size_t out_dim;     // Length of every output line
+    size_t inner;       // Stride between consecutive line elements, in elements
+    size_t k;           // kth element for SORT_PARTITION, count for SORT_TOPK
+    int failed;         // Set by a thread that could not allocate its scratch buffers
+} SortContext;
+
+// Scratch buffers for one line
+typedef struct {
+    char* keys;
+    char* tmp;
+    uint32_t* idx;
+    uint32_t* tmp_idx;
+} SortScratch;
+
+static int allocate_scratch(SortScratch* scratch, size_t n, size_t key_size) {
+    scratch->keys = malloc(n * key_size);
+    scratch->tmp = malloc(n * key_size);
+    scratch->idx = malloc(n * sizeof(uint32_t));
+    scratch->tmp_idx = malloc(n * sizeof(uint32_t));
+    if (!scratch->keys || !scratch->tmp || !scratch->idx || !scratch->tmp_idx) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for sort buffers");
+        return 0;
+    }
+    return 1;
+}
+
+static void free_scratch(SortScratch* scratch) {
+    free(scratch->keys);
+    free(scratch->tmp);
+    free(scratch->idx);
+    free(scratch->tmp_idx);
+}
+
+static void store_line(SortContext* s, SortScratch* scratch, size_t line, size_t n) {
+    size_t o = line / s->inner;
+    size_t c = line - o * s->inner;
+    size_t out_base = o * s->out_dim * s->inner + c;
+    size_t dtype_size = get_dtype_size(s->dtype);
+    if (s->values) {
+        store_keys(s->dtype, s->values + out_base * dtype_size, s->inner * dtype_size, n, scratch->keys);
+    }
+    if (s->indices) {
+        for (size_t i = 0; i < n; i++) {
+            s->indices[out_base + i * s->inner] = (int)scratch->idx[i];
+        }
+    }
+}
+
+static void load_line(SortContext* s, SortScratch* scratch, size_t line) {
+    size_t o = line / s->inner;
+    size_t c = line - o * s->inner;
+    size_t dtype_size = get_dtype_size(s->dtype);
+    const char* base = s->in + (o * s->axis_dim * s->inner + c) * dtype_size;
+    load_keys(s->dtype, base, s->inner * dtype_size, s->axis_dim, scratch->keys);
+    if (s->mode != SORT_VALUES && s->mode != SORT_PARTITION) {
+        for (size_t i = 0; i < s->axis_dim; i++) {
+            scratch->idx[i] = (uint32_t)i;
+        }
+    }
+}
+
+static void sort_line(SortContext* s, SortScratch* scratch, size_t line) {
+    const SortKernels* kernels = s->kernels;
+    size_t n = s->axis_dim;
+    load_line(s, scratch, line);
+
+    switch (s->mode) {
+        case SORT_VALUES:
+            kernels->sort(scratch->keys, NULL, n, scratch->tmp, NULL);
+            break;
+        case SORT_INDICES:
+            kernels->sort(scratch->keys, scratch->idx, n, scratch->tmp, scratch->tmp_idx);
+            break;
+        case SORT_PARTITION:
+            kernels->select(scratch->keys, NULL, n, s->k, scratch->tmp, NULL);
+            break;
+        case SORT_TOPK:
+            // Complemented keys put the largest values first
+            kernels->complement(scratch->keys, n);
+            if (s->k < n) {
+                kernels->select(scratch->keys, scratch->idx, n, s->k - 1, scratch->tmp, scratch->tmp_idx);
+            }
+            kernels->sort(scratch->keys, scratch->idx, s->k, scratch->tmp, scratch->tmp_idx);
+            kernels->complement(scratch->keys, s->k);
+            break;
+    }
+    store_line(s, scratch, line, s->out_dim);
+}
+
+static void sort_lines(size_t begin, size_t end, void* ctx) {
+    SortContext* s = ctx;
+    SortScratch scratch;
+    if (!allocate_scratch(&scratch, s->axis_dim, s->kernels->key_size)) {
+        __atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+        free_scratch(&scratch);
+        return;
+    }
+    for (size_t line = begin; line < end; line++) {
+        sort_line(s, &scratch, line);
+    }
+    free_scratch(&scratch);
+}
+
+
+// Parallel sort of a single long line: the line is cut into one chunk per
+// thread, the chunks are sorted concurrently, and neighbouring sorted runs are
+// then merged pairwise, each merge pass running its merges in parallel.
+
+typedef struct {
+    const SortKernels* kernels;
+    char* src;
+    char* dst;
+    uint32_t* src_idx;
+    uint32_t* dst_idx;
+    size_t* bounds;      // Start of every run, plus the end of the line
+    size_t n_runs;
+} MergeContext;
+
+static void sort_chunks(size_t begin, size_t end, void* ctx) {
+    MergeContext* m = ctx;
+    size_t key_size = m->kernels->key_size;
+    for (size_t r = begin; r < end; r++) {
+        size_t start = m->bounds[r];
+        size_t len = m->bounds[r + 1] - start;
+        m->kernels->sort(m->src + start * key_size, m->src_idx ? m->src_idx + start : NULL, len,
+                         m->dst + start * key_size, m->dst_idx ? m->dst_idx + start : NULL);
+    }
+}
+
+static void merge_pairs(size_t begin, size_t end, void* ctx) {
+    MergeContext* m = ctx;
+    size_t key_size = m->kernels->key_size;
+    for (size_t p = begin; p < end; p++) {
+        size_t a = 2 * p;
+        size_t start = m->bounds[a];
+        size_t mid = m->bounds[a + 1];
+        size_t stop = (a + 2 <= m->n_runs) ? m->bounds[a + 2] : mid;
+        m->kernels->merge(m->src + start * key_size, m->src_idx ? m->src_idx + start : NULL, mid - start,
+                          m->src + mid * key_size, m->src_idx ? m->src_idx + mid : NULL, stop - mid,
+                          m->dst + start * key_size, m->dst_idx ? m->dst_idx + start : NULL);
+    }
+}
+
+static int sort_line_parallel(SortContext* s, size_t line) {
+    size_t n = s->axis_dim;
+    size_t key_size = s->kernels->key_size;
+    SortScratch scratch;
+    if (!allocate_scratch(&scratch, n, key_size)) {
+        free_scratch(&scratch);
+        return 0;
+    }
+    load_line(s, &scratch, line);
+
+    size_t n_runs = get_num_threads();
+    size_t bounds[n_runs + 1];
+    for (size_t r = 0; r <= n_runs; r++) {
+        bounds[r] = n * r / n_runs;
+    }
+
+    int with_idx = s->mode == SORT_INDICES;
+    MergeContext m = {
+        s->kernels, scratch.keys, scratch.tmp,
+        with_idx ? scratch.idx : NULL, with_idx ? scratch.tmp_idx : NULL,
+        bounds, n_runs
+    };
+    parallel_for(n_runs, 1, sort_chunks, &m);
+
+    while (m.n_runs > 1) {
+        size_t n_pairs = (m.n_runs + 1) / 2;
+        parallel_for(n_pairs, 1, merge_pairs, &m);
+
+        // Runs 2p and 2p + 1 are now run p
+        for (size_t p = 0; p < n_pairs; p++) {
+            bounds[p] = bounds[2 * p];
+        }
+        bounds[n_pairs] = n;
+        m.n_runs = n_pairs;
+
+        char* swap = m.src; m.src = m.dst; m.dst = swap;
+        uint32_t* swap_idx = m.src_idx; m.src_idx = m.dst_idx; m.dst_idx = swap_idx;
+    }
+
+    // store_line reads from the scratch keys and indices
+    scratch.keys = m.src;
+    scratch.tmp = m.dst;
+    if (with_idx) {
+        scratch.idx = m.src_idx;
+        scratch.tmp_idx = m.dst_idx;
+    }
+    store_line(s, &scratch, line, n);
+    free_scratch(&scratch);
+    return 1;
+}
+
+/**
+ * Run a sorting operation on every line of an array along an axis.
+ *
+ * Lines are independent and distributed over the threads. When there are
+ * fewer lines than threads and the lines are long, each line is instead
+ * sorted with the parallel chunk sort and merge.
+ *
+ * @return 1 on success, 0 on error.
+ */
+static int sort_along_axis(Array* arr, size_t axis, SortMode mode, size_t k,
+                           char* values, int* indices, size_t out_dim) {
+    size_t* strides = calculate_strides(arr->shape, arr->ndim);
+    if (!strides) {
+        return 0;
+    }
+    SortContext ctx = {
+        .kernels = (get_dtype_size(arr->dtype) == 8) ? &sort_kernels_u64 : &sort_kernels_u32,
+        .mode = mode,
+        .dtype = arr->dtype,
+        .in = arr->data,
+        .values = values,
+        .indices = indices,
+        .axis_dim = arr->shape[axis],
+        .out_dim = out_dim,
+        .inner = strides[axis],
+        .k = k,
+    };
+    free(strides);
+
+    size_t n_lines = arr->size / ctx.axis_dim;
+    if ((mode == SORT_VALUES || mode == SORT_INDICES) && n_lines < get_num_threads() &&
+        ctx.axis_dim >= PARALLEL_SORT_MIN) {
+        for (size_t line = 0; line < n_lines; line++) {
+            if (!sort_line_parallel(&ctx, line)) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    size_t grain = PARALLEL_GRAIN_BYTES / (ctx.axis_dim * get_dtype_size(arr->dtype)) + 1;
+    parallel_for(n_lines, grain, sort_lines, &ctx);
+    return !ctx.failed;
+}
+
+static int validate_sort_input(Array* arr, size_t axis) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return 0;
+        }
+    #endif
+
+    if (axis >= arr->ndim) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return 0;
+    }
+    if (arr->dtype < TYPE_INT || arr->dtype > TYPE_BOOL) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return 0;
+    }
+    if (arr->shape[axis] > UINT32_MAX) {
+        log_error(ARRAY_ERROR_SHAPE, "Axis is too long to sort");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Sort an array along an axis.
+ *
+ * Short lines use a sorting network, medium lines a merge sort over network
+ * sorted blocks and long lines an LSD radix sort on order-preserving keys.
+ *
+ * @param arr The array to sort.
+ * @param axis The axis to sort along.
+ * @return A new sorted array, or NULL on error.
+ */
+Array* sort(Array* arr, size_t axis) {
+    if (!validate_sort_input(arr, axis)) {
+        return NULL;
+    }
+    Array* result = create_array(arr->dtype, arr->ndim, arr->shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    if (!sort_along_axis(arr, axis, SORT_VALUES, 0, result->data, NULL, arr->shape[axis])) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Compute the indices that sort an array along an axis.
+ *
+ * The sort is stable, so equal elements keep their original order.
+ *
+ * @param arr The array to sort.
+ * @param axis The axis to sort along.
+ * @return A new TYPE_INT array of positions along the axis, or NULL on error.
+ */
+Array* argsort(Array* arr, size_t axis) {
+    if (!validate_sort_input(arr, axis)) {
+        return NULL;
+    }
+    Array* result = create_array(TYPE_INT, arr->ndim, arr->shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    if (!sort_along_axis(arr, axis, SORT_INDICES, 0, NULL, result->data, arr->shape[axis])) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Partially sort an array along an axis.
+ *
+ * The element at position kth of every line ends up where a full sort would
+ * put it, with no larger element before it and no smaller element after it.
+ *
+ * @param arr The array to partition.
+ * @param kth The position to place.
+ * @param axis The axis to partition along.
+ * @return A new array, or NULL on error.
+ */
+Array* partition(Array* arr, size_t kth, size_t axis) {
+    if (!validate_sort_input(arr, axis)) {
+        return NULL;
+    }
+    if (kth >= arr->shape[axis]) {
+        log_error(ARRAY_ERROR_INDEX, "kth is out of range");
+        return NULL;
+    }
+    Array* result = create_array(arr->dtype, arr->ndim, arr->shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+    if (!sort_along_axis(arr, axis, SORT_PARTITION, kth, result->data, NULL, arr->shape[axis])) {
+        free_array(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Find the k largest elements of every line along an axis.
+ *
+ * Introselect moves the k largest elements to the front of the line, after
+ * which only those k are sorted.
+ *
+ * @param arr The input array.
+ * @param k Number of elements to keep per line.
+ * @param axis The axis to search along.
+ * @param values Receives a new array with the k largest values per line, in descending order.
+ * @param indices Receives a new TYPE_INT array with their positions along the axis.
+ * @return 1 on success, 0 on error.
+ */
+int topk(Array* arr, size_t k, size_t axis, Array** values, Array** indices) {
+    if (!validate_sort_input(arr, axis)) {
+        return 0;
+    }
+    #if DEBUG_MODE
+        if (!values || !indices) {
+            log_error(ARRAY_ERROR_NULL, "Output pointers are NULL");
+            return 0;
+        }
+    #endif
+
+    if (k == 0 || k > arr->shape[axis]) {
+        log_error(ARRAY_ERROR_INDEX, "k is out of range");
+        return 0;
+    }
+
+    size_t out_shape[arr->ndim];
+    memcpy(out_shape, arr->shape, arr->ndim * sizeof(size_t));
+    out_shape[axis] = k;
+
+    *values = create_array(arr->dtype, arr->ndim, out_shape, NULL);
+    *indices = create_array(TYPE_INT, arr->ndim, out_shape, NULL);
+    if (!*values || !*indices ||
+        !sort_along_axis(arr, axis, SORT_TOPK, k, (*values)->data, (*indices)->data, k)) {
+        free_array(*values);
+        free_array(*indices);
+        *values = NULL;
+        *indices = NULL;
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,795 @@
+#include "array_sparse.h"
+
+// Matrices with fewer nonzeros plus rows than this are processed on the calling thread
+#define SPARSE_PARALLEL_MIN (1 << 15)
+
+// Row ranges handed out per thread, so that a few dense rows do not stall one thread
+#define SPARSE_PARTS_PER_THREAD 4
+
+// Columns of the dense operand processed together by sparse_matmul, sized so that
+// an output row block and the dense rows it reads stay in cache
+#define SPMM_COLUMN_BLOCK 256
+
+static int is_sparse_dtype(DataType dtype) {
+    return dtype == TYPE_INT || dtype == TYPE_FLOAT || dtype == TYPE_DOUBLE;
+}
+
+// malloc that returns a valid pointer for empty matrices
+static void* sparse_alloc(size_t n, size_t size) {
+    return malloc(n ? n * size : 1);
+}
+
+/**
+ * Allocate a sparse matrix with room for nnz entries.
+ *
+ * @return A pointer to the new SparseArray structure with uninitialized entries, or NULL on error.
+ */
+static SparseArray* allocate_sparse(SparseFormat format, DataType dtype, size_t n_rows, size_t n_cols, size_t nnz) {
+    SparseArray* sp = calloc(1, sizeof(SparseArray));
+    if (!sp) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for sparse array");
+        return NULL;
+    }
+
+    sp->format = format;
+    sp->dtype = dtype;
+    sp->shape[0] = n_rows;
+    sp->shape[1] = n_cols;
+    sp->nnz = nnz;
+    sp->cols = sparse_alloc(nnz, sizeof(size_t));
+    sp->values = sparse_alloc(nnz, get_dtype_size(dtype));
+    if (format == SPARSE_CSR) {
+        sp->row_ptr = malloc((n_rows + 1) * sizeof(size_t));
+    } else {
+        sp->rows = sparse_alloc(nnz, sizeof(size_t));
+    }
+
+    if (!sp->cols || !sp->values || (format == SPARSE_CSR ? !sp->row_ptr : !sp->rows)) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for sparse array");
+        free_sparse_array(sp);
+        return NULL;
+    }
+    return sp;
+}
+
+/**
+ * Create a COO sparse matrix from coordinate triples.
+ *
+ * @param dtype The data type of the values.
+ * @param n_rows Number of rows.
+ * @param n_cols Number of columns.
+ * @param nnz Number of triples.
+ * @param rows Row index of each triple.
+ * @param cols Column index of each triple.
+ * @param values Value of each triple.
+ * @return A pointer to the new SparseArray structure, or NULL on error.
+ */
+SparseArray* create_sparse_coo(DataType dtype, size_t n_rows, size_t n_cols, size_t nnz,
+                               size_t* rows, size_t* cols, void* values) {
+    #if DEBUG_MODE
+        if (nnz && (!rows || !cols || !values)) {
+            log_error(ARRAY_ERROR_NULL, "One of the inputs is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (!is_sparse_dtype(dtype)) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    size_t bad = 0;
+    for (size_t j = 0; j < nnz; j++) {
+        bad |= (rows[j] >= n_rows) | (cols[j] >= n_cols);
+    }
+    if (bad) {
+        log_error(ARRAY_ERROR_INDEX, "Index out of bounds");
+        return NULL;
+    }
+
+    SparseArray* sp = allocate_sparse(SPARSE_COO, dtype, n_rows, n_cols, nnz);
+    if (!sp) {
+        return NULL;
+    }
+    if (nnz) {
+        memcpy(sp->rows, rows, nnz * sizeof(size_t));
+        memcpy(sp->cols, cols, nnz * sizeof(size_t));
+        memcpy(sp->values, values, nnz * get_dtype_size(dtype));
+    }
+    return sp;
+}
+
+/**
+ * Free a sparse matrix.
+ *
+ * @param sp The SparseArray structure to free, may be NULL.
+ */
+void free_sparse_array(SparseArray* sp) {
+    if (!sp) {
+        return;
+    }
+    free(sp->row_ptr);
+    free(sp->rows);
+    free(sp->cols);
+    free(sp->values);
+    free(sp);
+}
+
+
+// Row-range parallelism
+//
+// CSR rows are split into ranges of roughly equal cost, counting one unit per
+// nonzero plus one per row, so matrices with a few very dense rows still spread
+// evenly over the threads. Each range writes only to its own rows of the output.
+
+typedef void (*RowKernel)(const SparseArray* sp, size_t row_begin, size_t row_end, void* ctx);
+
+typedef struct {
+    const SparseArray* sp;
+    RowKernel kernel;
+    void* ctx;
+    const size_t* bounds;
+} RowContext;
+
+static void run_row_ranges(size_t begin, size_t end, void* ctx) {
+    RowContext* r = ctx;
+    for (size_t p = begin; p < end; p++) {
+        r->kernel(r->sp, r->bounds[p], r->bounds[p + 1], r->ctx);
+    }
+}
+
+// Runs kernel over all rows of a CSR matrix, split into balanced row ranges
+static void for_each_row_range(const SparseArray* sp, RowKernel kernel, void* ctx) {
+    size_t n_rows = sp->shape[0];
+    size_t work = sp->nnz + n_rows;
+    size_t n_parts = work < SPARSE_PARALLEL_MIN ? 1 : get_num_threads() * SPARSE_PARTS_PER_THREAD;
+    if (n_parts > n_rows) {
+        n_parts = n_rows ? n_rows : 1;
+    }
+
+    size_t bounds[n_parts + 1];
+    bounds[0] = 0;
+    bounds[n_parts] = n_rows;
+    for (size_t p = 1; p < n_parts; p++) {
+        // First row whose cost prefix row_ptr[row] + row reaches the target
+        size_t target = work * p / n_parts;
+        size_t lo = bounds[p - 1], hi = n_rows;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (sp->row_ptr[mid] + mid < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        bounds[p] = lo;
+    }
+
+    RowContext r = { sp, kernel, ctx, bounds };
+    parallel_for(n_parts, 1, run_row_ranges, &r);
+}
+
+
+// Typed kernels
+
+typedef struct {
+    const char* data;      // Dense input or operand
+    size_t row_stride;     // Byte strides of the dense operand broadcast to the matrix shape
+    size_t col_stride;
+    size_t k;              // sparse_matmul: columns of the dense operand
+    void* out;             // Dense output or output values
+} SparseContext;
+
+typedef struct {
+    const char* data;
+    size_t n_cols;
+    size_t* counts;        // Nonzeros per row
+    SparseArray* sp;
+} DenseRowsContext;
+
+// Works on the entries [begin, end) of a matrix in either format
+typedef void (*EntryKernel)(const SparseArray* sp, size_t begin, size_t end, void* out);
+
+#define DEFINE_SPARSE_KERNELS(T, suffix) \
+    static void count_nonzeros_##suffix(size_t begin, size_t end, void* ctx) { \
+        DenseRowsContext* c = ctx; \
+        for (size_t r = begin; r < end; r++) { \
+            const T* row = (const T*)c->data + r * c->n_cols; \
+            size_t count = 0; \
+            for (size_t j = 0; j < c->n_cols; j++) { \
+                count += row[j] != 0; \
+            } \
+            c->counts[r] = count; \
+        } \
+    } \
+    \
+    static void pack_nonzeros_##suffix(size_t begin, size_t end, void* ctx) { \
+        DenseRowsContext* c = ctx; \
+        T* values = c->sp->values; \
+        for (size_t r = begin; r < end; r++) { \
+            const T* row = (const T*)c->data + r * c->n_cols; \
+            size_t at = c->sp->row_ptr[r]; \
+            for (size_t j = 0; j < c->n_cols; j++) { \
+                if (row[j] != 0) { \
+                    c->sp->cols[at] = j; \
+                    values[at++] = row[j]; \
+                } \
+            } \
+        } \
+    } \
+    \
+    static void scatter_rows_##suffix(const SparseArray* sp, size_t r0, size_t r1, void* ctx) { \
+        SparseContext* c = ctx; \
+        const T* values = sp->values; \
+        for (size_t r = r0; r < r1; r++) { \
+            T* out = (T*)c->out + r * sp->shape[1]; \
+            for (size_t j = sp->row_ptr[r]; j < sp->row_ptr[r + 1]; j++) { \
+                out[sp->cols[j]] += values[j]; \
+            } \
+        } \
+    } \
+    \
+    static void scatter_entries_##suffix(const SparseArray* sp, size_t begin, size_t end, void* out) { \
+        const T* values = sp->values; \
+        T* dense = out; \
+        for (size_t j = begin; j < end; j++) { \
+            dense[sp->rows[j] * sp->shape[1] + sp->cols[j]] += values[j]; \
+        } \
+    } \
+    \
+    static void column_sums_##suffix(const SparseArray* sp, size_t begin, size_t end, void* out) { \
+        const T* values = sp->values; \
+        T* sums = out; \
+        for (size_t j = begin; j < end; j++) { \
+            sums[sp->cols[j]] += values[j]; \
+        } \
+    } \
+    \
+    static void row_sums_##suffix(const SparseArray* sp, size_t r0, size_t r1, void* ctx) { \
+        SparseContext* c = ctx; \
+        const T* values = sp->values; \
+        T* sums = c->out; \
+        for (size_t r = r0; r < r1; r++) { \
+            T sum = 0; \
+            for (size_t j = sp->row_ptr[r]; j < sp->row_ptr[r + 1]; j++) { \
+                sum += values[j]; \
+            } \
+            sums[r] = sum; \
+        } \
+    } \
+    \
+    static void broadcast_add_##suffix(const SparseArray* sp, size_t r0, size_t r1, void* ctx) { \
+        SparseContext* c = ctx; \
+        for (size_t r = r0; r < r1; r++) { \
+            T* out = (T*)c->out + r * sp->shape[1]; \
+            const char* row = c->data + r * c->row_stride; \
+            for (size_t j = 0; j < sp->shape[1]; j++) { \
+                out[j] = *(const T*)(row + j * c->col_stride); \
+            } \
+        } \
+        scatter_rows_##suffix(sp, r0, r1, ctx); \
+    } \
+    \
+    static void broadcast_multiply_##suffix(const SparseArray* sp, size_t r0, size_t r1, void* ctx) { \
+        SparseContext* c = ctx; \
+        const T* values = sp->values; \
+        T* out = c->out; \
+        for (size_t r = r0; r < r1; r++) { \
+            const char* row = c->data + r * c->row_stride; \
+            for (size_t j = sp->row_ptr[r]; j < sp->row_ptr[r + 1]; j++) { \
+                out[j] = values[j] * *(const T*)(row + sp->cols[j] * c->col_stride); \
+            } \
+        } \
+    } \
+    \
+    static void spmv_##suffix(const SparseArray* sp, size_t r0, size_t r1, void* ctx) { \
+        SparseContext* c = ctx; \
+        const T* values = sp->values; \
+        const T* x = (const T*)c->data; \
+        T* y = c->out; \
+        for (size_t r = r0; r < r1; r++) { \
+            T sum = 0; \
+            for (size_t j = sp->row_ptr[r]; j < sp->row_ptr[r + 1]; j++) { \
+                sum += values[j] * x[sp->cols[j]]; \
+            } \
+            y[r] = sum; \
+        } \
+    } \
+    \
+    static void spmm_##suffix(const SparseArray* sp, size_t r0, size_t r1, void* ctx) { \
+        SparseContext* c = ctx; \
+        const T* values = sp->values; \
+        const T* b = (const T*)c->data; \
+        size_t k = c->k; \
+        for (size_t r = r0; r < r1; r++) { \
+            for (size_t kb = 0; kb < k; kb += SPMM_COLUMN_BLOCK) { \
+                size_t width = k - kb < SPMM_COLUMN_BLOCK ? k - kb : SPMM_COLUMN_BLOCK; \
+                T* restrict out = (T*)c->out + r * k + kb; \
+                for (size_t j = sp->row_ptr[r]; j < sp->row_ptr[r + 1]; j++) { \
+                    const T v = values[j]; \
+                    const T* restrict b_row = b + sp->cols[j] * k + kb; \
+                    for (size_t t = 0; t < width; t++) { \
+                        out[t] += v * b_row[t]; \
+                    } \
+                } \
+            } \
+        } \
+    }
+
+DEFINE_SPARSE_KERNELS(int, int)
+DEFINE_SPARSE_KERNELS(float, float)
+DEFINE_SPARSE_KERNELS(double, double)
+
+typedef struct {
+    ParallelFunc count_nonzeros;
+    ParallelFunc pack_nonzeros;
+    RowKernel scatter_rows;
+    EntryKernel scatter_entries;
+    EntryKernel column_sums;
+    RowKernel row_sums;
+    RowKernel broadcast_add;
+    RowKernel broadcast_multiply;
+    RowKernel spmv;
+    RowKernel spmm;
+} SparseKernels;
+
+#define SPARSE_KERNELS(suffix) { \
+    count_nonzeros_##suffix, pack_nonzeros_##suffix, scatter_rows_##suffix, scatter_entries_##suffix, \
+    column_sums_##suffix, row_sums_##suffix, broadcast_add_##suffix, broadcast_multiply_##suffix, \
+    spmv_##suffix, spmm_##suffix }
+
+// Indexed by dtype; TYPE_BOOL is not a sparse value type
+static const SparseKernels sparse_kernels[3] = {
+    SPARSE_KERNELS(int),
+    SPARSE_KERNELS(float),
+    SPARSE_KERNELS(double),
+};
+
+
+// Conversion
+
+/**
+ * Convert a dense two-dimensional array to a CSR or COO sparse matrix.
+ *
+ * Rows are counted in parallel, the counts are prefix-summed into row offsets,
+ * and the rows are then packed in parallel directly into their final positions.
+ *
+ * @param arr The two-dimensional array to convert.
+ * @param format The storage format of the result.
+ * @return A pointer to the new SparseArray structure, or NULL on error.
+ */
+SparseArray* dense_to_sparse(Array* arr, SparseFormat format) {
+    #if DEBUG_MODE
+        if (!arr) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (arr->ndim != 2) {
+        log_error(ARRAY_ERROR_SHAPE, "Sparse arrays must be two-dimensional");
+        return NULL;
+    }
+    if (!is_sparse_dtype(arr->dtype)) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+
+    const SparseKernels* kernels = &sparse_kernels[arr->dtype];
+    size_t n_rows = arr->shape[0];
+    size_t n_cols = arr->shape[1];
+    size_t row_bytes = n_cols * get_dtype_size(arr->dtype);
+    size_t grain = row_bytes < PARALLEL_GRAIN_BYTES ? PARALLEL_GRAIN_BYTES / row_bytes : 1;
+
+    size_t* counts = malloc(n_rows * sizeof(size_t));
+    if (!counts) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for sparse array");
+        return NULL;
+    }
+
+    DenseRowsContext c = { arr->data, n_cols, counts, NULL };
+    parallel_for(n_rows, grain, kernels->count_nonzeros, &c);
+
+    size_t nnz = 0;
+    for (size_t r = 0; r < n_rows; r++) {
+        nnz += counts[r];
+    }
+
+    c.sp = allocate_sparse(SPARSE_CSR, arr->dtype, n_rows, n_cols, nnz);
+    if (c.sp) {
+        c.sp->row_ptr[0] = 0;
+        for (size_t r = 0; r < n_rows; r++) {
+            c.sp->row_ptr[r + 1] = c.sp->row_ptr[r] + counts[r];
+        }
+        parallel_for(n_rows, grain, kernels->pack_nonzeros, &c);
+    }
+    free(counts);
+
+    if (c.sp && format == SPARSE_COO) {
+        SparseArray* coo = sparse_convert(c.sp, SPARSE_COO);
+        free_sparse_array(c.sp);
+        return coo;
+    }
+    return c.sp;
+}
+
+/**
+ * Convert a sparse matrix to a dense two-dimensional array.
+ *
+ * CSR rows are scattered in parallel; COO entries are scattered in order.
+ * Duplicate entries are summed.
+ *
+ * @param sp The sparse matrix to convert.
+ * @return A pointer to the new Array structure, or NULL on error.
+ */
+Array* sparse_to_dense(SparseArray* sp) {
+    #if DEBUG_MODE
+        if (!sp) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    Array* result = create_array(sp->dtype, 2, sp->shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    const SparseKernels* kernels = &sparse_kernels[sp->dtype];
+    if (sp->format == SPARSE_CSR) {
+        SparseContext c = { .out = result->data };
+        for_each_row_range(sp, kernels->scatter_rows, &c);
+    } else {
+        kernels->scatter_entries(sp, 0, sp->nnz, result->data);
+    }
+    return result;
+}
+
+// Expands CSR row offsets into one row index per entry
+static void expand_rows(const SparseArray* sp, size_t r0, size_t r1, void* ctx) {
+    size_t* rows = ctx;
+    for (size_t r = r0; r < r1; r++) {
+        for (size_t j = sp->row_ptr[r]; j < sp->row_ptr[r + 1]; j++) {
+            rows[j] = r;
+        }
+    }
+}
+
+/**
+ * Convert a sparse matrix to another storage format.
+ *
+ * COO to CSR is a stable counting sort of the entries by row, so entries keep
+ * their relative order within each row. Converting to the same format copies.
+ *
+ * @param sp The sparse matrix to convert.
+ * @param format The storage format of the result.
+ * @return A pointer to the new SparseArray structure, or NULL on error.
+ */
+SparseArray* sparse_convert(SparseArray* sp, SparseFormat format) {
+    #if DEBUG_MODE
+        if (!sp) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    size_t n_rows = sp->shape[0];
+    size_t nnz = sp->nnz;
+    size_t elem_size = get_dtype_size(sp->dtype);
+
+    SparseArray* result = allocate_sparse(format, sp->dtype, n_rows, sp->shape[1], nnz);
+    if (!result) {
+        return NULL;
+    }
+
+    if (sp->format == format || format == SPARSE_COO) {
+        parallel_memcpy(result->cols, sp->cols, nnz * sizeof(size_t));
+        parallel_memcpy(result->values, sp->values, nnz * elem_size);
+        if (sp->format == SPARSE_CSR && format == SPARSE_CSR) {
+            memcpy(result->row_ptr, sp->row_ptr, (n_rows + 1) * sizeof(size_t));
+        } else if (sp->format == SPARSE_COO) {
+            parallel_memcpy(result->rows, sp->rows, nnz * sizeof(size_t));
+        } else {
+            for_each_row_range(sp, expand_rows, result->rows);
+        }
+        return result;
+    }
+
+    // COO to CSR: count entries per row, then place each entry at its row's next free slot
+    size_t* next = result->row_ptr;
+    memset(next, 0, (n_rows + 1) * sizeof(size_t));
+    for (size_t j = 0; j < nnz; j++) {
+        next[sp->rows[j] + 1]++;
+    }
+    for (size_t r = 0; r < n_rows; r++) {
+        next[r + 1] += next[r];
+    }
+
+    const char* values = sp->values;
+    char* out_values = result->values;
+    for (size_t j = 0; j < nnz; j++) {
+        size_t at = next[sp->rows[j]]++;
+        result->cols[at] = sp->cols[j];
+        memcpy(out_values + at * elem_size, values + j * elem_size, elem_size);
+    }
+
+    // Placing advanced every offset to the start of the following row
+    memmove(next + 1, next, n_rows * sizeof(size_t));
+    next[0] = 0;
+    return result;
+}
+
+// Returns sp itself when it is CSR, otherwise a CSR copy the caller must free
+static SparseArray* as_csr(SparseArray* sp) {
+    return sp->format == SPARSE_CSR ? sp : sparse_convert(sp, SPARSE_CSR);
+}
+
+static void release_csr(SparseArray* csr, SparseArray* sp) {
+    if (csr != sp) {
+        free_sparse_array(csr);
+    }
+}
+
+
+// Operations
+
+typedef struct {
+    const SparseArray* sp;
+    EntryKernel kernel;
+    char* sums;            // n_chunks consecutive accumulators of shape[1] elements
+    size_t n_chunks;
+    size_t row_bytes;
+} ColumnSumContext;
+
+static void sum_column_chunks(size_t begin, size_t end, void* ctx) {
+    ColumnSumContext* c = ctx;
+    size_t nnz = c->sp->nnz;
+    for (size_t chunk = begin; chunk < end; chunk++) {
+        c->kernel(c->sp, nnz * chunk / c->n_chunks, nnz * (chunk + 1) / c->n_chunks,
+                  c->sums + chunk * c->row_bytes);
+    }
+}
+
+/**
+ * Sum a sparse matrix along an axis.
+ *
+ * Row sums (axis 1) reduce each CSR row in parallel. Column sums (axis 0)
+ * scatter the entries of either format into per-thread accumulators that are
+ * added together at the end, so threads never write to the same sum.
+ *
+ * @param sp The sparse matrix to sum.
+ * @param axis 0 for one sum per column, 1 for one sum per row.
+ * @return A pointer to a new one-dimensional Array structure, or NULL on error.
+ */
+Array* sparse_sum_along_axis(SparseArray* sp, size_t axis) {
+    #if DEBUG_MODE
+        if (!sp) {
+            log_error(ARRAY_ERROR_NULL, "Array is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (axis > 1) {
+        log_error(ARRAY_ERROR_AXIS, "Invalid axis: Out of range");
+        return NULL;
+    }
+
+    const SparseKernels* kernels = &sparse_kernels[sp->dtype];
+    size_t shape[1] = { sp->shape[1 - axis] };
+    Array* result = create_array(sp->dtype, 1, shape, NULL);
+    if (!result) {
+        return NULL;
+    }
+
+    if (axis == 1) {
+        SparseArray* csr = as_csr(sp);
+        if (!csr) {
+            free_array(result);
+            return NULL;
+        }
+        SparseContext c = { .out = result->data };
+        for_each_row_range(csr, kernels->row_sums, &c);
+        release_csr(csr, sp);
+        return result;
+    }
+
+    size_t n_chunks = get_num_threads();
+    if (sp->nnz < SPARSE_PARALLEL_MIN || shape[0] * n_chunks > sp->nnz) {
+        n_chunks = 1;
+    }
+    if (n_chunks == 1) {
+        kernels->column_sums(sp, 0, sp->nnz, result->data);
+        return result;
+    }
+
+    size_t row_bytes = shape[0] * get_dtype_size(sp->dtype);
+    ColumnSumContext c = { sp, kernels->column_sums, calloc(n_chunks, row_bytes), n_chunks, row_bytes };
+    if (!c.sums) {
+        log_error(ARRAY_ERROR_MEMORY, "Failed to allocate memory for column sums");
+        free_array(result);
+        return NULL;
+    }
+    parallel_for(n_chunks, 1, sum_column_chunks, &c);
+
+    StridedLoopFunc add = get_operation_loop('+', sp->dtype);
+    size_t elem_size = get_dtype_size(sp->dtype);
+    size_t strides[2] = { elem_size, elem_size };
+    memcpy(result->data, c.sums, row_bytes);
+    for (size_t chunk = 1; chunk < n_chunks; chunk++) {
+        char* in[2] = { result->data, c.sums + chunk * row_bytes };
+        add(result->data, in, strides, shape[0]);
+    }
+    free(c.sums);
+    return result;
+}
+
+/**
+ * Compute the byte strides of a dense operand broadcast to the shape of a sparse matrix.
+ *
+ * @return 1 on success, 0 on error.
+ */
+static int sparse_operand_strides(SparseArray* sp, Array* dense, SparseContext* c) {
+    #if DEBUG_MODE
+        if (!sp || !dense) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return 0;
+        }
+    #endif
+
+    if (sp->dtype != dense->dtype) {
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+        return 0;
+    }
+
+    size_t* strides = broadcast_strides(dense, sp->shape, 2);
+    if (!strides) {
+        return 0;
+    }
+    c->data = dense->data;
+    c->row_stride = strides[0];
+    c->col_stride = strides[1];
+    free(strides);
+    return 1;
+}
+
+/**
+ * Multiply the stored entries of a sparse matrix by a broadcast dense array.
+ *
+ * Only the stored entries are visited, so the cost is proportional to the
+ * number of nonzeros rather than to the dense shape.
+ *
+ * @param sp The sparse matrix.
+ * @param dense The dense array, broadcastable to the shape of sp.
+ * @return A pointer to a new CSR SparseArray structure with the sparsity pattern of sp, or NULL on error.
+ */
+SparseArray* sparse_multiply_dense(SparseArray* sp, Array* dense) {
+    SparseContext c = { 0 };
+    if (!sparse_operand_strides(sp, dense, &c)) {
+        return NULL;
+    }
+
+    SparseArray* csr = as_csr(sp);
+    if (!csr) {
+        return NULL;
+    }
+    SparseArray* result = allocate_sparse(SPARSE_CSR, sp->dtype, sp->shape[0], sp->shape[1], sp->nnz);
+    if (result) {
+        memcpy(result->row_ptr, csr->row_ptr, (sp->shape[0] + 1) * sizeof(size_t));
+        parallel_memcpy(result->cols, csr->cols, sp->nnz * sizeof(size_t));
+        c.out = result->values;
+        for_each_row_range(csr, sparse_kernels[sp->dtype].broadcast_multiply, &c);
+    }
+    release_csr(csr, sp);
+    return result;
+}
+
+/**
+ * Add a sparse matrix to a broadcast dense array.
+ *
+ * Every row of the result is filled from the dense operand and then receives
+ * the entries of the same sparse row, both while the row is in cache.
+ *
+ * @param sp The sparse matrix.
+ * @param dense The dense array, broadcastable to the shape of sp.
+ * @return A pointer to a new dense two-dimensional Array structure, or NULL on error.
+ */
+Array* sparse_add_dense(SparseArray* sp, Array* dense) {
+    SparseContext c = { 0 };
+    if (!sparse_operand_strides(sp, dense, &c)) {
+        return NULL;
+    }
+
+    SparseArray* csr = as_csr(sp);
+    if (!csr) {
+        return NULL;
+    }
+    Array* result = create_array(sp->dtype, 2, sp->shape, NULL);
+    if (result) {
+        c.out = result->data;
+        for_each_row_range(csr, sparse_kernels[sp->dtype].broadcast_add, &c);
+    }
+    release_csr(csr, sp);
+    return result;
+}
+
+/**
+ * Compute the sparse matrix-vector product sp * x.
+ *
+ * Rows are split into ranges with balanced numbers of nonzeros and every
+ * output element is reduced by a single thread.
+ *
+ * @param sp The sparse matrix.
+ * @param x One-dimensional array with sp->shape[1] elements.
+ * @return A pointer to a new one-dimensional Array structure with sp->shape[0] elements, or NULL on error.
+ */
+Array* sparse_matvec(SparseArray* sp, Array* x) {
+    #if DEBUG_MODE
+        if (!sp || !x) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (sp->dtype != x->dtype) {
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+        return NULL;
+    }
+    if (x->ndim != 1 || x->shape[0] != sp->shape[1]) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+        return NULL;
+    }
+
+    SparseArray* csr = as_csr(sp);
+    if (!csr) {
+        return NULL;
+    }
+    Array* result = create_array(sp->dtype, 1, sp->shape, NULL);
+    if (result) {
+        SparseContext c = { .data = x->data, .out = result->data };
+        for_each_row_range(csr, sparse_kernels[sp->dtype].spmv, &c);
+    }
+    release_csr(csr, sp);
+    return result;
+}
+
+/**
+ * Compute the sparse matrix-dense matrix product sp * dense.
+ *
+ * Each sparse row accumulates scaled rows of the dense operand into its output
+ * row, SPMM_COLUMN_BLOCK columns at a time so the output block stays in cache
+ * while all entries of the row are applied.
+ *
+ * @param sp The sparse matrix.
+ * @param dense Two-dimensional array of shape (sp->shape[1], k).
+ * @return A pointer to a new Array structure of shape (sp->shape[0], k), or NULL on error.
+ */
+Array* sparse_matmul(SparseArray* sp, Array* dense) {
+    #if DEBUG_MODE
+        if (!sp || !dense) {
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
+            return NULL;
+        }
+    #endif
+
+    if (sp->dtype != dense->dtype) {
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
+        return NULL;
+    }
+    if (dense->ndim != 2 || dense->shape[0] != sp->shape[1]) {
+        log_error(ARRAY_ERROR_SHAPE, "Shapes are incompatible");
+        return NULL;
+    }
+
+    SparseArray* csr = as_csr(sp);
+    if (!csr) {
+        return NULL;
+    }
+    size_t shape[2] = { sp->shape[0], dense->shape[1] };
+    Array* result = create_array(sp->dtype, 2, shape, NULL);
+    if (result) {
+        SparseContext c = { .data = dense->data, .k = shape[1], .out = result->data };
+        for_each_row_range(csr, sparse_kernels[sp->dtype].spmm, &c);
+    }
+    release_csr(csr, sp);
+    return result;
+}
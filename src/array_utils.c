@@ -9,6 +9,12 @@ size_t get_dtype_size(DataType dtype) {
             return sizeof(float);
         case TYPE_DOUBLE:
             return sizeof(double);
+        case TYPE_BOOL:
+            return sizeof(unsigned char);
+        case TYPE_COMPLEX_FLOAT:
+            return 2 * sizeof(float);
+        case TYPE_COMPLEX_DOUBLE:
+            return 2 * sizeof(double);
         default:
             return 0;
     }
@@ -34,43 +40,6 @@ void print_shape(size_t* shape, size_t ndim) {
 
 
 
-void print_array(Array* arr) {
-    if (!arr) {
-        printf("\033[31mArray: NULL\033[0m\n");  // Red for NULL
-        return;
-    }
-
-    size_t ndim = arr->ndim;
-    size_t *shape = arr->shape;
-
-    for (size_t i = 0; i < arr->size; i++) {
-        size_t indices[ndim];
-        size_t remaining_index = i;
-
-        // Compute the multi-dimensional indices
-        for (size_t j = ndim; j-- > 0;) {
-            indices[j] = remaining_index % shape[j];
-            remaining_index /= shape[j];
-        }
-
-        // Fetch and print the element
-        void *element = get_element(arr, indices);
-        if (element) {
-            printf("%d", *(int*)element);
-        } else {
-            printf("NULL");
-        }
-
-        // Determine when to add newlines based on the last dimension
-        if ((i + 1) % shape[ndim - 1] == 0) {
-            printf("\n");
-        } else {
-            printf(", ");
-        }
-    }
-}
-
-
 int are_shapes_equal(size_t* shapeA, size_t ndimA, size_t* shapeB, size_t ndimB) {
     if (ndimA != ndimB) {
         return 0; 
@@ -85,40 +54,76 @@ int are_shapes_equal(size_t* shapeA, size_t ndimA, size_t* shapeB, size_t ndimB)
     return 1; 
 }
 
+// Bytes compared with one memcmp call between checks for a mismatch found by another thread
+#define EQUAL_BLOCK_BYTES (1 << 16)
+
+// Work shared by the threads of arrays_are_equal
+typedef struct {
+    const char* a;
+    const char* b;
+    size_t n_bytes;
+    int differs;             // Set once any block differs
+} EqualContext;
+
+static void compare_blocks(size_t begin, size_t end, void* ctx) {
+    EqualContext* c = ctx;
+    size_t start = begin * EQUAL_BLOCK_BYTES;
+    size_t stop = end * EQUAL_BLOCK_BYTES < c->n_bytes ? end * EQUAL_BLOCK_BYTES : c->n_bytes;
+    for (; start < stop && !__atomic_load_n(&c->differs, __ATOMIC_RELAXED); start += EQUAL_BLOCK_BYTES) {
+        size_t len = stop - start < EQUAL_BLOCK_BYTES ? stop - start : EQUAL_BLOCK_BYTES;
+        if (memcmp(c->a + start, c->b + start, len) != 0) {
+            __atomic_store_n(&c->differs, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * Compare two arrays bitwise for equality.
+ *
+ * The data buffers are compared as whole blocks with memcmp, split across
+ * threads, and the comparison stops at the first block that differs. Clones
+ * sharing a data block are equal without reading it.
+ *
+ * @param arr_a First input array.
+ * @param arr_b Second input array.
+ * @return 1 if the arrays have the same dtype, shape and bytes, 0 otherwise.
+ */
 int arrays_are_equal(Array* arr_a, Array* arr_b) {
     #if DEBUG_MODE
         if (!arr_a || !arr_b) {
-            log_error("One of the arrays is NULL");
+            log_error(ARRAY_ERROR_NULL, "One of the arrays is NULL");
             return 0;
         }
     #endif
 
     if (arr_a->dtype != arr_b->dtype) {
-        log_error("Data types are not equal");
+        log_error(ARRAY_ERROR_DTYPE, "Data types are not equal");
         return 0;
     }
 
     if (arr_a->ndim != arr_b->ndim) {
-        log_error("Number of dimensions are not equal");
+        log_error(ARRAY_ERROR_SHAPE, "Number of dimensions are not equal");
         return 0;
     }
 
     for (size_t i = 0; i < arr_a->ndim; i++) {
         if (arr_a->shape[i] != arr_b->shape[i]) {
-            log_error("Shapes are not equal");
+            log_error(ARRAY_ERROR_SHAPE, "Shapes are not equal");
             return 0;
         }
     }
 
-    for (size_t i = 0; i < arr_a->size; i++) {
-        void* elem_a = (char*)arr_a->data + i * get_dtype_size(arr_a->dtype);
-        void* elem_b = (char*)arr_b->data + i * get_dtype_size(arr_b->dtype);
+    if (arr_a->data == arr_b->data) {
+        return 1;
+    }
 
-        if (memcmp(elem_a, elem_b, get_dtype_size(arr_a->dtype)) != 0) {
-            log_error("Elements are not equal");
-            return 0;
-        }
+    EqualContext c = { arr_a->data, arr_b->data, arr_a->size * get_dtype_size(arr_a->dtype), 0 };
+    size_t n_blocks = (c.n_bytes + EQUAL_BLOCK_BYTES - 1) / EQUAL_BLOCK_BYTES;
+    parallel_for(n_blocks, PARALLEL_GRAIN_BYTES / EQUAL_BLOCK_BYTES, compare_blocks, &c);
+    if (c.differs) {
+        log_error(ARRAY_ERROR_VALUE, "Elements are not equal");
+        return 0;
     }
 
     return 1;
-}
\ No newline at end of file
+}
@@ -75,11 +75,75 @@ int get_op_index(char op) {
 
 void apply_operation(char operation_symbol, void* result, void* a, void* b, DataType dtype) {
     int op_index = get_op_index(operation_symbol);
-    if (op_index == -1 || dtype < TYPE_INT || dtype > TYPE_DOUBLE) {
-        log_error("Invalid operation or data type");
+    if (op_index == -1) {
+        log_error(ARRAY_ERROR_VALUE, "Invalid operation symbol");
+        return;
+    }
+    if (dtype < TYPE_INT || dtype > TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
         return;
     }
     // Execute the appropriate operation
     op_tables[dtype][op_index](result, a, b);
 }
 
+
+// Strided row loops used by the broadcasting engine.
+// The contiguous and scalar-broadcast cases get their own loops so the compiler can vectorize them.
+#define DEFINE_OPERATION_LOOP(name, type, op)                                          \
+    static void name(char* out, char** in, const size_t* in_strides, size_t n) {       \
+        type* res = (type*)out;                                                        \
+        const char* a = in[0];                                                         \
+        const char* b = in[1];                                                         \
+        if (in_strides[0] == sizeof(type) && in_strides[1] == sizeof(type)) {          \
+            const type* pa = (const type*)a;                                           \
+            const type* pb = (const type*)b;                                           \
+            for (size_t i = 0; i < n; i++) res[i] = pa[i] op pb[i];                    \
+        } else if (in_strides[0] == sizeof(type) && in_strides[1] == 0) {              \
+            const type* pa = (const type*)a;                                           \
+            const type vb = *(const type*)b;                                           \
+            for (size_t i = 0; i < n; i++) res[i] = pa[i] op vb;                       \
+        } else if (in_strides[0] == 0 && in_strides[1] == sizeof(type)) {              \
+            const type va = *(const type*)a;                                           \
+            const type* pb = (const type*)b;                                           \
+            for (size_t i = 0; i < n; i++) res[i] = va op pb[i];                       \
+        } else {                                                                       \
+            for (size_t i = 0; i < n; i++) {                                           \
+                res[i] = *(const type*)(a + i * in_strides[0]) op                      \
+                         *(const type*)(b + i * in_strides[1]);                        \
+            }                                                                          \
+        }                                                                              \
+    }
+
+DEFINE_OPERATION_LOOP(add_int_loop, int, +)
+DEFINE_OPERATION_LOOP(sub_int_loop, int, -)
+DEFINE_OPERATION_LOOP(mul_int_loop, int, *)
+DEFINE_OPERATION_LOOP(div_int_loop, int, /)
+DEFINE_OPERATION_LOOP(add_float_loop, float, +)
+DEFINE_OPERATION_LOOP(sub_float_loop, float, -)
+DEFINE_OPERATION_LOOP(mul_float_loop, float, *)
+DEFINE_OPERATION_LOOP(div_float_loop, float, /)
+DEFINE_OPERATION_LOOP(add_double_loop, double, +)
+DEFINE_OPERATION_LOOP(sub_double_loop, double, -)
+DEFINE_OPERATION_LOOP(mul_double_loop, double, *)
+DEFINE_OPERATION_LOOP(div_double_loop, double, /)
+
+// Loop tables for each data type and operation, indexed like op_tables
+StridedLoopFunc int_loops[] = { add_int_loop, sub_int_loop, mul_int_loop, div_int_loop };
+StridedLoopFunc float_loops[] = { add_float_loop, sub_float_loop, mul_float_loop, div_float_loop };
+StridedLoopFunc double_loops[] = { add_double_loop, sub_double_loop, mul_double_loop, div_double_loop };
+
+StridedLoopFunc* loop_tables[] = { int_loops, float_loops, double_loops };
+
+StridedLoopFunc get_operation_loop(char operation_symbol, DataType dtype) {
+    int op_index = get_op_index(operation_symbol);
+    if (op_index == -1) {
+        log_error(ARRAY_ERROR_VALUE, "Invalid operation symbol");
+        return NULL;
+    }
+    if (dtype < TYPE_INT || dtype > TYPE_DOUBLE) {
+        log_error(ARRAY_ERROR_DTYPE, "Invalid data type");
+        return NULL;
+    }
+    return loop_tables[dtype][op_index];
+}
@@ -1,8 +1,61 @@
 #include "utils.h"
+#include <pthread.h>
 
 
-void log_error(const char* message) {
+// Error state of the calling thread
+static _Thread_local ArrayError last_error = ARRAY_OK;
+static _Thread_local const char* last_message = "";
+
+// Copy of the last message handed over by restore_last_error
+static _Thread_local char restored_message[256];
+
+// Process-wide error callback; the lock keeps the callback and its user data
+// consistent with each other, and is only taken when an error is raised
+static pthread_mutex_t callback_lock = PTHREAD_MUTEX_INITIALIZER;
+static ErrorCallback error_callback = NULL;
+static void* error_user_data = NULL;
+
+void log_error(ArrayError code, const char* message) {
+    last_error = code;
+    last_message = message;
+
+    pthread_mutex_lock(&callback_lock);
+    ErrorCallback callback = error_callback;
+    void* user_data = error_user_data;
+    pthread_mutex_unlock(&callback_lock);
+    if (callback) {
+        callback(code, message, user_data);
+        return;
+    }
 #if LOG_DEBUG
     fprintf(stderr, "DEBUG: %s\n", message);
 #endif
-}
\ No newline at end of file
+}
+
+ArrayError get_last_error() {
+    return last_error;
+}
+
+const char* get_last_error_message() {
+    return last_message;
+}
+
+void clear_last_error() {
+    last_error = ARRAY_OK;
+    last_message = "";
+}
+
+void set_error_callback(ErrorCallback callback, void* user_data) {
+    pthread_mutex_lock(&callback_lock);
+    error_callback = callback;
+    error_user_data = user_data;
+    pthread_mutex_unlock(&callback_lock);
+}
+
+void restore_last_error(ArrayError code, const char* message) {
+    last_error = code;
+    if (message != restored_message) {
+        snprintf(restored_message, sizeof(restored_message), "%s", message);
+    }
+    last_message = restored_message;
+}